@@ -46,6 +46,14 @@
 
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 
+/* Adaptive rate control tuning. The delta is re-evaluated
+ * every AUDIO_RATE_CONTROL_WINDOW flushes. */
+#define AUDIO_RATE_CONTROL_WINDOW       256
+#define AUDIO_RATE_CONTROL_KI           0.000002
+#define AUDIO_RATE_CONTROL_MAX_DRIFT    0.005
+#define AUDIO_RATE_CONTROL_DELTA_MIN    0.0005f
+#define AUDIO_RATE_CONTROL_DELTA_MAX    0.02f
+
 static const audio_driver_t *audio_drivers[] = {
 #ifdef HAVE_ALSA
    &audio_alsa,
@@ -150,16 +158,26 @@ static bool audio_driver_use_float                       = false;
 static bool audio_driver_active                          = false;
 static bool audio_driver_data_own                        = false;
 
+static unsigned audio_driver_underrun_count              = 0;
+static bool audio_driver_buffer_drained                  = false;
+static float audio_driver_rate_control_delta             = 0.0f;
+static float audio_driver_rate_control_peak              = 0.0f;
+static double audio_driver_rate_control_integral         = 0.0;
+
 /**
  * compute_audio_buffer_statistics:
+ * @stats              : pointer to statistics structure to fill in.
  *
- * Computes audio buffer statistics.
+ * Computes audio buffer statistics over the most recent
+ * AUDIO_BUFFER_FREE_SAMPLES_COUNT buffer fill samples.
  *
+ * Returns: true (1) if enough samples were recorded,
+ * otherwise false (0).
  **/
-static void compute_audio_buffer_statistics(void)
+static bool compute_audio_buffer_statistics(audio_statistics_t *stats)
 {
    unsigned i, low_water_size, high_water_size, avg, stddev;
-   float avg_filled, deviation;
+   unsigned histogram[101];
    uint64_t accum                = 0;
    uint64_t accum_var            = 0;
    unsigned low_water_count      = 0;
@@ -168,8 +186,10 @@ static void compute_audio_buffer_statistics(void)
          audio_driver_free_samples_count,
          AUDIO_BUFFER_FREE_SAMPLES_COUNT);
 
-   if (samples < 3)
-      return;
+   if (!stats || samples < 3 || !audio_driver_buffer_size)
+      return false;
+
+   memset(histogram, 0, sizeof(histogram));
 
    for (i = 1; i < samples; i++)
       accum += audio_driver_free_samples_buf[i];
@@ -183,25 +203,145 @@ static void compute_audio_buffer_statistics(void)
    }
 
    stddev          = (unsigned)sqrt((double)accum_var / (samples - 2));
-   avg_filled      = 1.0f - (float)avg / audio_driver_buffer_size;
-   deviation       = (float)stddev / audio_driver_buffer_size;
 
    low_water_size  = audio_driver_buffer_size * 3 / 4;
    high_water_size = audio_driver_buffer_size / 4;
 
    for (i = 1; i < samples; i++)
    {
-      if (audio_driver_free_samples_buf[i] >= low_water_size)
+      unsigned avail = MIN(audio_driver_free_samples_buf[i],
+            audio_driver_buffer_size);
+
+      if (avail >= low_water_size)
          low_water_count++;
-      else if (audio_driver_free_samples_buf[i] <= high_water_size)
+      else if (avail <= high_water_size)
          high_water_count++;
+
+      /* Bucket by buffer saturation percentage. */
+      histogram[100 - (avail * 100) / audio_driver_buffer_size]++;
+   }
+
+   stats->samples                   = samples - 1;
+   stats->average_buffer_saturation = (1.0f - (float)avg
+         / audio_driver_buffer_size) * 100.0;
+   stats->std_deviation_percentage  = ((float)stddev
+         / audio_driver_buffer_size) * 100.0;
+   stats->close_to_underrun         = (100.0 * low_water_count)
+      / (samples - 1);
+   stats->close_to_blocking         = (100.0 * high_water_count)
+      / (samples - 1);
+   stats->saturation_p5             = 0;
+   stats->saturation_p50            = 0;
+   stats->saturation_p95            = 0;
+   stats->underrun_count            = audio_driver_underrun_count;
+   stats->rate_control_delta        = audio_driver_rate_control_delta;
+   stats->ratio_drift               = 0.0;
+
+   if (audio_source_ratio_original > 0.0)
+      stats->ratio_drift = (audio_source_ratio_current
+            / audio_source_ratio_original - 1.0) * 100.0;
+
+   /* Walk the histogram to find the percentiles. */
+   {
+      unsigned p5_count  = (stats->samples *  5) / 100;
+      unsigned p50_count = (stats->samples * 50) / 100;
+      unsigned p95_count = (stats->samples * 95) / 100;
+      bool p5_found      = false;
+      bool p50_found     = false;
+      bool p95_found     = false;
+
+      accum = 0;
+
+      for (i = 0; i <= 100; i++)
+      {
+         accum += histogram[i];
+
+         if (!p5_found && accum > p5_count)
+         {
+            stats->saturation_p5  = i;
+            p5_found              = true;
+         }
+         if (!p50_found && accum > p50_count)
+         {
+            stats->saturation_p50 = i;
+            p50_found             = true;
+         }
+         if (!p95_found && accum > p95_count)
+         {
+            stats->saturation_p95 = i;
+            p95_found             = true;
+         }
+      }
    }
 
-   RARCH_LOG("Average audio buffer saturation: %.2f %%, standard deviation (percentage points): %.2f %%.\n",
-         avg_filled * 100.0, deviation * 100.0);
-   RARCH_LOG("Amount of time spent close to underrun: %.2f %%. Close to blocking: %.2f %%.\n",
-         (100.0 * low_water_count) / (samples - 1),
-         (100.0 * high_water_count) / (samples - 1));
+   return true;
+}
+
+/**
+ * audio_driver_rate_control_adapt:
+ * @direction          : normalized buffer fill error, in the range
+ *                       [-1.0, 1.0]. Positive when the buffer is
+ *                       draining, negative when it is filling up.
+ *
+ * PI controller for dynamic rate control. The integral term
+ * tracks the steady-state clock drift between the core and
+ * the audio device, so that the proportional term (the rate
+ * control delta) only has to absorb jitter. The delta itself
+ * is then tuned based on the peak error seen over a window.
+ *
+ * Returns: the rate adjustment to apply to the source ratio.
+ **/
+static double audio_driver_rate_control_adapt(double direction)
+{
+   double peak = fabs(direction);
+
+   audio_driver_rate_control_integral += AUDIO_RATE_CONTROL_KI * direction;
+
+   if (audio_driver_rate_control_integral > AUDIO_RATE_CONTROL_MAX_DRIFT)
+      audio_driver_rate_control_integral = AUDIO_RATE_CONTROL_MAX_DRIFT;
+   else if (audio_driver_rate_control_integral < -AUDIO_RATE_CONTROL_MAX_DRIFT)
+      audio_driver_rate_control_integral = -AUDIO_RATE_CONTROL_MAX_DRIFT;
+
+   if (peak > audio_driver_rate_control_peak)
+      audio_driver_rate_control_peak = peak;
+
+   if ((audio_driver_free_samples_count
+            % AUDIO_RATE_CONTROL_WINDOW) == 0)
+   {
+      /* Buffer swings too close to its edges - react faster. */
+      if (audio_driver_rate_control_peak > 0.75f)
+         audio_driver_rate_control_delta *= 1.25f;
+      /* Buffer is stable - reduce pitch modulation. */
+      else if (audio_driver_rate_control_peak < 0.25f)
+         audio_driver_rate_control_delta *= 0.9f;
+
+      if (audio_driver_rate_control_delta > AUDIO_RATE_CONTROL_DELTA_MAX)
+         audio_driver_rate_control_delta = AUDIO_RATE_CONTROL_DELTA_MAX;
+      else if (audio_driver_rate_control_delta < AUDIO_RATE_CONTROL_DELTA_MIN)
+         audio_driver_rate_control_delta = AUDIO_RATE_CONTROL_DELTA_MIN;
+
+      audio_driver_rate_control_peak = 0.0f;
+   }
+
+   return 1.0 + audio_driver_rate_control_delta * direction
+      + audio_driver_rate_control_integral;
+}
+
+/**
+ * audio_driver_get_statistics:
+ * @stats              : pointer to statistics structure to fill in.
+ *
+ * Gets live audio buffer statistics, as gathered by
+ * dynamic rate control.
+ *
+ * Returns: true (1) if statistics are available,
+ * otherwise false (0).
+ **/
+bool audio_driver_get_statistics(audio_statistics_t *stats)
+{
+   if (!audio_driver_control)
+      return false;
+   return compute_audio_buffer_statistics(stats);
 }
 
 /**
@@ -287,7 +427,27 @@ static bool audio_driver_deinit_internal(void)
 
    command_event(CMD_EVENT_DSP_FILTER_DEINIT, NULL);
 
-   compute_audio_buffer_statistics();
+   {
+      audio_statistics_t stats;
+
+      if (compute_audio_buffer_statistics(&stats))
+      {
+         RARCH_LOG("Average audio buffer saturation: %.2f %%, standard deviation (percentage points): %.2f %%.\n",
+               stats.average_buffer_saturation,
+               stats.std_deviation_percentage);
+         RARCH_LOG("Amount of time spent close to underrun: %.2f %%. Close to blocking: %.2f %%.\n",
+               stats.close_to_underrun,
+               stats.close_to_blocking);
+         RARCH_LOG("Audio buffer saturation percentiles: 5th: %u %%, 50th: %u %%, 95th: %u %%. Underruns: %u.\n",
+               stats.saturation_p5,
+               stats.saturation_p50,
+               stats.saturation_p95,
+               stats.underrun_count);
+         RARCH_LOG("Audio rate control delta: %.4f, ratio drift: %.4f %%.\n",
+               stats.rate_control_delta,
+               stats.ratio_drift);
+      }
+   }
 
    return true;
 }
@@ -460,7 +620,12 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
 
    command_event(CMD_EVENT_DSP_FILTER_INIT, NULL);
 
-   audio_driver_free_samples_count = 0;
+   audio_driver_free_samples_count    = 0;
+   audio_driver_underrun_count        = 0;
+   audio_driver_buffer_drained        = false;
+   audio_driver_rate_control_delta    = settings->audio.rate_control_delta;
+   audio_driver_rate_control_peak     = 0.0f;
+   audio_driver_rate_control_integral = 0.0;
 
    /* Threaded driver is initially stopped. */
    if (
@@ -580,7 +745,22 @@ static bool audio_driver_flush(const int16_t *data, size_t samples)
          current_audio->write_avail(audio_driver_context_audio_data);
       int      delta_mid   = avail - half_size;
       double   direction   = (double)delta_mid / half_size;
-      double   adjust      = 1.0 + settings->audio.rate_control_delta * direction;
+      double   adjust      = 1.0;
+
+      /* Count an underrun once, when the buffer recovers
+       * from running dry, not on every flush while it's empty. */
+      if (avail >= (int)audio_driver_buffer_size)
+         audio_driver_buffer_drained = true;
+      else if (audio_driver_buffer_drained)
+      {
+         audio_driver_buffer_drained = false;
+         audio_driver_underrun_count++;
+      }
+
+      if (settings->audio.rate_control_adaptive)
+         adjust = audio_driver_rate_control_adapt(direction);
+      else
+         adjust = 1.0 + settings->audio.rate_control_delta * direction;
 
 #if 0
       RARCH_LOG_OUTPUT("Audio buffer is %u%% full\n",
@@ -33,6 +33,24 @@ RETRO_BEGIN_DECLS
 
 #define AUDIO_MAX_RATIO                16
 
+typedef struct audio_statistics
+{
+   /* Buffer saturation figures are in percent. */
+   float average_buffer_saturation;
+   float std_deviation_percentage;
+   float close_to_underrun;
+   float close_to_blocking;
+   unsigned saturation_p5;
+   unsigned saturation_p50;
+   unsigned saturation_p95;
+   unsigned underrun_count;
+   unsigned samples;
+   float rate_control_delta;
+   /* Deviation of the effective resampling ratio
+    * from the nominal ratio, in percent. */
+   double ratio_drift;
+} audio_statistics_t;
+
 typedef struct audio_driver
 {
    /* Creates and initializes handle to audio driver.
@@ -218,6 +236,8 @@ bool audio_driver_deinit(void);
 
 bool audio_driver_init(void);
 
+bool audio_driver_get_statistics(audio_statistics_t *stats);
+
 extern audio_driver_t audio_rsound;
 extern audio_driver_t audio_oss;
 extern audio_driver_t audio_alsa;
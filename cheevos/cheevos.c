@@ -20,6 +20,7 @@
 #include <streams/file_stream.h>
 #include <compat/strl.h>
 #include <rhash.h>
+#include <features/features_cpu.h>
 #include <libretro.h>
 
 #ifdef HAVE_CONFIG_H
@@ -65,6 +66,10 @@
  * from retroachievements.org. */
 #undef CHEEVOS_JSON_OVERRIDE
 
+/* Define this macro to benchmark the condition evaluator with a synthetic
+ * set of achievements when content is loaded. */
+#undef CHEEVOS_BENCHMARK
+
 /* Define this macro to have the password and token logged. THIS WILL DISCLOSE
  * THE USER'S PASSWORD, TAKE CARE! */
 #undef CHEEVOS_LOG_PASSWORD
@@ -195,10 +200,57 @@ typedef struct
    cheevos_var_t target;
 } cheevos_cond_t;
 
+enum
+{
+   CHEEVOS_OPERAND_VALUE = 0,
+   CHEEVOS_OPERAND_MEMORY,
+   CHEEVOS_OPERAND_DELTA
+}; /* cheevos_operand_t.kind */
+
+enum
+{
+   CHEEVOS_CMP_LESS    = 1 << 0,
+   CHEEVOS_CMP_EQUAL   = 1 << 1,
+   CHEEVOS_CMP_GREATER = 1 << 2
+}; /* cheevos_insn_t.cmp */
+
+typedef struct
+{
+   const uint8_t *ptr;  /* resolved address, NULL if unmapped */
+   unsigned size;       /* CHEEVOS_VAR_SIZE_* */
+   unsigned value;      /* read once per frame */
+
+   int      bank_id;
+   unsigned address;
+} cheevos_memref_t;
+
+typedef struct
+{
+   const unsigned *value; /* a memref's value, or constant below */
+   unsigned kind;         /* CHEEVOS_OPERAND_* */
+   unsigned constant;     /* constant, or index into the memref table */
+   unsigned previous;     /* value seen by the last test, for deltas */
+} cheevos_operand_t;
+
+typedef struct
+{
+   cheevos_operand_t source;
+   cheevos_operand_t target;
+   unsigned cmp;        /* CHEEVOS_CMP_* outcomes that make it true */
+   unsigned req_hits;
+   unsigned curr_hits;
+} cheevos_insn_t;
+
 typedef struct
 {
    cheevos_cond_t *conds;
    unsigned        count;
+
+   /* Compiled conditions, pause ones first, then standard, then reset. */
+   cheevos_insn_t *insns;
+   unsigned        pause_count;
+   unsigned        standard_count;
+   unsigned        reset_count;
 } cheevos_condset_t;
 
 typedef struct
@@ -282,8 +334,9 @@ typedef struct
 
 typedef struct
 {
-   cheevos_var_t var;
-   int           multiplier;
+   cheevos_var_t     var;
+   cheevos_operand_t operand;
+   int               multiplier;
 } cheevos_term_t;
 
 typedef struct
@@ -319,6 +372,12 @@ typedef struct
    char token[32];
 
    retro_ctx_memory_info_t meminfo[4];
+
+   cheevos_memref_t *memrefs;
+   unsigned memref_count;
+   unsigned memref_capacity;
+   cheevos_insn_t *insns;
+   bool remap;
 } cheevos_locals_t;
 
 static cheevos_locals_t cheevos_locals =
@@ -335,7 +394,12 @@ static cheevos_locals_t cheevos_locals =
    /* meminfo[1]          */ {NULL, 0, 0},
    /* meminfo[2]          */ {NULL, 0, 0},
    /* meminfo[3]          */ {NULL, 0, 0}
-   }
+   },
+   /* memrefs             */ NULL,
+   /* memref_count        */ 0,
+   /* memref_capacity     */ 0,
+   /* insns               */ NULL,
+   /* remap               */ false
 };
 
 bool cheevos_loaded      = false;
@@ -1465,6 +1529,288 @@ error:
    return -1;
 }
 
+/*****************************************************************************
+Compile the parsed conditions into flat instruction arrays.
+*****************************************************************************/
+
+static void cheevos_resolve_memrefs(void)
+{
+   cheevos_memref_t *ref       = cheevos_locals.memrefs;
+   const cheevos_memref_t *end = ref + cheevos_locals.memref_count;
+
+   for (; ref < end; ref++)
+   {
+      cheevos_var_t var;
+
+      var.bank_id = ref->bank_id;
+      var.value   = ref->address;
+
+      ref->ptr    = cheevos_get_memory(&var);
+   }
+
+   cheevos_locals.remap = false;
+}
+
+static int cheevos_add_memref(const cheevos_var_t *var, unsigned *index)
+{
+   cheevos_memref_t *ref       = cheevos_locals.memrefs;
+   const cheevos_memref_t *end = ref + cheevos_locals.memref_count;
+
+   /* Conditions reading the same location share a single read per frame. */
+   for (; ref < end; ref++)
+   {
+      if (     ref->bank_id == var->bank_id
+            && ref->address == var->value
+            && ref->size    == var->size)
+      {
+         *index = ref - cheevos_locals.memrefs;
+         return 0;
+      }
+   }
+
+   if (cheevos_locals.memref_count == cheevos_locals.memref_capacity)
+   {
+      unsigned capacity = cheevos_locals.memref_capacity ?
+         cheevos_locals.memref_capacity * 2 : 64;
+      cheevos_memref_t *memrefs = (cheevos_memref_t*)realloc(
+            cheevos_locals.memrefs, capacity * sizeof(cheevos_memref_t));
+
+      if (!memrefs)
+         return -1;
+
+      cheevos_locals.memrefs         = memrefs;
+      cheevos_locals.memref_capacity = capacity;
+   }
+
+   ref          = cheevos_locals.memrefs + cheevos_locals.memref_count;
+   ref->ptr     = NULL;
+   ref->size    = var->size;
+   ref->value   = 0;
+   ref->bank_id = var->bank_id;
+   ref->address = var->value;
+
+   *index = cheevos_locals.memref_count++;
+   return 0;
+}
+
+static int cheevos_compile_operand(cheevos_operand_t *operand,
+      const cheevos_var_t *var)
+{
+   operand->value    = NULL;
+   operand->previous = 0;
+
+   switch (var->type)
+   {
+      case CHEEVOS_VAR_TYPE_ADDRESS:
+         operand->kind = CHEEVOS_OPERAND_MEMORY;
+         return cheevos_add_memref(var, &operand->constant);
+      case CHEEVOS_VAR_TYPE_DELTA_MEM:
+         operand->kind = CHEEVOS_OPERAND_DELTA;
+         return cheevos_add_memref(var, &operand->constant);
+      case CHEEVOS_VAR_TYPE_VALUE_COMP:
+         operand->kind     = CHEEVOS_OPERAND_VALUE;
+         operand->constant = var->value;
+         break;
+      default:
+         operand->kind     = CHEEVOS_OPERAND_VALUE;
+         operand->constant = 0;
+         break;
+   }
+
+   return 0;
+}
+
+static void cheevos_link_operand(cheevos_operand_t *operand)
+{
+   /* The memref table doesn't move once all conditions are compiled. */
+   if (operand->kind == CHEEVOS_OPERAND_VALUE)
+      operand->value = &operand->constant;
+   else
+      operand->value = &cheevos_locals.memrefs[operand->constant].value;
+}
+
+static unsigned cheevos_compile_op(unsigned op)
+{
+   switch (op)
+   {
+      case CHEEVOS_COND_OP_EQUALS:
+         return CHEEVOS_CMP_EQUAL;
+      case CHEEVOS_COND_OP_LESS_THAN:
+         return CHEEVOS_CMP_LESS;
+      case CHEEVOS_COND_OP_LESS_THAN_OR_EQUAL:
+         return CHEEVOS_CMP_LESS | CHEEVOS_CMP_EQUAL;
+      case CHEEVOS_COND_OP_GREATER_THAN:
+         return CHEEVOS_CMP_GREATER;
+      case CHEEVOS_COND_OP_GREATER_THAN_OR_EQUAL:
+         return CHEEVOS_CMP_GREATER | CHEEVOS_CMP_EQUAL;
+      case CHEEVOS_COND_OP_NOT_EQUAL_TO:
+         return CHEEVOS_CMP_LESS | CHEEVOS_CMP_GREATER;
+      default:
+         break;
+   }
+
+   return 0;
+}
+
+static int cheevos_compile_conds(const cheevos_condset_t *condset,
+      unsigned type, cheevos_insn_t **insn, unsigned *count)
+{
+   const cheevos_cond_t *cond = condset->conds;
+   const cheevos_cond_t *end  = cond + condset->count;
+
+   *count = 0;
+
+   for (; cond < end; cond++)
+   {
+      cheevos_insn_t *dst = *insn;
+
+      if (cond->type != type)
+         continue;
+
+      if (     cheevos_compile_operand(&dst->source, &cond->source)
+            || cheevos_compile_operand(&dst->target, &cond->target))
+         return -1;
+
+      dst->cmp       = cheevos_compile_op(cond->op);
+      dst->req_hits  = cond->req_hits;
+      dst->curr_hits = 0;
+
+      (*insn)++;
+      (*count)++;
+   }
+
+   return 0;
+}
+
+static int cheevos_compile_condition(cheevos_condition_t *condition,
+      cheevos_insn_t **insn)
+{
+   cheevos_condset_t *condset   = condition->condsets;
+   const cheevos_condset_t *end = condset + condition->count;
+
+   for (; condset < end; condset++)
+   {
+      condset->insns = *insn;
+
+      if (     cheevos_compile_conds(condset, CHEEVOS_COND_TYPE_PAUSE_IF,
+                  insn, &condset->pause_count)
+            || cheevos_compile_conds(condset, CHEEVOS_COND_TYPE_STANDARD,
+                  insn, &condset->standard_count)
+            || cheevos_compile_conds(condset, CHEEVOS_COND_TYPE_RESET_IF,
+                  insn, &condset->reset_count))
+         return -1;
+   }
+
+   return 0;
+}
+
+static unsigned cheevos_count_insns(const cheevos_condition_t *condition)
+{
+   unsigned i;
+   unsigned count = 0;
+
+   for (i = 0; i < condition->count; i++)
+      count += condition->condsets[i].count;
+
+   return count;
+}
+
+static void cheevos_free_program(void)
+{
+   free((void*)cheevos_locals.memrefs);
+   free((void*)cheevos_locals.insns);
+
+   cheevos_locals.memrefs         = NULL;
+   cheevos_locals.memref_count    = 0;
+   cheevos_locals.memref_capacity = 0;
+   cheevos_locals.insns           = NULL;
+}
+
+static int cheevos_compile(void)
+{
+   unsigned i, j;
+   cheevos_insn_t *insn  = NULL;
+   unsigned count        = 0;
+
+   cheevos_free_program();
+
+   for (i = 0; i < cheevos_locals.core.count; i++)
+      count += cheevos_count_insns(&cheevos_locals.core.cheevos[i].condition);
+
+   for (i = 0; i < cheevos_locals.unofficial.count; i++)
+      count += cheevos_count_insns(
+            &cheevos_locals.unofficial.cheevos[i].condition);
+
+   for (i = 0; i < cheevos_locals.lboard_count; i++)
+   {
+      const cheevos_leaderboard_t *lboard = cheevos_locals.leaderboards + i;
+
+      count += cheevos_count_insns(&lboard->start);
+      count += cheevos_count_insns(&lboard->cancel);
+      count += cheevos_count_insns(&lboard->submit);
+   }
+
+   cheevos_locals.insns = (cheevos_insn_t*)
+      calloc(count ? count : 1, sizeof(cheevos_insn_t));
+
+   if (!cheevos_locals.insns)
+      return -1;
+
+   insn = cheevos_locals.insns;
+
+   for (i = 0; i < cheevos_locals.core.count; i++)
+      if (cheevos_compile_condition(
+               &cheevos_locals.core.cheevos[i].condition, &insn))
+         goto error;
+
+   for (i = 0; i < cheevos_locals.unofficial.count; i++)
+      if (cheevos_compile_condition(
+               &cheevos_locals.unofficial.cheevos[i].condition, &insn))
+         goto error;
+
+   for (i = 0; i < cheevos_locals.lboard_count; i++)
+   {
+      cheevos_leaderboard_t *lboard = cheevos_locals.leaderboards + i;
+
+      if (     cheevos_compile_condition(&lboard->start, &insn)
+            || cheevos_compile_condition(&lboard->cancel, &insn)
+            || cheevos_compile_condition(&lboard->submit, &insn))
+         goto error;
+
+      for (j = 0; j < lboard->value.count; j++)
+      {
+         cheevos_term_t *term = lboard->value.terms + j;
+
+         if (cheevos_compile_operand(&term->operand, &term->var))
+            goto error;
+      }
+   }
+
+   for (i = 0; i < count; i++)
+   {
+      cheevos_link_operand(&cheevos_locals.insns[i].source);
+      cheevos_link_operand(&cheevos_locals.insns[i].target);
+   }
+
+   for (i = 0; i < cheevos_locals.lboard_count; i++)
+   {
+      const cheevos_leaderboard_t *lboard = cheevos_locals.leaderboards + i;
+
+      for (j = 0; j < lboard->value.count; j++)
+         cheevos_link_operand(&lboard->value.terms[j].operand);
+   }
+
+   cheevos_resolve_memrefs();
+
+   RARCH_LOG("CHEEVOS compiled %u conditions reading %u memory locations.\n",
+         count, cheevos_locals.memref_count);
+   return 0;
+
+error:
+   cheevos_free_program();
+   return -1;
+}
+
 /*****************************************************************************
 Load achievements from a JSON string.
 *****************************************************************************/
@@ -1752,6 +2098,9 @@ static int cheevos_parse(const char *json)
    if (jsonsax_parse(json, &handlers, (void*)&ud) != JSONSAX_OK)
       goto error;
 
+   if (cheevos_compile())
+      goto error;
+
    return 0;
 
 error:
@@ -1787,104 +2136,93 @@ uint8_t *cheevos_get_memory(const cheevos_var_t *var)
    return memory;
 }
 
-static unsigned cheevos_get_var_value(cheevos_var_t *var)
+static unsigned cheevos_read_memory(const uint8_t *memory, unsigned size)
 {
-   if (var->type == CHEEVOS_VAR_TYPE_VALUE_COMP)
-      return var->value;
+   unsigned live_val;
 
-   if (     var->type == CHEEVOS_VAR_TYPE_ADDRESS
-         || var->type == CHEEVOS_VAR_TYPE_DELTA_MEM)
-   {
-      const uint8_t *memory = cheevos_get_memory(var);
-      unsigned live_val     = 0;
+   if (!memory)
+      return 0;
 
-      if (memory)
-      {
-         live_val = memory[0];
+   live_val = memory[0];
 
-         switch (var->size)
-         {
-            case CHEEVOS_VAR_SIZE_BIT_0:
-               live_val &= 1;
-               break;
-            case CHEEVOS_VAR_SIZE_BIT_1:
-               live_val = (live_val >> 1) & 1;
-               break;
-            case CHEEVOS_VAR_SIZE_BIT_2:
-               live_val = (live_val >> 2) & 1;
-               break;
-            case CHEEVOS_VAR_SIZE_BIT_3:
-               live_val = (live_val >> 3) & 1;
-               break;
-            case CHEEVOS_VAR_SIZE_BIT_4:
-               live_val = (live_val >> 4) & 1;
-               break;
-            case CHEEVOS_VAR_SIZE_BIT_5:
-               live_val = (live_val >> 5) & 1;
-               break;
-            case CHEEVOS_VAR_SIZE_BIT_6:
-               live_val = (live_val >> 6) & 1;
-               break;
-            case CHEEVOS_VAR_SIZE_BIT_7:
-               live_val = (live_val >> 7) & 1;
-               break;
-            case CHEEVOS_VAR_SIZE_NIBBLE_LOWER:
-               live_val &= 0x0f;
-               break;
-            case CHEEVOS_VAR_SIZE_NIBBLE_UPPER:
-               live_val = (live_val >> 4) & 0x0f;
-               break;
-            case CHEEVOS_VAR_SIZE_EIGHT_BITS:
-               break;
-            case CHEEVOS_VAR_SIZE_SIXTEEN_BITS:
-               live_val |= memory[1] << 8;
-               break;
-            case CHEEVOS_VAR_SIZE_THIRTYTWO_BITS:
-               live_val |= memory[1] << 8;
-               live_val |= memory[2] << 16;
-               live_val |= memory[3] << 24;
-               break;
-         }
-      }
+   switch (size)
+   {
+      case CHEEVOS_VAR_SIZE_BIT_0:
+         live_val &= 1;
+         break;
+      case CHEEVOS_VAR_SIZE_BIT_1:
+         live_val = (live_val >> 1) & 1;
+         break;
+      case CHEEVOS_VAR_SIZE_BIT_2:
+         live_val = (live_val >> 2) & 1;
+         break;
+      case CHEEVOS_VAR_SIZE_BIT_3:
+         live_val = (live_val >> 3) & 1;
+         break;
+      case CHEEVOS_VAR_SIZE_BIT_4:
+         live_val = (live_val >> 4) & 1;
+         break;
+      case CHEEVOS_VAR_SIZE_BIT_5:
+         live_val = (live_val >> 5) & 1;
+         break;
+      case CHEEVOS_VAR_SIZE_BIT_6:
+         live_val = (live_val >> 6) & 1;
+         break;
+      case CHEEVOS_VAR_SIZE_BIT_7:
+         live_val = (live_val >> 7) & 1;
+         break;
+      case CHEEVOS_VAR_SIZE_NIBBLE_LOWER:
+         live_val &= 0x0f;
+         break;
+      case CHEEVOS_VAR_SIZE_NIBBLE_UPPER:
+         live_val = (live_val >> 4) & 0x0f;
+         break;
+      case CHEEVOS_VAR_SIZE_EIGHT_BITS:
+         break;
+      case CHEEVOS_VAR_SIZE_SIXTEEN_BITS:
+         live_val |= memory[1] << 8;
+         break;
+      case CHEEVOS_VAR_SIZE_THIRTYTWO_BITS:
+         live_val |= memory[1] << 8;
+         live_val |= memory[2] << 16;
+         live_val |= memory[3] << 24;
+         break;
+   }
 
-      if (var->type == CHEEVOS_VAR_TYPE_DELTA_MEM)
-      {
-         unsigned previous = var->previous;
-         var->previous     = live_val;
-         return previous;
-      }
+   return live_val;
+}
 
-      return live_val;
-   }
+static void cheevos_read_memrefs(void)
+{
+   cheevos_memref_t *ref       = cheevos_locals.memrefs;
+   const cheevos_memref_t *end = ref + cheevos_locals.memref_count;
 
-   /* We shouldn't get here... */
-   return 0;
+   /* Memory doesn't change while testing, read each location once. */
+   for (; ref < end; ref++)
+      ref->value = cheevos_read_memory(ref->ptr, ref->size);
 }
 
-static int cheevos_test_condition(cheevos_cond_t *cond)
+static INLINE unsigned cheevos_operand_value(cheevos_operand_t *operand)
 {
-   unsigned sval = cheevos_get_var_value(&cond->source);
-   unsigned tval = cheevos_get_var_value(&cond->target);
+   unsigned value = *operand->value;
 
-   switch (cond->op)
+   if (operand->kind == CHEEVOS_OPERAND_DELTA)
    {
-      case CHEEVOS_COND_OP_EQUALS:
-         return sval == tval;
-      case CHEEVOS_COND_OP_LESS_THAN:
-         return sval < tval;
-      case CHEEVOS_COND_OP_LESS_THAN_OR_EQUAL:
-         return sval <= tval;
-      case CHEEVOS_COND_OP_GREATER_THAN:
-         return sval > tval;
-      case CHEEVOS_COND_OP_GREATER_THAN_OR_EQUAL:
-         return sval >= tval;
-      case CHEEVOS_COND_OP_NOT_EQUAL_TO:
-         return sval != tval;
-      default:
-         break;
+      unsigned previous = operand->previous;
+      operand->previous = value;
+      return previous;
    }
 
-   return 0;
+   return value;
+}
+
+static INLINE int cheevos_test_insn(cheevos_insn_t *insn)
+{
+   unsigned sval = cheevos_operand_value(&insn->source);
+   unsigned tval = cheevos_operand_value(&insn->target);
+   unsigned cmp  = (sval < tval) | (sval == tval) << 1 | (sval > tval) << 2;
+
+   return (insn->cmp & cmp) != 0;
 }
 
 static int cheevos_test_cond_set(const cheevos_condset_t *condset,
@@ -1892,23 +2230,20 @@ static int cheevos_test_cond_set(const cheevos_condset_t *condset,
 {
    int cond_valid            = 0;
    int set_valid             = 1;
-   const cheevos_cond_t *end = condset->conds + condset->count;
-   cheevos_cond_t *cond      = NULL;
+   cheevos_insn_t *insn      = condset->insns;
+   const cheevos_insn_t *end = insn + condset->pause_count;
 
    /* Now, read all Pause conditions, and if any are true,
     * do not process further (retain old state). */
 
-   for (cond = condset->conds; cond < end; cond++)
+   for (; insn < end; insn++)
    {
-      if (cond->type != CHEEVOS_COND_TYPE_PAUSE_IF)
-         continue;
-
       /* Reset by default, set to 1 if hit! */
-      cond->curr_hits = 0;
+      insn->curr_hits = 0;
 
-      if (cheevos_test_condition(cond))
+      if (cheevos_test_insn(insn))
       {
-         cond->curr_hits = 1;
+         insn->curr_hits = 1;
          *dirty_conds = 1;
 
          /* Early out: this achievement is paused,
@@ -1918,25 +2253,24 @@ static int cheevos_test_cond_set(const cheevos_condset_t *condset,
    }
 
    /* Read all standard conditions, and process as normal: */
-   for (cond = condset->conds; cond < end; cond++)
-   {
-      if (cond->type != CHEEVOS_COND_TYPE_STANDARD)
-         continue;
+   end += condset->standard_count;
 
-      if (cond->req_hits != 0 && cond->curr_hits >= cond->req_hits)
+   for (; insn < end; insn++)
+   {
+      if (insn->req_hits != 0 && insn->curr_hits >= insn->req_hits)
          continue;
 
-      cond_valid = cheevos_test_condition(cond);
+      cond_valid = cheevos_test_insn(insn);
 
       if (cond_valid)
       {
-         cond->curr_hits++;
+         insn->curr_hits++;
          *dirty_conds = 1;
 
          /* Process this logic, if this condition is true: */
-         if (cond->req_hits == 0)
+         if (insn->req_hits == 0)
             ; /* Not a hit-based requirement: ignore any additional logic! */
-         else if (cond->curr_hits < cond->req_hits)
+         else if (insn->curr_hits < insn->req_hits)
             cond_valid = 0; /* Not entirely valid yet! */
 
          if (match_any)
@@ -1948,12 +2282,12 @@ static int cheevos_test_cond_set(const cheevos_condset_t *condset,
    }
 
    /* Now, ONLY read reset conditions! */
-   for (cond = condset->conds; cond < end; cond++)
-   {
-      if (cond->type != CHEEVOS_COND_TYPE_RESET_IF)
-         continue;
+   insn = condset->insns + condset->pause_count + condset->standard_count;
+   end  = insn + condset->reset_count;
 
-      cond_valid = cheevos_test_condition(cond);
+   for (; insn < end; insn++)
+   {
+      cond_valid = cheevos_test_insn(insn);
 
       if (cond_valid)
       {
@@ -1966,30 +2300,17 @@ static int cheevos_test_cond_set(const cheevos_condset_t *condset,
    return set_valid;
 }
 
-static int cheevos_reset_cond_set(cheevos_condset_t *condset, int deltas)
+static int cheevos_reset_cond_set(cheevos_condset_t *condset)
 {
    int dirty                 = 0;
-   const cheevos_cond_t *end = condset->conds + condset->count;
-   cheevos_cond_t *cond      = NULL;
-
-   if (deltas)
-   {
-      for (cond = condset->conds; cond < end; cond++)
-      {
-         dirty |= cond->curr_hits != 0;
-         cond->curr_hits = 0;
+   cheevos_insn_t *insn      = condset->insns;
+   const cheevos_insn_t *end = insn + condset->pause_count
+      + condset->standard_count + condset->reset_count;
 
-         cond->source.previous = cond->source.value;
-         cond->target.previous = cond->target.value;
-      }
-   }
-   else
+   for (; insn < end; insn++)
    {
-      for (cond = condset->conds; cond < end; cond++)
-      {
-         dirty |= cond->curr_hits != 0;
-         cond->curr_hits = 0;
-      }
+      dirty |= insn->curr_hits != 0;
+      insn->curr_hits = 0;
    }
 
    return dirty;
@@ -2025,7 +2346,7 @@ static int cheevos_test_cheevo(cheevo_t *cheevo)
       dirty = 0;
 
       for (condset = cheevo->condition.condsets; condset < end; condset++)
-         dirty |= cheevos_reset_cond_set(condset, 0);
+         dirty |= cheevos_reset_cond_set(condset);
 
       if (dirty)
          cheevo->dirty |= CHEEVOS_DIRTY_CONDITIONS;
@@ -2233,7 +2554,7 @@ static int cheevos_test_lboard_condition(const cheevos_condition_t* condition)
    if (reset_conds)
    {
       for (condset = condition->condsets; condset < end; condset++)
-         cheevos_reset_cond_set(condset, 0);
+         cheevos_reset_cond_set(condset);
    }
 
    return ret_val && ret_val_sub_cond;
@@ -2247,7 +2568,7 @@ static int cheevos_expr_value(cheevos_expr_t* expr)
 
    for (i = expr->count; i != 0; i--, term++)
    {
-      value += cheevos_get_var_value(&term->var) * term->multiplier;
+      value += cheevos_operand_value(&term->operand) * term->multiplier;
    }
 
    return value;
@@ -2918,6 +3239,117 @@ static unsigned cheevos_find_game_id_nes(
    return cheevos_get_game_id(hash, &timeout);
 }
 
+/*****************************************************************************
+Benchmark the condition evaluator with a synthetic set of achievements.
+*****************************************************************************/
+
+#ifdef CHEEVOS_BENCHMARK
+#define CHEEVOS_BENCHMARK_CHEEVOS 500
+#define CHEEVOS_BENCHMARK_FRAMES  10000
+
+static unsigned cheevos_benchmark_rand(void)
+{
+   static unsigned seed = 0x1234567U;
+   seed = seed * 1103515245U + 12345U;
+   return seed >> 16;
+}
+
+static void cheevos_benchmark(void)
+{
+   static uint8_t ram[0x2000];
+   static const char sizes[] = "HHHH XLUMT";
+   char memaddr[256];
+   char size[5];
+   unsigned addr[9];
+   unsigned i, j, frame;
+   retro_time_t elapsed;
+   unsigned count               = 0;
+   cheevos_locals_t saved       = cheevos_locals;
+   cheevo_t *cheevos            = (cheevo_t*)
+      calloc(CHEEVOS_BENCHMARK_CHEEVOS, sizeof(cheevo_t));
+
+   if (!cheevos)
+      return;
+
+   cheevos_locals.console_id       = 0;
+   cheevos_locals.core.cheevos     = cheevos;
+   cheevos_locals.core.count       = CHEEVOS_BENCHMARK_CHEEVOS;
+   cheevos_locals.unofficial.count = 0;
+   cheevos_locals.lboard_count     = 0;
+   cheevos_locals.memrefs          = NULL;
+   cheevos_locals.memref_count     = 0;
+   cheevos_locals.memref_capacity  = 0;
+   cheevos_locals.insns            = NULL;
+
+   /* Real sets test a few hundred hot addresses from many achievements,
+    * with a mix of sizes, deltas, hit counts, pauses, resets and alt groups. */
+   for (i = 0; i < CHEEVOS_BENCHMARK_CHEEVOS; i++)
+   {
+      for (j = 0; j < ARRAY_SIZE(size); j++)
+         size[j] = sizes[cheevos_benchmark_rand() % (sizeof(sizes) - 1)];
+
+      for (j = 0; j < ARRAY_SIZE(addr); j++)
+         addr[j] = cheevos_benchmark_rand() & 0xff;
+
+      snprintf(memaddr, sizeof(memaddr),
+            "0x%c%04x=%u_d0xH%04x<0xH%04x_0x%c%04x>%u.%u._"
+            "P:0xH%04x=%u_R:0xH%04x=255"
+            "S0x%c%04x=%uS0x%c%04x!=%u",
+            size[0], addr[0], addr[8] & 1,
+            addr[1], addr[2],
+            size[1], addr[3], addr[8] & 0x7f, (addr[8] >> 2) + 1,
+            addr[4], addr[8] ^ addr[0],
+            addr[5],
+            size[2], addr[6], addr[7] & 0x0f,
+            size[3], addr[7], addr[6] & 0x0f);
+
+      if (cheevos_parse_condition(&cheevos[i].condition, memaddr))
+         goto end;
+
+      count += cheevos_count_insns(&cheevos[i].condition);
+   }
+
+   if (cheevos_compile())
+      goto end;
+
+   /* Read the synthetic RAM, whatever the core's memory map is. */
+   for (i = 0; i < cheevos_locals.memref_count; i++)
+      cheevos_locals.memrefs[i].ptr =
+         ram + cheevos_locals.memrefs[i].address % (sizeof(ram) - 3);
+
+   elapsed = cpu_features_get_time_usec();
+
+   for (frame = 0; frame < CHEEVOS_BENCHMARK_FRAMES; frame++)
+   {
+      for (j = 0; j < 2; j++)
+      {
+         unsigned offset = cheevos_benchmark_rand() & 0xff;
+         ram[offset]     = (uint8_t)cheevos_benchmark_rand();
+      }
+
+      cheevos_read_memrefs();
+
+      for (i = 0; i < CHEEVOS_BENCHMARK_CHEEVOS; i++)
+         cheevos_test_cheevo(cheevos + i);
+   }
+
+   elapsed = cpu_features_get_time_usec() - elapsed;
+
+   RARCH_LOG("CHEEVOS benchmark: %u achievements, %u conditions, "
+         "%u memory locations, %.2f us per frame.\n",
+         CHEEVOS_BENCHMARK_CHEEVOS, count, cheevos_locals.memref_count,
+         (double)elapsed / CHEEVOS_BENCHMARK_FRAMES);
+
+end:
+   for (i = 0; i < CHEEVOS_BENCHMARK_CHEEVOS; i++)
+      cheevos_free_condition(&cheevos[i].condition);
+
+   free((void*)cheevos);
+   cheevos_free_program();
+   cheevos_locals = saved;
+}
+#endif
+
 bool cheevos_load(const void *data)
 {
    static const uint32_t genesis_exts[] =
@@ -2973,6 +3405,10 @@ bool cheevos_load(const void *data)
    if (!cheevos_locals.core_supports || !info)
       return true;
 
+#ifdef CHEEVOS_BENCHMARK
+   cheevos_benchmark();
+#endif
+
    cheevos_locals.meminfo[0].id = RETRO_MEMORY_SYSTEM_RAM;
    core_get_memory(&cheevos_locals.meminfo[0]);
 
@@ -3254,6 +3690,7 @@ bool cheevos_unload(void)
 
    cheevos_free_cheevo_set(&cheevos_locals.core);
    cheevos_free_cheevo_set(&cheevos_locals.unofficial);
+   cheevos_free_program();
 
    cheevos_loaded = 0;
 
@@ -3289,6 +3726,11 @@ void cheevos_test(void)
 {
    settings_t *settings = config_get_ptr();
 
+   if (cheevos_locals.remap)
+      cheevos_resolve_memrefs();
+
+   cheevos_read_memrefs();
+
    cheevos_test_cheevo_set(&cheevos_locals.core);
 
    if (settings->cheevos.test_unofficial)
@@ -3313,3 +3755,8 @@ bool cheevos_get_support_cheevos(void)
 {
   return cheevos_locals.core_supports;
 }
+
+void cheevos_remap_memory(void)
+{
+   cheevos_locals.remap = true;
+}
@@ -61,6 +61,10 @@ void cheevos_set_support_cheevos(bool state);
 
 bool cheevos_get_support_cheevos(void);
 
+/* Re-resolve the memory addresses read by the achievements before the next
+ * test, must be called whenever the core's memory maps change. */
+void cheevos_remap_memory(void);
+
 void cheevos_parse_guest_addr(cheevos_var_t *var, unsigned value);
 
 uint8_t *cheevos_get_memory(const cheevos_var_t *var);
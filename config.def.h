@@ -435,6 +435,10 @@ static bool bundle_assets_extract_enable = false;
 static const bool def_history_list_enable = true;
 static const bool def_playlist_entry_remove = true;
 
+/* Save database collections in the binary playlist
+ * format, which is mapped instead of parsed on load. */
+static const bool def_playlist_binary_format = false;
+
 static const unsigned int def_user_language = 0;
 
 #if (defined(_WIN32) && !defined(_XBOX)) || (defined(__linux) && !defined(ANDROID) && !defined(HAVE_LAKKA)) || (defined(__MACH__) && !defined(IOS))
@@ -714,6 +718,9 @@ static const bool gpu_screenshot = true;
 /* Screenshots named automatically. */
 static const bool auto_screenshot_filename = true;
 
+/* zlib level used for PNG screenshots, 1 (fastest) to 9 (smallest). */
+static const unsigned screenshot_compression_level = 9;
+
 /* Record post-shaded GPU output instead of raw game footage if available. */
 static const bool gpu_record = false;
 
@@ -781,6 +788,11 @@ static const bool rate_control = false;
  * is allowed to adjust input rate. */
 static const float rate_control_delta = 0.005;
 
+/* Adaptive rate control. Tunes the rate control delta
+ * automatically based on buffer behavior, and compensates
+ * for steady-state clock drift. */
+static const bool rate_control_adaptive = false;
+
 /* Maximum timing skew. Defines how much adjust_system_rates
  * is allowed to adjust input rate. */
 static const float max_timing_skew = 0.05;
@@ -804,6 +816,14 @@ static const unsigned rewind_buffer_size = 20 << 20; /* 20MiB */
 /* How many frames to rewind at a time. */
 static const unsigned rewind_granularity = 1;
 
+/* Hides the game's own input lag by emulating frames ahead with the
+ * current input and rolling back with savestates every frame. */
+static const bool run_ahead_enabled = false;
+
+/* How many frames to run ahead. Each one costs a full extra frame of
+ * emulation, so keep it at or below the game's actual input lag. */
+static const unsigned run_ahead_frames = 1;
+
 /* Pause gameplay when gameplay loses focus. */
 #ifdef EMSCRIPTEN
 static const bool pause_nonactive = false;
@@ -831,6 +851,14 @@ static const unsigned netplay_delay_frames = 16;
 
 static const int netplay_check_frames = 30;
 
+/* Serve spectators that can't play from a relay thread, which sends
+ * everybody the same stream of input and lets new spectators join from a
+ * periodic keyframe instead of a fresh savestate. */
+static const bool netplay_spectator_relay = false;
+
+/* Frames between spectator relay keyframes. */
+static const unsigned netplay_relay_keyframe_interval = 600;
+
 /* On save state load, block SRAM from being overwritten.
  * This could potentially lead to buggy games. */
 static const bool block_sram_overwrite = false;
@@ -850,6 +878,12 @@ static const bool savestate_auto_load = false;
 
 static const bool savestate_thumbnail_enable = false;
 
+/* Compress savestates and embed their thumbnail and
+ * metadata in the same file. Uncompressed savestates
+ * can still be loaded. Off by default, since older
+ * versions can't read the compressed format. */
+static const bool savestate_file_compression = false;
+
 /* Slowmotion ratio. */
 static const float slowmotion_ratio = 3.0;
 
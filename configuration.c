@@ -731,6 +731,7 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
    SETTING_BOOL("netplay_public_announce",       &settings->netplay.public_announce, true, netplay_public_announce, false);
    SETTING_BOOL("netplay_stateless_mode",        &settings->netplay.stateless_mode, false, netplay_stateless_mode, false);
    SETTING_BOOL("netplay_client_swap_input",     &settings->netplay.swap_input, true, netplay_client_swap_input, false);
+   SETTING_BOOL("netplay_spectator_relay",       &settings->netplay.spectator_relay, true, netplay_spectator_relay, false);
 #endif
    SETTING_BOOL("input_descriptor_label_show",   &settings->input.input_descriptor_label_show, true, input_descriptor_label_show, false);
    SETTING_BOOL("input_descriptor_hide_unbound", &settings->input.input_descriptor_hide_unbound, true, input_descriptor_hide_unbound, false);
@@ -742,6 +743,7 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
    SETTING_BOOL("ui_menubar_enable",             &settings->ui.menubar_enable, true, true, false);
    SETTING_BOOL("suspend_screensaver_enable",    &settings->ui.suspend_screensaver_enable, true, true, false);
    SETTING_BOOL("rewind_enable",                 &settings->rewind_enable, true, rewind_enable, false);
+   SETTING_BOOL("run_ahead_enabled",             &settings->run_ahead_enabled, true, run_ahead_enabled, false);
    SETTING_BOOL("audio_sync",                    &settings->audio.sync, true, audio_sync, false);
    SETTING_BOOL("video_shader_enable",           &settings->video.shader_enable, true, shader_enable, false);
 
@@ -846,8 +848,10 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
    SETTING_BOOL("savestate_auto_save",          &settings->savestate_auto_save, true, savestate_auto_save, false);
    SETTING_BOOL("savestate_auto_load",          &settings->savestate_auto_load, true, savestate_auto_load, false);
    SETTING_BOOL("savestate_thumbnail_enable",   &settings->savestate_thumbnail_enable, true, savestate_thumbnail_enable, false);
+   SETTING_BOOL("savestate_file_compression",   &settings->savestate_file_compression, true, savestate_file_compression, false);
    SETTING_BOOL("history_list_enable",          &settings->history_list_enable, true, def_history_list_enable, false);
    SETTING_BOOL("playlist_entry_remove",        &settings->playlist_entry_remove, true, def_playlist_entry_remove, false);
+   SETTING_BOOL("playlist_binary_format",       &settings->playlist_binary_format, true, def_playlist_binary_format, false);
    SETTING_BOOL("game_specific_options",        &settings->game_specific_options, true, default_game_specific_options, false);
    SETTING_BOOL("auto_overrides_enable",        &settings->auto_overrides_enable, true, default_auto_overrides_enable, false);
    SETTING_BOOL("auto_remaps_enable",           &settings->auto_remaps_enable, true, default_auto_remaps_enable, false);
@@ -858,6 +862,7 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
    SETTING_BOOL("show_hidden_files",            &settings->show_hidden_files, true, show_hidden_files, false);
    SETTING_BOOL("input_autodetect_enable",      &settings->input.autodetect_enable, true, input_autodetect_enable, false);
    SETTING_BOOL("audio_rate_control",           &settings->audio.rate_control, true, rate_control, false);
+   SETTING_BOOL("audio_rate_control_adaptive",  &settings->audio.rate_control_adaptive, true, rate_control_adaptive, false);
 
    if (global)
    {
@@ -914,6 +919,8 @@ static struct config_int_setting *populate_settings_int(settings_t *settings, in
    SETTING_INT("audio_latency",                &settings->audio.latency, false, 0 /* TODO */, false);
    SETTING_INT("audio_block_frames",           &settings->audio.block_frames, true, 0, false);
    SETTING_INT("rewind_granularity",           &settings->rewind_granularity, true, rewind_granularity, false);
+   SETTING_INT("run_ahead_frames",             &settings->run_ahead_frames, true, run_ahead_frames, false);
+   SETTING_INT("screenshot_compression_level", &settings->screenshot_compression_level, true, screenshot_compression_level, false);
    SETTING_INT("autosave_interval",            &settings->autosave_interval,  true, autosave_interval, false);
    SETTING_INT("libretro_log_level",           &settings->libretro_log_level, true, libretro_log_level, false);
    SETTING_INT("keyboard_gamepad_mapping_type",&settings->input.keyboard_gamepad_mapping_type, true, 1, false);
@@ -967,6 +974,7 @@ static struct config_int_setting *populate_settings_int(settings_t *settings, in
    SETTING_INT("netplay_check_frames",         (unsigned*)&settings->netplay.check_frames, true, netplay_check_frames, false);
    SETTING_INT("netplay_input_latency_frames_min",&settings->netplay.input_latency_frames_min, true, 0, false);
    SETTING_INT("netplay_input_latency_frames_range",&settings->netplay.input_latency_frames_range, true, 0, false);
+   SETTING_INT("netplay_relay_keyframe_interval", &settings->netplay.relay_keyframe_interval, true, netplay_relay_keyframe_interval, false);
 #endif
 #ifdef HAVE_LANGEXTRA
    SETTING_INT("user_language",                &settings->user_language, true, RETRO_LANGUAGE_ENGLISH, false);
@@ -2003,6 +2011,18 @@ static bool config_load_file(const char *path, bool set_defaults,
    if (settings->video.frame_delay > 15)
       settings->video.frame_delay = 15;
 
+   if (settings->run_ahead_frames > 6)
+   {
+      RARCH_WARN("run_ahead_frames is limited to 6, using 6 instead of %u.\n",
+            settings->run_ahead_frames);
+      settings->run_ahead_frames = 6;
+   }
+
+   if (settings->screenshot_compression_level < 1)
+      settings->screenshot_compression_level = 1;
+   if (settings->screenshot_compression_level > 9)
+      settings->screenshot_compression_level = 9;
+
    settings->video.swap_interval = MAX(settings->video.swap_interval, 1);
    settings->video.swap_interval = MIN(settings->video.swap_interval, 4);
 
@@ -252,6 +252,7 @@ typedef struct settings
 
 
       bool rate_control;
+      bool rate_control_adaptive;
       float rate_control_delta;
       float max_timing_skew;
       float volume; /* dB scale. */
@@ -414,6 +415,8 @@ typedef struct settings
       bool nat_traversal;
       char password[128];
       char spectate_password[128];
+      bool spectator_relay;
+      unsigned relay_keyframe_interval;
    } netplay;
 #endif
 
@@ -422,13 +425,18 @@ typedef struct settings
    unsigned libretro_log_level;
 
    bool auto_screenshot_filename;
+   unsigned screenshot_compression_level;
 
    bool history_list_enable;
    bool playlist_entry_remove;
+   bool playlist_binary_format;
    bool rewind_enable;
    size_t rewind_buffer_size;
    unsigned rewind_granularity;
 
+   bool run_ahead_enabled;
+   unsigned run_ahead_frames;
+
    float slowmotion_ratio;
    float fastforward_ratio;
 
@@ -440,6 +448,7 @@ typedef struct settings
    bool savestate_auto_save;
    bool savestate_auto_load;
    bool savestate_thumbnail_enable;
+   bool savestate_file_compression;
 
    bool network_cmd_enable;
    unsigned network_cmd_port;
@@ -177,6 +177,8 @@ bool core_set_poll_type(unsigned *type);
 /* Runs the core for one frame. */
 bool core_run(void);
 
+bool core_run_ahead(unsigned frames);
+
 bool core_init(void);
 
 bool core_deinit(void *data);
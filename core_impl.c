@@ -40,6 +40,7 @@
 #include "dynamic.h"
 #include "msg_hash.h"
 #include "managers/state_manager.h"
+#include "movie.h"
 #include "verbosity.h"
 #include "gfx/video_driver.h"
 #include "audio/audio_driver.h"
@@ -52,6 +53,10 @@ static bool                core_input_polled              = false;
 static bool                core_has_set_input_descriptors = false;
 static uint64_t            core_serialization_quirks_v    = 0;
 
+static void               *core_run_ahead_state           = NULL;
+static size_t              core_run_ahead_state_size      = 0;
+static bool                core_run_ahead_unavailable     = false;
+
 static struct              retro_callbacks retro_ctx;
 static struct              retro_core_t core;
 
@@ -286,6 +291,9 @@ bool core_load_game(retro_ctx_load_content_info_t *load_info)
 
    content_get_status(&contentless, &is_inited);
 
+   /* Give run-ahead another chance with the new content */
+   core_run_ahead_unavailable = false;
+
    if (load_info && load_info->special)
       core_game_loaded = core.retro_load_game_special(
             load_info->special->id, load_info->info, load_info->content->size);
@@ -401,6 +409,11 @@ bool core_unload(void)
 
 bool core_unload_game(void)
 {
+   free(core_run_ahead_state);
+   core_run_ahead_state       = NULL;
+   core_run_ahead_state_size  = 0;
+   core_run_ahead_unavailable = false;
+
    video_driver_free_hw_context();
    audio_driver_stop();
    core.retro_unload_game();
@@ -445,6 +458,152 @@ bool core_run(void)
    return true;
 }
 
+static void core_video_refresh_null(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+}
+
+static void core_audio_sample_null(int16_t left, int16_t right)
+{
+}
+
+static size_t core_audio_sample_batch_null(const int16_t *data, size_t frames)
+{
+   return frames;
+}
+
+/**
+ * core_set_run_ahead_callbacks:
+ * @video          : pass video frames on to the video driver
+ * @audio          : pass audio samples on to the audio driver
+ *
+ * Sets the audio and video callbacks used while running ahead, so that
+ * speculative frames are neither shown nor heard.
+ **/
+static void core_set_run_ahead_callbacks(bool video, bool audio)
+{
+   core.retro_set_video_refresh(video
+         ? video_driver_frame : core_video_refresh_null);
+
+   if (audio)
+      core_set_rewind_callbacks();
+   else
+   {
+      core.retro_set_audio_sample(core_audio_sample_null);
+      core.retro_set_audio_sample_batch(core_audio_sample_batch_null);
+   }
+}
+
+static bool core_run_ahead_is_possible(void)
+{
+   retro_ctx_size_info_t info;
+
+   if (core_run_ahead_unavailable)
+      return false;
+
+#ifdef HAVE_NETWORKING
+   /* Netplay already does its own rollback and owns the callbacks */
+   if (netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_DATA_INITED, NULL))
+      return false;
+#endif
+
+   /* Speculative frames would poll input into the movie */
+   if (bsv_movie_ctl(BSV_MOVIE_CTL_IS_INITED, NULL))
+      return false;
+
+   if (state_manager_frame_is_reversed())
+      return false;
+
+   if (core_serialization_quirks_v & RETRO_SERIALIZATION_QUIRK_INCOMPLETE)
+   {
+      RARCH_WARN("Run-ahead disabled: core savestates are incomplete.\n");
+      core_run_ahead_unavailable = true;
+      return false;
+   }
+
+   /* The size may change as the core runs, so check every frame */
+   core_serialize_size(&info);
+   if (!info.size)
+   {
+      RARCH_WARN("Run-ahead disabled: core does not support savestates.\n");
+      core_run_ahead_unavailable = true;
+      return false;
+   }
+
+   if (info.size > core_run_ahead_state_size)
+   {
+      void *state = realloc(core_run_ahead_state, info.size);
+      if (!state)
+         return false;
+      core_run_ahead_state = state;
+   }
+   core_run_ahead_state_size = info.size;
+
+   return true;
+}
+
+/**
+ * core_run_ahead:
+ * @frames         : number of frames to run ahead
+ *
+ * Runs the real frame with its audio, saves its state, then runs @frames
+ * more frames with the same input and shows only the last of them before
+ * rolling back to the saved state. This hides up to @frames frames of the
+ * game's own input lag at the cost of emulating @frames + 1 frames.
+ *
+ * Falls back to core_run() when the core can't be rolled back.
+ *
+ * Returns: false if the rollback itself failed, leaving the core
+ * @frames frames ahead of the real input. Later calls then just run
+ * the core until new content is loaded.
+ **/
+bool core_run_ahead(unsigned frames)
+{
+   unsigned i;
+   retro_ctx_serialize_info_t info;
+
+   if (!frames || !core_run_ahead_is_possible())
+      return core_run();
+
+   core_set_run_ahead_callbacks(false, true);
+   core_run();
+
+   info.data       = core_run_ahead_state;
+   info.data_const = core_run_ahead_state;
+   info.size       = core_run_ahead_state_size;
+
+   if (!core_serialize(&info))
+   {
+      /* Some cores can't save until they've run a few frames */
+      if (!(core_serialization_quirks_v &
+               RETRO_SERIALIZATION_QUIRK_MUST_INITIALIZE))
+      {
+         RARCH_WARN("Run-ahead disabled: core failed to save state.\n");
+         core_run_ahead_unavailable = true;
+      }
+      core_set_run_ahead_callbacks(true, true);
+      video_driver_cached_frame();
+      return true;
+   }
+
+   core_set_run_ahead_callbacks(false, false);
+   for (i = 1; i < frames; i++)
+      core_run();
+
+   core_set_run_ahead_callbacks(true, false);
+   core_run();
+
+   core_set_run_ahead_callbacks(true, true);
+
+   if (!core.retro_unserialize(info.data_const, info.size))
+   {
+      core_run_ahead_unavailable = true;
+      return false;
+   }
+
+   return true;
+}
+
 bool core_load(unsigned poll_type_behavior)
 {
    core_poll_type = poll_type_behavior;
@@ -22,6 +22,8 @@ extern "C" {
 #include <libavutil/imgutils.h>
 #include <libavutil/time.h>
 #include <libavutil/opt.h>
+#include <libavutil/cpu.h>
+#include <libavutil/pixdesc.h>
 #include <libavdevice/avdevice.h>
 #ifdef HAVE_SWRESAMPLE
 #include <libswresample/swresample.h>
@@ -45,6 +47,7 @@ extern "C" {
 
 #include <rthreads/rthreads.h>
 #include <queues/fifo_queue.h>
+#include <retro_miscellaneous.h>
 
 #include <libretro.h>
 #ifdef RARCH_INTERNAL
@@ -128,7 +131,6 @@ static double pts_bias;
 
 /* Threaded FIFOs. */
 static volatile bool decode_thread_dead;
-static fifo_buffer_t *video_decode_fifo;
 static fifo_buffer_t *audio_decode_fifo;
 static scond_t *fifo_cond;
 static scond_t *fifo_decode_cond;
@@ -138,10 +140,58 @@ static sthread_t *decode_thread_handle;
 static double decode_last_video_time;
 static double decode_last_audio_time;
 
-static uint32_t *video_frame_temp_buffer;
-
 static bool main_sleeping;
 
+/* Decoded video frames, passed between the decode thread
+ * and the main thread by index. Free buffers are kept on a
+ * stack, decoded ones in a ring in presentation order.
+ * The buffer on display is held by the main thread until
+ * the next one is shown, as the frontend may keep using it.
+ * Protected by fifo_lock. */
+#define MAX_DECODE_AHEAD 32
+
+struct video_buffer
+{
+   uint32_t *data;
+   int64_t pts;
+};
+
+static struct video_buffer video_buffers[MAX_DECODE_AHEAD + 1];
+static unsigned video_buffers_num;
+static unsigned video_buffer_free[MAX_DECODE_AHEAD + 1];
+static unsigned video_buffer_free_num;
+static unsigned video_buffer_ring[MAX_DECODE_AHEAD + 1];
+static unsigned video_buffer_head;
+static unsigned video_buffer_tail;
+static int video_buffer_display = -1;
+
+/* Color conversion is split into horizontal bands,
+ * band 0 runs on the decode thread. */
+#define MAX_SWS_SLICES 8
+
+struct sws_slice
+{
+   struct SwsContext *ctx;
+   sthread_t *thread;
+   const AVFrame *src;
+   uint32_t *dst;
+   unsigned y;
+   unsigned height;
+};
+
+static struct sws_slice sws_slices[MAX_SWS_SLICES];
+static unsigned sws_slices_num;
+static unsigned sws_pending;
+static unsigned sws_generation;
+static bool sws_quit;
+static slock_t *sws_lock;
+static scond_t *sws_cond;
+static scond_t *sws_done_cond;
+
+/* Decoder threads, 0 lets libavcodec decide. */
+static unsigned decode_threads;
+static unsigned decode_ahead;
+
 /* Seeking. */
 static bool do_seek;
 static double seek_time;
@@ -279,6 +329,8 @@ void CORE_PREFIX(retro_set_environment)(retro_environment_t cb)
 #endif
 #endif
       { "ffmpeg_color_space", "Colorspace; auto|BT.709|BT.601|FCC|SMPTE240M" },
+      { "ffmpeg_decode_threads", "Decoder Threads (Restart); auto|1|2|4|6|8|12|16" },
+      { "ffmpeg_decode_ahead", "Decode-ahead Frames (Restart); 8|2|4|16|32" },
       { NULL, NULL },
    };
    struct retro_log_callback log;
@@ -387,6 +439,83 @@ static void check_variables(void)
    }
 }
 
+/* Only read when loading, the decoder and
+ * frame buffers are set up once. */
+static void check_load_variables(void)
+{
+   struct retro_variable threads_var = {0};
+   struct retro_variable ahead_var   = {0};
+
+   decode_threads = 0;
+   decode_ahead   = 8;
+
+   threads_var.key = "ffmpeg_decode_threads";
+
+   if (CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_GET_VARIABLE, &threads_var) && threads_var.value)
+   {
+      if (strcmp(threads_var.value, "auto"))
+         decode_threads = strtoul(threads_var.value, NULL, 0);
+   }
+
+   ahead_var.key = "ffmpeg_decode_ahead";
+
+   if (CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_GET_VARIABLE, &ahead_var) && ahead_var.value)
+      decode_ahead = strtoul(ahead_var.value, NULL, 0);
+
+   if (decode_ahead < 2)
+      decode_ahead = 2;
+   if (decode_ahead > MAX_DECODE_AHEAD)
+      decode_ahead = MAX_DECODE_AHEAD;
+}
+
+/* Must be called with fifo_lock held. */
+static void video_buffer_flush(void)
+{
+   while (video_buffer_head != video_buffer_tail)
+      video_buffer_free[video_buffer_free_num++] =
+         video_buffer_ring[video_buffer_head++ % video_buffers_num];
+}
+
+static bool video_buffer_init(void)
+{
+   unsigned i;
+
+   /* One extra for the frame on display. */
+   video_buffers_num     = decode_ahead + 1;
+   video_buffer_free_num = 0;
+   video_buffer_head     = 0;
+   video_buffer_tail     = 0;
+   video_buffer_display  = -1;
+
+   for (i = 0; i < video_buffers_num; i++)
+   {
+      video_buffers[i].data = (uint32_t*)
+         av_malloc(media.width * media.height * sizeof(uint32_t));
+      video_buffers[i].pts  = 0;
+
+      if (!video_buffers[i].data)
+         return false;
+
+      video_buffer_free[video_buffer_free_num++] = i;
+   }
+
+   return true;
+}
+
+static void video_buffer_deinit(void)
+{
+   unsigned i;
+
+   for (i = 0; i < MAX_DECODE_AHEAD + 1; i++)
+      av_freep(&video_buffers[i].data);
+
+   video_buffers_num     = 0;
+   video_buffer_free_num = 0;
+   video_buffer_head     = 0;
+   video_buffer_tail     = 0;
+   video_buffer_display  = -1;
+}
+
 static void seek_frame(int seek_frames)
 {
    char msg[256];
@@ -415,8 +544,7 @@ static void seek_frame(int seek_frames)
    }
    audio_frames = frame_cnt * media.sample_rate / media.interpolate_fps;
 
-   if (video_decode_fifo)
-      fifo_clear(video_decode_fifo);
+   video_buffer_flush();
    if (audio_decode_fifo)
       fifo_clear(audio_decode_fifo);
    scond_signal(fifo_decode_cond);
@@ -609,13 +737,12 @@ void CORE_PREFIX(retro_run)(void)
 
       while (!decode_thread_dead && min_pts > frames[1].pts)
       {
-         size_t to_read_frame_bytes;
-         int64_t pts = 0;
+         int64_t pts          = 0;
+         const uint32_t *data = NULL;
 
          slock_lock(fifo_lock);
-         to_read_frame_bytes = media.width * media.height * sizeof(uint32_t) + sizeof(int64_t);
 
-         while (!decode_thread_dead && fifo_read_avail(video_decode_fifo) < to_read_frame_bytes)
+         while (!decode_thread_dead && video_buffer_head == video_buffer_tail)
          {
             main_sleeping = true;
             scond_signal(fifo_decode_cond);
@@ -625,24 +752,39 @@ void CORE_PREFIX(retro_run)(void)
 
          if (!decode_thread_dead)
          {
-            uint32_t *data = video_frame_temp_buffer;
-            fifo_read(video_decode_fifo, &pts, sizeof(int64_t));
+            /* The previous frame is not needed by anyone anymore. */
+            if (video_buffer_display >= 0)
+               video_buffer_free[video_buffer_free_num++] = video_buffer_display;
+
+            video_buffer_display = video_buffer_ring[
+               video_buffer_head++ % video_buffers_num];
+            data = video_buffers[video_buffer_display].data;
+            pts  = video_buffers[video_buffer_display].pts;
+         }
+
+         scond_signal(fifo_decode_cond);
+         slock_unlock(fifo_lock);
+
+         /* The decode thread doesn't touch the buffer
+          * on display, so it can be used unlocked. */
+         if (data)
+         {
 #if defined(HAVE_OPENGL) || defined(HAVE_OPENGLES)
             if (use_gl)
             {
 #ifndef HAVE_OPENGLES
+               uint32_t *pbo_data = NULL;
+
                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frames[1].pbo);
 #ifdef __MACH__
-               data = (uint32_t*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+               pbo_data = (uint32_t*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
 #else
-               data = (uint32_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+               pbo_data = (uint32_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
                      0, media.width * media.height * sizeof(uint32_t), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
-#endif
 #endif
 
-               fifo_read(video_decode_fifo, data, media.width * media.height * sizeof(uint32_t));
+               memcpy(pbo_data, data, media.width * media.height * sizeof(uint32_t));
 
-#ifndef HAVE_OPENGLES
                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 #endif
                glBindTexture(GL_TEXTURE_2D, frames[1].tex);
@@ -660,15 +802,9 @@ void CORE_PREFIX(retro_run)(void)
             }
             else
 #endif
-            {
-               fifo_read(video_decode_fifo, data, media.width * media.height * sizeof(uint32_t));
                dupe = false;
-            }
          }
 
-         scond_signal(fifo_decode_cond);
-         slock_unlock(fifo_lock);
-
          frames[1].pts = av_q2d(fctx->streams[video_stream]->time_base) * pts;
       }
 
@@ -718,7 +854,8 @@ void CORE_PREFIX(retro_run)(void)
       else
 #endif
       {
-         CORE_PREFIX(video_cb)(dupe ? NULL : video_frame_temp_buffer,
+         CORE_PREFIX(video_cb)(dupe ? NULL
+               : video_buffers[video_buffer_display].data,
                media.width, media.height, media.width * sizeof(uint32_t));
       }
    }
@@ -764,6 +901,13 @@ static bool open_codec(AVCodecContext **ctx, unsigned index)
    }
 
    *ctx = fctx->streams[index]->codec;
+
+   if ((*ctx)->codec_type == AVMEDIA_TYPE_VIDEO)
+   {
+      (*ctx)->thread_count = decode_threads;
+      (*ctx)->thread_type  = FF_THREAD_FRAME | FF_THREAD_SLICE;
+   }
+
    if (avcodec_open2(*ctx, codec, NULL) < 0)
       return false;
 
@@ -994,8 +1138,196 @@ static void set_colorspace(struct SwsContext *sws,
    }
 }
 
-static bool decode_video(AVPacket *pkt, AVFrame *frame,
-      AVFrame *conv, struct SwsContext *sws)
+static void scale_slice(struct sws_slice *slice)
+{
+   unsigned i;
+   unsigned planes = 0;
+   const uint8_t *src[4];
+   uint8_t *dst[4]                = {NULL};
+   int dst_stride[4]              = {0};
+   const AVFrame *frame           = slice->src;
+   const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(
+         (enum AVPixelFormat)frame->format);
+
+   if (!slice->height || !desc)
+      return;
+
+   slice->ctx = sws_getCachedContext(slice->ctx,
+         media.width, slice->height, (enum AVPixelFormat)frame->format,
+         media.width, slice->height, PIX_FMT_RGB32,
+         SWS_POINT, NULL, NULL, NULL);
+
+   if (!slice->ctx)
+      return;
+
+   set_colorspace(slice->ctx, media.width, media.height,
+         av_frame_get_colorspace(frame), av_frame_get_color_range(frame));
+
+   for (i = 0; i < desc->nb_components; i++)
+      if (desc->comp[i].plane >= planes)
+         planes = desc->comp[i].plane + 1;
+
+   /* Only offset image planes, not palettes. */
+   for (i = 0; i < 4; i++)
+   {
+      unsigned shift = ((i == 1 || i == 2)
+            && !(desc->flags & AV_PIX_FMT_FLAG_RGB))
+         ? desc->log2_chroma_h : 0;
+
+      src[i] = frame->data[i];
+
+      if (src[i] && i < planes)
+         src[i] += (slice->y >> shift) * frame->linesize[i];
+   }
+
+   dst[0]        = (uint8_t*)(slice->dst + slice->y * media.width);
+   dst_stride[0] = media.width * sizeof(uint32_t);
+
+   sws_scale(slice->ctx, src, frame->linesize, 0, slice->height,
+         dst, dst_stride);
+}
+
+static void sws_slice_thread(void *data)
+{
+   struct sws_slice *slice = (struct sws_slice*)data;
+   unsigned generation     = 0;
+
+   slock_lock(sws_lock);
+
+   for (;;)
+   {
+      while (!sws_quit && generation == sws_generation)
+         scond_wait(sws_cond, sws_lock);
+
+      if (sws_quit)
+         break;
+
+      generation = sws_generation;
+      slock_unlock(sws_lock);
+
+      scale_slice(slice);
+
+      slock_lock(sws_lock);
+      if (--sws_pending == 0)
+         scond_signal(sws_done_cond);
+   }
+
+   slock_unlock(sws_lock);
+}
+
+static void sws_slices_init(void)
+{
+   unsigned i;
+   unsigned num = decode_threads ? decode_threads : av_cpu_count();
+
+   /* Bands narrower than this aren't worth a thread. */
+   if (num > media.height / 64)
+      num = media.height / 64;
+   if (num > MAX_SWS_SLICES)
+      num = MAX_SWS_SLICES;
+   if (num < 1)
+      num = 1;
+
+   sws_slices_num = 1;
+   sws_pending    = 0;
+   sws_generation = 0;
+   sws_quit       = false;
+   memset(sws_slices, 0, sizeof(sws_slices));
+
+   if (num < 2)
+      return;
+
+   sws_lock      = slock_new();
+   sws_cond      = scond_new();
+   sws_done_cond = scond_new();
+
+   for (i = 1; i < num; i++)
+   {
+      sws_slices[i].thread = sthread_create(sws_slice_thread, &sws_slices[i]);
+      if (!sws_slices[i].thread)
+         break;
+      sws_slices_num++;
+   }
+}
+
+static void sws_slices_deinit(void)
+{
+   unsigned i;
+
+   if (sws_lock)
+   {
+      slock_lock(sws_lock);
+      sws_quit = true;
+      scond_broadcast(sws_cond);
+      slock_unlock(sws_lock);
+   }
+
+   for (i = 0; i < sws_slices_num; i++)
+   {
+      if (sws_slices[i].thread)
+         sthread_join(sws_slices[i].thread);
+      if (sws_slices[i].ctx)
+         sws_freeContext(sws_slices[i].ctx);
+   }
+
+   if (sws_lock)
+      slock_free(sws_lock);
+   if (sws_cond)
+      scond_free(sws_cond);
+   if (sws_done_cond)
+      scond_free(sws_done_cond);
+
+   memset(sws_slices, 0, sizeof(sws_slices));
+   sws_slices_num = 0;
+   sws_lock       = NULL;
+   sws_cond       = NULL;
+   sws_done_cond  = NULL;
+}
+
+/* Converts straight into a frame buffer, band by band. */
+static void scale_frame(const AVFrame *frame, uint32_t *dst)
+{
+   unsigned i;
+   const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(
+         (enum AVPixelFormat)frame->format);
+   unsigned align  = desc ? 1 << desc->log2_chroma_h : 1;
+   unsigned band   = (media.height + sws_slices_num - 1) / sws_slices_num;
+
+   /* Keep chroma rows whole within a band. */
+   band = (band + align - 1) & ~(align - 1);
+
+   for (i = 0; i < sws_slices_num; i++)
+   {
+      unsigned y = i * band;
+
+      sws_slices[i].src    = frame;
+      sws_slices[i].dst    = dst;
+      sws_slices[i].y      = y;
+      sws_slices[i].height = y < media.height
+         ? MIN(band, media.height - y) : 0;
+   }
+
+   if (sws_slices_num > 1)
+   {
+      slock_lock(sws_lock);
+      sws_pending = sws_slices_num - 1;
+      sws_generation++;
+      scond_broadcast(sws_cond);
+      slock_unlock(sws_lock);
+   }
+
+   scale_slice(&sws_slices[0]);
+
+   if (sws_slices_num > 1)
+   {
+      slock_lock(sws_lock);
+      while (sws_pending)
+         scond_wait(sws_done_cond, sws_lock);
+      slock_unlock(sws_lock);
+   }
+}
+
+static bool decode_video(AVPacket *pkt, AVFrame *frame)
 {
    int got_ptr = 0;
    int ret     = avcodec_decode_video2(vctx, frame, &got_ptr, pkt);
@@ -1003,17 +1335,7 @@ static bool decode_video(AVPacket *pkt, AVFrame *frame,
    if (ret < 0)
       return false;
 
-   if (got_ptr)
-   {
-      set_colorspace(sws, media.width, media.height,
-            av_frame_get_colorspace(frame), av_frame_get_color_range(frame));
-      sws_scale(sws, (const uint8_t * const*)frame->data,
-            frame->linesize, 0, media.height,
-            conv->data, conv->linesize);
-      return true;
-   }
-
-   return false;
+   return got_ptr;
 }
 
 static int16_t *decode_audio(AVCodecContext *ctx, AVPacket *pkt,
@@ -1109,11 +1431,8 @@ static void decode_thread_seek(double time)
 #ifdef HAVE_SSA
 /* Straight CPU alpha blending.
  * Should probably do in GL. */
-static void render_ass_img(AVFrame *conv_frame, ASS_Image *img)
+static void render_ass_img(uint32_t *frame, int stride, ASS_Image *img)
 {
-   uint32_t *frame = (uint32_t*)conv_frame->data[0];
-   int      stride = conv_frame->linesize[0] / sizeof(uint32_t);
-
    for (; img; img = img->next)
    {
       int x, y;
@@ -1163,20 +1482,13 @@ static void decode_thread(void *data)
    SwrContext *swr[audio_streams_num];
    AVFrame *aud_frame      = NULL;
    AVFrame *vid_frame      = NULL;
-   void *conv_frame_buf    = NULL;
-   size_t frame_size       = 0;
    int16_t *audio_buffer   = NULL;
    size_t audio_buffer_cap = 0;
-   AVFrame *conv_frame     = NULL;
-   struct SwsContext *sws  = NULL;
 
    (void)data;
    
    if (video_stream >= 0)
-      sws = sws_getCachedContext(NULL,
-            media.width, media.height, vctx->pix_fmt,
-            media.width, media.height, PIX_FMT_RGB32,
-            SWS_POINT, NULL, NULL, NULL);
+      sws_slices_init();
 
    for (i = 0; (int)i < audio_streams_num; i++)
    {
@@ -1194,15 +1506,6 @@ static void decode_thread(void *data)
    aud_frame = av_frame_alloc();
    vid_frame = av_frame_alloc();
 
-   if (video_stream >= 0)
-   {
-      frame_size = avpicture_get_size(PIX_FMT_RGB32, media.width, media.height);
-      conv_frame = av_frame_alloc();
-      conv_frame_buf = av_malloc(frame_size);
-      avpicture_fill((AVPicture*)conv_frame, (const uint8_t*)conv_frame_buf,
-            PIX_FMT_RGB32, media.width, media.height);
-   }
-
    while (!decode_thread_dead)
    {
       bool seek;
@@ -1229,8 +1532,7 @@ static void decode_thread(void *data)
          do_seek = false;
          seek_time = 0.0;
 
-         if (video_decode_fifo)
-            fifo_clear(video_decode_fifo);
+         video_buffer_flush();
          if (audio_decode_fifo)
             fifo_clear(audio_decode_fifo);
 
@@ -1255,56 +1557,57 @@ static void decode_thread(void *data)
 
       if (pkt.stream_index == video_stream)
       {
-         if (decode_video(&pkt, vid_frame, conv_frame, sws))
+         if (decode_video(&pkt, vid_frame))
          {
-            size_t decoded_size;
+            int index         = -1;
             int64_t pts       = av_frame_get_best_effort_timestamp(vid_frame);
             double video_time = pts * av_q2d(fctx->streams[video_stream]->time_base);
 
-#ifdef HAVE_SSA
-            if (ass_render && ass_track_active)
-            {
-               int change     = 0;
-               ASS_Image *img = ass_render_frame(ass_render, ass_track_active,
-                     1000 * video_time, &change);
-
-               /* Do it on CPU for now.
-                * We're in a thread anyways, so shouldn't really matter. */
-               render_ass_img(conv_frame, img);
-            }
-#endif
-
-            decoded_size = frame_size + sizeof(pts);
             slock_lock(fifo_lock);
 
-            while (!decode_thread_dead  && (video_decode_fifo != NULL)
-                  && fifo_write_avail(video_decode_fifo) < decoded_size)
+            while (!decode_thread_dead && !video_buffer_free_num)
             {
                if (!main_sleeping)
                   scond_wait(fifo_decode_cond, fifo_lock);
                else
                {
-                  fifo_clear(video_decode_fifo);
-                  break;
+                  /* Main thread waits on audio, drop the oldest frame. */
+                  video_buffer_free[video_buffer_free_num++] =
+                     video_buffer_ring[video_buffer_head++ % video_buffers_num];
                }
             }
 
-            decode_last_video_time = video_time;
             if (!decode_thread_dead)
+               index = video_buffer_free[--video_buffer_free_num];
+
+            slock_unlock(fifo_lock);
+
+            if (index >= 0)
             {
-               int stride;
-               unsigned y;
-               const uint8_t *src = NULL;
-               
-               fifo_write(video_decode_fifo, &pts, sizeof(pts));
-               src    = conv_frame->data[0];
-               stride = conv_frame->linesize[0];
-
-               for (y = 0; y < media.height; y++, src += stride)
-                  fifo_write(video_decode_fifo, src, media.width * sizeof(uint32_t));
+               uint32_t *buffer = video_buffers[index].data;
+
+               scale_frame(vid_frame, buffer);
+
+#ifdef HAVE_SSA
+               if (ass_render && ass_track_active)
+               {
+                  int change     = 0;
+                  ASS_Image *img = ass_render_frame(ass_render, ass_track_active,
+                        1000 * video_time, &change);
+
+                  /* Do it on CPU for now.
+                   * We're in a thread anyways, so shouldn't really matter. */
+                  render_ass_img(buffer, media.width, img);
+               }
+#endif
+
+               slock_lock(fifo_lock);
+               video_buffers[index].pts = pts;
+               video_buffer_ring[video_buffer_tail++ % video_buffers_num] = index;
+               decode_last_video_time = video_time;
+               scond_signal(fifo_cond);
+               slock_unlock(fifo_lock);
             }
-            scond_signal(fifo_cond);
-            slock_unlock(fifo_lock);
          }
       }
       else if (pkt.stream_index == audio_stream && actx_active)
@@ -1344,17 +1647,13 @@ static void decode_thread(void *data)
       av_free_packet(&pkt);
    }
 
-   if (sws)
-      sws_freeContext(sws);
-   sws = NULL;
+   sws_slices_deinit();
 
    for (i = 0; (int)i < audio_streams_num; i++)
       swr_free(&swr[i]);
 
    av_frame_free(&aud_frame);
    av_frame_free(&vid_frame);
-   av_frame_free(&conv_frame);
-   av_freep(&conv_frame_buf);
    av_freep(&audio_buffer);
 
    slock_lock(fifo_lock);
@@ -1484,8 +1783,6 @@ void CORE_PREFIX(retro_unload_game)(void)
    if (decode_thread_lock)
       slock_free(decode_thread_lock);
 
-   if (video_decode_fifo)
-      fifo_free(video_decode_fifo);
    if (audio_decode_fifo)
       fifo_free(audio_decode_fifo);
 
@@ -1493,7 +1790,6 @@ void CORE_PREFIX(retro_unload_game)(void)
    fifo_decode_cond = NULL;
    fifo_lock = NULL;
    decode_thread_lock = NULL;
-   video_decode_fifo = NULL;
    audio_decode_fifo = NULL;
 
    decode_last_video_time = 0.0;
@@ -1550,7 +1846,7 @@ void CORE_PREFIX(retro_unload_game)(void)
    ass = NULL;
 #endif
 
-   av_freep(&video_frame_temp_buffer);
+   video_buffer_deinit();
 }
 
 bool CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
@@ -1593,6 +1889,8 @@ bool CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
 
    av_dump_format(fctx, 0, info->path, 0);
 
+   check_load_variables();
+
    if (!open_codecs())
    {
       LOG_ERR("Failed to find codec.");
@@ -1609,10 +1907,14 @@ bool CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
    is_glfft = video_stream < 0 && audio_streams_num > 0;
 #endif
 
+   if (video_stream >= 0 && !video_buffer_init())
+   {
+      LOG_ERR("Failed to allocate frame buffers.");
+      goto error;
+   }
+
    if (video_stream >= 0 || is_glfft)
    {
-      video_decode_fifo = fifo_new(media.width 
-            * media.height * sizeof(uint32_t) * 32);
 
 #if defined(HAVE_OPENGL) || defined(HAVE_OPENGLES)
       use_gl = true;
@@ -1651,9 +1953,6 @@ bool CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
 
    decode_thread_handle = sthread_create(decode_thread, NULL);
 
-   video_frame_temp_buffer = (uint32_t*)
-      av_malloc(media.width * media.height * sizeof(uint32_t));
-
    pts_bias = 0.0;
 
    return true;
@@ -9,6 +9,13 @@
 #include <file/file_path.h>
 #include <compat/strl.h>
 #include <retro_environment.h>
+#include <retro_miscellaneous.h>
+#include <gfx/scaler/scaler.h>
+#include <features/features_cpu.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #if defined(HAVE_RPNG) || defined(HAVE_RJPEG) || defined(HAVE_RTGA) || defined(HAVE_RBMP)
 #define PREFER_NON_STB_IMAGE
@@ -53,15 +60,58 @@ static retro_environment_t IMAGE_CORE_PREFIX(environ_cb);
 
 static bool      process_new_image;
 static uint32_t* image_buffer;
-#ifndef STB_IMAGE_IMPLEMENTATION
-static struct texture_image image_texture;
-#endif
 static int       image_width;
 static int       image_height;
 static bool      image_uploaded;
 static bool      slideshow_enable;
+static bool      image_supports_rgba;
+static int       image_index;
 struct string_list *file_list;
 
+/* Decoded images, looked up by their index in file_list.
+ * Images around the one on screen are decoded ahead of time
+ * by a pool of threads, least recently used ones are dropped
+ * when the cache grows past its budget. */
+#define IMAGE_CACHE_ENTRIES 64
+#define IMAGE_MAX_THREADS   4
+
+enum image_entry_state
+{
+   IMAGE_ENTRY_EMPTY = 0,
+   IMAGE_ENTRY_LOADING,
+   IMAGE_ENTRY_READY,
+   IMAGE_ENTRY_FAILED
+};
+
+struct image_entry
+{
+   uint32_t *pixels;
+   unsigned width;
+   unsigned height;
+   unsigned last_used;
+   unsigned generation;
+   int index;
+   enum image_entry_state state;
+};
+
+static struct image_entry image_cache[IMAGE_CACHE_ENTRIES];
+static struct image_entry *image_displayed;
+static size_t   image_cache_bytes;
+static size_t   image_cache_budget = 128 * 1024 * 1024;
+static unsigned image_cache_clock;
+static unsigned image_generation;
+static unsigned image_prefetch     = 2;
+static unsigned image_max_width    = 1920;
+static unsigned image_max_height   = 1080;
+
+#ifdef HAVE_THREADS
+static slock_t  *image_lock;
+static scond_t  *image_cond;
+static sthread_t *image_threads[IMAGE_MAX_THREADS];
+static unsigned image_threads_num;
+static bool     image_threads_quit;
+#endif
+
 #if 0
 #define DUPE_TEST
 #endif
@@ -117,9 +167,10 @@ void IMAGE_CORE_PREFIX(retro_get_system_av_info)(struct retro_system_av_info *in
 
 static void imageviewer_reset(void)
 {
-   image_buffer = NULL;
-   image_width  = 0;
-   image_height = 0;
+   image_buffer    = NULL;
+   image_displayed = NULL;
+   image_width     = 0;
+   image_height    = 0;
 }
 
 void IMAGE_CORE_PREFIX(retro_init)(void)
@@ -135,15 +186,45 @@ void IMAGE_CORE_PREFIX(retro_init)(void)
 
 }
 
-static void imageviewer_free_image(void)
+static void imageviewer_lock(void)
 {
-#ifdef STB_IMAGE_IMPLEMENTATION
-   if (image_buffer)
-      free(image_buffer);
-#else
-   image_texture_free(&image_texture);
+#ifdef HAVE_THREADS
+   if (image_lock)
+      slock_lock(image_lock);
+#endif
+}
+
+static void imageviewer_unlock(void)
+{
+#ifdef HAVE_THREADS
+   if (image_lock)
+      slock_unlock(image_lock);
 #endif
-   image_buffer = NULL;
+}
+
+static void imageviewer_entry_free(struct image_entry *entry)
+{
+   if (entry->pixels)
+   {
+      free(entry->pixels);
+      image_cache_bytes -= entry->width * entry->height * sizeof(uint32_t);
+   }
+
+   memset(entry, 0, sizeof(*entry));
+   entry->index = -1;
+}
+
+/* Drops every cached image, the decode threads must be stopped. */
+static void imageviewer_free_image(void)
+{
+   unsigned i;
+
+   for (i = 0; i < IMAGE_CACHE_ENTRIES; i++)
+      imageviewer_entry_free(&image_cache[i]);
+
+   image_cache_bytes = 0;
+   image_buffer      = NULL;
+   image_displayed   = NULL;
 }
 
 void IMAGE_CORE_PREFIX(retro_deinit)(void)
@@ -155,6 +236,9 @@ void IMAGE_CORE_PREFIX(retro_deinit)(void)
 void IMAGE_CORE_PREFIX(retro_set_environment)(retro_environment_t cb)
 {
    static const struct retro_variable vars[] = {
+      { "imageviewer_max_resolution", "Downscale Images To; 1920x1080|1280x720|2560x1440|3840x2160|original" },
+      { "imageviewer_prefetch", "Preload Neighbouring Images; 2|0|1|4|8" },
+      { "imageviewer_cache_size", "Image Cache Size (MB); 128|64|256|512|1024" },
       { NULL, NULL },
    };
 
@@ -223,57 +307,500 @@ void IMAGE_CORE_PREFIX(retro_cheat_set)(unsigned a, bool b, const char * c)
 {
 }
 
-static bool imageviewer_load(const char *path, int image_index)
+/* Decodes an image to XRGB8888, scaled down to fit within
+ * max_width x max_height. Safe to call from any thread. */
+static bool imageviewer_load(const char *path,
+      unsigned max_width, unsigned max_height,
+      uint32_t **pixels, unsigned *width, unsigned *height)
 {
+   uint32_t *buf = NULL;
+   unsigned w    = 0;
+   unsigned h    = 0;
 #ifdef STB_IMAGE_IMPLEMENTATION
    int comp;
-#endif
-#ifdef RARCH_INTERNAL
-   extern bool video_driver_supports_rgba(void);
+   int stb_width  = 0;
+   int stb_height = 0;
+
+   buf = (uint32_t*)stbi_load(path, &stb_width, &stb_height, &comp, 4);
+   w   = stb_width;
+   h   = stb_height;
+#else
+   struct texture_image texture = {0};
+
+   texture.supports_rgba = image_supports_rgba;
+
+   if (!image_texture_load(&texture, path))
+      return false;
+
+   buf = texture.pixels;
+   w   = texture.width;
+   h   = texture.height;
 #endif
 
-   imageviewer_free_image();
+   if (!buf || !w || !h)
+   {
+      free(buf);
+      return false;
+   }
+
+   if (max_width && max_height && (w > max_width || h > max_height))
+   {
+      /* Every channel is filtered alike, so this works
+       * for RGBA and ARGB input alike. */
+      struct scaler_ctx scaler = {0};
+      float scale              = MIN((float)max_width / w,
+            (float)max_height / h);
+      uint32_t *scaled         = NULL;
+
+      scaler.in_width    = w;
+      scaler.in_height   = h;
+      scaler.in_stride   = w * sizeof(uint32_t);
+      scaler.out_width   = MAX((unsigned)(w * scale + 0.5f), 1);
+      scaler.out_height  = MAX((unsigned)(h * scale + 0.5f), 1);
+      scaler.out_stride  = scaler.out_width * sizeof(uint32_t);
+      scaler.in_fmt      = SCALER_FMT_ARGB8888;
+      scaler.out_fmt     = SCALER_FMT_ARGB8888;
+      scaler.scaler_type = SCALER_TYPE_SINC;
+
+      if (scaler_ctx_gen_filter(&scaler))
+         scaled = (uint32_t*)malloc(scaler.out_height * scaler.out_stride);
+
+      if (scaled)
+      {
+         scaler_ctx_scale(&scaler, scaled, buf);
+         free(buf);
+         buf = scaled;
+         w   = scaler.out_width;
+         h   = scaler.out_height;
+      }
+
+      scaler_ctx_gen_reset(&scaler);
+   }
 
 #ifdef STB_IMAGE_IMPLEMENTATION
-   image_buffer           = (uint32_t*)stbi_load(
-         path,
-         &image_width,
-         &image_height,
-         &comp,
-         4);
-#else
-#ifdef RARCH_INTERNAL
-   image_texture.supports_rgba = video_driver_supports_rgba();
+   {
+      /* RGBA > XRGB8888 */
+      unsigned x, y;
+      uint32_t *out = buf;
+
+      for (y = 0; y < h; y++)
+      {
+         for (x = 0; x < w; x++, out++)
+         {
+            uint32_t pixel = *out;
+            uint32_t a = pixel >> 24;
+            
+            if (a == 255)
+               *out = (pixel & 0x0000ff00) | ((pixel << 16) & 0x00ff0000) | ((pixel >> 16) & 0x000000ff);
+            else
+            {
+               uint32_t r = pixel & 0x0000ff;
+               uint32_t g = (pixel & 0x00ff00) >> 8;
+               uint32_t b = (pixel & 0xff0000) >> 16;
+               uint32_t bg = ((x & 8) ^ (y & 8)) ? 0x66 : 0x99;
+               
+               r = a * r / 255 + (255 - a) * bg / 255;
+               g = a * g / 255 + (255 - a) * bg / 255;
+               b = a * b / 255 + (255 - a) * bg / 255;
+               
+               *out = r << 16 | g << 8 | b;
+            }
+         }
+      }
+   }
 #endif
-   if (!image_texture_load(&image_texture, path))
-      return false;
-   image_buffer = (uint32_t*)image_texture.pixels;
-   image_width  = image_texture.width;
-   image_height = image_texture.height;
+
+   *pixels = buf;
+   *width  = w;
+   *height = h;
+
+   return true;
+}
+
+/* The functions below must be called with image_lock held. */
+
+static bool imageviewer_in_window(int index)
+{
+   int distance = index - image_index;
+
+   return distance >= -(int)image_prefetch
+      && distance <= (int)image_prefetch;
+}
+
+static struct image_entry *imageviewer_find(int index)
+{
+   unsigned i;
+
+   for (i = 0; i < IMAGE_CACHE_ENTRIES; i++)
+   {
+      struct image_entry *entry = &image_cache[i];
+
+      if (     entry->state != IMAGE_ENTRY_EMPTY
+            && entry->index == index
+            && entry->generation == image_generation)
+         return entry;
+   }
+
+   return NULL;
+}
+
+/* Least recently used image that can go, stale ones first.
+ * The image on screen and the ones around it are kept,
+ * unless any_index is set. */
+static struct image_entry *imageviewer_victim(bool any_index)
+{
+   unsigned i;
+   struct image_entry *victim = NULL;
+   bool victim_stale          = false;
+
+   for (i = 0; i < IMAGE_CACHE_ENTRIES; i++)
+   {
+      struct image_entry *entry = &image_cache[i];
+      bool stale                = entry->generation != image_generation;
+
+      if (     entry->state == IMAGE_ENTRY_EMPTY
+            || entry->state == IMAGE_ENTRY_LOADING
+            || entry == image_displayed)
+         continue;
+
+      if (!stale && !any_index && imageviewer_in_window(entry->index))
+         continue;
+
+      if (victim)
+      {
+         if (stale != victim_stale)
+         {
+            if (!stale)
+               continue;
+         }
+         else if (entry->last_used >= victim->last_used)
+            continue;
+      }
+
+      victim       = entry;
+      victim_stale = stale;
+   }
+
+   return victim;
+}
+
+static void imageviewer_trim(void)
+{
+   while (image_cache_bytes > image_cache_budget)
+   {
+      struct image_entry *victim = imageviewer_victim(false);
+
+      if (!victim)
+         break;
+
+      imageviewer_entry_free(victim);
+   }
+}
+
+static struct image_entry *imageviewer_alloc(int index)
+{
+   unsigned i;
+   struct image_entry *entry = NULL;
+
+   for (i = 0; i < IMAGE_CACHE_ENTRIES && !entry; i++)
+      if (image_cache[i].state == IMAGE_ENTRY_EMPTY)
+         entry = &image_cache[i];
+
+   if (!entry)
+      entry = imageviewer_victim(index == image_index);
+
+   if (!entry)
+      return NULL;
+
+   imageviewer_entry_free(entry);
+
+   entry->index      = index;
+   entry->generation = image_generation;
+   entry->state      = IMAGE_ENTRY_LOADING;
+   entry->last_used  = ++image_cache_clock;
+
+   return entry;
+}
+
+/* Next image to decode: the one on screen first, then its
+ * neighbours by distance, forwards first. Preloading stops
+ * once the cache is full. */
+static int imageviewer_next_job(void)
+{
+   unsigned i;
+
+   imageviewer_trim();
+
+   for (i = 0; i <= image_prefetch * 2; i++)
+   {
+      int offset = (i & 1) ? (int)(i + 1) / 2 : -(int)(i / 2);
+      int index  = image_index + offset;
+
+      if (index < 0 || index >= (int)file_list->size)
+         continue;
+
+      if (imageviewer_find(index))
+         continue;
+
+      if (i && image_cache_bytes >= image_cache_budget)
+         return -1;
+
+      return index;
+   }
+
+   return -1;
+}
+
+/* Decodes into an entry allocated with imageviewer_alloc,
+ * image_lock is released while decoding. */
+static void imageviewer_fetch(struct image_entry *entry)
+{
+   bool ret;
+   uint32_t *pixels    = NULL;
+   unsigned width      = 0;
+   unsigned height     = 0;
+   unsigned max_width  = image_max_width;
+   unsigned max_height = image_max_height;
+   const char *path    = file_list->elems[entry->index].data;
+
+   imageviewer_unlock();
+   ret = imageviewer_load(path, max_width, max_height,
+         &pixels, &width, &height);
+   imageviewer_lock();
+
+   if (!ret)
+   {
+      entry->state = IMAGE_ENTRY_FAILED;
+      return;
+   }
+
+   entry->pixels     = pixels;
+   entry->width      = width;
+   entry->height     = height;
+   entry->state      = IMAGE_ENTRY_READY;
+   image_cache_bytes += width * height * sizeof(uint32_t);
+}
+
+#ifdef HAVE_THREADS
+static void imageviewer_thread(void *data)
+{
+   (void)data;
+
+   slock_lock(image_lock);
+
+   while (!image_threads_quit)
+   {
+      struct image_entry *entry = NULL;
+      int index                 = imageviewer_next_job();
+
+      if (index >= 0)
+         entry = imageviewer_alloc(index);
+
+      if (!entry)
+      {
+         scond_wait(image_cond, image_lock);
+         continue;
+      }
+
+      imageviewer_fetch(entry);
+
+      /* Let the main thread and idle threads know. */
+      scond_broadcast(image_cond);
+   }
+
+   slock_unlock(image_lock);
+}
+
+static void imageviewer_threads_init(void)
+{
+   unsigned i;
+   unsigned num = cpu_features_get_core_amount();
+
+   num = num > 1 ? num - 1 : 1;
+   if (num > IMAGE_MAX_THREADS)
+      num = IMAGE_MAX_THREADS;
+
+   image_threads_quit = false;
+   image_threads_num  = 0;
+   image_lock         = slock_new();
+   image_cond         = scond_new();
+
+   if (!image_lock || !image_cond)
+      return;
+
+   for (i = 0; i < num; i++)
+   {
+      image_threads[i] = sthread_create(imageviewer_thread, NULL);
+      if (!image_threads[i])
+         break;
+      image_threads_num++;
+   }
+}
+
+static void imageviewer_threads_deinit(void)
+{
+   unsigned i;
+
+   if (image_lock)
+   {
+      slock_lock(image_lock);
+      image_threads_quit = true;
+      scond_broadcast(image_cond);
+      slock_unlock(image_lock);
+   }
+
+   for (i = 0; i < image_threads_num; i++)
+      sthread_join(image_threads[i]);
+
+   if (image_cond)
+      scond_free(image_cond);
+   if (image_lock)
+      slock_free(image_lock);
+
+   image_threads_num = 0;
+   image_cond        = NULL;
+   image_lock        = NULL;
+}
 #endif
-   if (!image_buffer)
-      return false;
 
-   process_new_image = true;
+static void check_variables(void)
+{
+   struct retro_variable var = {0};
+   unsigned max_width        = image_max_width;
+   unsigned max_height       = image_max_height;
+
+   var.key = "imageviewer_max_resolution";
+
+   if (IMAGE_CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "original"))
+         max_width = max_height = 0;
+      else if (sscanf(var.value, "%ux%u", &max_width, &max_height) != 2)
+      {
+         max_width  = 1920;
+         max_height = 1080;
+      }
+   }
+
+   imageviewer_lock();
+
+   /* Cached images at the old size are stale now. */
+   if (max_width != image_max_width || max_height != image_max_height)
+      image_generation++;
 
+   image_max_width  = max_width;
+   image_max_height = max_height;
 
+   var.key   = "imageviewer_prefetch";
+   var.value = NULL;
+
+   if (IMAGE_CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      image_prefetch = strtoul(var.value, NULL, 0);
+
+   var.key   = "imageviewer_cache_size";
+   var.value = NULL;
+
+   if (IMAGE_CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      image_cache_budget = (size_t)strtoul(var.value, NULL, 0) * 1024 * 1024;
+
+#ifdef HAVE_THREADS
+   if (image_cond)
+      scond_broadcast(image_cond);
+#endif
+   imageviewer_unlock();
+}
+
+/* Shows the image at image_index once it is decoded,
+ * returns false if it can't be. */
+static bool imageviewer_update(void)
+{
+   struct image_entry *entry = NULL;
+
+   imageviewer_lock();
+
+   entry = imageviewer_find(image_index);
+
+#ifdef HAVE_THREADS
+   if (!image_threads_num)
+#endif
+   {
+      /* No decode threads, do it here. */
+      if (!entry)
+      {
+         entry = imageviewer_alloc(image_index);
+         if (entry)
+            imageviewer_fetch(entry);
+      }
+   }
+
+   if (entry && entry != image_displayed)
+   {
+      if (entry->state == IMAGE_ENTRY_FAILED)
+      {
+         imageviewer_unlock();
+         return false;
+      }
+
+      if (entry->state == IMAGE_ENTRY_READY)
+      {
+         image_displayed   = entry;
+         image_buffer      = entry->pixels;
+         image_width       = entry->width;
+         image_height      = entry->height;
+         process_new_image = true;
+      }
+   }
+
+   if (image_displayed)
+      image_displayed->last_used = ++image_cache_clock;
+
+   imageviewer_unlock();
    return true;
 }
 
 bool IMAGE_CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
 {
+   unsigned i;
    enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_XRGB8888;
    char *dir                   = strdup(info->path);
+#ifdef RARCH_INTERNAL
+   extern bool video_driver_supports_rgba(void);
+#endif
 
    slideshow_enable            = false;
+   image_index                 = -1;
 
    path_basedir(dir);
 
    file_list = dir_list_new(dir, IMAGE_CORE_PREFIX(valid_extensions),
          false,true,false,false);
-   dir_list_sort(file_list, false);
    free(dir);
 
+   if (!file_list)
+      return false;
+
+   dir_list_sort(file_list, false);
+
+   /* Start browsing from the image that was opened. */
+   for (i = 0; i < file_list->size; i++)
+   {
+      if (!strcmp(path_basename(file_list->elems[i].data),
+               path_basename(info->path)))
+      {
+         image_index = i;
+         break;
+      }
+   }
+
+   if (image_index < 0)
+   {
+      union string_list_elem_attr attr;
+
+      attr.i = RARCH_PLAIN_FILE;
+      if (!string_list_append(file_list, info->path, attr))
+         return false;
+      image_index = file_list->size - 1;
+   }
   
    if (!IMAGE_CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt))
    {
@@ -282,9 +809,21 @@ bool IMAGE_CORE_PREFIX(retro_load_game)(const struct retro_game_info *info)
       return false;
    }
 
-   if (!imageviewer_load(info->path, 0))
+#ifdef RARCH_INTERNAL
+   image_supports_rgba = video_driver_supports_rgba();
+#endif
+
+   check_variables();
+
+   /* The first image is needed for the geometry,
+    * so it is decoded before the threads start. */
+   if (!imageviewer_update() || !image_displayed)
       return false;
 
+#ifdef HAVE_THREADS
+   imageviewer_threads_init();
+#endif
+
    return true;
 }
 
@@ -296,7 +835,15 @@ bool IMAGE_CORE_PREFIX(retro_load_game_special)(unsigned a, const struct retro_g
 
 void IMAGE_CORE_PREFIX(retro_unload_game)(void)
 {
+#ifdef HAVE_THREADS
+   imageviewer_threads_deinit();
+#endif
    imageviewer_free_image();
+
+   if (file_list)
+      string_list_free(file_list);
+   file_list    = NULL;
+
    image_width  = 0;
    image_height = 0;
 }
@@ -326,18 +873,26 @@ void IMAGE_CORE_PREFIX(retro_run)(void)
    bool load_image        = false;
    bool next_image        = false;
    bool prev_image        = false;
+   bool updated           = false;
    static int frames      = 0;
-   static int image_index = 0;
+   int index              = image_index;
    uint16_t input         = 0;
    static uint16_t previnput;
    uint16_t realinput     = 0;
    int i;
 
+   if (IMAGE_CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated)
+      check_variables();
+
    IMAGE_CORE_PREFIX(input_poll_cb)();
 
+   /* Only move on once the current image has been shown
+    * for a while, the next one may still be decoding. */
    if (slideshow_enable)
    {
-      if ((frames % 120 == 0) && image_index < (signed)(file_list->size - 1))
+      if (     frames >= 120
+            && image_displayed && image_displayed->index == image_index
+            && image_index < (signed)(file_list->size - 1))
          next_image = true;
    }
 
@@ -385,83 +940,61 @@ void IMAGE_CORE_PREFIX(retro_run)(void)
 
    if (prev_image)
    {
-      image_index--;
+      index--;
       load_image = true;
    }
    else if (next_image)
    {
-      image_index++;
+      index++;
       load_image = true;
    }
    else if (backwards_image)
    {
-      image_index -= 5;
+      index -= 5;
       load_image = true;
    }
    else if (forward_image)
    {
-      image_index += 5;
+      index += 5;
       load_image = true;
    }
    else if (first_image)
    {
-      image_index = 0;
+      index = 0;
       load_image = true;
    }
    else if (last_image)
    {
-      image_index = file_list->size - 1;
+      index = file_list->size - 1;
       load_image = true;
    }
 
    if (load_image)
    {
-      if (!imageviewer_load(file_list->elems[image_index].data, image_index))
-      {
-         IMAGE_CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_SHUTDOWN, NULL);
-      }
+      /* Decode threads pick it up from here. */
+      imageviewer_lock();
+      image_index = index;
+#ifdef HAVE_THREADS
+      if (image_cond)
+         scond_broadcast(image_cond);
+#endif
+      imageviewer_unlock();
    }
 
+   if (!imageviewer_update())
+      IMAGE_CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_SHUTDOWN, NULL);
+
    if (process_new_image)
    {
-      /* RGBA > XRGB8888 */
       struct retro_system_av_info info;
 
-#ifdef STB_IMAGE_IMPLEMENTATION
-      int x, y;
-      uint32_t *buf = &image_buffer[0];
-
-      for (y = 0; y < image_height; y++)
-      {
-         for (x = 0; x < image_width; x++, buf++)
-         {
-            uint32_t pixel = *buf;
-            uint32_t a = pixel >> 24;
-            
-            if (a == 255)
-               *buf = (pixel & 0x0000ff00) | ((pixel << 16) & 0x00ff0000) | ((pixel >> 16) & 0x000000ff);
-            else
-            {
-               uint32_t r = pixel & 0x0000ff;
-               uint32_t g = (pixel & 0x00ff00) >> 8;
-               uint32_t b = (pixel & 0xff0000) >> 16;
-               uint32_t bg = ((x & 8) ^ (y & 8)) ? 0x66 : 0x99;
-               
-               r = a * r / 255 + (255 - a) * bg / 255;
-               g = a * g / 255 + (255 - a) * bg / 255;
-               b = a * b / 255 + (255 - a) * bg / 255;
-               
-               *buf = r << 16 | g << 8 | b;
-            }
-         }
-      }
-#endif
-
       IMAGE_CORE_PREFIX(retro_get_system_av_info)(&info);
 
       IMAGE_CORE_PREFIX(environ_cb)(RETRO_ENVIRONMENT_SET_GEOMETRY, &info.geometry);
 
       process_new_image = false;
+      image_uploaded    = false;
+      frames            = 0;
    }
 
 #ifdef DUPE_TEST
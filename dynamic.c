@@ -1554,6 +1554,10 @@ bool rarch_environment_cb(unsigned cmd, void *data)
 
             mmap_preprocess_descriptors(descriptors, mmaps->num_descriptors);
 
+#ifdef HAVE_CHEEVOS
+            cheevos_remap_memory();
+#endif
+
             if (sizeof(void *) == 8)
                RARCH_LOG("   ndx flags  ptr              offset   start    select   disconn  len      addrspace\n");
             else
@@ -313,6 +313,33 @@ void fill_pathname_application_special(char *s, size_t len, enum application_spe
                fill_pathname_basedir(s, path_get(RARCH_PATH_CONFIG), len);
          }
          break;
+      case APPLICATION_SPECIAL_DIRECTORY_SHADER_CACHE:
+         {
+            char s1[PATH_MAX_LENGTH];
+            settings_t *settings     = config_get_ptr();
+
+            s1[0] = '\0';
+
+            /* Try cache directory setting first,
+             * fallback to a cache directory next to the
+             * current configuration file. */
+            if (!string_is_empty(settings->directory.cache))
+               strlcpy(s1, settings->directory.cache, sizeof(s1));
+            else if (!path_is_empty(RARCH_PATH_CONFIG))
+            {
+               char s2[PATH_MAX_LENGTH];
+
+               s2[0] = '\0';
+
+               fill_pathname_basedir(s2, path_get(RARCH_PATH_CONFIG),
+                     sizeof(s2));
+               fill_pathname_join(s1, s2, "cache", sizeof(s1));
+            }
+
+            if (!string_is_empty(s1))
+               fill_pathname_join(s, s1, "shaders", len);
+         }
+         break;
       case APPLICATION_SPECIAL_DIRECTORY_ASSETS_ZARCH_ICONS:
 #ifdef HAVE_ZARCH
          {
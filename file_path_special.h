@@ -21,6 +21,9 @@
 #include <stddef.h>
 
 #include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
 
 enum file_path_enum
 {
@@ -98,7 +101,8 @@ enum application_special_type
    APPLICATION_SPECIAL_DIRECTORY_ASSETS_XMB_FONT,
    APPLICATION_SPECIAL_DIRECTORY_ASSETS_ZARCH,
    APPLICATION_SPECIAL_DIRECTORY_ASSETS_ZARCH_FONT,
-   APPLICATION_SPECIAL_DIRECTORY_ASSETS_ZARCH_ICONS
+   APPLICATION_SPECIAL_DIRECTORY_ASSETS_ZARCH_ICONS,
+   APPLICATION_SPECIAL_DIRECTORY_SHADER_CACHE
 };
 
 /**
@@ -134,4 +138,6 @@ bool fill_pathname_application_data(char *s, size_t len);
 
 void fill_pathname_application_special(char *s, size_t len, enum application_special_type type);
 
+RETRO_END_DECLS
+
 #endif
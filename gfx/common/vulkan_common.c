@@ -2160,7 +2160,19 @@ void vulkan_context_destroy(gfx_ctx_vulkan_data_t *vk,
       return;
 
    if (vk->context.device)
+   {
+      /* vkDeviceWaitIdle implicitly touches every queue of the device,
+       * which the shader build thread may be submitting to. */
+#ifdef HAVE_THREADS
+      if (vk->context.queue_lock)
+         slock_lock(vk->context.queue_lock);
+#endif
       vkDeviceWaitIdle(vk->context.device);
+#ifdef HAVE_THREADS
+      if (vk->context.queue_lock)
+         slock_unlock(vk->context.queue_lock);
+#endif
+   }
    if (vk->swapchain)
       vkDestroySwapchainKHR(vk->context.device,
             vk->swapchain, NULL);
@@ -2272,7 +2284,13 @@ bool vulkan_create_swapchain(gfx_ctx_vulkan_data_t *vk,
    VkPresentModeKHR swapchain_present_mode = VK_PRESENT_MODE_FIFO_KHR;
    settings_t                    *settings = config_get_ptr();
 
+#ifdef HAVE_THREADS
+   slock_lock(vk->context.queue_lock);
+#endif
    vkDeviceWaitIdle(vk->context.device);
+#ifdef HAVE_THREADS
+   slock_unlock(vk->context.queue_lock);
+#endif
 
    present_mode_count = 0;
    vkGetPhysicalDeviceSurfacePresentModesKHR(
@@ -391,6 +391,8 @@ typedef struct vk
    } tracker;
 
    void *filter_chain;
+   /* Filter chain being built in the background, see vulkan_set_shader. */
+   void *shader_job;
 } vk_t;
 
 uint32_t vulkan_find_memory_type(
@@ -20,9 +20,14 @@
 #include <string.h>
 
 #include <compat/strl.h>
+#include <file/config_file.h>
+#include <file/file_path.h>
 #include <gfx/scaler/scaler.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
 #include <formats/image.h>
 #include <retro_inline.h>
+#include <retro_stat.h>
 #include <retro_miscellaneous.h>
 #include <retro_assert.h>
 #include <libretro.h>
@@ -41,14 +46,18 @@
 
 #include "../../driver.h"
 #include "../../configuration.h"
+#include "../../file_path_special.h"
+#include "../../msg_hash.h"
 #include "../../record/record_driver.h"
 #include "../../performance_counters.h"
 
 #include "../../retroarch.h"
+#include "../../runloop.h"
 #include "../../verbosity.h"
 
 #include "../video_context_driver.h"
 #include "../video_coord_array.h"
+#include "../video_shader_parse.h"
 
 static void vulkan_set_viewport(void *data, unsigned viewport_width,
       unsigned viewport_height, bool force_full, bool allow_rotate);
@@ -658,25 +667,34 @@ static void vulkan_deinit_framebuffers(vk_t *vk)
    vkDestroyRenderPass(vk->context->device, vk->render_pass, NULL);
 }
 
+static void vulkan_init_filter_chain_info(vk_t *vk,
+      struct vulkan_filter_chain_create_info *info)
+{
+   memset(info, 0, sizeof(*info));
+
+   info->device                = vk->context->device;
+   info->gpu                   = vk->context->gpu;
+   info->memory_properties     = &vk->context->memory_properties;
+   info->pipeline_cache        = vk->pipelines.cache;
+   info->queue                 = vk->context->queue;
+#ifdef HAVE_THREADS
+   info->queue_lock            = vk->context->queue_lock;
+#endif
+   info->command_pool          = vk->swapchain[vk->context->current_swapchain_index].cmd_pool;
+   info->max_input_size.width  = vk->tex_w;
+   info->max_input_size.height = vk->tex_h;
+   info->swapchain.viewport    = vk->vk_vp;
+   info->swapchain.format      = vk->context->swapchain_format;
+   info->swapchain.render_pass = vk->render_pass;
+   info->swapchain.num_indices = vk->context->num_swapchain_images;
+   info->original_format       = vk->tex_fmt;
+}
+
 static bool vulkan_init_default_filter_chain(vk_t *vk)
 {
    struct vulkan_filter_chain_create_info info;
 
-   memset(&info, 0, sizeof(info));
-
-   info.device                = vk->context->device;
-   info.gpu                   = vk->context->gpu;
-   info.memory_properties     = &vk->context->memory_properties;
-   info.pipeline_cache        = vk->pipelines.cache;
-   info.queue                 = vk->context->queue;
-   info.command_pool          = vk->swapchain[vk->context->current_swapchain_index].cmd_pool;
-   info.max_input_size.width  = vk->tex_w;
-   info.max_input_size.height = vk->tex_h;
-   info.swapchain.viewport    = vk->vk_vp;
-   info.swapchain.format      = vk->context->swapchain_format;
-   info.swapchain.render_pass = vk->render_pass;
-   info.swapchain.num_indices = vk->context->num_swapchain_images;
-   info.original_format       = vk->tex_fmt;
+   vulkan_init_filter_chain_info(vk, &info);
 
    vk->filter_chain           = vulkan_filter_chain_create_default(
          &info,
@@ -696,21 +714,7 @@ static bool vulkan_init_filter_chain_preset(vk_t *vk, const char *shader_path)
 {
    struct vulkan_filter_chain_create_info info;
 
-   memset(&info, 0, sizeof(info));
-
-   info.device                = vk->context->device;
-   info.gpu                   = vk->context->gpu;
-   info.memory_properties     = &vk->context->memory_properties;
-   info.pipeline_cache        = vk->pipelines.cache;
-   info.queue                 = vk->context->queue;
-   info.command_pool          = vk->swapchain[vk->context->current_swapchain_index].cmd_pool;
-   info.max_input_size.width  = vk->tex_w;
-   info.max_input_size.height = vk->tex_h;
-   info.swapchain.viewport    = vk->vk_vp;
-   info.swapchain.format      = vk->context->swapchain_format;
-   info.swapchain.render_pass = vk->render_pass;
-   info.swapchain.num_indices = vk->context->num_swapchain_images;
-   info.original_format       = vk->tex_fmt;
+   vulkan_init_filter_chain_info(vk, &info);
 
    vk->filter_chain           = vulkan_filter_chain_create_from_preset(
          &info, shader_path,
@@ -752,6 +756,282 @@ static bool vulkan_init_filter_chain(vk_t *vk)
    return true;
 }
 
+#ifdef HAVE_THREADS
+/* Shader presets are parsed, compiled to SPIR-V and turned into
+ * pipelines on a worker thread. The active filter chain keeps
+ * rendering until the new one is complete, then vulkan_frame swaps
+ * it in between two frames. */
+struct vulkan_shader_job
+{
+   struct vulkan_filter_chain_create_info info;
+   enum vulkan_filter_chain_filter filter;
+   vulkan_filter_chain_t *chain;
+   sthread_t *thread;
+   slock_t *lock;
+   VkCommandPool cmd_pool;
+   bool done;
+   /* Only touched by the video thread. */
+   bool discard;
+   char path[PATH_MAX_LENGTH];
+   char next_path[PATH_MAX_LENGTH];
+};
+
+static void vulkan_shader_job_thread(void *data)
+{
+   struct vulkan_shader_job *job = (struct vulkan_shader_job*)data;
+   vulkan_filter_chain_t *chain  = vulkan_filter_chain_create_from_preset(
+         &job->info, job->path, job->filter);
+
+   slock_lock(job->lock);
+   job->chain = chain;
+   job->done  = true;
+   slock_unlock(job->lock);
+}
+
+static void vulkan_shader_job_wait(struct vulkan_shader_job *job)
+{
+   if (!job->thread)
+      return;
+
+   sthread_join(job->thread);
+   job->thread = NULL;
+}
+
+static void vulkan_shader_job_free(vk_t *vk, struct vulkan_shader_job *job)
+{
+   if (!job)
+      return;
+
+   vulkan_shader_job_wait(job);
+
+   if (job->chain)
+      vulkan_filter_chain_free(job->chain);
+   if (job->cmd_pool != VK_NULL_HANDLE)
+      vkDestroyCommandPool(vk->context->device, job->cmd_pool, NULL);
+   if (job->lock)
+      slock_free(job->lock);
+   free(job);
+}
+
+/**
+ * vulkan_shader_preset_check:
+ * @path                     : Path to the .slangp preset.
+ *
+ * Cheap part of building a filter chain: parses the preset
+ * and makes sure every pass and LUT it references exists.
+ * Compiling and creating the pipelines happen on the worker.
+ *
+ * Returns: true (1) if the preset looks usable, otherwise false (0).
+ **/
+static bool vulkan_shader_preset_check(const char *path)
+{
+   unsigned i;
+   bool ret                    = false;
+   config_file_t *conf         = config_file_new(path);
+   struct video_shader *shader = (struct video_shader*)
+      calloc(1, sizeof(*shader));
+
+   if (!conf || !shader)
+      goto end;
+
+   if (!video_shader_read_conf_cgp(conf, shader) || !shader->passes)
+      goto end;
+
+   video_shader_resolve_relative(shader, path);
+
+   for (i = 0; i < shader->passes; i++)
+   {
+      if (!path_file_exists(shader->pass[i].source.path))
+      {
+         RARCH_ERR("[Vulkan]: Shader pass not found: \"%s\".\n",
+               shader->pass[i].source.path);
+         goto end;
+      }
+   }
+
+   for (i = 0; i < shader->luts; i++)
+   {
+      if (!path_file_exists(shader->lut[i].path))
+      {
+         RARCH_ERR("[Vulkan]: Shader LUT not found: \"%s\".\n",
+               shader->lut[i].path);
+         goto end;
+      }
+   }
+
+   ret = true;
+
+end:
+   if (conf)
+      config_file_free(conf);
+   free(shader);
+   return ret;
+}
+
+/**
+ * vulkan_shader_job_start:
+ * @vk                       : Vulkan driver handle.
+ * @path                     : Path to the .slangp/.slang preset.
+ *
+ * Starts building the filter chain for @path in the background.
+ * If a build is already in flight, @path is queued and built
+ * once the current one finishes.
+ *
+ * Returns: true (1) if the request was accepted, otherwise
+ * false (0) and the caller should load the preset synchronously.
+ **/
+static bool vulkan_shader_job_start(vk_t *vk, const char *path)
+{
+   VkCommandPoolCreateInfo pool_info = {
+      VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+   struct vulkan_shader_job *job     =
+      (struct vulkan_shader_job*)vk->shader_job;
+
+   if (job)
+   {
+      strlcpy(job->next_path, path, sizeof(job->next_path));
+      job->discard = false;
+      return true;
+   }
+
+   job = (struct vulkan_shader_job*)calloc(1, sizeof(*job));
+   if (!job)
+      return false;
+
+   vulkan_init_filter_chain_info(vk, &job->info);
+   job->filter = vk->video.smooth ?
+      VULKAN_FILTER_CHAIN_LINEAR : VULKAN_FILTER_CHAIN_NEAREST;
+   strlcpy(job->path, path, sizeof(job->path));
+
+   /* Command pools are externally synchronized,
+    * so the worker gets one of its own for LUT uploads. */
+   pool_info.queueFamilyIndex = vk->context->graphics_queue_index;
+   pool_info.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+   if (vkCreateCommandPool(vk->context->device,
+            &pool_info, NULL, &job->cmd_pool) != VK_SUCCESS)
+      goto error;
+
+   job->info.command_pool = job->cmd_pool;
+
+   job->lock = slock_new();
+   if (!job->lock)
+      goto error;
+
+   job->thread = sthread_create(vulkan_shader_job_thread, job);
+   if (!job->thread)
+      goto error;
+
+   RARCH_LOG("[Vulkan]: Building filter chain \"%s\" in the background.\n", path);
+   vk->shader_job = job;
+   return true;
+
+error:
+   vulkan_shader_job_free(vk, job);
+   return false;
+}
+
+/**
+ * vulkan_shader_job_poll:
+ * @vk                       : Vulkan driver handle.
+ *
+ * Called on the video thread before the filter chain is used
+ * for a frame. Swaps in a finished filter chain, if any.
+ **/
+static void vulkan_shader_job_poll(vk_t *vk)
+{
+   char next_path[PATH_MAX_LENGTH];
+   struct vulkan_filter_chain_swapchain_info swapchain;
+   vulkan_filter_chain_t *chain      = NULL;
+   struct vulkan_shader_job *job     =
+      (struct vulkan_shader_job*)vk->shader_job;
+   bool done                         = false;
+
+   if (!job)
+      return;
+
+   slock_lock(job->lock);
+   done = job->done;
+   slock_unlock(job->lock);
+
+   if (!done)
+      return;
+
+   vulkan_shader_job_wait(job);
+
+   chain      = job->chain;
+   job->chain = NULL;
+
+   if (job->discard || *job->next_path)
+   {
+      /* Superseded while it was being built. */
+      strlcpy(next_path, job->next_path, sizeof(next_path));
+
+      if (chain)
+         vulkan_filter_chain_free(chain);
+      vulkan_shader_job_free(vk, job);
+      vk->shader_job = NULL;
+
+      if (*next_path && !vulkan_shader_job_start(vk, next_path))
+      {
+         if (vk->filter_chain)
+            vulkan_filter_chain_free((vulkan_filter_chain_t*)vk->filter_chain);
+         vk->filter_chain = NULL;
+
+         if (!vulkan_init_filter_chain_preset(vk, next_path))
+            vulkan_init_default_filter_chain(vk);
+      }
+      return;
+   }
+
+   swapchain = job->info.swapchain;
+
+   if (!chain)
+   {
+      RARCH_ERR("[Vulkan]: Failed to create filter chain: \"%s\". Falling back to stock.\n",
+            job->path);
+      /* vulkan_set_shader already returned, so tell the user. */
+      runloop_msg_queue_push(msg_hash_to_str(MSG_FAILED_TO_APPLY_SHADER),
+            1, 180, true);
+      vulkan_shader_job_free(vk, job);
+      vk->shader_job = NULL;
+
+      if (vk->filter_chain)
+         vulkan_filter_chain_free((vulkan_filter_chain_t*)vk->filter_chain);
+      vk->filter_chain = NULL;
+      vulkan_init_default_filter_chain(vk);
+      return;
+   }
+
+   RARCH_LOG("[Vulkan]: Filter chain \"%s\" is ready.\n", job->path);
+   vulkan_shader_job_free(vk, job);
+   vk->shader_job = NULL;
+
+   /* The swapchain may have been recreated while we were building. */
+   if (     swapchain.format      != vk->context->swapchain_format
+         || swapchain.render_pass != vk->render_pass
+         || swapchain.num_indices != vk->context->num_swapchain_images
+         || memcmp(&swapchain.viewport, &vk->vk_vp, sizeof(vk->vk_vp)))
+   {
+      swapchain.viewport    = vk->vk_vp;
+      swapchain.format      = vk->context->swapchain_format;
+      swapchain.render_pass = vk->render_pass;
+      swapchain.num_indices = vk->context->num_swapchain_images;
+
+      if (!vulkan_filter_chain_update_swapchain_info(chain, &swapchain))
+      {
+         RARCH_ERR("[Vulkan]: Failed to update filter chain info, keeping the current one.\n");
+         vulkan_filter_chain_free(chain);
+         return;
+      }
+   }
+
+   if (vk->filter_chain)
+      vulkan_filter_chain_free((vulkan_filter_chain_t*)vk->filter_chain);
+   vk->filter_chain = chain;
+}
+#endif
+
 static void vulkan_init_resources(vk_t *vk)
 {
    vk->num_swapchain_images = vk->context->num_swapchain_images;
@@ -763,18 +1043,129 @@ static void vulkan_init_resources(vk_t *vk)
    vulkan_init_command_buffers(vk);
 }
 
+static void vulkan_pipeline_cache_path(char *path, size_t len)
+{
+   char dir[PATH_MAX_LENGTH];
+
+   dir[0] = path[0] = '\0';
+
+   fill_pathname_application_special(dir, sizeof(dir),
+         APPLICATION_SPECIAL_DIRECTORY_SHADER_CACHE);
+
+   if (!string_is_empty(dir))
+      fill_pathname_join(path, dir, "vulkan_pipeline_cache.bin", len);
+}
+
+/* Only hand the driver a cache blob it wrote itself. Drivers are
+ * supposed to reject foreign data, but not all of them do. */
+static bool vulkan_pipeline_cache_is_compatible(vk_t *vk,
+      const uint8_t *data, ssize_t size)
+{
+   const VkPhysicalDeviceProperties *props = &vk->context->gpu_properties;
+
+   if (size < 16 + VK_UUID_SIZE)
+      return false;
+
+   return read_le(data + 0, 4) >= 16 + VK_UUID_SIZE
+      && read_le(data + 4, 4) == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+      && read_le(data + 8, 4) == props->vendorID
+      && read_le(data + 12, 4) == props->deviceID
+      && !memcmp(data + 16, props->pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+static void vulkan_pipeline_cache_save(vk_t *vk)
+{
+   char path[PATH_MAX_LENGTH];
+   char tmp[PATH_MAX_LENGTH];
+   size_t size = 0;
+   void *data  = NULL;
+
+   vulkan_pipeline_cache_path(path, sizeof(path));
+
+   if (string_is_empty(path))
+      return;
+
+   if (vkGetPipelineCacheData(vk->context->device,
+            vk->pipelines.cache, &size, NULL) != VK_SUCCESS || !size)
+      return;
+
+   data = malloc(size);
+
+   if (!data)
+      return;
+
+   if (vkGetPipelineCacheData(vk->context->device,
+            vk->pipelines.cache, &size, data) == VK_SUCCESS)
+   {
+      char dir[PATH_MAX_LENGTH];
+
+      dir[0] = '\0';
+
+      fill_pathname_basedir(dir, path, sizeof(dir));
+      path_mkdir(dir);
+
+      /* Write next to the old cache and swap, so a crash
+       * halfway through never leaves a truncated blob behind. */
+      strlcpy(tmp, path, sizeof(tmp));
+      strlcat(tmp, ".tmp", sizeof(tmp));
+
+      if (filestream_write_file(tmp, data, size))
+      {
+         if (path_file_replace(tmp, path))
+            RARCH_LOG("[Vulkan]: Saved pipeline cache (%u bytes).\n",
+                  (unsigned)size);
+         else
+            remove(tmp);
+      }
+   }
+
+   free(data);
+}
+
 static void vulkan_init_static_resources(vk_t *vk)
 {
    unsigned i;
+   char path[PATH_MAX_LENGTH];
    uint32_t blank[4 * 4];
+   void *cache_data                  = NULL;
+   ssize_t cache_size                = 0;
    VkCommandPoolCreateInfo pool_info = { 
       VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
    /* Create the pipeline cache. */
    VkPipelineCacheCreateInfo cache   = { 
       VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
 
-   vkCreatePipelineCache(vk->context->device,
-         &cache, NULL, &vk->pipelines.cache);
+   /* Seed it with the pipelines of previous runs. */
+   vulkan_pipeline_cache_path(path, sizeof(path));
+
+   if (!string_is_empty(path) && path_file_exists(path)
+         && filestream_read_file(path, &cache_data, &cache_size))
+   {
+      if (vulkan_pipeline_cache_is_compatible(vk,
+               (const uint8_t*)cache_data, cache_size))
+      {
+         cache.initialDataSize = cache_size;
+         cache.pInitialData    = cache_data;
+         RARCH_LOG("[Vulkan]: Loaded pipeline cache (%u bytes).\n",
+               (unsigned)cache_size);
+      }
+      else
+         RARCH_WARN("[Vulkan]: Pipeline cache was made by another GPU or driver, discarding.\n");
+   }
+
+   if (vkCreatePipelineCache(vk->context->device,
+         &cache, NULL, &vk->pipelines.cache) != VK_SUCCESS
+         && cache.pInitialData)
+   {
+      /* Retry without the stale data. */
+      RARCH_WARN("[Vulkan]: Driver rejected the pipeline cache, starting empty.\n");
+      cache.initialDataSize = 0;
+      cache.pInitialData    = NULL;
+      vkCreatePipelineCache(vk->context->device,
+            &cache, NULL, &vk->pipelines.cache);
+   }
+
+   free(cache_data);
 
    pool_info.queueFamilyIndex = vk->context->graphics_queue_index;
 
@@ -792,6 +1183,7 @@ static void vulkan_init_static_resources(vk_t *vk)
 static void vulkan_deinit_static_resources(vk_t *vk)
 {
    unsigned i;
+   vulkan_pipeline_cache_save(vk);
    vkDestroyPipelineCache(vk->context->device,
          vk->pipelines.cache, NULL);
    vulkan_destroy_texture(
@@ -842,6 +1234,11 @@ static void vulkan_free(void *data)
 
    if (vk->context && vk->context->device)
    {
+#ifdef HAVE_THREADS
+      vulkan_shader_job_free(vk,
+            (struct vulkan_shader_job*)vk->shader_job);
+      vk->shader_job = NULL;
+#endif
       vkQueueWaitIdle(vk->context->queue);
       vulkan_deinit_resources(vk);
 
@@ -1141,7 +1538,19 @@ static void vulkan_check_swapchain(vk_t *vk)
 {
    if (vk->context->invalid_swapchain)
    {
+#ifdef HAVE_THREADS
+      /* Normally joined before the context recreated the swapchain
+       * already. A chain being built may still reference the old
+       * render pass. */
+      if (vk->shader_job)
+         vulkan_shader_job_wait((struct vulkan_shader_job*)vk->shader_job);
+
+      slock_lock(vk->context->queue_lock);
+#endif
       vkQueueWaitIdle(vk->context->queue);
+#ifdef HAVE_THREADS
+      slock_unlock(vk->context->queue_lock);
+#endif
 
       vulkan_deinit_resources(vk);
       vulkan_init_resources(vk);
@@ -1235,6 +1644,28 @@ static bool vulkan_set_shader(void *data,
       path = NULL;
    }
 
+#ifdef HAVE_THREADS
+   /* Catch broken presets before handing them to the worker,
+    * so the caller still learns about them. */
+   if (path && !vulkan_shader_preset_check(path))
+   {
+      RARCH_ERR("[Vulkan]: Failed to load shader preset: \"%s\".\n", path);
+      return false;
+   }
+
+   if (path && vulkan_shader_job_start(vk, path))
+      return true;
+
+   /* Whatever is still being built is stale now. */
+   if (vk->shader_job)
+   {
+      struct vulkan_shader_job *job =
+         (struct vulkan_shader_job*)vk->shader_job;
+      job->discard      = true;
+      *job->next_path   = '\0';
+   }
+#endif
+
    if (vk->filter_chain)
       vulkan_filter_chain_free((vulkan_filter_chain_t*)vk->filter_chain);
    vk->filter_chain = NULL;
@@ -1650,6 +2081,11 @@ static bool vulkan_frame(void *data, const void *frame,
    }
    performance_counter_stop_plus(video_info->is_perfcnt_enable, copy_frame);
 
+#ifdef HAVE_THREADS
+   /* Swap in a filter chain that finished building in the background. */
+   vulkan_shader_job_poll(vk);
+#endif
+
    /* Notify filter chain about the new sync index. */
    vulkan_filter_chain_notify_sync_index((vulkan_filter_chain_t*)vk->filter_chain, frame_index);
    vulkan_filter_chain_set_frame_count((vulkan_filter_chain_t*)vk->filter_chain, frame_count);
@@ -1923,6 +2359,13 @@ static bool vulkan_frame(void *data, const void *frame,
       gfx_ctx_mode_t mode;
       mode.width  = width;
       mode.height = height;
+
+#ifdef HAVE_THREADS
+      /* The context recreates the swapchain right away,
+       * finish the chain being built against the old one first. */
+      if (vk->shader_job)
+         vulkan_shader_job_wait((struct vulkan_shader_job*)vk->shader_job);
+#endif
       video_context_driver_set_resize(mode);
 
       vk->should_resize = false;
@@ -2205,7 +2648,13 @@ static void vulkan_unload_texture(void *data, uintptr_t handle)
 
    /* TODO: We really want to defer this deletion instead,
     * but this will do for now. */
+#ifdef HAVE_THREADS
+   slock_lock(vk->context->queue_lock);
+#endif
    vkQueueWaitIdle(vk->context->queue);
+#ifdef HAVE_THREADS
+   slock_unlock(vk->context->queue_lock);
+#endif
    vulkan_destroy_texture(
          vk->context->device, texture);
    free(texture);
@@ -2303,7 +2752,13 @@ static bool vulkan_read_viewport(void *data, uint8_t *buffer, bool is_idle)
       if (!is_idle)
          video_driver_cached_frame();
 
+#ifdef HAVE_THREADS
+      slock_lock(vk->context->queue_lock);
+#endif
       vkQueueWaitIdle(vk->context->queue);
+#ifdef HAVE_THREADS
+      slock_unlock(vk->context->queue_lock);
+#endif
 
       if (!staging->mapped)
          vulkan_map_persistent_texture(
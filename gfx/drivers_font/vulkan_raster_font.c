@@ -82,7 +82,13 @@ static void vulkan_raster_font_free_font(void *data, bool is_threaded)
    if (font->font_driver && font->font_data)
       font->font_driver->free(font->font_data);
 
+#ifdef HAVE_THREADS
+   slock_lock(font->vk->context->queue_lock);
+#endif
    vkQueueWaitIdle(font->vk->context->queue);
+#ifdef HAVE_THREADS
+   slock_unlock(font->vk->context->queue_lock);
+#endif
    vulkan_destroy_texture( 
          font->vk->context->device, &font->texture);
 
@@ -20,6 +20,8 @@
 #include <algorithm>
 
 #include <retro_miscellaneous.h>
+#include <retro_stat.h>
+#include <compat/strl.h>
 #include <file/file_path.h>
 #include <streams/file_stream.h>
 #include <lists/string_list.h>
@@ -28,6 +30,7 @@
 #include "glslang_util.hpp"
 #include "glslang.hpp"
 
+#include "../../file_path_special.h"
 #include "../../verbosity.h"
 
 using namespace std;
@@ -363,9 +366,127 @@ bool glslang_parse_meta(const vector<string> &lines, glslang_meta *meta)
    return true;
 }
 
+/* Bump whenever the compiler or the layout of cached data changes. */
+#define GLSLANG_CACHE_VERSION 1
+#define GLSLANG_CACHE_MAGIC   0x43534152 /* "RASC" */
+
+uint64_t glslang_hash(const void *data, size_t size, uint64_t hash)
+{
+   /* 64-bit FNV-1a. */
+   const uint8_t *bytes = (const uint8_t*)data;
+
+   for (size_t i = 0; i < size; i++)
+   {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ull;
+   }
+
+   return hash;
+}
+
+static bool glslang_cache_path(uint64_t key, const char *ext,
+      char *path, size_t size)
+{
+   char dir[PATH_MAX_LENGTH];
+   char name[64];
+
+   dir[0] = path[0] = '\0';
+
+   fill_pathname_application_special(dir, sizeof(dir),
+         APPLICATION_SPECIAL_DIRECTORY_SHADER_CACHE);
+
+   if (string_is_empty(dir))
+      return false;
+
+   snprintf(name, sizeof(name), "%016llx.%s",
+         (unsigned long long)key, ext);
+   fill_pathname_join(path, dir, name, size);
+   return true;
+}
+
+bool glslang_cache_load(uint64_t key, const char *ext, vector<uint32_t> *blob)
+{
+   char path[PATH_MAX_LENGTH];
+   void *buf      = nullptr;
+   ssize_t len    = 0;
+   bool ret       = false;
+
+   if (!glslang_cache_path(key, ext, path, sizeof(path)))
+      return false;
+
+   if (!path_file_exists(path) || !filestream_read_file(path, &buf, &len))
+      return false;
+
+   /* Header: magic, version, word count, checksum of the words. */
+   if (len >= 16 && (len & 3) == 0)
+   {
+      const uint32_t *words = (const uint32_t*)buf;
+      size_t count          = (len - 16) / 4;
+
+      if (     words[0] == GLSLANG_CACHE_MAGIC
+            && words[1] == GLSLANG_CACHE_VERSION
+            && words[2] == count
+            && words[3] ==
+            (uint32_t)glslang_hash(words + 4, count * 4))
+      {
+         blob->resize(count);
+         memcpy(blob->data(), words + 4, count * 4);
+         ret = true;
+      }
+   }
+
+   if (!ret)
+      RARCH_WARN("[slang]: Discarding corrupt cache entry \"%s\".\n", path);
+
+   free(buf);
+   return ret;
+}
+
+bool glslang_cache_store(uint64_t key, const char *ext, const vector<uint32_t> &blob)
+{
+   char path[PATH_MAX_LENGTH];
+   char tmp[PATH_MAX_LENGTH];
+   char dir[PATH_MAX_LENGTH];
+   vector<uint32_t> words(blob.size() + 4);
+
+   if (!glslang_cache_path(key, ext, path, sizeof(path)))
+      return false;
+
+   /* Cache entries never leave the machine, so native
+    * endianness is fine. */
+   copy(blob.begin(), blob.end(), words.begin() + 4);
+
+   words[0] = GLSLANG_CACHE_MAGIC;
+   words[1] = GLSLANG_CACHE_VERSION;
+   words[2] = (uint32_t)blob.size();
+   words[3] = (uint32_t)glslang_hash(words.data() + 4, blob.size() * 4);
+
+   dir[0] = '\0';
+   fill_pathname_basedir(dir, path, sizeof(dir));
+   path_mkdir(dir);
+
+   /* Write next to the entry and swap, so a crash halfway
+    * through never leaves a truncated entry behind. */
+   strlcpy(tmp, path, sizeof(tmp));
+   strlcat(tmp, ".tmp", sizeof(tmp));
+
+   if (!filestream_write_file(tmp, words.data(), words.size() * 4))
+      return false;
+
+   if (!path_file_replace(tmp, path))
+   {
+      remove(tmp);
+      return false;
+   }
+
+   return true;
+}
+
 bool glslang_compile_shader(const char *shader_path, glslang_output *output)
 {
    vector<string> lines;
+   vector<uint32_t> blob;
+   uint64_t key = GLSLANG_CACHE_VERSION;
 
    RARCH_LOG("[slang]: Compiling shader \"%s\".\n", shader_path);
 
@@ -375,6 +496,22 @@ bool glslang_compile_shader(const char *shader_path, glslang_output *output)
    if (!glslang_parse_meta(lines, &output->meta))
       return false;
 
+   /* The preprocessed source is all compilation depends on,
+    * so included files are covered as well. */
+   key = glslang_hash(&key, sizeof(key));
+   for (auto &line : lines)
+      key = glslang_hash(line.c_str(), line.size() + 1, key);
+
+   if (glslang_cache_load(key, "spv", &blob)
+         && !blob.empty() && blob[0] < blob.size())
+   {
+      output->vertex.assign(blob.begin() + 1, blob.begin() + 1 + blob[0]);
+      output->fragment.assign(blob.begin() + 1 + blob[0], blob.end());
+      RARCH_LOG("[slang]: Using cached SPIR-V %016llx.\n",
+            (unsigned long long)key);
+      return true;
+   }
+
    if (    !glslang::compile_spirv(build_stage_source(lines, "vertex"),
             glslang::StageVertex, &output->vertex))
    {
@@ -389,6 +526,12 @@ bool glslang_compile_shader(const char *shader_path, glslang_output *output)
       return false;
    }
 
+   blob.clear();
+   blob.push_back((uint32_t)output->vertex.size());
+   blob.insert(blob.end(), output->vertex.begin(), output->vertex.end());
+   blob.insert(blob.end(), output->fragment.begin(), output->fragment.end());
+   glslang_cache_store(key, "spv", blob);
+
    return true;
 }
 
@@ -90,6 +90,13 @@ struct glslang_output
 bool glslang_compile_shader(const char *shader_path, glslang_output *output);
 const char *glslang_format_to_string(enum glslang_format fmt);
 
+// Persistent cache of data derived from shaders, stored in the shader
+// cache directory and keyed by a hash of everything it was derived from.
+uint64_t glslang_hash(const void *data, size_t size,
+      uint64_t hash = 0xcbf29ce484222325ull);
+bool glslang_cache_load(uint64_t key, const char *ext, std::vector<uint32_t> *blob);
+bool glslang_cache_store(uint64_t key, const char *ext, const std::vector<uint32_t> &blob);
+
 // Helpers for internal use.
 bool glslang_read_shader_file(const char *path, std::vector<std::string> *output, bool root_file);
 bool glslang_parse_meta(const std::vector<std::string> &lines, glslang_meta *meta);
@@ -21,6 +21,7 @@
 #include <compat/posix_string.h>
 #include <file/file_path.h>
 #include <retro_assert.h>
+#include <retro_stat.h>
 #include <streams/file_stream.h>
 #include <string/stdstring.h>
 
@@ -36,9 +37,20 @@
 #include "shader_glsl.h"
 #include "../../managers/state_manager.h"
 #include "../../core.h"
+#include "../../file_path_special.h"
 
 #define PREV_TEXTURES (GFX_MAX_TEXTURES - 1)
 
+#if defined(HAVE_OPENGLES2) && defined(GL_PROGRAM_BINARY_LENGTH_OES)
+#define GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+#define glGetProgramBinary glGetProgramBinaryOES
+#define glProgramBinary glProgramBinaryOES
+#endif
+
+/* Bump whenever the layout of cached programs changes. */
+#define GLSL_CACHE_VERSION 1
+#define GLSL_CACHE_MAGIC   0x4c534752 /* "RGSL" */
+
 /* Cache the VBO. */
 struct cache_vbo
 {
@@ -150,6 +162,7 @@ typedef struct glsl_shader_data
 } glsl_shader_data_t;
 
 static bool glsl_core;
+static bool glsl_program_binary;
 static unsigned glsl_major;
 static unsigned glsl_minor;
 static float* current_mat_data_pointer[GFX_MAX_SHADERS];
@@ -315,6 +328,170 @@ static bool gl_glsl_link_program(GLuint prog)
    return true;
 }
 
+#ifdef GL_PROGRAM_BINARY_LENGTH
+static uint64_t gl_glsl_hash_data(const void *data, size_t size,
+      uint64_t hash)
+{
+   /* 64-bit FNV-1a. */
+   size_t i;
+   const uint8_t *bytes = (const uint8_t*)data;
+
+   for (i = 0; i < size; i++)
+   {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ULL;
+   }
+
+   return hash;
+}
+
+static uint64_t gl_glsl_hash(const char *str, uint64_t hash)
+{
+   /* The terminator is hashed as well, so that
+    * concatenations of different strings differ. */
+   if (!str)
+      str = "";
+   return gl_glsl_hash_data(str, strlen(str) + 1, hash);
+}
+
+/* A program binary is only valid for the driver that produced it
+ * and for the exact sources and defines it was built from. */
+static uint64_t gl_glsl_program_key(glsl_shader_data_t *glsl,
+      struct shader_program_info *program_info)
+{
+   char profile[64];
+   uint64_t hash = 0xcbf29ce484222325ULL;
+
+   snprintf(profile, sizeof(profile), "%u:%d:%u.%u",
+         GLSL_CACHE_VERSION, glsl_core, glsl_major, glsl_minor);
+
+   hash = gl_glsl_hash(profile, hash);
+   hash = gl_glsl_hash((const char*)glGetString(GL_VENDOR), hash);
+   hash = gl_glsl_hash((const char*)glGetString(GL_RENDERER), hash);
+   hash = gl_glsl_hash((const char*)glGetString(GL_VERSION), hash);
+   hash = gl_glsl_hash(glsl->alias_define, hash);
+   hash = gl_glsl_hash(program_info->vertex, hash);
+   return gl_glsl_hash(program_info->fragment, hash);
+}
+
+static bool gl_glsl_program_cache_path(uint64_t key,
+      char *path, size_t len)
+{
+   char dir[PATH_MAX_LENGTH];
+   char name[32];
+
+   dir[0] = path[0] = '\0';
+
+   fill_pathname_application_special(dir, sizeof(dir),
+         APPLICATION_SPECIAL_DIRECTORY_SHADER_CACHE);
+
+   if (string_is_empty(dir))
+      return false;
+
+   snprintf(name, sizeof(name), "%016llx.glbin", (unsigned long long)key);
+   fill_pathname_join(path, dir, name, len);
+   return true;
+}
+
+static bool gl_glsl_program_cache_load(uint64_t key, GLuint prog)
+{
+   char path[PATH_MAX_LENGTH];
+   uint32_t header[5];
+   GLint status   = GL_FALSE;
+   void *buf      = NULL;
+   ssize_t len    = 0;
+
+   if (!gl_glsl_program_cache_path(key, path, sizeof(path)))
+      return false;
+
+   if (!path_file_exists(path) || !filestream_read_file(path, &buf, &len))
+      return false;
+
+   /* Header: magic, version, binary format, length, checksum. */
+   if (len < (ssize_t)sizeof(header))
+      goto end;
+
+   memcpy(header, buf, sizeof(header));
+
+   if (     header[0] != GLSL_CACHE_MAGIC
+         || header[1] != GLSL_CACHE_VERSION
+         || header[3] != (uint32_t)(len - sizeof(header))
+         || header[4] != (uint32_t)gl_glsl_hash_data(
+            (const uint8_t*)buf + sizeof(header), header[3],
+            0xcbf29ce484222325ULL))
+      goto end;
+
+   glProgramBinary(prog, header[2],
+         (const uint8_t*)buf + sizeof(header), header[3]);
+
+   /* The driver rejects binaries from other driver builds. */
+   glGetProgramiv(prog, GL_LINK_STATUS, &status);
+
+end:
+   if (status != GL_TRUE)
+      RARCH_LOG("[GLSL]: Discarding stale program cache entry %016llx.\n",
+            (unsigned long long)key);
+
+   free(buf);
+   return status == GL_TRUE;
+}
+
+static void gl_glsl_program_cache_store(uint64_t key, GLuint prog)
+{
+   char path[PATH_MAX_LENGTH];
+   char tmp[PATH_MAX_LENGTH];
+   char dir[PATH_MAX_LENGTH];
+   uint32_t header[5];
+   GLenum format  = 0;
+   GLsizei length = 0;
+   GLint size     = 0;
+   uint8_t *buf   = NULL;
+
+   if (!gl_glsl_program_cache_path(key, path, sizeof(path)))
+      return;
+
+   glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+
+   if (size <= 0)
+      return;
+
+   buf = (uint8_t*)malloc(sizeof(header) + size);
+
+   if (!buf)
+      return;
+
+   glGetProgramBinary(prog, size, &length, &format, buf + sizeof(header));
+
+   if (length <= 0)
+      goto end;
+
+   header[0] = GLSL_CACHE_MAGIC;
+   header[1] = GLSL_CACHE_VERSION;
+   header[2] = format;
+   header[3] = length;
+   header[4] = (uint32_t)gl_glsl_hash_data(buf + sizeof(header), length,
+         0xcbf29ce484222325ULL);
+   memcpy(buf, header, sizeof(header));
+
+   dir[0] = '\0';
+   fill_pathname_basedir(dir, path, sizeof(dir));
+   path_mkdir(dir);
+
+   /* Write next to the entry and swap, so a crash halfway
+    * through never leaves a truncated entry behind. */
+   strlcpy(tmp, path, sizeof(tmp));
+   strlcat(tmp, ".tmp", sizeof(tmp));
+
+   if (filestream_write_file(tmp, buf, sizeof(header) + length))
+   {
+      if (!path_file_replace(tmp, path))
+         remove(tmp);
+   }
+
+end:
+   free(buf);
+}
+#endif
 
 static bool gl_glsl_compile_program(
       void *data,
@@ -325,6 +502,9 @@ static bool gl_glsl_compile_program(
    glsl_shader_data_t *glsl = (glsl_shader_data_t*)data;
    struct shader_program_glsl_data *program = (struct shader_program_glsl_data*)program_data;
    GLuint prog = glCreateProgram();
+#ifdef GL_PROGRAM_BINARY_LENGTH
+   uint64_t key = 0;
+#endif
 
    if (!program)
       program = &glsl->prg[idx];
@@ -332,6 +512,19 @@ static bool gl_glsl_compile_program(
    if (!prog)
       goto error;
 
+#ifdef GL_PROGRAM_BINARY_LENGTH
+   if (glsl_program_binary && (program_info->vertex || program_info->fragment))
+   {
+      key = gl_glsl_program_key(glsl, program_info);
+
+      if (gl_glsl_program_cache_load(key, prog))
+      {
+         RARCH_LOG("Using cached GLSL program #%u.\n", idx);
+         goto linked;
+      }
+   }
+#endif
+
    if (program_info->vertex)
    {
       RARCH_LOG("Found GLSL vertex shader.\n");
@@ -366,9 +559,21 @@ static bool gl_glsl_compile_program(
    if (program_info->vertex || program_info->fragment)
    {
       RARCH_LOG("Linking GLSL program.\n");
+#if defined(GL_PROGRAM_BINARY_RETRIEVABLE_HINT) && !defined(HAVE_OPENGLES2)
+      /* Without the hint, drivers may not keep the binary
+       * around and glGetProgramBinary comes back empty. */
+      if (glsl_program_binary)
+         glProgramParameteri(prog,
+               GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
       if (!gl_glsl_link_program(prog))
          goto error;
 
+#ifdef GL_PROGRAM_BINARY_LENGTH
+      if (glsl_program_binary)
+         gl_glsl_program_cache_store(key, prog);
+#endif
+
       /* Clean up dead memory. We're not going to relink the program.
        * Detaching first seems to kill some mobile drivers
        * (according to the intertubes anyways). */
@@ -379,6 +584,9 @@ static bool gl_glsl_compile_program(
       program->vprg = 0;
       program->fprg = 0;
 
+#ifdef GL_PROGRAM_BINARY_LENGTH
+linked:
+#endif
       glUseProgram(prog);
       glUniform1i(gl_glsl_get_uniform(glsl, prog, "Texture"), 0);
       glUseProgram(0);
@@ -751,6 +959,12 @@ static void *gl_glsl_init(void *data, const char *path)
    }
 #endif
 
+#ifdef GL_PROGRAM_BINARY_LENGTH
+   glsl_program_binary = gl_check_capability(GL_CAPS_PROGRAM_BINARY);
+   if (glsl_program_binary)
+      RARCH_LOG("[GLSL]: Caching linked program binaries.\n");
+#endif
+
    glsl->shader = (struct video_shader*)calloc(1, sizeof(*glsl->shader));
    if (!glsl->shader)
       goto error;
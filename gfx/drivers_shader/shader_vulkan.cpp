@@ -577,6 +577,7 @@ struct vulkan_filter_chain
       VkPhysicalDevice gpu;
       const VkPhysicalDeviceMemoryProperties &memory_properties;
       VkPipelineCache cache;
+      slock_t *queue_lock;
       vector<unique_ptr<Pass>> passes;
       vector<vulkan_filter_chain_pass_info> pass_info;
       vector<vector<function<void ()>>> deferred_calls;
@@ -614,6 +615,7 @@ vulkan_filter_chain::vulkan_filter_chain(
      gpu(info.gpu),
      memory_properties(*info.memory_properties),
      cache(info.pipeline_cache),
+     queue_lock(info.queue_lock),
      common(info.device, *info.memory_properties),
      original_format(info.original_format)
 {
@@ -739,7 +741,16 @@ void vulkan_filter_chain::execute_deferred()
 
 void vulkan_filter_chain::flush()
 {
+   /* vkDeviceWaitIdle implicitly touches every queue of the device. */
+#ifdef HAVE_THREADS
+   if (queue_lock)
+      slock_lock(queue_lock);
+#endif
    vkDeviceWaitIdle(device);
+#ifdef HAVE_THREADS
+   if (queue_lock)
+      slock_unlock(queue_lock);
+#endif
    execute_deferred();
 }
 
@@ -2806,7 +2817,10 @@ static bool vulkan_filter_chain_load_luts(
       VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
    VkSubmitInfo submit_info                      = {
       VK_STRUCTURE_TYPE_SUBMIT_INFO };
+   VkFenceCreateInfo fence_info                  = {
+      VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
    VkCommandBuffer cmd                           = VK_NULL_HANDLE;
+   VkFence fence                                 = VK_NULL_HANDLE;
    VkCommandBufferAllocateInfo cmd_info          = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
    bool recording                                = false;
 
@@ -2834,8 +2848,23 @@ static bool vulkan_filter_chain_load_luts(
    vkEndCommandBuffer(cmd);
    submit_info.commandBufferCount = 1;
    submit_info.pCommandBuffers    = &cmd;
-   vkQueueSubmit(info->queue, 1, &submit_info, VK_NULL_HANDLE);
-   vkQueueWaitIdle(info->queue);
+
+   /* Wait on a fence rather than idling the queue, so the upload
+    * does not stall (or race) the video thread when the chain is
+    * built on a worker. */
+   vkCreateFence(info->device, &fence_info, nullptr, &fence);
+#ifdef HAVE_THREADS
+   if (info->queue_lock)
+      slock_lock(info->queue_lock);
+#endif
+   vkQueueSubmit(info->queue, 1, &submit_info, fence);
+#ifdef HAVE_THREADS
+   if (info->queue_lock)
+      slock_unlock(info->queue_lock);
+#endif
+   vkWaitForFences(info->device, 1, &fence, VK_TRUE, UINT64_MAX);
+   vkDestroyFence(info->device, fence, nullptr);
+
    vkFreeCommandBuffers(info->device, info->command_pool, 1, &cmd);
    chain->release_staging_buffers();
    return true;
@@ -99,6 +99,10 @@ struct vulkan_filter_chain_create_info
    const VkPhysicalDeviceMemoryProperties *memory_properties;
    VkPipelineCache pipeline_cache;
    VkQueue queue;
+   /* Optional. When set, submissions to queue and device-wide waits
+    * are serialized against this lock, so a chain can be built
+    * off the video thread. */
+   slock_t *queue_lock;
    VkCommandPool command_pool;
    unsigned num_passes;
 
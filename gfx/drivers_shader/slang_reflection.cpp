@@ -15,7 +15,9 @@
 
 #include "spirv_cross.hpp"
 #include "slang_reflection.hpp"
+#include "glslang_util.hpp"
 #include <vector>
+#include <algorithm>
 #include <stdio.h>
 #include "../../verbosity.h"
 
@@ -645,10 +647,195 @@ static bool slang_reflect(const Compiler &vertex_compiler, const Compiler &fragm
    return true;
 }
 
+template <typename M>
+static uint64_t slang_hash_semantic_map(const M *map, uint64_t hash)
+{
+   vector<string> entries;
+
+   if (!map)
+      return hash;
+
+   /* Iteration order of an unordered_map is unspecified, sort it. */
+   for (auto &entry : *map)
+   {
+      char mapping[64];
+      snprintf(mapping, sizeof(mapping), "=%d:%u",
+            int(entry.second.semantic), entry.second.index);
+      entries.push_back(entry.first + mapping);
+   }
+
+   sort(begin(entries), end(entries));
+
+   for (auto &entry : entries)
+      hash = glslang_hash(entry.c_str(), entry.size() + 1, hash);
+
+   return glslang_hash("", 1, hash);
+}
+
+/* Reflection depends on the SPIR-V as well as on the pass number
+ * and the names the preset gives to textures and parameters. */
+static uint64_t slang_reflection_key(const vector<uint32_t> &vertex,
+      const vector<uint32_t> &fragment, const slang_reflection *reflection)
+{
+   uint32_t sizes[3] = { uint32_t(vertex.size()), uint32_t(fragment.size()),
+      reflection->pass_number };
+   uint64_t hash     = glslang_hash(sizes, sizeof(sizes));
+
+   hash = glslang_hash(vertex.data(), vertex.size() * sizeof(uint32_t), hash);
+   hash = glslang_hash(fragment.data(), fragment.size() * sizeof(uint32_t), hash);
+   hash = slang_hash_semantic_map(reflection->texture_semantic_map, hash);
+   hash = slang_hash_semantic_map(reflection->texture_semantic_uniform_map, hash);
+   return slang_hash_semantic_map(reflection->semantic_map, hash);
+}
+
+static void slang_reflection_pack(const slang_reflection &reflection,
+      vector<uint32_t> *blob)
+{
+   blob->push_back(uint32_t(reflection.ubo_size));
+   blob->push_back(uint32_t(reflection.push_constant_size));
+   blob->push_back(reflection.ubo_binding);
+   blob->push_back(reflection.ubo_stage_mask);
+   blob->push_back(reflection.push_constant_stage_mask);
+
+   for (unsigned i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+   {
+      blob->push_back(uint32_t(reflection.semantic_textures[i].size()));
+
+      for (auto &meta : reflection.semantic_textures[i])
+      {
+         blob->push_back(uint32_t(meta.ubo_offset));
+         blob->push_back(uint32_t(meta.push_constant_offset));
+         blob->push_back(meta.binding);
+         blob->push_back(meta.stage_mask);
+         blob->push_back(meta.texture | (meta.uniform << 1) | (meta.push_constant << 2));
+      }
+   }
+
+   for (unsigned i = 0; i < SLANG_NUM_SEMANTICS; i++)
+   {
+      const slang_semantic_meta &meta = reflection.semantics[i];
+      blob->push_back(uint32_t(meta.ubo_offset));
+      blob->push_back(uint32_t(meta.push_constant_offset));
+      blob->push_back(meta.num_components);
+      blob->push_back(meta.uniform | (meta.push_constant << 1));
+   }
+
+   blob->push_back(uint32_t(reflection.semantic_float_parameters.size()));
+
+   for (auto &meta : reflection.semantic_float_parameters)
+   {
+      blob->push_back(uint32_t(meta.ubo_offset));
+      blob->push_back(uint32_t(meta.push_constant_offset));
+      blob->push_back(meta.num_components);
+      blob->push_back(meta.uniform | (meta.push_constant << 1));
+   }
+}
+
+static bool slang_reflection_unpack(const vector<uint32_t> &blob,
+      slang_reflection *reflection)
+{
+   size_t pos = 0;
+   auto next  = [&](uint32_t *value) -> bool {
+      if (pos >= blob.size())
+         return false;
+      *value = blob[pos++];
+      return true;
+   };
+   uint32_t v[5];
+   uint32_t count;
+
+   for (unsigned i = 0; i < 5; i++)
+      if (!next(&v[i]))
+         return false;
+
+   reflection->ubo_size                 = v[0];
+   reflection->push_constant_size       = v[1];
+   reflection->ubo_binding              = v[2];
+   reflection->ubo_stage_mask           = v[3];
+   reflection->push_constant_stage_mask = v[4];
+
+   for (unsigned i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+   {
+      if (!next(&count) || count > blob.size())
+         return false;
+
+      reflection->semantic_textures[i].resize(count);
+
+      for (auto &meta : reflection->semantic_textures[i])
+      {
+         for (unsigned j = 0; j < 5; j++)
+            if (!next(&v[j]))
+               return false;
+
+         meta.ubo_offset           = v[0];
+         meta.push_constant_offset = v[1];
+         meta.binding              = v[2];
+         meta.stage_mask           = v[3];
+         meta.texture              = (v[4] & 1) != 0;
+         meta.uniform              = (v[4] & 2) != 0;
+         meta.push_constant        = (v[4] & 4) != 0;
+      }
+   }
+
+   for (unsigned i = 0; i < SLANG_NUM_SEMANTICS; i++)
+   {
+      slang_semantic_meta &meta = reflection->semantics[i];
+
+      for (unsigned j = 0; j < 4; j++)
+         if (!next(&v[j]))
+            return false;
+
+      meta.ubo_offset           = v[0];
+      meta.push_constant_offset = v[1];
+      meta.num_components       = v[2];
+      meta.uniform              = (v[3] & 1) != 0;
+      meta.push_constant        = (v[3] & 2) != 0;
+   }
+
+   if (!next(&count) || count > blob.size())
+      return false;
+
+   reflection->semantic_float_parameters.resize(count);
+
+   for (auto &meta : reflection->semantic_float_parameters)
+   {
+      for (unsigned j = 0; j < 4; j++)
+         if (!next(&v[j]))
+            return false;
+
+      meta.ubo_offset           = v[0];
+      meta.push_constant_offset = v[1];
+      meta.num_components       = v[2];
+      meta.uniform              = (v[3] & 1) != 0;
+      meta.push_constant        = (v[3] & 2) != 0;
+   }
+
+   return pos == blob.size();
+}
+
 bool slang_reflect_spirv(const std::vector<uint32_t> &vertex,
       const std::vector<uint32_t> &fragment,
       slang_reflection *reflection)
 {
+   vector<uint32_t> blob;
+   uint64_t key = slang_reflection_key(vertex, fragment, reflection);
+
+   if (glslang_cache_load(key, "refl", &blob))
+   {
+      slang_reflection cached;
+
+      cached.pass_number                  = reflection->pass_number;
+      cached.texture_semantic_map         = reflection->texture_semantic_map;
+      cached.texture_semantic_uniform_map = reflection->texture_semantic_uniform_map;
+      cached.semantic_map                 = reflection->semantic_map;
+
+      if (slang_reflection_unpack(blob, &cached))
+      {
+         *reflection = cached;
+         return true;
+      }
+   }
+
    try
    {
       Compiler vertex_compiler(vertex);
@@ -664,6 +851,10 @@ bool slang_reflect_spirv(const std::vector<uint32_t> &vertex,
          return false;
       }
 
+      blob.clear();
+      slang_reflection_pack(*reflection, &blob);
+      glslang_cache_store(key, "refl", blob);
+
       return true;
    }
    catch (const std::exception &e)
@@ -47,6 +47,7 @@
 #include "video_context_driver.h"
 
 #include "../frontend/frontend_driver.h"
+#include "../audio/audio_driver.h"
 #include "../record/record_driver.h"
 #include "../config.def.h"
 #include "../configuration.h"
@@ -2036,6 +2037,7 @@ void video_driver_frame(const void *data, unsigned width,
    static retro_time_t curr_time;
    static retro_time_t fps_time;
    static float last_fps;
+   static char audio_text[128];
    unsigned output_width                             = 0;
    unsigned output_height                            = 0;
    unsigned output_pitch                             = 0;
@@ -2103,6 +2105,25 @@ void video_driver_frame(const void *data, unsigned width,
                   sizeof(video_driver_window_title));
          }
 
+         /* The buffer statistics walk the whole sample history,
+          * so only refresh them along with the FPS counter. */
+         audio_text[0] = '\0';
+         if (video_info.fps_show)
+         {
+            audio_statistics_t audio_stats;
+
+            if (audio_driver_get_statistics(&audio_stats))
+               snprintf(audio_text, sizeof(audio_text),
+                     " || %s: %u%%/%u%% || %s: %u || %s: %+.3f%%",
+                     msg_hash_to_str(MSG_AUDIO_BUFFER_FILL),
+                     audio_stats.saturation_p50,
+                     audio_stats.saturation_p5,
+                     msg_hash_to_str(MSG_AUDIO_UNDERRUNS),
+                     audio_stats.underrun_count,
+                     msg_hash_to_str(MSG_AUDIO_DRIFT),
+                     audio_stats.ratio_drift);
+         }
+
          curr_time = new_time;
 
          strlcat(video_driver_window_title,
@@ -2122,6 +2143,7 @@ void video_driver_frame(const void *data, unsigned width,
       }
 
       if (video_info.fps_show)
+      {
          snprintf(
                video_info.fps_text,
                sizeof(video_info.fps_text),
@@ -2129,6 +2151,9 @@ void video_driver_frame(const void *data, unsigned width,
                last_fps,
                msg_hash_to_str(MSG_FRAMES),
                (unsigned long long)video_info.frame_count);
+         strlcat(video_info.fps_text, audio_text,
+               sizeof(video_info.fps_text));
+      }
    }
    else
    {
@@ -22,6 +22,7 @@
 
 #include <limits.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -39,6 +40,10 @@
 #include <file/file_path.h>
 #include <compat/strl.h>
 #include <string/stdstring.h>
+#include <retro_miscellaneous.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "../input_config.h"
 #include "../input_driver.h"
@@ -53,6 +58,13 @@
 
 #include "../../verbosity.h"
 
+/* Events read by the input thread and not yet handled by udev_input_poll.
+ * Must be a power of two. */
+#define UDEV_INPUT_QUEUE_SIZE 1024
+
+/* Key events between two event-to-poll latency reports in verbose mode. */
+#define UDEV_INPUT_LATENCY_REPORT 256
+
 typedef struct udev_input udev_input_t;
 
 typedef void (*device_handle_cb)(void *data,
@@ -62,6 +74,7 @@ struct udev_input_device
 {
    int fd;
    dev_t dev;
+   bool monotonic;
    device_handle_cb handle_cb;
    char devnode[PATH_MAX_LENGTH];
 
@@ -98,6 +111,40 @@ struct udev_input
    int16_t mouse_x;
    int16_t mouse_y;
    bool mouse_l, mouse_r, mouse_m, mouse_wu, mouse_wd, mouse_whu, mouse_whd;
+
+   /* Time from the kernel timestamping a key event to us handling it */
+   struct
+   {
+      unsigned count;
+      uint64_t sum;
+      uint64_t max;
+      unsigned total_count;
+      uint64_t total_sum;
+      uint64_t total_max;
+   } latency;
+
+#ifdef HAVE_THREADS
+   /* Events are read as soon as they arrive by a thread blocking on epoll,
+    * and handed to udev_input_poll through a single-producer,
+    * single-consumer queue. The lock only guards the device list against
+    * hotplug while the thread reads. Joypads are not read here; they
+    * are still polled synchronously by the joypad driver. */
+   sthread_t *thread;
+   slock_t *devices_lock;
+   int wake_fds[2];
+   volatile bool thread_quit;
+   /* Set by the thread when it gives up; udev_input_poll then joins it
+    * and goes back to reading on poll. */
+   volatile bool thread_failed;
+
+   struct
+   {
+      udev_input_device_t *device;
+      struct input_event event;
+   } queue[UDEV_INPUT_QUEUE_SIZE];
+   volatile unsigned queue_head;
+   volatile unsigned queue_tail;
+#endif
 };
 
 #ifdef HAVE_XKBCOMMON
@@ -252,6 +299,14 @@ static bool udev_input_add_device(udev_input_t *udev,
    device->dev       = st.st_dev;
    device->handle_cb = cb;
 
+#ifdef EVIOCSCLOCKID
+   {
+      /* Timestamp events on the same clock we measure latency with */
+      int clock_id      = CLOCK_MONOTONIC;
+      device->monotonic = ioctl(fd, EVIOCSCLOCKID, &clock_id) == 0;
+   }
+#endif
+
    strlcpy(device->devnode, devnode, sizeof(device->devnode));
 
    /* Touchpads report in absolute coords. */
@@ -352,6 +407,228 @@ end:
    udev_device_unref(dev);
 }
 
+static uint64_t udev_input_time_usec(void)
+{
+   struct timespec tv;
+   if (clock_gettime(CLOCK_MONOTONIC, &tv) < 0)
+      return 0;
+   return (uint64_t)tv.tv_sec * 1000000 + tv.tv_nsec / 1000;
+}
+
+static void udev_input_report_latency(udev_input_t *udev)
+{
+   if (!udev->latency.count)
+      return;
+
+   RARCH_LOG("[udev]: Event-to-poll latency: avg %u us, max %u us (%u key events).\n",
+         (unsigned)(udev->latency.sum / udev->latency.count),
+         (unsigned)udev->latency.max, udev->latency.count);
+
+   udev->latency.count = 0;
+   udev->latency.sum   = 0;
+   udev->latency.max   = 0;
+}
+
+static void udev_input_handle_event(udev_input_t *udev,
+      udev_input_device_t *device, const struct input_event *event,
+      uint64_t now)
+{
+   if (event->type == EV_KEY && device->monotonic && now)
+   {
+      uint64_t stamp   = (uint64_t)event->time.tv_sec * 1000000
+         + event->time.tv_usec;
+      uint64_t latency = now > stamp ? now - stamp : 0;
+
+      udev->latency.count++;
+      udev->latency.sum += latency;
+      if (latency > udev->latency.max)
+         udev->latency.max = latency;
+
+      udev->latency.total_count++;
+      udev->latency.total_sum += latency;
+      if (latency > udev->latency.total_max)
+         udev->latency.total_max = latency;
+
+      if (udev->latency.count >= UDEV_INPUT_LATENCY_REPORT
+            && verbosity_is_enabled())
+         udev_input_report_latency(udev);
+   }
+
+   device->handle_cb(udev, event, device);
+}
+
+#ifdef HAVE_THREADS
+static bool udev_input_device_is_open(udev_input_t *udev,
+      udev_input_device_t *device)
+{
+   unsigned i;
+
+   for (i = 0; i < udev->num_devices; i++)
+      if (udev->devices[i] == device)
+         return true;
+
+   return false;
+}
+
+/* Producer side; called with devices_lock held.
+ * Returns false if the queue is full. */
+static bool udev_input_thread_read(udev_input_t *udev,
+      udev_input_device_t *device)
+{
+   for (;;)
+   {
+      int j, len;
+      struct input_event input_events[32];
+      unsigned head  = udev->queue_head;
+      unsigned space = UDEV_INPUT_QUEUE_SIZE - (head - udev->queue_tail);
+
+      if (!space)
+         return false;
+      if (space > ARRAY_SIZE(input_events))
+         space = ARRAY_SIZE(input_events);
+
+      /* Don't overwrite entries before the consumer is done with them */
+      __sync_synchronize();
+
+      len = read(device->fd, input_events, space * sizeof(*input_events));
+      if (len <= 0)
+         return true;
+
+      len /= sizeof(*input_events);
+      for (j = 0; j < len; j++, head++)
+      {
+         udev->queue[head & (UDEV_INPUT_QUEUE_SIZE - 1)].device = device;
+         udev->queue[head & (UDEV_INPUT_QUEUE_SIZE - 1)].event  = input_events[j];
+      }
+
+      /* Publish the entries before the new head */
+      __sync_synchronize();
+      udev->queue_head = head;
+   }
+}
+
+static void udev_input_thread(void *data)
+{
+   udev_input_t *udev = (udev_input_t*)data;
+
+   while (!udev->thread_quit)
+   {
+      int i;
+      bool full = false;
+      struct epoll_event events[32];
+      int ret   = epoll_waiting(&udev->epfd, events, ARRAY_SIZE(events), -1);
+
+      if (ret < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         RARCH_ERR("[udev]: Input thread failed to wait for events (%s).\n",
+               strerror(errno));
+         udev->thread_failed = true;
+         break;
+      }
+
+      slock_lock(udev->devices_lock);
+      for (i = 0; i < ret; i++)
+      {
+         udev_input_device_t *device = (udev_input_device_t*)events[i].data.ptr;
+
+         /* The wake pipe has no device */
+         if (!device)
+            continue;
+
+         /* Removed by hotplug after epoll_wait returned */
+         if (!udev_input_device_is_open(udev, device))
+            continue;
+
+         if (events[i].events & EPOLLIN)
+            if (!udev_input_thread_read(udev, device))
+               full = true;
+
+         /* An unplugged device stays readable-with-error until hotplug
+          * closes it, which would wake us in a loop; stop watching it. */
+         if (events[i].events & (EPOLLHUP | EPOLLERR))
+            epoll_ctl(udev->epfd, EPOLL_CTL_DEL, device->fd, NULL);
+      }
+      slock_unlock(udev->devices_lock);
+
+      /* Nobody is polling; leave the rest in the kernel's buffer */
+      if (full)
+         retro_sleep(1);
+   }
+}
+
+/* Consumer side; called from udev_input_poll. */
+static void udev_input_drain_queue(udev_input_t *udev)
+{
+   uint64_t now  = udev_input_time_usec();
+   unsigned tail = udev->queue_tail;
+   unsigned head = udev->queue_head;
+
+   /* Read the entries only after seeing the head that published them */
+   __sync_synchronize();
+
+   for (; tail != head; tail++)
+   {
+      unsigned slot = tail & (UDEV_INPUT_QUEUE_SIZE - 1);
+      udev_input_handle_event(udev, udev->queue[slot].device,
+            &udev->queue[slot].event, now);
+   }
+
+   __sync_synchronize();
+   udev->queue_tail = tail;
+}
+
+static bool udev_input_start_thread(udev_input_t *udev)
+{
+   udev->wake_fds[0] = udev->wake_fds[1] = -1;
+
+   if (pipe(udev->wake_fds) < 0)
+      return false;
+
+   if (!epoll_add(&udev->epfd, udev->wake_fds[0], NULL))
+      goto error;
+
+   udev->devices_lock = slock_new();
+   if (!udev->devices_lock)
+      goto error;
+
+   udev->thread = sthread_create(udev_input_thread, udev);
+   if (!udev->thread)
+      goto error;
+
+   return true;
+
+error:
+   if (udev->devices_lock)
+      slock_free(udev->devices_lock);
+   udev->devices_lock = NULL;
+   close(udev->wake_fds[0]);
+   close(udev->wake_fds[1]);
+   udev->wake_fds[0] = udev->wake_fds[1] = -1;
+   return false;
+}
+
+static void udev_input_stop_thread(udev_input_t *udev)
+{
+   if (!udev->thread)
+      return;
+
+   udev->thread_quit = true;
+   if (write(udev->wake_fds[1], "q", 1) < 0)
+      RARCH_WARN("[udev]: Failed to wake input thread (%s).\n", strerror(errno));
+   sthread_join(udev->thread);
+   udev->thread = NULL;
+
+   slock_free(udev->devices_lock);
+   udev->devices_lock = NULL;
+
+   close(udev->wake_fds[0]);
+   close(udev->wake_fds[1]);
+   udev->wake_fds[0] = udev->wake_fds[1] = -1;
+}
+#endif
+
 static void udev_input_poll(void *data)
 {
    int i, ret;
@@ -365,6 +642,36 @@ static void udev_input_poll(void *data)
    udev->mouse_wu  = udev->mouse_wd  = 0;
    udev->mouse_whu = udev->mouse_whd = 0;
 
+#ifdef HAVE_THREADS
+   if (udev->thread && udev->thread_failed)
+   {
+      udev_input_drain_queue(udev);
+      udev_input_stop_thread(udev);
+      RARCH_WARN("[udev]: Input thread stopped, reading events on poll.\n");
+   }
+
+   if (udev->thread)
+   {
+      if (udev->monitor && udev_hotplug_available(udev->monitor))
+      {
+         /* Handle whatever is queued for a device before it goes away,
+          * and keep the thread from queueing more meanwhile. */
+         slock_lock(udev->devices_lock);
+         udev_input_drain_queue(udev);
+         while (udev_hotplug_available(udev->monitor))
+            udev_input_handle_hotplug(udev);
+         slock_unlock(udev->devices_lock);
+      }
+
+      udev_input_drain_queue(udev);
+
+      /* Not covered by the thread; reads its own fds on poll */
+      if (udev->joypad)
+         udev->joypad->poll();
+      return;
+   }
+#endif
+
    while (udev->monitor && udev_hotplug_available(udev->monitor))
       udev_input_handle_hotplug(udev);
 
@@ -377,12 +684,13 @@ static void udev_input_poll(void *data)
          int j, len;
          struct input_event input_events[32];
          udev_input_device_t *device = (udev_input_device_t*)events[i].data.ptr;
+         uint64_t now                = udev_input_time_usec();
 
          while ((len = read(device->fd, input_events, sizeof(input_events))) > 0)
          {
             len /= sizeof(*input_events);
             for (j = 0; j < len; j++)
-               device->handle_cb(udev, &input_events[j], device);
+               udev_input_handle_event(udev, device, &input_events[j], now);
          }
       }
    }
@@ -546,6 +854,15 @@ static void udev_input_free(void *data)
    if (!data || !udev)
       return;
 
+#ifdef HAVE_THREADS
+   udev_input_stop_thread(udev);
+#endif
+
+   if (udev->latency.total_count)
+      RARCH_LOG("[udev]: Event-to-poll latency over session: avg %u us, max %u us (%u key events).\n",
+            (unsigned)(udev->latency.total_sum / udev->latency.total_count),
+            (unsigned)udev->latency.total_max, udev->latency.total_count);
+
    if (udev->joypad)
       udev->joypad->destroy();
 
@@ -665,6 +982,11 @@ static void *udev_input_init(const char *joypad_driver)
    udev->joypad = input_joypad_init_driver(joypad_driver, udev);
    input_keymaps_init_keyboard_lut(rarch_key_map_linux);
 
+#ifdef HAVE_THREADS
+   if (!udev_input_start_thread(udev))
+      RARCH_WARN("[udev]: Failed to start input thread, reading events on poll.\n");
+#endif
+
    linux_terminal_disable_input();
 
    return udev;
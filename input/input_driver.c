@@ -260,6 +260,86 @@ float input_sensor_get_input(unsigned port, unsigned id)
 
 static const struct retro_keybind *libretro_input_binds[MAX_USERS];
 
+/* RetroPad state of one user as the core sees it, before remapping and
+ * turbo. Resolved from the driver, overlay and network gamepad the first
+ * time the core asks for that user after a poll, so every later query in
+ * the frame is a table lookup and sees the same state. */
+typedef struct input_snapshot
+{
+   bool resolved;
+   uint16_t buttons;
+   int16_t analog[2][2];
+} input_snapshot_t;
+
+static input_snapshot_t input_driver_snapshot[MAX_USERS];
+
+static INLINE void input_state_extras(int16_t *res, unsigned port,
+      unsigned device, unsigned idx, unsigned id)
+{
+#ifdef HAVE_OVERLAY
+   if (overlay_ptr)
+      input_state_overlay(overlay_ptr, res, port, device, idx, id);
+#endif
+
+#ifdef HAVE_NETWORKGAMEPAD
+   input_remote_state(res, port, device, idx, id);
+#endif
+}
+
+/**
+ * input_snapshot_resolve:
+ * @settings             : pointer to settings
+ * @port                 : user number.
+ *
+ * Reads every RetroPad button and analog axis of @port into its snapshot.
+ **/
+static void input_snapshot_resolve(settings_t *settings, unsigned port)
+{
+   unsigned idx, id;
+   rarch_joypad_info_t joypad_info;
+   input_snapshot_t *snapshot        = &input_driver_snapshot[port];
+   const struct retro_keybind *binds = libretro_input_binds[port];
+
+   joypad_info.axis_threshold = settings->input.axis_threshold;
+   joypad_info.joy_idx        = settings->input.joypad_map[port];
+   joypad_info.auto_binds     = settings->input.autoconf_binds[joypad_info.joy_idx];
+
+   snapshot->buttons = 0;
+
+   for (id = 0; id < RARCH_FIRST_CUSTOM_BIND; id++)
+   {
+      int16_t res = 0;
+
+      if (binds && binds[id].valid)
+         res = current_input->input_state(current_input_data, joypad_info,
+               libretro_input_binds, port, RETRO_DEVICE_JOYPAD, 0, id);
+
+      input_state_extras(&res, port, RETRO_DEVICE_JOYPAD, 0, id);
+
+      if (res)
+         snapshot->buttons |= (1 << id);
+   }
+
+   for (idx = 0; idx < 2; idx++)
+   {
+      for (id = 0; id < 2; id++)
+      {
+         int16_t res = 0;
+
+         /* Same (odd) validity check as the unsnapshotted path */
+         if (binds && binds[id].valid)
+            res = current_input->input_state(current_input_data, joypad_info,
+                  libretro_input_binds, port, RETRO_DEVICE_ANALOG, idx, id);
+
+         input_state_extras(&res, port, RETRO_DEVICE_ANALOG, idx, id);
+
+         snapshot->analog[idx][id] = res;
+      }
+   }
+
+   snapshot->resolved = true;
+}
+
 /**
  * input_poll:
  *
@@ -275,6 +355,9 @@ void input_poll(void)
 
    input_driver_turbo_btns.count++;
 
+   for (i = 0; i < MAX_USERS; i++)
+      input_driver_snapshot[i].resolved = false;
+
    for (i = 0; i < max_users; i++)
    {
       libretro_input_binds[i]                 = settings->input.binds[i];
@@ -375,31 +458,41 @@ int16_t input_state(unsigned port, unsigned device,
          }
       }
 
-      if (((id < RARCH_FIRST_META_KEY) || (device == RETRO_DEVICE_KEYBOARD)))
+      if (port < MAX_USERS &&
+            ((device == RETRO_DEVICE_JOYPAD && id < RARCH_FIRST_CUSTOM_BIND)
+             || (device == RETRO_DEVICE_ANALOG && idx < 2 && id < 2)))
       {
-         bool bind_valid = libretro_input_binds[port] && libretro_input_binds[port][id].valid;
+         input_snapshot_t *snapshot = &input_driver_snapshot[port];
 
-         if (bind_valid || device == RETRO_DEVICE_KEYBOARD)
+         if (!snapshot->resolved)
+            input_snapshot_resolve(settings, port);
+
+         if (device == RETRO_DEVICE_JOYPAD)
+            res = (snapshot->buttons >> id) & 1;
+         else
+            res = snapshot->analog[idx][id];
+      }
+      else
+      {
+         if (((id < RARCH_FIRST_META_KEY) || (device == RETRO_DEVICE_KEYBOARD)))
          {
-            rarch_joypad_info_t joypad_info;
+            bool bind_valid = libretro_input_binds[port] && libretro_input_binds[port][id].valid;
 
-            joypad_info.axis_threshold = settings->input.axis_threshold;
-            joypad_info.joy_idx        = settings->input.joypad_map[port];
-            joypad_info.auto_binds     = settings->input.autoconf_binds[joypad_info.joy_idx];
+            if (bind_valid || device == RETRO_DEVICE_KEYBOARD)
+            {
+               rarch_joypad_info_t joypad_info;
 
-            res = current_input->input_state(
-                  current_input_data, joypad_info, libretro_input_binds, port, device, idx, id);
-         }
-      }
+               joypad_info.axis_threshold = settings->input.axis_threshold;
+               joypad_info.joy_idx        = settings->input.joypad_map[port];
+               joypad_info.auto_binds     = settings->input.autoconf_binds[joypad_info.joy_idx];
 
-#ifdef HAVE_OVERLAY
-      if (overlay_ptr)
-         input_state_overlay(overlay_ptr, &res, port, device, idx, id);
-#endif
+               res = current_input->input_state(
+                     current_input_data, joypad_info, libretro_input_binds, port, device, idx, id);
+            }
+         }
 
-#ifdef HAVE_NETWORKGAMEPAD
-      input_remote_state(&res, port, device, idx, id);
-#endif
+         input_state_extras(&res, port, device, idx, id);
+      }
 
       /* Don't allow turbo for D-pad. */
       if (device == RETRO_DEVICE_JOYPAD && (id < RETRO_DEVICE_ID_JOYPAD_UP ||
@@ -834,9 +927,6 @@ static INLINE bool input_keys_pressed_internal(
    {
       bool bind_valid = binds[i].valid;
 
-      joypad_info.joy_idx        = settings->input.joypad_map[0];
-      joypad_info.auto_binds     = settings->input.autoconf_binds[joypad_info.joy_idx];
-
       if (bind_valid && current_input->input_state(current_input_data,
                joypad_info, &binds,
                0, RETRO_DEVICE_JOYPAD, 0, i))
@@ -948,6 +1038,10 @@ uint64_t input_keys_pressed(
          input_driver_block_hotkey = false;
    }
 
+   /* The per-key checks below all read user 1's pad */
+   joypad_info.joy_idx        = settings->input.joypad_map[0];
+   joypad_info.auto_binds     = settings->input.autoconf_binds[joypad_info.joy_idx];
+
 #ifdef HAVE_MENU
    if (
          ((settings->input.menu_toggle_gamepad_combo != INPUT_TOGGLE_NONE) &&
@@ -1012,7 +1106,10 @@ bool input_driver_init(void)
    settings_t *settings       = config_get_ptr();
 
    for (i = 0; i < MAX_USERS; i++)
-      libretro_input_binds[i] = settings->input.binds[i];
+   {
+      libretro_input_binds[i]            = settings->input.binds[i];
+      input_driver_snapshot[i].resolved = false;
+   }
    if (current_input)
       current_input_data      = current_input->init(settings->input.joypad_driver);
 
@@ -42,6 +42,8 @@ MSG_HASH(MENU_ENUM_LABEL_AUDIO_MUTE,
       "audio_mute_enable")
 MSG_HASH(MENU_ENUM_LABEL_AUDIO_OUTPUT_RATE,
       "audio_output_rate")
+MSG_HASH(MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_ADAPTIVE,
+      "audio_rate_control_adaptive")
 MSG_HASH(MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_DELTA,
       "audio_rate_control_delta")
 MSG_HASH(MENU_ENUM_LABEL_AUDIO_RESAMPLER_DRIVER,
@@ -609,6 +611,8 @@ MSG_HASH(MENU_ENUM_LABEL_NETPLAY_NICKNAME,
       "netplay_nickname")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_PASSWORD,
       "netplay_password")
+MSG_HASH(MENU_ENUM_LABEL_NETPLAY_RELAY_KEYFRAME_INTERVAL,
+      "netplay_relay_keyframe_interval")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_SETTINGS,
       "menu_netplay_settings")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_PUBLIC_ANNOUNCE,
@@ -617,6 +621,8 @@ MSG_HASH(MENU_ENUM_LABEL_NETPLAY_SPECTATE_PASSWORD,
       "netplay_spectate_password")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_SPECTATOR_MODE_ENABLE,
       "netplay_spectator_mode_enable")
+MSG_HASH(MENU_ENUM_LABEL_NETPLAY_SPECTATOR_RELAY,
+      "netplay_spectator_relay")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_STATELESS_MODE,
       "netplay_stateless_mode")
 MSG_HASH(MENU_ENUM_LABEL_NETPLAY_TCP_UDP_PORT,
@@ -705,6 +711,8 @@ MSG_HASH(MENU_ENUM_LABEL_PERFCNT_ENABLE,
       "perfcnt_enable")
 MSG_HASH(MENU_ENUM_LABEL_PLAYLISTS_TAB,
       "playlists_tab")
+MSG_HASH(MENU_ENUM_LABEL_PLAYLIST_BINARY_FORMAT,
+      "playlist_binary_format")
 MSG_HASH(MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY,
       "playlist_collection_entry")
 MSG_HASH(MENU_ENUM_LABEL_PLAYLIST_DIRECTORY,
@@ -827,6 +835,10 @@ MSG_HASH(MENU_ENUM_LABEL_RGUI_SHOW_START_SCREEN,
       "rgui_show_start_screen")
 MSG_HASH(MENU_ENUM_LABEL_RUN,
       "collection")
+MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_ENABLED,
+      "run_ahead_enabled")
+MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,
+      "run_ahead_frames")
 MSG_HASH(MENU_ENUM_LABEL_SAMBA_ENABLE,
       "samba_enable")
 MSG_HASH(MENU_ENUM_LABEL_SAVEFILE_DIRECTORY,
@@ -839,6 +851,8 @@ MSG_HASH(MENU_ENUM_LABEL_SAVESTATE_AUTO_SAVE,
       "savestate_auto_save")
 MSG_HASH(MENU_ENUM_LABEL_SAVESTATE_DIRECTORY,
       "savestate_directory")
+MSG_HASH(MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION,
+      "savestate_file_compression")
 MSG_HASH(MENU_ENUM_LABEL_SAVE_CURRENT_CONFIG,
       "save_current_config")
 MSG_HASH(MENU_ENUM_LABEL_SAVE_CURRENT_CONFIG_OVERRIDE_CORE,
@@ -859,6 +873,8 @@ MSG_HASH(MENU_ENUM_LABEL_NETPLAY_REFRESH_ROOMS,
       "refresh_rooms")
 MSG_HASH(MENU_ENUM_LABEL_SCAN_THIS_DIRECTORY,
       "scan_this_directory")
+MSG_HASH(MENU_ENUM_LABEL_SCREENSHOT_COMPRESSION_LEVEL,
+      "screenshot_compression_level")
 MSG_HASH(MENU_ENUM_LABEL_SCREENSHOT_DIRECTORY,
       "screenshot_directory")
 MSG_HASH(MENU_ENUM_LABEL_SCREEN_RESOLUTION,
@@ -262,6 +262,10 @@ MSG_HASH(
       MENU_ENUM_LABEL_VALUE_AUDIO_RATE_CONTROL_DELTA,
       "Dynamic Audio Rate Control"
       )
+MSG_HASH(
+      MENU_ENUM_LABEL_VALUE_AUDIO_RATE_CONTROL_ADAPTIVE,
+      "Adaptive Audio Rate Control"
+      )
 MSG_HASH(
       MENU_ENUM_LABEL_VALUE_AUDIO_RESAMPLER_DRIVER,
       "Audio Resampler Driver"
@@ -991,6 +995,8 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_PASSWORD,
       "Server Password")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_PUBLIC_ANNOUNCE,
       "Publicly Announce Netplay")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_RELAY_KEYFRAME_INTERVAL,
+      "Netplay Relay Keyframe Interval")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_SETTINGS,
       "Netplay settings")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_STATELESS_MODE,
@@ -999,6 +1005,8 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_SPECTATE_PASSWORD,
       "Server Spectate-Only Password")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_SPECTATOR_MODE_ENABLE,
       "Netplay Spectator Enable")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_SPECTATOR_RELAY,
+      "Netplay Spectator Relay")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_TCP_UDP_PORT,
       "Netplay TCP Port")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_NETPLAY_NAT_TRAVERSAL,
@@ -1097,6 +1105,8 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_PERFCNT_ENABLE,
       "Performance Counters")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_PLAYLISTS_TAB,
       "Playlists")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_PLAYLIST_BINARY_FORMAT,
+      "Binary Playlist Format")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_PLAYLIST_DIRECTORY,
       "Playlist")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_PLAYLIST_SETTINGS,
@@ -1227,6 +1237,10 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_RIGHT_ANALOG,
       "Right Analog")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_RUN,
       "Run")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_RUN_AHEAD_ENABLED,
+      "Run-Ahead")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_RUN_AHEAD_FRAMES,
+      "Run-Ahead Frames")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SAMBA_ENABLE,
       "SAMBA Enable")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVEFILE_DIRECTORY,
@@ -1239,6 +1253,8 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVESTATE_AUTO_SAVE,
       "Auto Save State")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVESTATE_DIRECTORY,
       "Savestate")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_COMPRESSION,
+      "Savestate Compression")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVESTATE_THUMBNAIL_ENABLE,
       "Savestate Thumbnails")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVE_CURRENT_CONFIG,
@@ -1259,6 +1275,8 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_SCAN_FILE,
       "Scan File")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SCAN_THIS_DIRECTORY,
       "<Scan This Directory>")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_SCREENSHOT_COMPRESSION_LEVEL,
+      "Screenshot Compression Level")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SCREENSHOT_DIRECTORY,
       "Screenshot")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SCREEN_RESOLUTION,
@@ -1819,8 +1837,14 @@ MSG_HASH(MSG_APPLYING_CHEAT,
       "Applying cheat changes.")
 MSG_HASH(MSG_APPLYING_SHADER,
       "Applying shader")
+MSG_HASH(MSG_AUDIO_BUFFER_FILL,
+      "Audio")
+MSG_HASH(MSG_AUDIO_DRIFT,
+      "Drift")
 MSG_HASH(MSG_AUDIO_MUTED,
       "Audio muted.")
+MSG_HASH(MSG_AUDIO_UNDERRUNS,
+      "Underruns")
 MSG_HASH(MSG_AUDIO_UNMUTED,
       "Audio unmuted.")
 MSG_HASH(MSG_AUTOCONFIG_FILE_ERROR_SAVING,
@@ -2123,6 +2147,8 @@ MSG_HASH(MSG_REWIND_INIT_FAILED_THREADED_AUDIO,
       "Implementation uses threaded audio. Cannot use rewind.")
 MSG_HASH(MSG_REWIND_REACHED_END,
       "Reached end of rewind buffer.")
+MSG_HASH(MSG_RUN_AHEAD_DISABLED,
+      "Run-Ahead disabled: core failed to load state.")
 MSG_HASH(MSG_SAVED_NEW_CONFIG_TO,
       "Saved new config to")
 MSG_HASH(MSG_SAVED_STATE_TO_SLOT,
@@ -2948,3 +2974,19 @@ MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_VIEWPORT_CUSTOM_X,
       "Custom viewport offset used for defining the X-axis position of the viewport. These are ignored if 'Scaled Integer' is enabled, it will be automatically centered then.")
 MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_VIEWPORT_CUSTOM_Y,
       "Custom viewport offset used for defining the Y-axis position of the viewport. These are ignored if 'Scaled Integer' is enabled, it will be automatically centered then.")
+MSG_HASH(MENU_ENUM_SUBLABEL_RUN_AHEAD_ENABLED,
+      "Hides the game's own input lag by running frames ahead and rolling back with savestates. Requires a core with savestate support.")
+MSG_HASH(MENU_ENUM_SUBLABEL_RUN_AHEAD_FRAMES,
+      "How many frames to run ahead. Each one costs a full extra frame of emulation, so keep it at or below the game's own input lag. Maximum is 6.")
+MSG_HASH(MENU_ENUM_SUBLABEL_AUDIO_RATE_CONTROL_ADAPTIVE,
+      "Tunes the rate control delta automatically from the audio buffer fill level and compensates for steady clock drift between the core and the audio device.")
+MSG_HASH(MENU_ENUM_SUBLABEL_NETPLAY_SPECTATOR_RELAY,
+      "Serves spectators from a relay thread that sends everyone the same input stream. New spectators join from a periodic keyframe instead of a fresh savestate. Host only.")
+MSG_HASH(MENU_ENUM_SUBLABEL_NETPLAY_RELAY_KEYFRAME_INTERVAL,
+      "Frames between spectator relay keyframes. Shorter intervals let spectators join sooner at the cost of more savestates.")
+MSG_HASH(MENU_ENUM_SUBLABEL_PLAYLIST_BINARY_FORMAT,
+      "Saves database playlists in a binary format that is mapped instead of parsed when loaded. Older versions can't read these playlists.")
+MSG_HASH(MENU_ENUM_SUBLABEL_SAVESTATE_FILE_COMPRESSION,
+      "Compresses savestates and embeds their thumbnail in the same file. Older versions can't load compressed savestates, but uncompressed ones still load either way.")
+MSG_HASH(MENU_ENUM_SUBLABEL_SCREENSHOT_COMPRESSION_LEVEL,
+      "zlib level used for PNG screenshots, from 1 (fastest) to 9 (smallest).")
@@ -588,6 +588,83 @@ end:
    return ret;
 }
 
+#ifdef HAVE_ZLIB
+/* Opens the index of a ZIP archive. @path may name a file
+ * inside the archive after the '#' delimiter. */
+static file_archive_index_t *file_archive_open_index(const char *path)
+{
+   char archive_path[PATH_MAX_LENGTH];
+   char *delim        = NULL;
+
+   if (file_archive_get_file_backend(path) != &zlib_backend)
+      return NULL;
+
+   strlcpy(archive_path, path, sizeof(archive_path));
+
+   delim = (char*)path_get_archive_delim(archive_path);
+
+   if (delim)
+      *delim = '\0';
+
+   return file_archive_index_open(archive_path);
+}
+
+static struct string_list *file_archive_index_get_file_list(
+      const file_archive_index_t *index, const char *valid_exts)
+{
+   size_t i;
+   union string_list_elem_attr attr;
+   struct string_list *ext_list = NULL;
+   struct string_list *list     = string_list_new();
+
+   memset(&attr, 0, sizeof(attr));
+
+   if (!list)
+      return NULL;
+
+   if (valid_exts)
+   {
+      ext_list = string_split(valid_exts, "|");
+      attr.i   = RARCH_COMPRESSED_FILE_IN_ARCHIVE;
+   }
+
+   for (i = 0; i < file_archive_index_size(index); i++)
+   {
+      const char *path = file_archive_index_get(index, i)->name;
+      size_t path_len  = strlen(path);
+
+      if (!path_len)
+         continue;
+
+      if (ext_list)
+      {
+         const char *file_ext = NULL;
+
+         /* Skip if directory. */
+         if (path[path_len - 1] == '/' || path[path_len - 1] == '\\')
+            continue;
+
+         file_ext = path_get_extension(path);
+
+         if (!file_ext || !string_list_find_elem_prefix(
+                  ext_list, ".", file_ext))
+            continue;
+      }
+
+      if (!string_list_append(list, path, attr))
+         goto error;
+   }
+
+   string_list_free(ext_list);
+   return list;
+
+error:
+   string_list_free(ext_list);
+   string_list_free(list);
+   return NULL;
+}
+#endif
+
 /**
  * file_archive_get_file_list:
  * @path                        : filename path of archive
@@ -599,6 +676,17 @@ struct string_list *file_archive_get_file_list(const char *path,
 {
    int ret;
    struct archive_extract_userdata userdata;
+#ifdef HAVE_ZLIB
+   file_archive_index_t *index = file_archive_open_index(path);
+
+   if (index)
+   {
+      struct string_list *list =
+         file_archive_index_get_file_list(index, valid_exts);
+      file_archive_index_close(index);
+      return list;
+   }
+#endif
 
    strlcpy(userdata.archive_path, path, sizeof(userdata.archive_path));
    userdata.first_extracted_file_path       = NULL;
@@ -850,6 +938,10 @@ uint32_t file_archive_get_file_crc32(const char *path)
    bool contains_compressed                        = false;
    const char *archive_path                        = NULL;
 
+#ifdef HAVE_ZLIB
+   file_archive_index_t *index                     = NULL;
+#endif
+
    if (!backend)
       return 0;
 
@@ -864,6 +956,28 @@ uint32_t file_archive_get_file_crc32(const char *path)
          archive_path += 1;
    }
 
+#ifdef HAVE_ZLIB
+   index = file_archive_open_index(path);
+
+   if (index)
+   {
+      uint32_t crc                           = 0;
+      const struct file_archive_entry *entry = NULL;
+
+      /* No path within the archive, use the first file. */
+      if (!contains_compressed || !archive_path)
+         entry = file_archive_index_get(index, 0);
+      else
+         entry = file_archive_index_find(index, archive_path);
+
+      if (entry)
+         crc = entry->crc32;
+
+      file_archive_index_close(index);
+      return crc;
+   }
+#endif
+
    state.type          = ARCHIVE_TRANSFER_INIT;
    state.archive_size  = 0;
    state.handle        = NULL;
@@ -22,12 +22,18 @@
 
 #include <stdlib.h>
 
+#include <compat/strl.h>
 #include <file/archive_file.h>
 #include <streams/file_stream.h>
 #include <streams/trans_stream.h>
 #include <string.h>
 #include <retro_miscellaneous.h>
 #include <encodings/crc32.h>
+#include <retro_stat.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 /* Only for MAX_WBITS */
 #include <compat/zlib.h>
@@ -36,6 +42,10 @@
 #define CENTRAL_FILE_HEADER_SIGNATURE 0x02014b50
 #endif
 
+#ifndef LOCAL_FILE_HEADER_SIGNATURE
+#define LOCAL_FILE_HEADER_SIGNATURE 0x04034b50
+#endif
+
 #ifndef END_OF_CENTRAL_DIR_SIGNATURE
 #define END_OF_CENTRAL_DIR_SIGNATURE 0x06054b50
 #endif
@@ -112,164 +122,586 @@ static uint32_t zlib_stream_crc32_calculate(uint32_t crc,
    return encoding_crc32(crc, data, length);
 }
 
-static bool zip_file_decompressed_handle(
-      file_archive_file_handle_t *handle,
-      const uint8_t *cdata, uint32_t csize,
-      uint32_t size, uint32_t crc32)
+#define ZIP_INDEX_CACHE_SIZE 4
+
+struct file_archive_index
 {
-   int ret   = 0;
+   char path[PATH_MAX_LENGTH];
+   struct file_archive_entry *entries;
+   /* Hash chains. Both hold entry index + 1, 0 ends a chain. */
+   uint32_t *buckets;
+   uint32_t *chain;
+   char *names;
+   size_t count;
+   size_t bucket_mask;
+   /* End of central directory record, used to tell whether
+    * a cached index still matches the file on disk. */
+   uint32_t footer_crc;
+   size_t footer_len;
+   ssize_t archive_size;
+   /* Catches archives rewritten in place to the same size. */
+   int64_t mtime;
+   unsigned refs;
+   unsigned long last_use;
+   bool cached;
+};
 
-   handle->backend = &zlib_backend;
+static struct file_archive_index *zip_index_cache[ZIP_INDEX_CACHE_SIZE];
+static unsigned long zip_index_cache_clock;
+#ifdef HAVE_THREADS
+static slock_t *zip_index_cache_lock;
+#endif
 
-   if (!handle->backend->stream_decompress_data_to_file_init(
-            handle, cdata, csize, size))
-      return false;
+static uint32_t zip_index_hash(const char *name)
+{
+   uint32_t hash = 5381;
+
+   while (*name)
+      hash = (hash << 5) + hash + (uint8_t)*name++;
+
+   return hash;
+}
+
+static void zip_index_free(struct file_archive_index *index)
+{
+   if (!index)
+      return;
+
+   free(index->entries);
+   free(index->buckets);
+   free(index->chain);
+   free(index->names);
+   free(index);
+}
+
+/* Reads the end of central directory record of @file into a malloc'd
+ * buffer. @footer_offset receives the record's offset in the file. */
+static uint8_t *zip_index_read_footer(RFILE *file, ssize_t archive_size,
+      size_t *footer_len, ssize_t *footer_offset)
+{
+   ssize_t i;
+   uint8_t *footer  = NULL;
+   size_t tail_len  = archive_size < 22 + 0xFFFF ?
+      archive_size : 22 + 0xFFFF;
+   uint8_t *tail    = NULL;
+
+   if (archive_size < 22)
+      return NULL;
+
+   tail = (uint8_t*)malloc(tail_len);
+
+   if (!tail)
+      return NULL;
+
+   if (filestream_seek(file, archive_size - tail_len, SEEK_SET) < 0 ||
+         filestream_read(file, tail, tail_len) != (ssize_t)tail_len)
+      goto end;
+
+   for (i = tail_len - 22; i >= 0; i--)
+   {
+      if (read_le(tail + i, 4) == END_OF_CENTRAL_DIR_SIGNATURE
+            && i + 22 + read_le(tail + i + 20, 2) == tail_len)
+      {
+         *footer_len    = tail_len - i;
+         *footer_offset = archive_size - *footer_len;
+         footer         = (uint8_t*)malloc(*footer_len);
+         if (footer)
+            memcpy(footer, tail + i, *footer_len);
+         break;
+      }
+   }
+
+end:
+   free(tail);
+   return footer;
+}
+
+static struct file_archive_index *zip_index_build(const char *path,
+      RFILE *file, ssize_t archive_size, const uint8_t *footer,
+      size_t footer_len, ssize_t footer_offset)
+{
+   size_t i;
+   const uint8_t *entry            = NULL;
+   const uint8_t *directory_end    = NULL;
+   char *name                      = NULL;
+   size_t names_len                = 0;
+   size_t buckets                  = 1;
+   uint8_t *directory              = NULL;
+   struct file_archive_index *index = NULL;
+   uint32_t directory_size         = read_le(footer + 12, 4);
+   uint32_t directory_offset       = read_le(footer + 16, 4);
+
+   if ((ssize_t)directory_offset + directory_size > footer_offset)
+      return NULL;
+
+   directory = (uint8_t*)malloc(directory_size ? directory_size : 1);
+   index     = (struct file_archive_index*)calloc(1, sizeof(*index));
+
+   if (!directory || !index)
+      goto error;
+
+   if (filestream_seek(file, directory_offset, SEEK_SET) < 0 ||
+         filestream_read(file, directory, directory_size)
+         != (ssize_t)directory_size)
+      goto error;
+
+   /* First pass counts entries, so the entry count in the footer
+    * (which is capped for ZIP64) never has to be trusted. */
+   directory_end = directory + directory_size;
 
-   do
+   for (entry = directory; entry + 46 <= directory_end; )
    {
-      ret = handle->backend->stream_decompress_data_to_file_iterate(
-            handle->stream);
-   }while(ret == 0);
+      uint32_t namelength = read_le(entry + 28, 2);
+      size_t payload      = 46 + namelength + read_le(entry + 30, 2)
+         + read_le(entry + 32, 2);
 
-#if 0
-   handle->real_checksum = handle->backend->stream_crc_calculate(0,
-         handle->data, size);
+      if (read_le(entry, 4) != CENTRAL_FILE_HEADER_SIGNATURE
+            || entry + payload > directory_end)
+         break;
+
+      index->count++;
+      names_len += namelength + 1;
+      entry     += payload;
+   }
+
+   while (buckets < index->count * 2)
+      buckets <<= 1;
+
+   index->entries     = (struct file_archive_entry*)
+      calloc(index->count ? index->count : 1, sizeof(*index->entries));
+   index->chain       = (uint32_t*)
+      calloc(index->count ? index->count : 1, sizeof(*index->chain));
+   index->buckets     = (uint32_t*)calloc(buckets, sizeof(*index->buckets));
+   index->names       = (char*)malloc(names_len ? names_len : 1);
+   index->bucket_mask = buckets - 1;
 
-   if (handle->real_checksum != crc32)
+   if (!index->entries || !index->chain || !index->buckets || !index->names)
       goto error;
-#endif
 
-   if (handle->stream)
-      free(handle->stream);
+   name  = index->names;
+   entry = directory;
+
+   for (i = 0; i < index->count; i++)
+   {
+      struct file_archive_entry *e = &index->entries[i];
+      uint32_t namelength          = read_le(entry + 28, 2);
+
+      memcpy(name, entry + 46, namelength);
+      name[namelength] = '\0';
+
+      e->name          = name;
+      e->hash          = zip_index_hash(name);
+      e->cmode         = read_le(entry + 10, 2);
+      e->crc32         = read_le(entry + 16, 4);
+      e->csize         = read_le(entry + 20, 4);
+      e->size          = read_le(entry + 24, 4);
+      e->offset        = read_le(entry + 42, 4);
+
+      name  += namelength + 1;
+      entry += 46 + namelength + read_le(entry + 30, 2)
+         + read_le(entry + 32, 2);
+   }
+
+   /* Insert back to front, so that of several entries sharing
+    * a name the first one is found, like a sequential walk would. */
+   for (i = index->count; i-- > 0; )
+   {
+      size_t bucket          = index->entries[i].hash & index->bucket_mask;
+      index->chain[i]        = index->buckets[bucket];
+      index->buckets[bucket] = (uint32_t)(i + 1);
+   }
+
+   strlcpy(index->path, path, sizeof(index->path));
+   index->footer_crc   = encoding_crc32(0, footer, footer_len);
+   index->footer_len   = footer_len;
+   index->archive_size = archive_size;
+   index->refs         = 1;
+
+   free(directory);
+   return index;
 
-   return true;
-#if 0
 error:
-   if (handle->stream)
-      free(handle->stream);
-   if (handle->data)
-      free(handle->data);
+   free(directory);
+   zip_index_free(index);
+   return NULL;
+}
 
-   handle->stream = NULL;
-   handle->data   = NULL;
-   return false;
+static bool zip_index_cache_acquire(void)
+{
+#ifdef HAVE_THREADS
+   if (!zip_index_cache_lock)
+      return false;
+   slock_lock(zip_index_cache_lock);
 #endif
+   return true;
 }
 
-/* Extract the relative path (needle) from a
- * ZIP archive (path) and allocate a buffer for it to write it in.
- *
- * optional_outfile if not NULL will be used to extract the file to.
- * buf will be 0 then.
- */
+static void zip_index_cache_release(void)
+{
+#ifdef HAVE_THREADS
+   slock_unlock(zip_index_cache_lock);
+#endif
+}
 
-static int zip_file_decompressed(
-      const char *name, const char *valid_exts,
-      const uint8_t *cdata, unsigned cmode,
-      uint32_t csize, uint32_t size,
-      uint32_t crc32, struct archive_extract_userdata *userdata)
+/* Caches @index in place of an older index of the same archive,
+ * an empty slot or the least recently used index, in that order.
+ * An evicted index still in use is freed by its last owner. */
+static void zip_index_cache_insert(struct file_archive_index *index)
 {
-   /* Ignore directories. */
-   if (name[strlen(name) - 1] == '/' || name[strlen(name) - 1] == '\\')
-      return 1;
+   unsigned i;
+   unsigned slot = 0;
+
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE; i++)
+   {
+      struct file_archive_index *cached = zip_index_cache[i];
+
+      if (!cached || !strcmp(cached->path, index->path))
+      {
+         slot = i;
+         break;
+      }
+
+      if (cached->last_use < zip_index_cache[slot]->last_use)
+         slot = i;
+   }
+
+   if (zip_index_cache[slot])
+   {
+      if (zip_index_cache[slot]->refs == 0)
+         zip_index_free(zip_index_cache[slot]);
+      else
+         zip_index_cache[slot]->cached = false;
+   }
+
+   index->cached         = true;
+   index->last_use       = ++zip_index_cache_clock;
+   zip_index_cache[slot] = index;
+}
 
-#if 0
-   RARCH_LOG("[deflate] Path: %s, CRC32: 0x%x\n", name, crc32);
+void file_archive_index_cache_init(void)
+{
+#ifdef HAVE_THREADS
+   if (!zip_index_cache_lock)
+      zip_index_cache_lock = slock_new();
 #endif
+}
+
+void file_archive_index_cache_deinit(void)
+{
+   unsigned i;
+
+   if (!zip_index_cache_acquire())
+      return;
 
-   if (strstr(name, userdata->decomp_state.needle))
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE; i++)
    {
-      bool goto_error = false;
-      file_archive_file_handle_t handle = {0};
+      struct file_archive_index *cached = zip_index_cache[i];
 
-      userdata->decomp_state.found = true;
+      if (!cached)
+         continue;
 
-      if (zip_file_decompressed_handle(&handle,
-               cdata, csize, size, crc32))
-      {
-         if (userdata->decomp_state.opt_file != 0)
-         {
-            /* Called in case core has need_fullpath enabled. */
-            char *buf       = (char*)malloc(size);
+      if (cached->refs == 0)
+         zip_index_free(cached);
+      else
+         cached->cached = false;
 
-            if (buf)
-            {
-               /*RARCH_LOG("%s: %s\n",
-                     msg_hash_to_str(MSG_EXTRACTING_FILE),
-                     userdata->decomp_state.opt_file);*/
-               memcpy(buf, handle.data, size);
+      zip_index_cache[i] = NULL;
+   }
 
-               if (!filestream_write_file(userdata->decomp_state.opt_file, buf, size))
-                  goto_error = true;
-            }
+   zip_index_cache_release();
 
-            free(buf);
+#ifdef HAVE_THREADS
+   slock_free(zip_index_cache_lock);
+   zip_index_cache_lock = NULL;
+#endif
+}
 
-            userdata->decomp_state.size = 0;
-         }
-         else
+file_archive_index_t *file_archive_index_open(const char *path)
+{
+   unsigned i;
+   uint32_t footer_crc;
+   int64_t mtime                    = path_get_mtime(path);
+   size_t footer_len                = 0;
+   ssize_t footer_offset            = 0;
+   ssize_t archive_size             = 0;
+   bool use_cache                   = false;
+   uint8_t *footer                  = NULL;
+   struct file_archive_index *index = NULL;
+   RFILE *file                      = filestream_open(path,
+         RFILE_MODE_READ, -1);
+
+   if (!file)
+      return NULL;
+
+   if (filestream_seek(file, 0, SEEK_END) < 0)
+      goto end;
+
+   archive_size = filestream_tell(file);
+   footer       = zip_index_read_footer(file, archive_size,
+         &footer_len, &footer_offset);
+
+   if (!footer)
+      goto end;
+
+   footer_crc = encoding_crc32(0, footer, footer_len);
+   use_cache  = zip_index_cache_acquire();
+
+   if (use_cache)
+   {
+      for (i = 0; i < ZIP_INDEX_CACHE_SIZE; i++)
+      {
+         struct file_archive_index *cached = zip_index_cache[i];
+
+         if (     cached
+               && cached->archive_size == archive_size
+               && cached->mtime        == mtime
+               && cached->footer_len   == footer_len
+               && cached->footer_crc   == footer_crc
+               && !strcmp(cached->path, path))
          {
-            /* Called in case core has need_fullpath disabled.
-             * Will copy decompressed content directly into
-             * RetroArch's ROM buffer. */
-            *userdata->decomp_state.buf = malloc(size);
-            memcpy(*userdata->decomp_state.buf, handle.data, size);
-
-            userdata->decomp_state.size = size;
+            cached->refs++;
+            cached->last_use = ++zip_index_cache_clock;
+            index            = cached;
+            break;
          }
       }
 
-      if (handle.data)
-         free(handle.data);
+      zip_index_cache_release();
+   }
+
+   if (index)
+      goto end;
 
-      if (goto_error)
-         return 0;
+   index = zip_index_build(path, file, archive_size,
+         footer, footer_len, footer_offset);
+
+   if (index)
+      index->mtime = mtime;
+
+   if (index && use_cache && zip_index_cache_acquire())
+   {
+      zip_index_cache_insert(index);
+      zip_index_cache_release();
    }
 
-   return 1;
+end:
+   free(footer);
+   filestream_close(file);
+   return index;
+}
+
+void file_archive_index_close(file_archive_index_t *index)
+{
+   bool release    = false;
+   bool use_cache;
+
+   if (!index)
+      return;
+
+   use_cache = zip_index_cache_acquire();
+   release   = --index->refs == 0 && !index->cached;
+
+   if (use_cache)
+      zip_index_cache_release();
+
+   if (release)
+      zip_index_free(index);
+}
+
+size_t file_archive_index_size(const file_archive_index_t *index)
+{
+   if (!index)
+      return 0;
+   return index->count;
+}
+
+const struct file_archive_entry *file_archive_index_get(
+      const file_archive_index_t *index, size_t idx)
+{
+   if (!index || idx >= index->count)
+      return NULL;
+   return &index->entries[idx];
 }
 
+const struct file_archive_entry *file_archive_index_find(
+      const file_archive_index_t *index, const char *name)
+{
+   uint32_t hash;
+   uint32_t i;
+
+   if (!index || !name)
+      return NULL;
+
+   hash = zip_index_hash(name);
+
+   for (i = index->buckets[hash & index->bucket_mask]; i;
+         i = index->chain[i - 1])
+   {
+      const struct file_archive_entry *entry = &index->entries[i - 1];
+
+      if (entry->hash == hash && !strcmp(entry->name, name))
+         return entry;
+   }
+
+   return NULL;
+}
+
+static bool zip_inflate(const uint8_t *cdata, uint32_t csize,
+      uint8_t *data, uint32_t size)
+{
+   uint32_t rd, wn;
+   enum trans_stream_error terror;
+   bool ret     = false;
+   void *stream = zlib_inflate_backend.stream_new();
+
+   if (!stream)
+      return false;
+
+   if (zlib_inflate_backend.define)
+      zlib_inflate_backend.define(stream, "window_bits", (uint32_t)-MAX_WBITS);
+
+   zlib_inflate_backend.set_in(stream, cdata, csize);
+   zlib_inflate_backend.set_out(stream, data, size);
+
+   /* The whole entry is in memory, so a single call inflates it. */
+   ret = zlib_inflate_backend.trans(stream, true, &rd, &wn, &terror)
+      && wn == size;
+
+   zlib_inflate_backend.stream_free(stream);
+
+   return ret;
+}
+
+int64_t file_archive_index_read(const file_archive_index_t *index,
+      const struct file_archive_entry *entry, void **buf,
+      const char *optional_outfile)
+{
+   uint8_t header[30];
+   int64_t ret    = -1;
+   uint8_t *cdata = NULL;
+   uint8_t *data  = NULL;
+   RFILE *file    = NULL;
+
+   if (!index || !entry)
+      return -1;
+
+   file = filestream_open(index->path, RFILE_MODE_READ, -1);
+
+   if (!file)
+      return -1;
+
+   if (filestream_seek(file, entry->offset, SEEK_SET) < 0
+         || filestream_read(file, header, sizeof(header)) != sizeof(header)
+         || read_le(header, 4) != LOCAL_FILE_HEADER_SIGNATURE)
+      goto end;
+
+   /* The local header's name and extra field lengths can
+    * differ from the central directory's. */
+   if (filestream_seek(file, entry->offset + 30 + read_le(header + 26, 2)
+            + read_le(header + 28, 2), SEEK_SET) < 0)
+      goto end;
+
+   data = (uint8_t*)malloc(entry->size ? entry->size : 1);
+
+   if (!data)
+      goto end;
+
+   switch (entry->cmode)
+   {
+      case ARCHIVE_MODE_UNCOMPRESSED:
+         if (entry->csize != entry->size
+               || filestream_read(file, data, entry->size)
+               != (ssize_t)entry->size)
+            goto end;
+         break;
+      case ARCHIVE_MODE_COMPRESSED:
+         cdata = (uint8_t*)malloc(entry->csize ? entry->csize : 1);
+
+         if (!cdata
+               || filestream_read(file, cdata, entry->csize)
+               != (ssize_t)entry->csize)
+            goto end;
+
+         if (entry->size && !zip_inflate(cdata, entry->csize,
+                  data, entry->size))
+            goto end;
+         break;
+      default:
+         goto end;
+   }
+
+   if (optional_outfile)
+   {
+      /* Called in case core has need_fullpath enabled. */
+      if (!filestream_write_file(optional_outfile, data, entry->size))
+         goto end;
+      ret = 0;
+   }
+   else
+   {
+      /* Called in case core has need_fullpath disabled.
+       * Hands the buffer directly to RetroArch's ROM buffer. */
+      *buf = data;
+      data = NULL;
+      ret  = entry->size;
+   }
+
+end:
+   free(cdata);
+   free(data);
+   filestream_close(file);
+   return ret;
+}
+
+/* Extract the relative path (needle) from a
+ * ZIP archive (path) and allocate a buffer for it to write it in.
+ *
+ * optional_outfile if not NULL will be used to extract the file to.
+ * buf will be 0 then.
+ */
 static int zip_file_read(
       const char *path,
       const char *needle, void **buf,
       const char *optional_outfile)
 {
-   file_archive_transfer_t zlib;
-   struct archive_extract_userdata userdata = {{0}};
-   bool returnerr                    = true;
-   int ret                           = 0;
-
-   zlib.type                         = ARCHIVE_TRANSFER_INIT;
+   int64_t ret                            = -1;
+   const struct file_archive_entry *entry = NULL;
+   file_archive_index_t *index            = file_archive_index_open(path);
 
-   userdata.decomp_state.needle      = NULL;
-   userdata.decomp_state.opt_file    = NULL;
-   userdata.decomp_state.found       = false;
-   userdata.decomp_state.buf         = buf;
+   if (!index)
+      return -1;
 
    if (needle)
-      userdata.decomp_state.needle   = strdup(needle);
-   if (optional_outfile)
-      userdata.decomp_state.opt_file = strdup(optional_outfile);
+      entry = file_archive_index_find(index, needle);
 
-   do
+   /* No exact match, take the first file whose name contains needle. */
+   if (!entry)
    {
-      ret = file_archive_parse_file_iterate(&zlib, &returnerr, path,
-            "", zip_file_decompressed, &userdata);
-      if (!returnerr)
-         break;
-   }while(ret == 0 && !userdata.decomp_state.found);
+      size_t i;
 
-   file_archive_parse_file_iterate_stop(&zlib);
+      for (i = 0; i < index->count; i++)
+      {
+         const char *name = index->entries[i].name;
+         size_t len       = strlen(name);
 
-   if (userdata.decomp_state.opt_file)
-      free(userdata.decomp_state.opt_file);
-   if (userdata.decomp_state.needle)
-      free(userdata.decomp_state.needle);
+         /* Ignore directories. */
+         if (!len || name[len - 1] == '/' || name[len - 1] == '\\')
+            continue;
 
-   if (!userdata.decomp_state.found)
-      return -1;
+         if (!needle || strstr(name, needle))
+         {
+            entry = &index->entries[i];
+            break;
+         }
+      }
+   }
+
+   if (entry)
+      ret = file_archive_index_read(index, entry, buf, optional_outfile);
+
+   file_archive_index_close(index);
 
-   return userdata.decomp_state.size;
+   return (int)ret;
 }
 
 static int zip_parse_file_init(file_archive_transfer_t *state,
@@ -81,7 +81,8 @@ enum stat_mode
    IS_VALID
 };
 
-static bool path_stat(const char *path, enum stat_mode mode, int32_t *size)
+static bool path_stat(const char *path, enum stat_mode mode,
+      int32_t *size, int64_t *mtime)
 {
 #if defined(VITA) || defined(PSP)
    SceIoStat buf;
@@ -118,6 +119,16 @@ static bool path_stat(const char *path, enum stat_mode mode, int32_t *size)
    if (size)
       *size = buf.st_size;
 
+   if (mtime)
+   {
+#if defined(VITA) || defined(PSP)
+      /* SceDateTime, not a plain timestamp. */
+      *mtime = 0;
+#else
+      *mtime = (int64_t)buf.st_mtime;
+#endif
+   }
+
    switch (mode)
    {
       case IS_DIRECTORY:
@@ -153,28 +164,44 @@ static bool path_stat(const char *path, enum stat_mode mode, int32_t *size)
  */
 bool path_is_directory(const char *path)
 {
-   return path_stat(path, IS_DIRECTORY, NULL);
+   return path_stat(path, IS_DIRECTORY, NULL, NULL);
 }
 
 bool path_is_character_special(const char *path)
 {
-   return path_stat(path, IS_CHARACTER_SPECIAL, NULL);
+   return path_stat(path, IS_CHARACTER_SPECIAL, NULL, NULL);
 }
 
 bool path_is_valid(const char *path)
 {
-   return path_stat(path, IS_VALID, NULL);
+   return path_stat(path, IS_VALID, NULL, NULL);
 }
 
 int32_t path_get_size(const char *path)
 {
    int32_t filesize = 0;
-   if (path_stat(path, IS_VALID, &filesize))
+   if (path_stat(path, IS_VALID, &filesize, NULL))
       return filesize;
 
    return -1;
 }
 
+/**
+ * path_get_mtime:
+ * @path               : path
+ *
+ * Returns: last modification time of @path in seconds,
+ * 0 if it is unknown on this platform, or -1 on error.
+ */
+int64_t path_get_mtime(const char *path)
+{
+   int64_t mtime = 0;
+   if (path_stat(path, IS_VALID, NULL, &mtime))
+      return mtime;
+
+   return -1;
+}
+
 /**
  * path_mkdir_norecurse:
  * @dir                : directory
@@ -212,3 +239,27 @@ bool mkdir_norecurse(const char *dir)
       printf("mkdir(%s) error: %s.\n", dir, strerror(errno));
    return ret == 0;
 }
+
+/**
+ * path_file_replace:
+ * @src                : file to move
+ * @dst                : file to replace
+ *
+ * Moves @src over @dst, replacing @dst if it exists. Where
+ * the platform allows it, readers of @dst see either the old
+ * or the new file, never a partially written one.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool path_file_replace(const char *src, const char *dst)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+   return MoveFileExA(src, dst, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+#if defined(_WIN32)
+   /* rename() doesn't replace existing files here. */
+   remove(dst);
+#endif
+   return rename(src, dst) == 0;
+#endif
+}
@@ -30,6 +30,7 @@
 #endif
 
 #include <boolean.h>
+#include <retro_miscellaneous.h>
 #include <formats/image.h>
 #include <formats/rpng.h>
 #include <streams/trans_stream.h>
@@ -576,10 +577,208 @@ error:
    return -1;
 }
 
+static void png_unfilter_up(uint8_t *line, const uint8_t *prev,
+      const uint8_t *filtered, unsigned pitch)
+{
+   unsigned i = 0;
+#if defined(__SSE2__)
+   for (; i + 16 <= pitch; i += 16)
+      _mm_storeu_si128((__m128i*)(line + i), _mm_add_epi8(
+               _mm_loadu_si128((const __m128i*)(prev + i)),
+               _mm_loadu_si128((const __m128i*)(filtered + i))));
+#elif defined(__ARM_NEON__)
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(line + i, vaddq_u8(vld1q_u8(prev + i),
+               vld1q_u8(filtered + i)));
+#endif
+   for (; i < pitch; i++)
+      line[i] = prev[i] + filtered[i];
+}
+
+/* Sub, Average and Paeth depend on the pixel to the left, so the
+ * vector kernels work a pixel at a time, for 3 and 4 byte pixels.
+ * 3 byte pixels are moved 4 bytes at a time as well; the extra byte
+ * is overwritten by the next pixel, and only the last pixel of the
+ * line is moved with 3 bytes. */
+#if defined(__SSE2__)
+static INLINE __m128i png_load_pixel(const uint8_t *src, unsigned size)
+{
+   uint32_t pixel = 0;
+   /* Constant sizes, so the copies compile to plain loads. */
+   if (size == 4)
+      memcpy(&pixel, src, 4);
+   else
+      memcpy(&pixel, src, 3);
+   return _mm_cvtsi32_si128((int)pixel);
+}
+
+static INLINE void png_store_pixel(uint8_t *dst, __m128i pixel, unsigned size)
+{
+   uint32_t value = (uint32_t)_mm_cvtsi128_si32(pixel);
+   if (size == 4)
+      memcpy(dst, &value, 4);
+   else
+      memcpy(dst, &value, 3);
+}
+
+static void png_unfilter_sub_simd(uint8_t *line,
+      const uint8_t *filtered, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned size = MIN(pitch - i, 4);
+
+      a = _mm_add_epi8(a, png_load_pixel(filtered + i, size));
+      png_store_pixel(line + i, a, size);
+   }
+}
+
+static void png_unfilter_avg_simd(uint8_t *line, const uint8_t *prev,
+      const uint8_t *filtered, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i one = _mm_set1_epi8(1);
+   __m128i a   = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned size = MIN(pitch - i, 4);
+      __m128i b     = png_load_pixel(prev + i, size);
+      /* pavgb rounds up, PNG rounds down. */
+      __m128i avg   = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), one));
+
+      a = _mm_add_epi8(avg, png_load_pixel(filtered + i, size));
+      png_store_pixel(line + i, a, size);
+   }
+}
+
+static void png_unfilter_paeth_simd(uint8_t *line, const uint8_t *prev,
+      const uint8_t *filtered, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i zero = _mm_setzero_si128();
+   __m128i a    = zero;
+   __m128i c    = zero;
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned size = MIN(pitch - i, 4);
+      __m128i b     = _mm_unpacklo_epi8(png_load_pixel(prev + i, size), zero);
+      __m128i pred  = paeth_sse2(a, b, c);
+      __m128i x     = _mm_add_epi8(_mm_packus_epi16(pred, pred),
+            png_load_pixel(filtered + i, size));
+
+      png_store_pixel(line + i, x, size);
+      a = _mm_unpacklo_epi8(x, zero);
+      c = b;
+   }
+}
+#elif defined(__ARM_NEON__)
+static INLINE uint8x8_t png_load_pixel(const uint8_t *src, unsigned size)
+{
+   uint8_t pixel[8] = {0};
+   /* Constant sizes, so the copies compile to plain loads. */
+   if (size == 4)
+      memcpy(pixel, src, 4);
+   else
+      memcpy(pixel, src, 3);
+   return vld1_u8(pixel);
+}
+
+static INLINE void png_store_pixel(uint8_t *dst, uint8x8_t pixel, unsigned size)
+{
+   uint8_t value[8];
+   vst1_u8(value, pixel);
+   if (size == 4)
+      memcpy(dst, value, 4);
+   else
+      memcpy(dst, value, 3);
+}
+
+static void png_unfilter_sub_simd(uint8_t *line,
+      const uint8_t *filtered, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned size = MIN(pitch - i, 4);
+
+      a = vadd_u8(a, png_load_pixel(filtered + i, size));
+      png_store_pixel(line + i, a, size);
+   }
+}
+
+static void png_unfilter_avg_simd(uint8_t *line, const uint8_t *prev,
+      const uint8_t *filtered, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned size = MIN(pitch - i, 4);
+
+      a = vadd_u8(vhadd_u8(a, png_load_pixel(prev + i, size)),
+            png_load_pixel(filtered + i, size));
+      png_store_pixel(line + i, a, size);
+   }
+}
+
+static void png_unfilter_paeth_simd(uint8_t *line, const uint8_t *prev,
+      const uint8_t *filtered, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+   uint8x8_t c = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      unsigned size = MIN(pitch - i, 4);
+      uint8x8_t b   = png_load_pixel(prev + i, size);
+
+      a = vadd_u8(paeth_neon(a, b, c), png_load_pixel(filtered + i, size));
+      png_store_pixel(line + i, a, size);
+      c = b;
+   }
+}
+#endif
+
 static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
       struct rpng_process *pngp, unsigned filter)
 {
    unsigned i;
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+   bool simd = pngp->bpp == 3 || pngp->bpp == 4;
+
+   if (simd)
+   {
+      switch (filter)
+      {
+         case PNG_FILTER_SUB:
+            png_unfilter_sub_simd(pngp->decoded_scanline,
+                  pngp->inflate_buf, pngp->pitch, pngp->bpp);
+            goto copy;
+         case PNG_FILTER_AVERAGE:
+            png_unfilter_avg_simd(pngp->decoded_scanline,
+                  pngp->prev_scanline, pngp->inflate_buf,
+                  pngp->pitch, pngp->bpp);
+            goto copy;
+         case PNG_FILTER_PAETH:
+            png_unfilter_paeth_simd(pngp->decoded_scanline,
+                  pngp->prev_scanline, pngp->inflate_buf,
+                  pngp->pitch, pngp->bpp);
+            goto copy;
+         default:
+            break;
+      }
+   }
+#endif
 
    switch (filter)
    {
@@ -593,8 +792,8 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
             pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
          break;
       case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+         png_unfilter_up(pngp->decoded_scanline, pngp->prev_scanline,
+               pngp->inflate_buf, pngp->pitch);
          break;
       case PNG_FILTER_AVERAGE:
          for (i = 0; i < pngp->bpp; i++)
@@ -620,6 +819,9 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
          return IMAGE_PROCESS_ERROR_END;
    }
 
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+copy:
+#endif
    switch (ihdr->color_type)
    {
       case PNG_IHDR_COLOR_GRAY:
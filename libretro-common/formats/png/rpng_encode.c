@@ -24,9 +24,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <retro_miscellaneous.h>
+#include <compat/zlib.h>
 #include <encodings/crc32.h>
 #include <streams/file_stream.h>
-#include <streams/trans_stream.h>
+
+#ifdef HAVE_THREADS
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
+#endif
 
 #include "rpng_internal.h"
 
@@ -37,6 +43,46 @@
    goto end; \
 } while(0)
 
+#define RPNG_DEFAULT_LEVEL    9
+#define RPNG_BAND_HEADER_SIZE 10
+#define RPNG_BAND_MIN_ROWS    32
+#define RPNG_MAX_BANDS        8
+
+/* Encoded images go either to a file or into memory. */
+struct png_out
+{
+   RFILE *file;
+   uint8_t *data;
+   size_t size;
+   size_t cap;
+};
+
+static bool png_write(struct png_out *out, const void *data, size_t size)
+{
+   if (out->file)
+      return filestream_write(out->file, data, size) == (ssize_t)size;
+
+   if (out->size + size > out->cap)
+   {
+      size_t cap   = out->cap ? out->cap * 2 : 4096;
+      uint8_t *buf = NULL;
+
+      while (cap < out->size + size)
+         cap *= 2;
+
+      buf = (uint8_t*)realloc(out->data, cap);
+      if (!buf)
+         return false;
+
+      out->data = buf;
+      out->cap  = cap;
+   }
+
+   memcpy(out->data + out->size, data, size);
+   out->size += size;
+   return true;
+}
+
 static void dword_write_be(uint8_t *buf, uint32_t val)
 {
    *buf++ = (uint8_t)(val >> 24);
@@ -45,16 +91,16 @@ static void dword_write_be(uint8_t *buf, uint32_t val)
    *buf++ = (uint8_t)(val >>  0);
 }
 
-static bool png_write_crc(RFILE *file, const uint8_t *data, size_t size)
+static bool png_write_crc(struct png_out *out, const uint8_t *data, size_t size)
 {
    uint8_t crc_raw[4] = {0};
    uint32_t crc       = encoding_crc32(0, data, size);
 
    dword_write_be(crc_raw, crc);
-   return filestream_write(file, crc_raw, sizeof(crc_raw)) == sizeof(crc_raw);
+   return png_write(out, crc_raw, sizeof(crc_raw));
 }
 
-static bool png_write_ihdr(RFILE *file, const struct png_ihdr *ihdr)
+static bool png_write_ihdr(struct png_out *out, const struct png_ihdr *ihdr)
 {
    uint8_t ihdr_raw[21];
    
@@ -83,38 +129,38 @@ static bool png_write_ihdr(RFILE *file, const struct png_ihdr *ihdr)
    dword_write_be(ihdr_raw +  0, sizeof(ihdr_raw) - 8);
    dword_write_be(ihdr_raw +  8, ihdr->width);
    dword_write_be(ihdr_raw + 12, ihdr->height);
-   if (filestream_write(file, ihdr_raw, sizeof(ihdr_raw)) != sizeof(ihdr_raw))
+   if (!png_write(out, ihdr_raw, sizeof(ihdr_raw)))
       return false;
 
-   if (!png_write_crc(file, ihdr_raw + sizeof(uint32_t),
+   if (!png_write_crc(out, ihdr_raw + sizeof(uint32_t),
             sizeof(ihdr_raw) - sizeof(uint32_t)))
       return false;
 
    return true;
 }
 
-static bool png_write_idat(RFILE *file, const uint8_t *data, size_t size)
+static bool png_write_idat(struct png_out *out, const uint8_t *data, size_t size)
 {
-   if (filestream_write(file, data, size) != (ssize_t)size)
+   if (!png_write(out, data, size))
       return false;
 
-   if (!png_write_crc(file, data + sizeof(uint32_t), size - sizeof(uint32_t)))
+   if (!png_write_crc(out, data + sizeof(uint32_t), size - sizeof(uint32_t)))
       return false;
 
    return true;
 }
 
-static bool png_write_iend(RFILE *file)
+static bool png_write_iend(struct png_out *out)
 {
    const uint8_t data[] = {
       0, 0, 0, 0,
       'I', 'E', 'N', 'D',
    };
 
-   if (filestream_write(file, data, sizeof(data)) != sizeof(data))
+   if (!png_write(out, data, sizeof(data)))
       return false;
 
-   if (!png_write_crc(file, data + sizeof(uint32_t),
+   if (!png_write_crc(out, data + sizeof(uint32_t),
             sizeof(data) - sizeof(uint32_t)))
       return false;
 
@@ -147,9 +193,23 @@ static void copy_bgr24_line(uint8_t *dst, const uint8_t *src, unsigned width)
 
 static unsigned count_sad(const uint8_t *data, size_t size)
 {
-   size_t i;
+   size_t i     = 0;
    unsigned cnt = 0;
-   for (i = 0; i < size; i++)
+#if defined(__SSE2__)
+   __m128i zero = _mm_setzero_si128();
+   __m128i sum  = _mm_setzero_si128();
+
+   for (; i + 16 <= size; i += 16)
+   {
+      __m128i v    = _mm_loadu_si128((const __m128i*)(data + i));
+      __m128i sign = _mm_cmpgt_epi8(zero, v);
+      __m128i absv = _mm_sub_epi8(_mm_xor_si128(v, sign), sign);
+      sum          = _mm_add_epi64(sum, _mm_sad_epu8(absv, zero));
+   }
+
+   cnt = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+#endif
+   for (; i < size; i++)
       cnt += abs((int8_t)data[i]);
    return cnt;
 }
@@ -157,9 +217,15 @@ static unsigned count_sad(const uint8_t *data, size_t size)
 static unsigned filter_up(uint8_t *target, const uint8_t *line,
       const uint8_t *prev, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
    width *= bpp;
-   for (i = 0; i < width; i++)
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - prev[i];
 
    return count_sad(target, width);
@@ -172,7 +238,13 @@ static unsigned filter_sub(uint8_t *target, const uint8_t *line,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i];
-   for (i = bpp; i < width; i++)
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(line + i - bpp))));
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - line[i - bpp];
 
    return count_sad(target, width);
@@ -185,7 +257,19 @@ static unsigned filter_avg(uint8_t *target, const uint8_t *line,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i] - (prev[i] >> 1);
-   for (i = bpp; i < width; i++)
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+   {
+      __m128i a   = _mm_loadu_si128((const __m128i*)(line + i - bpp));
+      __m128i b   = _mm_loadu_si128((const __m128i*)(prev + i));
+      /* pavgb rounds up, PNG rounds down. */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)), avg));
+   }
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - ((line[i - bpp] + prev[i]) >> 1);
 
    return count_sad(target, width);
@@ -199,75 +283,85 @@ static unsigned filter_paeth(uint8_t *target,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i] - paeth(0, prev[i], 0);
-   for (i = bpp; i < width; i++)
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+   {
+      __m128i zero = _mm_setzero_si128();
+      __m128i a    = _mm_loadu_si128((const __m128i*)(line + i - bpp));
+      __m128i b    = _mm_loadu_si128((const __m128i*)(prev + i));
+      __m128i c    = _mm_loadu_si128((const __m128i*)(prev + i - bpp));
+      __m128i lo   = paeth_sse2(_mm_unpacklo_epi8(a, zero),
+            _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+      __m128i hi   = paeth_sse2(_mm_unpackhi_epi8(a, zero),
+            _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_packus_epi16(lo, hi)));
+   }
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - paeth(line[i - bpp], prev[i], prev[i - bpp]);
 
    return count_sad(target, width);
 }
 
-static bool rpng_save_image(const char *path,
-      const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+/* A run of rows, filtered and deflated on its own. Every band but
+ * the last ends on a sync flush, so the raw deflate data of all bands
+ * concatenates into one stream. */
+struct rpng_band
 {
-   unsigned h;
-   bool ret = true;
-   struct png_ihdr ihdr = {0};
-
-   const struct trans_stream_backend *stream_backend = NULL;
-   size_t encode_buf_size  = 0;
-   uint8_t *encode_buf     = NULL;
-   uint8_t *deflate_buf    = NULL;
-   uint8_t *rgba_line      = NULL;
-   uint8_t *up_filtered    = NULL;
-   uint8_t *sub_filtered   = NULL;
-   uint8_t *avg_filtered   = NULL;
-   uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
-   void *stream            = NULL;
-   uint32_t total_in       = 0;
-   uint32_t total_out      = 0;
-   RFILE *file             = filestream_open(path, RFILE_MODE_WRITE, -1);
-   if (!file)
-      GOTO_END_ERROR();
-
-   stream_backend = trans_stream_get_zlib_deflate_backend();
-
-   if (filestream_write(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
-      GOTO_END_ERROR();
-
-   ihdr.width = width;
-   ihdr.height = height;
-   ihdr.depth = 8;
-   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr(file, &ihdr))
-      GOTO_END_ERROR();
-
-   encode_buf_size = (width * bpp + 1) * height;
-   encode_buf = (uint8_t*)malloc(encode_buf_size);
-   if (!encode_buf)
-      GOTO_END_ERROR();
+   const uint8_t *data;  /* First row of the band. */
+   const uint8_t *above; /* Row above the band, NULL for the first band. */
+   unsigned width;
+   unsigned rows;
+   unsigned pitch;
+   unsigned bpp;
+   int level;
+   bool last;
+
+   /* Room for the chunk header and the zlib header,
+    * then the deflate data, then room for the Adler-32. */
+   uint8_t *out;
+   size_t out_size;
+   size_t raw_size;
+   uint32_t adler;
+   bool ok;
+};
+
+static void copy_line(uint8_t *dst, const uint8_t *src,
+      unsigned width, unsigned bpp)
+{
+   if (bpp == sizeof(uint32_t))
+      copy_argb_line(dst, (const uint32_t*)src, width);
+   else
+      copy_bgr24_line(dst, src, width);
+}
 
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
+static bool rpng_filter_band(struct rpng_band *band, uint8_t *encode_target)
+{
+   unsigned h;
+   bool ret                = true;
+   unsigned line_size      = band->width * band->bpp;
+   const uint8_t *data     = band->data;
+   uint8_t *rgba_line      = (uint8_t*)malloc(line_size);
+   uint8_t *prev_encoded   = (uint8_t*)calloc(1, line_size);
+   uint8_t *up_filtered    = (uint8_t*)malloc(line_size);
+   uint8_t *sub_filtered   = (uint8_t*)malloc(line_size);
+   uint8_t *avg_filtered   = (uint8_t*)malloc(line_size);
+   uint8_t *paeth_filtered = (uint8_t*)malloc(line_size);
+
+   if (!rgba_line || !prev_encoded || !up_filtered || !sub_filtered
+         || !avg_filtered || !paeth_filtered)
       GOTO_END_ERROR();
 
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
-      GOTO_END_ERROR();
+   if (band->above)
+      copy_line(prev_encoded, band->above, band->width, band->bpp);
 
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
+   for (h = 0; h < band->rows;
+         h++, encode_target += line_size, data += band->pitch)
    {
-      if (bpp == sizeof(uint32_t))
-         copy_argb_line(rgba_line, (const uint32_t*)data, width);
-      else
-         copy_bgr24_line(rgba_line, data, width);
+      copy_line(rgba_line, data, band->width, band->bpp);
 
       /* Try every filtering method, and choose the method
        * which has most entries as zero.
@@ -276,11 +370,11 @@ static bool rpng_save_image(const char *path,
        * simple to implement.
        */
       {
-         unsigned none_score  = count_sad(rgba_line, width * bpp);
-         unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
-         unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
+         unsigned none_score  = count_sad(rgba_line, line_size);
+         unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, band->width, band->bpp);
+         unsigned sub_score   = filter_sub(sub_filtered, rgba_line, band->width, band->bpp);
+         unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, band->width, band->bpp);
+         unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, band->width, band->bpp);
 
          uint8_t filter       = 0;
          unsigned min_sad     = none_score;
@@ -315,75 +409,251 @@ static bool rpng_save_image(const char *path,
          }
 
          *encode_target++ = filter;
-         memcpy(encode_target, chosen_filtered, width * bpp);
+         memcpy(encode_target, chosen_filtered, line_size);
 
-         memcpy(prev_encoded, rgba_line, width * bpp);
+         memcpy(prev_encoded, rgba_line, line_size);
       }
    }
 
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
-   if (!deflate_buf)
-      GOTO_END_ERROR();
+end:
+   free(rgba_line);
+   free(prev_encoded);
+   free(up_filtered);
+   free(sub_filtered);
+   free(avg_filtered);
+   free(paeth_filtered);
+   return ret;
+}
 
-   stream = stream_backend->stream_new();
+static void rpng_encode_band(void *data)
+{
+   z_stream z;
+   int zret;
+   size_t bound;
+   struct rpng_band *band = (struct rpng_band*)data;
+   uint8_t *encode_buf    = NULL;
 
-   if (!stream)
-      GOTO_END_ERROR();
+   band->ok       = false;
+   band->raw_size = (size_t)(band->width * band->bpp + 1) * band->rows;
+   encode_buf     = (uint8_t*)malloc(band->raw_size);
 
-   stream_backend->set_in(
-         stream,
-         encode_buf,
-         encode_buf_size);
-   stream_backend->set_out(
-         stream,
-         deflate_buf + 8,
-         encode_buf_size * 2);
+   if (!encode_buf || !rpng_filter_band(band, encode_buf))
+   {
+      free(encode_buf);
+      return;
+   }
+
+   band->adler = adler32(adler32(0, NULL, 0), encode_buf, band->raw_size);
 
-   if (!stream_backend->trans(stream, true, &total_in, &total_out, NULL))
+   memset(&z, 0, sizeof(z));
+   if (deflateInit2(&z, band->level, Z_DEFLATED, -MAX_WBITS, 8,
+            Z_DEFAULT_STRATEGY) != Z_OK)
    {
-      GOTO_END_ERROR();
+      free(encode_buf);
+      return;
+   }
+
+   /* The sync flush marker is not covered by deflateBound. */
+   bound     = deflateBound(&z, band->raw_size) + 16;
+   band->out = (uint8_t*)malloc(RPNG_BAND_HEADER_SIZE + bound + 4);
+
+   if (band->out)
+   {
+      z.next_in   = encode_buf;
+      z.avail_in  = (uInt)band->raw_size;
+      z.next_out  = band->out + RPNG_BAND_HEADER_SIZE;
+      z.avail_out = (uInt)bound;
+
+      zret = deflate(&z, band->last ? Z_FINISH : Z_SYNC_FLUSH);
+
+      band->out_size = bound - z.avail_out;
+      band->ok       = band->last ? zret == Z_STREAM_END
+         : (zret == Z_OK && !z.avail_in && z.avail_out);
    }
 
-   memcpy(deflate_buf + 4, "IDAT", 4);
-   dword_write_be(deflate_buf + 0,        ((uint32_t)total_out));
-   if (!png_write_idat(file, deflate_buf, ((size_t)total_out + 8)))
+   deflateEnd(&z);
+   free(encode_buf);
+}
+
+static unsigned rpng_band_count(unsigned height)
+{
+   unsigned bands = 1;
+#ifdef HAVE_THREADS
+   bands = MIN(cpu_features_get_core_amount(), RPNG_MAX_BANDS);
+   bands = MIN(bands, height / RPNG_BAND_MIN_ROWS);
+   if (!bands)
+      bands = 1;
+#endif
+   return bands;
+}
+
+static bool rpng_save_image(struct png_out *out,
+      const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp,
+      int level)
+{
+   unsigned i;
+   struct rpng_band bands[RPNG_MAX_BANDS];
+#ifdef HAVE_THREADS
+   sthread_t *threads[RPNG_MAX_BANDS] = {NULL};
+#endif
+   bool ret             = true;
+   unsigned band_count  = rpng_band_count(height);
+   unsigned row         = 0;
+   uint32_t adler       = adler32(0, NULL, 0);
+   struct png_ihdr ihdr = {0};
+
+   memset(bands, 0, sizeof(bands));
+
+   if (!png_write(out, png_magic, sizeof(png_magic)))
       GOTO_END_ERROR();
 
-   if (!png_write_iend(file))
+   ihdr.width = width;
+   ihdr.height = height;
+   ihdr.depth = 8;
+   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr(out, &ihdr))
       GOTO_END_ERROR();
 
-end:
-   filestream_close(file);
-   free(encode_buf);
-   free(deflate_buf);
-   free(rgba_line);
-   free(prev_encoded);
-   free(up_filtered);
-   free(sub_filtered);
-   free(avg_filtered);
-   free(paeth_filtered);
+   for (i = 0; i < band_count; i++)
+   {
+      unsigned rows  = height / band_count + (i < height % band_count);
+
+      bands[i].data  = data + (size_t)row * pitch;
+      bands[i].above = row ? bands[i].data - pitch : NULL;
+      bands[i].width = width;
+      bands[i].rows  = rows;
+      bands[i].pitch = pitch;
+      bands[i].bpp   = bpp;
+      bands[i].level = level;
+      bands[i].last  = i == band_count - 1;
+      row           += rows;
+   }
+
+   /* The calling thread takes the first band. */
+#ifdef HAVE_THREADS
+   for (i = 1; i < band_count; i++)
+      threads[i] = sthread_create(rpng_encode_band, &bands[i]);
+#endif
+
+   rpng_encode_band(&bands[0]);
+
+   for (i = 1; i < band_count; i++)
+   {
+#ifdef HAVE_THREADS
+      if (threads[i])
+      {
+         sthread_join(threads[i]);
+         continue;
+      }
+#endif
+      rpng_encode_band(&bands[i]);
+   }
 
-   if (stream_backend)
+   for (i = 0; i < band_count; i++)
    {
-      if (stream)
+      uint8_t *chunk = NULL;
+      size_t size    = bands[i].out_size;
+
+      if (!bands[i].ok)
+         GOTO_END_ERROR();
+
+      chunk          = bands[i].out + 2;
+
+      adler = adler32_combine(adler, bands[i].adler, bands[i].raw_size);
+
+      if (i == 0)
       {
-         if (stream_backend->stream_free)
-            stream_backend->stream_free(stream);
+         /* zlib header: deflate with a 32K window,
+          * FLEVEL from the compression level. */
+         unsigned flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+         unsigned flg    = flevel << 6;
+
+         flg            += 31 - (0x7800 + flg) % 31;
+         chunk           = bands[i].out;
+         chunk[8]        = 0x78;
+         chunk[9]        = (uint8_t)flg;
+         size           += 2;
       }
+
+      if (bands[i].last)
+      {
+         dword_write_be(chunk + 8 + size, adler);
+         size += 4;
+      }
+
+      dword_write_be(chunk, (uint32_t)size);
+      memcpy(chunk + 4, "IDAT", 4);
+      if (!png_write_idat(out, chunk, size + 8))
+         GOTO_END_ERROR();
    }
+
+   if (!png_write_iend(out))
+      GOTO_END_ERROR();
+
+end:
+   for (i = 0; i < band_count; i++)
+      free(bands[i].out);
+   return ret;
+}
+
+static bool rpng_save_image_file(const char *path,
+      const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp,
+      int level)
+{
+   bool ret = false;
+   struct png_out out;
+
+   memset(&out, 0, sizeof(out));
+
+   out.file = filestream_open(path, RFILE_MODE_WRITE, -1);
+   if (!out.file)
+      return false;
+
+   ret = rpng_save_image(&out, data, width, height, pitch, bpp, level);
+
+   filestream_close(out.file);
    return ret;
 }
 
 bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
-   return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, sizeof(uint32_t));
+   return rpng_save_image_file(path, (const uint8_t*)data,
+         width, height, pitch, sizeof(uint32_t), RPNG_DEFAULT_LEVEL);
 }
 
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
-   return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, 3);
+   return rpng_save_image_file(path, (const uint8_t*)data,
+         width, height, pitch, 3, RPNG_DEFAULT_LEVEL);
+}
+
+bool rpng_save_image_bgr24_level(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level)
+{
+   if (level < 1 || level > 9)
+      level = RPNG_DEFAULT_LEVEL;
+
+   return rpng_save_image_file(path, data, width, height, pitch, 3, level);
+}
+
+uint8_t *rpng_save_image_bgr24_string(const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, size_t *size)
+{
+   struct png_out out;
+
+   memset(&out, 0, sizeof(out));
+
+   if (!rpng_save_image(&out, data, width, height, pitch, 3,
+            RPNG_DEFAULT_LEVEL))
+   {
+      free(out.data);
+      return NULL;
+   }
+
+   *size = out.size;
+   return out.data;
 }
@@ -25,8 +25,15 @@
 
 #include <stdint.h>
 #include <filters.h>
+#include <retro_inline.h>
 #include <formats/rpng.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #undef GOTO_END_ERROR
 #define GOTO_END_ERROR() do { \
    fprintf(stderr, "[RPNG]: Error in line %d.\n", __LINE__); \
@@ -42,6 +49,46 @@ static const uint8_t png_magic[8] = {
    0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a,
 };
 
+#if defined(__SSE2__)
+/* Paeth predictor on eight 16-bit lanes. */
+static INLINE __m128i paeth_sse2(__m128i a, __m128i b, __m128i c)
+{
+   __m128i zero  = _mm_setzero_si128();
+   __m128i pa    = _mm_sub_epi16(b, c);
+   __m128i pb    = _mm_sub_epi16(a, c);
+   __m128i pc    = _mm_add_epi16(pa, pb);
+   __m128i use_a, use_b;
+
+   pa    = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+   pb    = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+   pc    = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+   use_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+   use_b = _mm_cmpgt_epi16(pb, pc);
+
+   /* use_a and use_b hold the inverted conditions. */
+   c     = _mm_or_si128(_mm_andnot_si128(use_b, b), _mm_and_si128(use_b, c));
+   return _mm_or_si128(_mm_andnot_si128(use_a, a), _mm_and_si128(use_a, c));
+}
+#elif defined(__ARM_NEON__)
+/* Paeth predictor on eight bytes. */
+static INLINE uint8x8_t paeth_neon(uint8x8_t a, uint8x8_t b, uint8x8_t c)
+{
+   uint16x8_t p1 = vaddl_u8(a, b);
+   uint16x8_t pc = vaddl_u8(c, c);
+   uint16x8_t pa = vabdl_u8(b, c);
+   uint16x8_t pb = vabdl_u8(a, c);
+   uint8x8_t use_a, use_b;
+
+   pc    = vabdq_u16(p1, pc);
+   p1    = vandq_u16(vcleq_u16(pa, pb), vcleq_u16(pa, pc));
+   use_b = vmovn_u16(vcleq_u16(pb, pc));
+   use_a = vmovn_u16(p1);
+
+   return vbsl_u8(use_a, a, vbsl_u8(use_b, b, c));
+}
+#endif
+
 struct png_ihdr
 {
    uint32_t width;
@@ -321,6 +321,33 @@ bool gl_check_capability(enum gl_capability_enum enum_idx)
          if (gl_query_extension("EXT_texture_storage"))
             return true;
          break;
+      case GL_CAPS_PROGRAM_BINARY:
+         {
+            GLint formats = 0;
+
+#if defined(HAVE_OPENGLES2)
+            if (!gl_query_extension("OES_get_program_binary"))
+               break;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+#elif defined(HAVE_OPENGLES3)
+            if (major < 3)
+               break;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+#elif defined(GL_NUM_PROGRAM_BINARY_FORMATS)
+            if (!glGetProgramBinary || !glProgramBinary)
+               break;
+            if (!(major > 4 || (major == 4 && minor >= 1))
+                  && !gl_query_extension("ARB_get_program_binary"))
+               break;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+#endif
+
+            /* Some drivers expose the entry points
+             * without any binary format to go with them. */
+            if (formats > 0)
+               return true;
+         }
+         break;
       case GL_CAPS_NONE:
       default:
          break;
@@ -122,6 +122,9 @@ static void gen_filter_sinc_sub(struct scaler_filter *filter,
 
    for (i = 0; i < len; i++, pos += step)
    {
+      int sum  = 0;
+      int peak = 0;
+
       filter->filter_pos[i] = pos >> 16;
 
       for (j = 0; j < sinc_size; j++)
@@ -131,7 +134,15 @@ static void gen_filter_sinc_sub(struct scaler_filter *filter,
          int16_t sinc_val     = FILTER_UNITY * sinc(sinc_phase * phase_mul) * sinc(lanczos_phase) * phase_mul;
 
          filter->filter[i * sinc_size + j] = sinc_val;
+         sum += sinc_val;
+         if (sinc_val > filter->filter[i * sinc_size + peak])
+            peak = j;
       }
+
+      /* The truncated window doesn't sum to unity, which darkens
+       * the image noticeably when downsampling. Fold the error
+       * into the largest tap. */
+      filter->filter[i * sinc_size + peak] += FILTER_UNITY - sum;
    }
 }
 
@@ -207,35 +218,45 @@ static void fixup_filter_sub(struct scaler_filter *filter, int out_len, int in_l
 
       if (postsample > 0)
       {
+         int j;
+         int clipped          = 0;
          int16_t *base_filter = NULL;
          filter->filter_pos[i] -= postsample;
 
          base_filter = filter->filter + i * filter->filter_stride;
 
          if (postsample > (int)filter->filter_len)
-            memset(base_filter, 0, filter->filter_len * sizeof(int16_t));
-         else
-         {
-            memmove(base_filter + postsample, base_filter,
-                  (filter->filter_len - postsample) * sizeof(int16_t));
-            memset(base_filter, 0, postsample * sizeof(int16_t));
-         }
+            postsample = filter->filter_len;
+
+         /* Taps past the edge would sample the last pixel,
+          * so fold their weight into it instead of dropping it. */
+         for (j = filter->filter_len - postsample; j < filter->filter_len; j++)
+            clipped += base_filter[j];
+
+         memmove(base_filter + postsample, base_filter,
+               (filter->filter_len - postsample) * sizeof(int16_t));
+         memset(base_filter, 0, postsample * sizeof(int16_t));
+         base_filter[filter->filter_len - 1] += clipped;
       }
 
       if (presample > 0)
       {
+         int j;
+         int clipped          = 0;
          int16_t *base_filter = NULL;
          filter->filter_pos[i] += presample;
          base_filter = filter->filter + i * filter->filter_stride;
 
          if (presample > (int)filter->filter_len)
-            memset(base_filter, 0, filter->filter_len * sizeof(int16_t));
-         else
-         {
-            memmove(base_filter, base_filter + presample,
-                  (filter->filter_len - presample) * sizeof(int16_t));
-            memset(base_filter + (filter->filter_len - presample), 0, presample * sizeof(int16_t));
-         }
+            presample = filter->filter_len;
+
+         for (j = 0; j < presample; j++)
+            clipped += base_filter[j];
+
+         memmove(base_filter, base_filter + presample,
+               (filter->filter_len - presample) * sizeof(int16_t));
+         memset(base_filter + (filter->filter_len - presample), 0, presample * sizeof(int16_t));
+         base_filter[0] += clipped;
       }
    }
 }
@@ -70,7 +70,11 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
          const uint64_t *input_base_y = input_base + w;
 #if defined(__SSE2__)
          __m128i final;
-         __m128i res = _mm_setzero_si128();
+         /* Every mulhi truncates, losing half an LSB per tap on average,
+          * and the final shift truncates too. Bias the accumulator to
+          * compensate; only one half, since both get summed together. */
+         const int16_t bias = 4 + (ctx->vert.filter_len >> 1);
+         __m128i res = _mm_set_epi16(0, 0, 0, 0, bias, bias, bias, bias);
 
          for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
          {
@@ -95,10 +99,10 @@ void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int strid
 
          output[w] = _mm_cvtsi128_si32(final);
 #else
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+         int16_t res_a = 4 + (ctx->vert.filter_len >> 1);
+         int16_t res_r = res_a;
+         int16_t res_g = res_a;
+         int16_t res_b = res_a;
 
          for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
          {
@@ -150,7 +154,9 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
       {
          const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
 #if defined(__SSE2__)
-         __m128i res = _mm_setzero_si128();
+         /* Compensates for mulhi truncation, see scaler_argb8888_vert. */
+         const int16_t bias = ctx->horiz.filter_len >> 1;
+         __m128i res = _mm_set_epi16(0, 0, 0, 0, bias, bias, bias, bias);
 
          for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
          {
@@ -187,10 +193,10 @@ void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int
          u.u32[1] = _mm_cvtsi128_si32(_mm_srli_si128(res, 4));
 #endif
 #else
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+         int16_t res_a = ctx->horiz.filter_len >> 1;
+         int16_t res_r = res_a;
+         int16_t res_g = res_a;
+         int16_t res_b = res_a;
 
          for (x = 0; x < ctx->horiz.filter_len; x++)
          {
@@ -92,6 +92,10 @@ typedef struct
    char *callback_error;
 
    file_archive_transfer_t archive;
+
+   /* Set when the archive can be extracted entry by entry. */
+   struct file_archive_index *index;
+   struct decompress_workers *workers;
 } decompress_state_t;
 
 struct archive_extract_userdata
@@ -200,6 +204,75 @@ const struct file_archive_file_backend* file_archive_get_file_backend(const char
  **/
 uint32_t file_archive_get_file_crc32(const char *path);
 
+/* Central directory entry of an indexed archive. */
+struct file_archive_entry
+{
+   const char *name;
+   uint32_t hash;
+   uint32_t crc32;
+   uint32_t csize;
+   uint32_t size;
+   uint32_t offset;
+   unsigned cmode;
+};
+
+typedef struct file_archive_index file_archive_index_t;
+
+/**
+ * file_archive_index_open:
+ * @path                         : filename path of a ZIP archive
+ *
+ * Reads the central directory of @path into a hashed index, or
+ * reuses a cached one if the archive's end of central directory
+ * record is unchanged. Release with file_archive_index_close().
+ *
+ * Returns: index on success, otherwise NULL.
+ **/
+file_archive_index_t *file_archive_index_open(const char *path);
+
+void file_archive_index_close(file_archive_index_t *index);
+
+size_t file_archive_index_size(const file_archive_index_t *index);
+
+const struct file_archive_entry *file_archive_index_get(
+      const file_archive_index_t *index, size_t idx);
+
+/**
+ * file_archive_index_find:
+ * @index                        : archive index
+ * @name                         : path of the entry inside the archive
+ *
+ * Returns: entry whose name is exactly @name, otherwise NULL.
+ **/
+const struct file_archive_entry *file_archive_index_find(
+      const file_archive_index_t *index, const char *name);
+
+/**
+ * file_archive_index_read:
+ * @index                        : archive index
+ * @entry                        : entry of @index to extract
+ * @buf                          : receives a malloc'd buffer with the
+ *                                 contents, unless @optional_outfile is set
+ * @optional_outfile             : if not NULL, path to extract the entry to
+ *
+ * Seeks to @entry and inflates it on its own, without walking the
+ * rest of the archive. Safe to call from several threads at once.
+ *
+ * Returns: size of the entry (0 when written to @optional_outfile),
+ * or -1 on failure.
+ **/
+int64_t file_archive_index_read(const file_archive_index_t *index,
+      const struct file_archive_entry *entry, void **buf,
+      const char *optional_outfile);
+
+/* Creates and frees the lock guarding the index cache. Until
+ * file_archive_index_cache_init() is called, threaded builds
+ * don't cache indexes. Not thread-safe; call while no other
+ * thread uses archives. */
+void file_archive_index_cache_init(void);
+
+void file_archive_index_cache_deinit(void);
+
 extern const struct file_archive_file_backend zlib_backend;
 extern const struct file_archive_file_backend sevenzip_backend;
 
@@ -56,6 +56,14 @@ bool rpng_save_image_argb(const char *path, const uint32_t *data,
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch);
 
+/* Level is the zlib compression level, 1 (fastest) to 9 (smallest). */
+bool rpng_save_image_bgr24_level(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, int level);
+
+/* Encodes into memory; the returned buffer is to be freed by the caller. */
+uint8_t *rpng_save_image_bgr24_string(const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, size_t *size);
+
 RETRO_END_DECLS
 
 #endif
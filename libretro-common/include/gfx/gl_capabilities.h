@@ -46,7 +46,8 @@ enum gl_capability_enum
    GL_CAPS_BGRA8888,
    GL_CAPS_GLES3_SUPPORTED,
    GL_CAPS_TEX_STORAGE,
-   GL_CAPS_TEX_STORAGE_EXT
+   GL_CAPS_TEX_STORAGE_EXT,
+   GL_CAPS_PROGRAM_BINARY
 };
 
 bool gl_check_error(char **error_string);
@@ -32,24 +32,52 @@ RETRO_BEGIN_DECLS
 
 #include <boolean.h>
 
+enum file_list_item_flags
+{
+   /* Entry is materialized on demand by the list's fetch callback. */
+   FILE_LIST_ITEM_DEFERRED         = (1 << 0),
+   /* Path and label are owned by the fetch callback as well. */
+   FILE_LIST_ITEM_DEFERRED_STRINGS = (1 << 1),
+   /* Deferred entry currently holds fetched data. */
+   FILE_LIST_ITEM_FETCHED          = (1 << 2)
+};
+
 struct item_file
 {
    char *path;
    char *label;
    char *alt;
    unsigned type;
+   unsigned flags;
    size_t directory_ptr;
    size_t entry_idx;
    void *userdata;
    void *actiondata;
 };
 
+struct file_list;
+
+/* Materializes deferred entry 'idx'; it is expected to set
+ * path/label (if they are deferred) and actiondata. */
+typedef void (*file_list_fetch_t)(struct file_list *list,
+      size_t idx, void *data);
+
+/* Returns a borrowed sort/search key for a deferred entry
+ * without materializing it. */
+typedef const char *(*file_list_fetch_alt_t)(const struct file_list *list,
+      size_t idx, void *data);
+
 typedef struct file_list
 {
    struct item_file *list;
 
    size_t capacity;
    size_t size;
+
+   file_list_fetch_t fetch_cb;
+   file_list_fetch_alt_t fetch_alt_cb;
+   void (*fetch_free_cb)(void *data);
+   void *fetch_data;
 } file_list_t;
 
 
@@ -65,6 +93,20 @@ bool file_list_append(file_list_t *userdata, const char *path,
       const char *label, unsigned type, size_t current_directory_ptr,
       size_t entry_index);
 
+bool file_list_append_deferred(file_list_t *list,
+      const char *path, const char *label,
+      unsigned type, size_t directory_ptr,
+      size_t entry_idx);
+
+void file_list_set_fetch_cb(file_list_t *list,
+      file_list_fetch_t fetch_cb, file_list_fetch_alt_t fetch_alt_cb,
+      void (*fetch_free_cb)(void *data), void *fetch_data);
+
+bool file_list_needs_fetch(const file_list_t *list, size_t idx);
+
+void file_list_release_deferred(file_list_t *list,
+      size_t first, size_t last);
+
 bool file_list_prepend(file_list_t *list,
       const char *path, const char *label,
       unsigned type, size_t directory_ptr,
@@ -48,6 +48,10 @@ bool path_is_valid(const char *path);
 
 int32_t path_get_size(const char *path);
 
+int64_t path_get_mtime(const char *path);
+
+bool path_file_replace(const char *src, const char *dst);
+
 /**
  * path_mkdir_norecurse:
  * @dir                : directory
@@ -84,6 +84,17 @@ int sha1_calculate(const char *path, char *result);
 
 uint32_t djb2_calculate(const char *str);
 
+/**
+ * xxh64_calculate:
+ * @data              : Input.
+ * @length            : Size of @data.
+ * @seed              : Seed value.
+ *
+ * Computes a 64-bit xxHash64 of @data. Not suitable for
+ * cryptographic use.
+ **/
+uint64_t xxh64_calculate(const uint8_t *data, size_t length, uint64_t seed);
+
 /* Any 32-bit or wider unsigned integer data type will do */
 typedef unsigned int MD5_u32plus;
 
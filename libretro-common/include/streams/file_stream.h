@@ -77,6 +77,8 @@ int filestream_putc(RFILE *stream, int c);
 
 int filestream_get_fd(RFILE *stream);
 
+const void *filestream_get_mapped(RFILE *stream, size_t *size);
+
 RETRO_END_DECLS
 
 #endif
@@ -21,6 +21,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(_WIN32) && defined(_XBOX)
 #include <xtl.h>
@@ -37,26 +38,33 @@
 
 #include <retro_miscellaneous.h>
 
+struct dir_list_sort_key
+{
+   /* Entry path past the prefix shared by the whole list. */
+   const char *key;
+   struct string_list_elem elem;
+};
+
 static int qstrcmp_plain(const void *a_, const void *b_)
 {
-   const struct string_list_elem *a = (const struct string_list_elem*)a_;
-   const struct string_list_elem *b = (const struct string_list_elem*)b_;
+   const struct dir_list_sort_key *a = (const struct dir_list_sort_key*)a_;
+   const struct dir_list_sort_key *b = (const struct dir_list_sort_key*)b_;
 
-   return strcasecmp(a->data, b->data);
+   return strcasecmp(a->key, b->key);
 }
 
 static int qstrcmp_dir(const void *a_, const void *b_)
 {
-   const struct string_list_elem *a = (const struct string_list_elem*)a_;
-   const struct string_list_elem *b = (const struct string_list_elem*)b_;
-   int a_type = a->attr.i;
-   int b_type = b->attr.i;
+   const struct dir_list_sort_key *a = (const struct dir_list_sort_key*)a_;
+   const struct dir_list_sort_key *b = (const struct dir_list_sort_key*)b_;
+   int a_type = a->elem.attr.i;
+   int b_type = b->elem.attr.i;
 
 
    /* Sort directories before files. */
    if (a_type != b_type)
       return b_type - a_type;
-   return strcasecmp(a->data, b->data);
+   return strcasecmp(a->key, b->key);
 }
 
 /**
@@ -66,12 +74,51 @@ static int qstrcmp_dir(const void *a_, const void *b_)
  *
  * Sorts a directory listing.
  *
+ * All entries of a listing usually share their parent
+ * directory, so the common prefix is skipped once up
+ * front instead of being compared over and over again.
  **/
 void dir_list_sort(struct string_list *list, bool dir_first)
 {
-   if (list)
-      qsort(list->elems, list->size, sizeof(struct string_list_elem),
-            dir_first ? qstrcmp_dir : qstrcmp_plain);
+   size_t i;
+   size_t prefix_len                   = 0;
+   struct dir_list_sort_key *keys      = NULL;
+
+   if (!list || list->size < 2)
+      return;
+
+   keys = (struct dir_list_sort_key*)
+      malloc(list->size * sizeof(*keys));
+
+   if (!keys)
+      return;
+
+   prefix_len = strlen(list->elems[0].data);
+
+   for (i = 1; i < list->size && prefix_len; i++)
+   {
+      size_t j         = 0;
+      const char *a    = list->elems[0].data;
+      const char *b    = list->elems[i].data;
+
+      while (j < prefix_len && a[j] == b[j])
+         j++;
+      prefix_len = j;
+   }
+
+   for (i = 0; i < list->size; i++)
+   {
+      keys[i].key  = list->elems[i].data + prefix_len;
+      keys[i].elem = list->elems[i];
+   }
+
+   qsort(keys, list->size, sizeof(*keys),
+         dir_first ? qstrcmp_dir : qstrcmp_plain);
+
+   for (i = 0; i < list->size; i++)
+      list->elems[i] = keys[i].elem;
+
+   free(keys);
 }
 
 /**
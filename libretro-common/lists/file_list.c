@@ -91,28 +91,48 @@ static bool file_list_expand_if_needed(file_list_t *list)
    return true;
 }
 
+/**
+ * file_list_fetch:
+ * @list             : pointer to file list
+ * @idx              : index of entry
+ *
+ * Materializes a deferred entry through the list's
+ * fetch callback, if it hasn't been already.
+ **/
+static void file_list_fetch(const file_list_t *list, size_t idx)
+{
+   struct item_file *item = &list->list[idx];
+
+   if (!(item->flags & FILE_LIST_ITEM_DEFERRED)
+         || (item->flags & FILE_LIST_ITEM_FETCHED)
+         || !list->fetch_cb)
+      return;
+
+   item->flags |= FILE_LIST_ITEM_FETCHED;
+   list->fetch_cb((file_list_t*)list, idx, list->fetch_data);
+}
+
+static void file_list_free_fetch_data(file_list_t *list)
+{
+   if (list->fetch_free_cb && list->fetch_data)
+      list->fetch_free_cb(list->fetch_data);
+
+   list->fetch_cb      = NULL;
+   list->fetch_alt_cb  = NULL;
+   list->fetch_free_cb = NULL;
+   list->fetch_data    = NULL;
+}
+
 bool file_list_prepend(file_list_t *list,
       const char *path, const char *label,
       unsigned type, size_t directory_ptr,
       size_t entry_idx)
 {
-   unsigned i;
-   
    if (!file_list_expand_if_needed(list))
       return false;
 
-   for (i = list->size; i > 0; i--)
-   {
-      struct item_file *copy = (struct item_file*)
-         calloc(1, sizeof(struct item_file));
-      
-      memcpy(copy, &list->list[i-1], sizeof(struct item_file));
-
-      memcpy(&list->list[i-1], &list->list[i], sizeof(struct item_file));
-      memcpy(&list->list[i],             copy, sizeof(struct item_file));
-
-      free(copy);
-   }
+   memmove(&list->list[1], &list->list[0],
+         list->size * sizeof(struct item_file));
 
    file_list_add(list, 0, path, label, type,
          directory_ptr, entry_idx);
@@ -134,6 +154,118 @@ bool file_list_append(file_list_t *list,
    return true;
 }
 
+/**
+ * file_list_append_deferred:
+ * @list             : pointer to file list
+ * @path             : path of entry, or NULL to fetch it on demand
+ * @label            : label of entry, or NULL to fetch it on demand
+ *
+ * Appends an entry whose data gets materialized by the
+ * fetch callback (see file_list_set_fetch_cb) the first
+ * time it is accessed. If @label is NULL, path and label
+ * are fetched as well and get released along with the
+ * action data by file_list_release_deferred.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool file_list_append_deferred(file_list_t *list,
+      const char *path, const char *label,
+      unsigned type, size_t directory_ptr,
+      size_t entry_idx)
+{
+   struct item_file *item = NULL;
+
+   if (!file_list_append(list, path, label, type,
+            directory_ptr, entry_idx))
+      return false;
+
+   item         = &list->list[list->size - 1];
+   item->flags |= FILE_LIST_ITEM_DEFERRED;
+   if (!label)
+      item->flags |= FILE_LIST_ITEM_DEFERRED_STRINGS;
+
+   return true;
+}
+
+/**
+ * file_list_set_fetch_cb:
+ * @list             : pointer to file list
+ * @fetch_cb         : materializes a deferred entry
+ * @fetch_alt_cb     : returns the sort key of a deferred
+ *                     entry without materializing it (optional)
+ * @fetch_free_cb    : frees @fetch_data (optional)
+ * @fetch_data       : opaque pointer passed to the callbacks
+ *
+ * Sets the provider for deferred entries. It is
+ * released when the list gets cleared or freed.
+ **/
+void file_list_set_fetch_cb(file_list_t *list,
+      file_list_fetch_t fetch_cb, file_list_fetch_alt_t fetch_alt_cb,
+      void (*fetch_free_cb)(void *data), void *fetch_data)
+{
+   if (!list)
+      return;
+
+   file_list_free_fetch_data(list);
+
+   list->fetch_cb      = fetch_cb;
+   list->fetch_alt_cb  = fetch_alt_cb;
+   list->fetch_free_cb = fetch_free_cb;
+   list->fetch_data    = fetch_data;
+}
+
+bool file_list_needs_fetch(const file_list_t *list, size_t idx)
+{
+   if (!list || idx >= list->size)
+      return false;
+   return (list->list[idx].flags & FILE_LIST_ITEM_DEFERRED)
+      && !(list->list[idx].flags & FILE_LIST_ITEM_FETCHED);
+}
+
+/**
+ * file_list_release_deferred:
+ * @list             : pointer to file list
+ * @first            : first index to keep
+ * @last             : last index to keep
+ *
+ * Drops the fetched data of all deferred entries
+ * outside of [@first, @last], so only that window
+ * stays materialized.
+ **/
+void file_list_release_deferred(file_list_t *list,
+      size_t first, size_t last)
+{
+   size_t i;
+
+   if (!list || !list->fetch_cb)
+      return;
+
+   for (i = 0; i < list->size; i++)
+   {
+      struct item_file *item = &list->list[i];
+
+      if (i >= first && i <= last)
+         continue;
+      if (!(item->flags & FILE_LIST_ITEM_FETCHED))
+         continue;
+
+      file_list_free_actiondata(list, i);
+
+      if (item->flags & FILE_LIST_ITEM_DEFERRED_STRINGS)
+      {
+         if (item->path)
+            free(item->path);
+         item->path = NULL;
+
+         if (item->label)
+            free(item->label);
+         item->label = NULL;
+      }
+
+      item->flags &= ~FILE_LIST_ITEM_FETCHED;
+   }
+}
+
 size_t file_list_get_size(const file_list_t *list)
 {
    if (!list)
@@ -193,6 +325,7 @@ void file_list_free(file_list_t *list)
          free(list->list[i].alt);
       list->list[i].alt = NULL;
    }
+   file_list_free_fetch_data(list);
    if (list->list)
       free(list->list);
    list->list = NULL;
@@ -221,6 +354,8 @@ void file_list_clear(file_list_t *list)
       list->list[i].alt = NULL;
    }
 
+   file_list_free_fetch_data(list);
+
    list->size = 0;
 }
 
@@ -268,6 +403,18 @@ void file_list_copy(const file_list_t *src, file_list_t *dst)
 
    for (item = dst->list; item < &dst->list[dst->size]; ++item)
    {
+      size_t idx     = item - dst->list;
+
+      /* The copy doesn't share the source's fetch callback,
+       * so entries whose strings haven't been fetched yet
+       * get their sort key as path instead. */
+      if (     !item->path && !item->label
+            && (item->flags & FILE_LIST_ITEM_DEFERRED_STRINGS)
+            && src->fetch_alt_cb)
+         item->path  = (char*)src->fetch_alt_cb(src, idx, src->fetch_data);
+
+      item->flags    = 0;
+
       if (item->path)
          item->path  = strdup(item->path);
 
@@ -299,6 +446,8 @@ void file_list_get_label_at_offset(const file_list_t *list, size_t idx,
    if (!label || !list)
       return;
 
+   file_list_fetch(list, idx);
+
    *label = list->list[idx].path;
    if (list->list[idx].label)
       *label = list->list[idx].label;
@@ -324,6 +473,12 @@ void file_list_get_alt_at_offset(const file_list_t *list, size_t idx,
    if (!list)
       return;
 
+   if (alt && list->fetch_alt_cb && file_list_needs_fetch(list, idx))
+   {
+      *alt = list->fetch_alt_cb(list, idx, list->fetch_data);
+      return;
+   }
+
    if (alt)
       *alt = list->list[idx].alt ?
          list->list[idx].alt : list->list[idx].path;
@@ -335,7 +490,7 @@ static int file_list_alt_cmp(const void *a_, const void *b_)
    const struct item_file *b = (const struct item_file*)b_;
    const char *cmp_a = a->alt ? a->alt : a->path;
    const char *cmp_b = b->alt ? b->alt : b->path;
-   return strcasecmp(cmp_a, cmp_b);
+   return strcasecmp(cmp_a ? cmp_a : "", cmp_b ? cmp_b : "");
 }
 
 static int file_list_type_cmp(const void *a_, const void *b_)
@@ -352,6 +507,21 @@ static int file_list_type_cmp(const void *a_, const void *b_)
 
 void file_list_sort_on_alt(file_list_t *list)
 {
+   size_t i;
+
+   /* Deferred entries may have no strings yet; the
+    * comparator can't reach the list, so store their
+    * sort key up front. */
+   if (list->fetch_alt_cb)
+   {
+      for (i = 0; i < list->size; i++)
+      {
+         if (!list->list[i].alt && file_list_needs_fetch(list, i))
+            file_list_set_alt_at_offset(list, i,
+                  list->fetch_alt_cb(list, i, list->fetch_data));
+      }
+   }
+
    qsort(list->list, list->size, sizeof(list->list[0]), file_list_alt_cmp);
 }
 
@@ -385,6 +555,7 @@ void *file_list_get_actiondata_at_offset(const file_list_t *list, size_t idx)
 {
    if (!list)
       return NULL;
+   file_list_fetch(list, idx);
    return list->list[idx].actiondata;
 }
 
@@ -410,6 +581,7 @@ void *file_list_get_last_actiondata(const file_list_t *list)
 {
    if (!list)
       return NULL;
+   file_list_fetch(list, list->size - 1);
    return list->list[list->size - 1].actiondata;
 }
 
@@ -420,6 +592,9 @@ void file_list_get_at_offset(const file_list_t *list, size_t idx,
    if (!list)
       return;
 
+   if (path || label)
+      file_list_fetch(list, idx);
+
    if (path)
       *path      = list->list[idx].path;
    if (label)
@@ -102,6 +102,29 @@ int filestream_get_fd(RFILE *stream)
    return stream->fd;
 }
 
+/**
+ * filestream_get_mapped:
+ * @stream           : stream opened with RFILE_HINT_MMAP.
+ * @size             : set to the size of the mapping.
+ *
+ * Gives direct access to a memory-mapped stream. The memory is read-only
+ * and stays valid until the stream is closed.
+ *
+ * Returns: pointer to the mapped file, or NULL if the stream isn't mapped.
+ */
+const void *filestream_get_mapped(RFILE *stream, size_t *size)
+{
+#ifdef HAVE_MMAP
+   if (stream && stream->hints & RFILE_HINT_MMAP && stream->mapped)
+   {
+      if (size)
+         *size = (size_t)stream->mapsize;
+      return stream->mapped;
+   }
+#endif
+   return NULL;
+}
+
 RFILE *filestream_open(const char *path, unsigned mode, ssize_t len)
 {
    int            flags = 0;
@@ -212,20 +235,26 @@ RFILE *filestream_open(const char *path, unsigned mode, ssize_t len)
 #ifdef HAVE_MMAP
       if (stream->hints & RFILE_HINT_MMAP)
       {
+         off_t size      = lseek(stream->fd, 0, SEEK_END);
+
          stream->mappos  = 0;
          stream->mapped  = NULL;
-         stream->mapsize = filestream_seek(stream, 0, SEEK_END);
 
-         if (stream->mapsize == (uint64_t)-1)
+         /* filestream_seek() doesn't report the offset of
+          * unbuffered streams */
+         if (size < 0 || lseek(stream->fd, 0, SEEK_SET) < 0)
             goto error;
 
-         filestream_rewind(stream);
+         stream->mapsize = size;
 
          stream->mapped = (uint8_t*)mmap((void*)0,
                stream->mapsize, PROT_READ,  MAP_SHARED, stream->fd, 0);
 
          if (stream->mapped == MAP_FAILED)
+         {
+            stream->mapped = NULL;
             stream->hints &= ~RFILE_HINT_MMAP;
+         }
       }
 #endif
    }
@@ -213,7 +213,7 @@ static bool frame_is_reversed                         = false;
 
 /* Returns the maximum compressed size of a savestate. 
  * It is very likely to compress to far less. */
-static size_t state_manager_raw_maxsize(size_t uncomp)
+size_t state_manager_raw_maxsize(size_t uncomp)
 {
    /* bytes covered by a compressed block */
    const int maxcblkcover = UINT16_MAX * sizeof(uint16_t);
@@ -229,7 +229,7 @@ static size_t state_manager_raw_maxsize(size_t uncomp)
  * See state_manager_raw_compress for information about this.
  * When you're done with it, send it to free().
  */
-static void *state_manager_raw_alloc(size_t len, uint16_t uniq)
+void *state_manager_raw_alloc(size_t len, uint16_t uniq)
 {
    size_t  len16 = (len + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
    uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4 + 16, 1);
@@ -258,7 +258,7 @@ static void *state_manager_raw_alloc(size_t len, uint16_t uniq)
  * 'patch' must be size 'state_manager_raw_maxsize(len)' or more.
  * Returns the number of bytes actually written to 'patch'.
  */
-static size_t state_manager_raw_compress(const void *src,
+size_t state_manager_raw_compress(const void *src,
       const void *dst, size_t len, void *patch)
 {
    const uint16_t  *old16 = (const uint16_t*)src;
@@ -325,7 +325,7 @@ static size_t state_manager_raw_compress(const void *src,
  * If the given arguments do not match a previous call to 
  * state_manager_raw_compress(), anything at all can happen.
  */
-static void state_manager_raw_decompress(const void *patch,
+void state_manager_raw_decompress(const void *patch,
       size_t patchlen, void *data, size_t datalen)
 {
    uint16_t         *out16 = (uint16_t*)data;
@@ -28,6 +28,18 @@ RETRO_BEGIN_DECLS
 
 typedef struct state_manager state_manager_t;
 
+/* Raw savestate delta encoder, as used by rewind.
+ * See state_manager.c for the patch format. */
+size_t state_manager_raw_maxsize(size_t uncomp);
+
+void *state_manager_raw_alloc(size_t len, uint16_t uniq);
+
+size_t state_manager_raw_compress(const void *src,
+      const void *dst, size_t len, void *patch);
+
+void state_manager_raw_decompress(const void *patch,
+      size_t patchlen, void *data, size_t datalen);
+
 bool state_manager_frame_is_reversed(void);
 
 void state_manager_event_deinit(void);
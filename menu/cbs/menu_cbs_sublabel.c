@@ -312,6 +312,14 @@ default_sublabel_macro(action_bind_sublabel_video_viewport_custom_height,
 default_sublabel_macro(action_bind_sublabel_video_viewport_custom_width,           MENU_ENUM_SUBLABEL_VIDEO_VIEWPORT_CUSTOM_WIDTH)
 default_sublabel_macro(action_bind_sublabel_video_viewport_custom_x,               MENU_ENUM_SUBLABEL_VIDEO_VIEWPORT_CUSTOM_X)
 default_sublabel_macro(action_bind_sublabel_video_viewport_custom_y,               MENU_ENUM_SUBLABEL_VIDEO_VIEWPORT_CUSTOM_Y)
+default_sublabel_macro(action_bind_sublabel_run_ahead_enabled,                     MENU_ENUM_SUBLABEL_RUN_AHEAD_ENABLED)
+default_sublabel_macro(action_bind_sublabel_run_ahead_frames,                      MENU_ENUM_SUBLABEL_RUN_AHEAD_FRAMES)
+default_sublabel_macro(action_bind_sublabel_audio_rate_control_adaptive,           MENU_ENUM_SUBLABEL_AUDIO_RATE_CONTROL_ADAPTIVE)
+default_sublabel_macro(action_bind_sublabel_netplay_spectator_relay,               MENU_ENUM_SUBLABEL_NETPLAY_SPECTATOR_RELAY)
+default_sublabel_macro(action_bind_sublabel_netplay_relay_keyframe_interval,       MENU_ENUM_SUBLABEL_NETPLAY_RELAY_KEYFRAME_INTERVAL)
+default_sublabel_macro(action_bind_sublabel_playlist_binary_format,                MENU_ENUM_SUBLABEL_PLAYLIST_BINARY_FORMAT)
+default_sublabel_macro(action_bind_sublabel_savestate_file_compression,            MENU_ENUM_SUBLABEL_SAVESTATE_FILE_COMPRESSION)
+default_sublabel_macro(action_bind_sublabel_screenshot_compression_level,          MENU_ENUM_SUBLABEL_SCREENSHOT_COMPRESSION_LEVEL)
 
 static int action_bind_sublabel_cheevos_entry(
       file_list_t *list,
@@ -373,6 +381,30 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
    {
       switch (cbs->enum_idx)
       {
+         case MENU_ENUM_LABEL_RUN_AHEAD_ENABLED:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_run_ahead_enabled);
+            break;
+         case MENU_ENUM_LABEL_RUN_AHEAD_FRAMES:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_run_ahead_frames);
+            break;
+         case MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_ADAPTIVE:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_rate_control_adaptive);
+            break;
+         case MENU_ENUM_LABEL_NETPLAY_SPECTATOR_RELAY:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_netplay_spectator_relay);
+            break;
+         case MENU_ENUM_LABEL_NETPLAY_RELAY_KEYFRAME_INTERVAL:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_netplay_relay_keyframe_interval);
+            break;
+         case MENU_ENUM_LABEL_PLAYLIST_BINARY_FORMAT:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_playlist_binary_format);
+            break;
+         case MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_savestate_file_compression);
+            break;
+         case MENU_ENUM_LABEL_SCREENSHOT_COMPRESSION_LEVEL:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_screenshot_compression_level);
+            break;
          case MENU_ENUM_LABEL_VIDEO_VIEWPORT_CUSTOM_HEIGHT:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_video_viewport_custom_height);
             break;
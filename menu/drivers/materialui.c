@@ -546,7 +546,10 @@ static void mui_compute_entries_box(mui_handle_t* mui, int width)
 
       sublabel_str[0]  = '\0';
 
-      if (menu_entry_get_sublabel(i, sublabel_str, sizeof(sublabel_str)))
+      /* Deferred entries (playlists, file browser) have no
+       * sublabel, don't materialize them for layout. */
+      if (     !file_list_needs_fetch(list, i)
+            && menu_entry_get_sublabel(i, sublabel_str, sizeof(sublabel_str)))
       {
          word_wrap(sublabel_str, sublabel_str, (int)(usable_width / mui->glyph_width2));
          lines = mui_count_lines(sublabel_str);
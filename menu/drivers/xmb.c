@@ -45,6 +45,7 @@
 #include "../menu_animation.h"
 #include "../menu_display.h"
 #include "../menu_navigation.h"
+#include "../menu_thumbnail_cache.h"
 
 #include "../widgets/menu_entry.h"
 #include "../widgets/menu_list.h"
@@ -69,6 +70,9 @@
 #define XMB_DELAY 10
 #endif
 
+/* Entries above and below the selection to decode thumbnails for. */
+#define XMB_THUMBNAIL_PREFETCH 4
+
 #define BATTERY_LEVEL_CHECK_INTERVAL (30 * 1000000)
 
 #if 0
@@ -84,7 +88,6 @@ typedef struct
    float y;
    uintptr_t icon;
    uintptr_t content_icon;
-   char fullpath[4096];
 } xmb_node_t;
 
 enum
@@ -870,19 +873,27 @@ end:
    string_list_free(list);
 }
 
-static void xmb_update_thumbnail_path(void *data, unsigned i)
+/**
+ * xmb_get_thumbnail_path:
+ * @xmb              : XMB handle.
+ * @i                : index of the entry.
+ * @path             : buffer for the thumbnail path.
+ * @size             : size of @path.
+ *
+ * Returns: false if entries of this list have no thumbnails.
+ **/
+static bool xmb_get_thumbnail_path(xmb_handle_t *xmb, unsigned i,
+      char *path, size_t size)
 {
    menu_entry_t entry;
    char tmp_new[PATH_MAX_LENGTH];
    char             *tmp    = NULL;
    char *scrub_char_pointer = NULL;
    settings_t     *settings = config_get_ptr();
-   xmb_handle_t     *xmb    = (xmb_handle_t*)data;
    playlist_t     *playlist = NULL;
    const char    *core_name = NULL;
 
-   if (!xmb)
-      return;
+   path[0]             = '\0';
 
    entry.path[0]       = '\0';
    entry.label[0]      = '\0';
@@ -899,27 +910,18 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
 
    if (entry.type == FILE_TYPE_IMAGEVIEWER || entry.type == FILE_TYPE_IMAGE)
    {
-      file_list_t *selection_buf = menu_entries_get_selection_buf_ptr(0);
-      xmb_node_t *node = (xmb_node_t*)
-         menu_entries_get_userdata_at_offset(selection_buf, i);
+      const char *menu_path = NULL;
 
-      if (node)
-      {
-         fill_pathname_join(
-               xmb->thumbnail_file_path,
-               node->fullpath,
-               entry.path,
-               sizeof(xmb->thumbnail_file_path));
+      menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
 
-         return;
+      if (!string_is_empty(menu_path))
+      {
+         fill_pathname_join(path, menu_path, entry.path, size);
+         return true;
       }
    }
    else if (xmb_list_get_selection(xmb) <= XMB_SYSTEM_TAB_SETTINGS)
-   {
-      xmb->thumbnail_file_path[0] = '\0';
-      xmb->thumbnail = 0;
-      return;
-   }
+      return false;
 
    menu_driver_ctl(RARCH_MENU_CTL_PLAYLIST_GET, &playlist);
 
@@ -930,20 +932,15 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
 
       if (core_name && string_is_equal(core_name, "imageviewer"))
       {
-         strlcpy(xmb->thumbnail_file_path, entry.label,
-               sizeof(xmb->thumbnail_file_path));
-         return;
+         strlcpy(path, entry.label, size);
+         return true;
       }
    }
 
-   fill_pathname_join(
-         xmb->thumbnail_file_path,
-         settings->directory.thumbnails,
-         xmb->title_name,
-         sizeof(xmb->thumbnail_file_path));
+   fill_pathname_join(path, settings->directory.thumbnails,
+         xmb->title_name, size);
 
-   fill_pathname_join(xmb->thumbnail_file_path, xmb->thumbnail_file_path,
-         xmb_thumbnails_ident(), sizeof(xmb->thumbnail_file_path));
+   fill_pathname_join(path, path, xmb_thumbnails_ident(), size);
 
    /* Scrub characters that are not cross-platform and/or violate the
     * No-Intro filename standard:
@@ -958,16 +955,25 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
    /* Look for thumbnail file with this scrubbed filename */
    tmp_new[0] = '\0';
 
-   fill_pathname_join(tmp_new,
-         xmb->thumbnail_file_path,
-         tmp, sizeof(tmp_new));
-   strlcpy(xmb->thumbnail_file_path,
-         tmp_new, sizeof(xmb->thumbnail_file_path));
+   fill_pathname_join(tmp_new, path, tmp, sizeof(tmp_new));
+   strlcpy(path, tmp_new, size);
    free(tmp);
 
-   strlcat(xmb->thumbnail_file_path,
-         file_path_str(FILE_PATH_PNG_EXTENSION),
-         sizeof(xmb->thumbnail_file_path));
+   strlcat(path, file_path_str(FILE_PATH_PNG_EXTENSION), size);
+
+   return true;
+}
+
+static void xmb_update_thumbnail_path(void *data, unsigned i)
+{
+   xmb_handle_t     *xmb    = (xmb_handle_t*)data;
+
+   if (!xmb)
+      return;
+
+   if (!xmb_get_thumbnail_path(xmb, i, xmb->thumbnail_file_path,
+            sizeof(xmb->thumbnail_file_path)))
+      xmb->thumbnail = 0;
 }
 
 static void xmb_update_savestate_thumbnail_path(void *data, unsigned i)
@@ -1019,27 +1025,80 @@ static void xmb_update_savestate_thumbnail_path(void *data, unsigned i)
             strlcpy(path, global->name.savestate, sizeof(path));
       }
 
+      strlcpy(xmb->savestate_thumbnail_file_path, path,
+            sizeof(xmb->savestate_thumbnail_file_path));
       strlcat(path, file_path_str(FILE_PATH_PNG_EXTENSION), sizeof(path));
 
+      /* Compressed savestates carry their own thumbnail. */
       if (path_file_exists(path))
-      {
          strlcpy(xmb->savestate_thumbnail_file_path, path,
                sizeof(xmb->savestate_thumbnail_file_path));
-      }
+#if !defined(HAVE_ZLIB) || !defined(HAVE_RPNG)
+      else
+         xmb->savestate_thumbnail_file_path[0] = '\0';
+#endif
    }
 }
 
 static void xmb_update_thumbnail_image(void *data)
 {
-   xmb_handle_t *xmb = (xmb_handle_t*)data;
+   unsigned width, height;
+   size_t selection           = 0;
+   uintptr_t texture          = 0;
+   union string_list_elem_attr attr;
+   struct string_list *paths  = NULL;
+   xmb_handle_t *xmb          = (xmb_handle_t*)data;
    if (!xmb)
       return;
 
-   if (path_file_exists(xmb->thumbnail_file_path))
-      task_push_image_load(xmb->thumbnail_file_path,
-            menu_display_handle_thumbnail_upload, NULL);
-   else if (xmb->depth == 1)
+   if (menu_thumbnail_cache_get(xmb->thumbnail_file_path,
+            &texture, &width, &height))
+   {
+      xmb->thumbnail = texture;
+      if (texture)
+      {
+         xmb->thumbnail_orig_width  = (float)width;
+         xmb->thumbnail_orig_height = (float)height;
+         xmb->thumbnail_height      = xmb->thumbnail_width
+            * (float)height / (float)width;
+      }
+   }
+   else if (!path_file_exists(xmb->thumbnail_file_path)
+         && xmb->depth == 1)
       xmb->thumbnail = 0;
+
+   /* Decode the entries around the selection as well,
+    * so they are ready when scrolled to. */
+   paths  = string_list_new();
+   attr.i = 0;
+
+   if (!paths)
+      return;
+
+   string_list_append(paths, xmb->thumbnail_file_path, attr);
+
+   if (menu_navigation_ctl(MENU_NAVIGATION_CTL_GET_SELECTION, &selection))
+   {
+      unsigned i;
+      size_t end = menu_entries_get_end();
+
+      for (i = 1; i <= XMB_THUMBNAIL_PREFETCH; i++)
+      {
+         char path[PATH_MAX_LENGTH];
+
+         if (     selection + i < end
+               && xmb_get_thumbnail_path(xmb,
+                  (unsigned)(selection + i), path, sizeof(path)))
+            string_list_append(paths, path, attr);
+
+         if (     selection >= i
+               && xmb_get_thumbnail_path(xmb,
+                  (unsigned)(selection - i), path, sizeof(path)))
+            string_list_append(paths, path, attr);
+      }
+   }
+
+   menu_thumbnail_cache_request(paths);
 }
 
 static void xmb_update_savestate_thumbnail_image(void *data)
@@ -1048,11 +1107,17 @@ static void xmb_update_savestate_thumbnail_image(void *data)
    if (!xmb)
       return;
 
-   if (path_file_exists(xmb->savestate_thumbnail_file_path))
-      task_push_image_load(xmb->savestate_thumbnail_file_path,
+   if (!path_file_exists(xmb->savestate_thumbnail_file_path))
+      xmb->savestate_thumbnail = 0;
+#if defined(HAVE_ZLIB) && defined(HAVE_RPNG)
+   else if (!string_is_equal(
+            path_get_extension(xmb->savestate_thumbnail_file_path), "png"))
+      task_push_state_thumbnail_load(xmb->savestate_thumbnail_file_path,
             menu_display_handle_savestate_thumbnail_upload, NULL);
+#endif
    else
-      xmb->savestate_thumbnail = 0;
+      task_push_image_load(xmb->savestate_thumbnail_file_path,
+            menu_display_handle_savestate_thumbnail_upload, NULL);
 }
 
 static void xmb_selection_pointer_changed(
@@ -3294,6 +3359,8 @@ static void xmb_free(void *data)
       video_coord_array_free(&xmb->raster_block2.carr);
    }
 
+   menu_thumbnail_cache_free();
+
    font_driver_bind_block(NULL, NULL);
 
 }
@@ -3310,8 +3377,16 @@ static bool xmb_load_image(void *userdata, void *data, enum menu_image_type type
 {
    xmb_handle_t *xmb = (xmb_handle_t*)userdata;
 
-   if (!xmb || !data)
+   if (!xmb)
+      return false;
+
+   if (!data)
+   {
+      /* Savestate without an embedded thumbnail. */
+      if (type == MENU_IMAGE_SAVESTATE_THUMBNAIL && xmb->savestate_thumbnail)
+         video_driver_texture_unload(&xmb->savestate_thumbnail);
       return false;
+   }
 
    switch (type)
    {
@@ -3613,9 +3688,6 @@ static void xmb_list_insert(void *userdata,
 
    current           = selection;
 
-   if (!string_is_empty(fullpath))
-      strlcpy(node->fullpath, fullpath, sizeof(node->fullpath));
-
    node->alpha       = xmb->items.passive.alpha;
    node->zoom        = xmb->items.passive.zoom;
    node->label_alpha = node->alpha;
@@ -3700,7 +3772,9 @@ static void xmb_list_deep_copy(const file_list_t *src, file_list_t *dst)
    for (i = 0; i < size; ++i)
    {
       void *src_udata = menu_entries_get_userdata_at_offset(src, i);
-      void *src_adata = (void*)menu_entries_get_actiondata_at_offset(src, i);
+      /* Don't go through the getter, it would materialize
+       * every deferred entry of the source list. */
+      void *src_adata = src->list[i].actiondata;
 
       if (src_udata)
       {
@@ -3856,6 +3930,9 @@ static void xmb_context_destroy(void *data)
    xmb_context_destroy_horizontal_list(xmb);
    xmb_context_bg_destroy(xmb);
 
+   menu_thumbnail_cache_free();
+   xmb->thumbnail = 0;
+
    menu_display_font_free(xmb->font);
    menu_display_font_free(xmb->font2);
 
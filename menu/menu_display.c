@@ -16,6 +16,8 @@
  */
 
 #include <time.h>
+#include <math.h>
+#include <string.h>
 
 #include <retro_assert.h>
 #include <queues/message_queue.h>
@@ -64,6 +66,22 @@ static const uint8_t *menu_display_font_framebuf = NULL;
 static msg_queue_t *menu_display_msg_queue       = NULL;
 static menu_display_ctx_driver_t *menu_disp      = NULL;
 
+/* Retained draw list. Quads drawn between menu_display_set_viewport()
+ * and menu_display_unset_viewport() are transformed on the CPU into
+ * one persistent vertex arena, and every run of quads sharing a texture
+ * and blend state is issued as a single triangle list. */
+#define MENU_DISPLAY_BATCH_MAX_FONTS 4
+
+static video_coord_array_t menu_disp_batch_ca;
+static uintptr_t menu_disp_batch_texture         = 0;
+static unsigned menu_disp_batch_width            = 0;
+static unsigned menu_disp_batch_height           = 0;
+static bool menu_disp_batch_enable               = false;
+static bool menu_disp_batch_blend                = false;
+static bool menu_disp_blend                      = false;
+static bool menu_disp_blend_deferred             = false;
+static const font_data_t *menu_disp_batch_fonts[MENU_DISPLAY_BATCH_MAX_FONTS];
+
 static menu_display_ctx_driver_t *menu_display_ctx_drivers[] = {
 #ifdef HAVE_D3D
    &menu_display_ctx_d3d,
@@ -193,18 +211,237 @@ void menu_display_timedate(menu_display_ctx_datetime_t *datetime)
    }
 }
 
+static void menu_display_set_blend(bool enable)
+{
+   if (!menu_disp)
+      return;
+
+   if (enable)
+   {
+      if (menu_disp->blend_begin)
+         menu_disp->blend_begin();
+   }
+   else if (menu_disp->blend_end)
+      menu_disp->blend_end();
+}
+
 void menu_display_blend_begin(void)
 {
-   if (!menu_disp || !menu_disp->blend_begin)
+   menu_disp_blend = true;
+
+   /* Applied once the pending batch has been drawn. */
+   if (menu_disp_batch_ca.coords.vertices)
+   {
+      menu_disp_blend_deferred = true;
       return;
-   menu_disp->blend_begin();
+   }
+
+   menu_display_set_blend(true);
 }
 
 void menu_display_blend_end(void)
 {
-   if (!menu_disp || !menu_disp->blend_end)
+   menu_disp_blend = false;
+
+   if (menu_disp_batch_ca.coords.vertices)
+   {
+      menu_disp_blend_deferred = true;
+      return;
+   }
+
+   menu_display_set_blend(false);
+}
+
+/**
+ * menu_display_batch_flush:
+ *
+ * Draws all quads batched so far. Must be called before anything
+ * that draws behind menu_display's back, so ordering is kept.
+ **/
+void menu_display_batch_flush(void)
+{
+   menu_display_ctx_draw_t draw;
+
+   if (!menu_disp_batch_ca.coords.vertices)
       return;
-   menu_disp->blend_end();
+
+   if (menu_disp && menu_disp->draw)
+   {
+      menu_display_set_blend(menu_disp_batch_blend);
+
+      memset(&draw, 0, sizeof(draw));
+      draw.width       = menu_disp_batch_width;
+      draw.height      = menu_disp_batch_height;
+      draw.coords      = (struct video_coords*)&menu_disp_batch_ca.coords;
+      draw.texture     = menu_disp_batch_texture;
+      draw.prim_type   = MENU_DISPLAY_PRIM_TRIANGLES;
+
+      menu_disp->draw(&draw);
+   }
+
+   menu_disp_batch_ca.coords.vertices = 0;
+
+   if (menu_disp_blend_deferred)
+      menu_display_set_blend(menu_disp_blend);
+   menu_disp_blend_deferred = false;
+}
+
+/* Only drivers which draw triangle lists of any length
+ * through draw() and use a plain [0, 1] ortho projection
+ * can be batched. */
+static bool menu_display_batch_supported(void)
+{
+   const math_matrix_4x4 *mvp = NULL;
+
+   if (!menu_disp || !menu_disp->get_default_mvp)
+      return false;
+
+   switch (menu_disp->type)
+   {
+      case MENU_VIDEO_DRIVER_OPENGL:
+      case MENU_VIDEO_DRIVER_VULKAN:
+         break;
+      default:
+         return false;
+   }
+
+   mvp = (const math_matrix_4x4*)menu_disp->get_default_mvp();
+
+   return mvp
+      && fabs(MAT_ELEM_4X4(*mvp, 0, 0) - 2.0f) < 0.0001f
+      && fabs(MAT_ELEM_4X4(*mvp, 0, 3) + 1.0f) < 0.0001f
+      && fabs(MAT_ELEM_4X4(*mvp, 1, 1) - 2.0f) < 0.0001f
+      && fabs(MAT_ELEM_4X4(*mvp, 1, 3) + 1.0f) < 0.0001f
+      && MAT_ELEM_4X4(*mvp, 0, 1) == 0.0f
+      && MAT_ELEM_4X4(*mvp, 1, 0) == 0.0f
+      && MAT_ELEM_4X4(*mvp, 3, 0) == 0.0f
+      && MAT_ELEM_4X4(*mvp, 3, 1) == 0.0f
+      && MAT_ELEM_4X4(*mvp, 3, 3) == 1.0f;
+}
+
+/**
+ * menu_display_batch_push:
+ * @draw                     : Draw to batch.
+ *
+ * Appends a single textured quad to the draw list. The quad is
+ * moved from its own viewport (and matrix) into full-screen
+ * coordinates, so quads with different placement can share a draw.
+ *
+ * Returns: true (1) if the quad was batched, false (0) if it
+ * has to be drawn directly.
+ **/
+static bool menu_display_batch_push(const menu_display_ctx_draw_t *draw)
+{
+   unsigned i;
+   video_coords_t coords;
+   float quad[8];
+   float vertex[12];
+   float tex_coord[12];
+   float color[24];
+   static const unsigned strip_to_list[6] = { 0, 1, 2, 2, 1, 3 };
+   const math_matrix_4x4 *mat             = NULL;
+   const float *src_vertex                = NULL;
+   const float *src_tex_coord             = NULL;
+   /* The Vulkan backend flips Y on input, before the matrix. */
+   bool flip_y                            = false;
+
+   if (!menu_disp_batch_enable || !draw->coords
+         || draw->prim_type != MENU_DISPLAY_PRIM_TRIANGLESTRIP
+         || draw->coords->vertices != 4
+         || !draw->coords->color
+         || draw->pipeline.id != 0)
+      return false;
+
+   src_vertex    = draw->coords->vertex;
+   src_tex_coord = draw->coords->tex_coord;
+
+   if (!src_vertex)
+      src_vertex    = menu_disp->get_default_vertices();
+   if (!src_tex_coord)
+      src_tex_coord = menu_disp->get_default_tex_coords();
+
+   mat    = (const math_matrix_4x4*)draw->matrix_data;
+   flip_y = menu_disp->type == MENU_VIDEO_DRIVER_VULKAN;
+
+   if (mat == (const math_matrix_4x4*)menu_disp->get_default_mvp())
+      mat = NULL;
+
+   for (i = 0; i < 4; i++)
+   {
+      float x = src_vertex[i * 2 + 0];
+      float y = src_vertex[i * 2 + 1];
+
+      if (mat)
+      {
+         float clip_x, clip_y, clip_w;
+
+         if (flip_y)
+            y = 1.0f - y;
+
+         clip_x = MAT_ELEM_4X4(*mat, 0, 0) * x
+            + MAT_ELEM_4X4(*mat, 0, 1) * y + MAT_ELEM_4X4(*mat, 0, 3);
+         clip_y = MAT_ELEM_4X4(*mat, 1, 0) * x
+            + MAT_ELEM_4X4(*mat, 1, 1) * y + MAT_ELEM_4X4(*mat, 1, 3);
+         clip_w = MAT_ELEM_4X4(*mat, 3, 0) * x
+            + MAT_ELEM_4X4(*mat, 3, 1) * y + MAT_ELEM_4X4(*mat, 3, 3);
+
+         if (fabs(clip_w - 1.0f) > 0.0001f)
+            return false;
+
+         x = (clip_x + 1.0f) * 0.5f;
+         y = (clip_y + 1.0f) * 0.5f;
+
+         if (flip_y)
+            y = 1.0f - y;
+      }
+
+      /* Anything clipped by its own viewport is drawn directly,
+       * since the shared full-screen viewport would not clip it. */
+      if (x < -0.0001f || x > 1.0001f || y < -0.0001f || y > 1.0001f)
+         return false;
+
+      quad[i * 2 + 0] = (draw->x + x * draw->width)
+         / menu_disp_batch_width;
+      quad[i * 2 + 1] = (draw->y + y * draw->height)
+         / menu_disp_batch_height;
+   }
+
+   if (menu_disp_batch_ca.coords.vertices
+         && (   menu_disp_batch_texture != draw->texture
+             || menu_disp_batch_blend   != menu_disp_blend))
+      menu_display_batch_flush();
+
+   menu_disp_batch_texture = draw->texture;
+   menu_disp_batch_blend   = menu_disp_blend;
+
+   for (i = 0; i < 6; i++)
+   {
+      unsigned j = strip_to_list[i];
+
+      vertex[i * 2 + 0]    = quad[j * 2 + 0];
+      vertex[i * 2 + 1]    = quad[j * 2 + 1];
+      tex_coord[i * 2 + 0] = src_tex_coord[j * 2 + 0];
+      tex_coord[i * 2 + 1] = src_tex_coord[j * 2 + 1];
+      memcpy(&color[i * 4], &draw->coords->color[j * 4], 4 * sizeof(float));
+   }
+
+   coords.vertices      = 6;
+   coords.vertex        = vertex;
+   coords.tex_coord     = tex_coord;
+   coords.lut_tex_coord = tex_coord;
+   coords.color         = color;
+
+   return video_coord_array_append(&menu_disp_batch_ca, &coords, 6);
+}
+
+static bool menu_display_batch_font_bound(const font_data_t *font)
+{
+   unsigned i;
+
+   for (i = 0; i < MENU_DISPLAY_BATCH_MAX_FONTS; i++)
+      if (font && menu_disp_batch_fonts[i] == font)
+         return true;
+   return false;
 }
 
 void menu_display_font_free(font_data_t *font)
@@ -244,14 +481,34 @@ font_data_t *menu_display_font_main_init(menu_display_ctx_font_t *font)
 
 void menu_display_font_bind_block(font_data_t *font, void *block)
 {
+   unsigned i;
+
+   /* Text going into a block is not drawn yet,
+    * so it does not need to break the current batch. */
+   for (i = 0; i < MENU_DISPLAY_BATCH_MAX_FONTS; i++)
+   {
+      if (menu_disp_batch_fonts[i] == font)
+         menu_disp_batch_fonts[i] = NULL;
+   }
+
+   for (i = 0; block && i < MENU_DISPLAY_BATCH_MAX_FONTS; i++)
+   {
+      if (!menu_disp_batch_fonts[i])
+      {
+         menu_disp_batch_fonts[i] = font;
+         break;
+      }
+   }
+
    font_driver_bind_block(font, block);
 }
 
 bool menu_display_font_flush_block(unsigned width, unsigned height,
       font_data_t *font)
 {
+   menu_display_batch_flush();
    font_driver_flush(width, height, font);
-   font_driver_bind_block(font, NULL);
+   menu_display_font_bind_block(font, NULL);
    return true;
 }
 
@@ -268,6 +525,10 @@ void menu_display_deinit(void)
       msg_queue_free(menu_display_msg_queue);
 
    video_coord_array_free(&menu_disp_ca);
+   video_coord_array_free(&menu_disp_batch_ca);
+   memset(menu_disp_batch_fonts, 0, sizeof(menu_disp_batch_fonts));
+   menu_disp_batch_enable       = false;
+   menu_disp_blend_deferred     = false;
    menu_display_msg_queue       = NULL;
    menu_display_msg_force       = false;
    menu_display_header_height   = 0;
@@ -281,6 +542,7 @@ bool menu_display_init(void)
 {
    menu_display_msg_queue  = msg_queue_new(8);
    menu_disp_ca.allocated  =  0;
+   menu_disp_batch_ca.allocated = 0;
    return true;
 }
 
@@ -405,11 +667,19 @@ bool menu_display_get_update_pending(void)
 
 void menu_display_set_viewport(unsigned width, unsigned height)
 {
+   menu_display_batch_flush();
    video_driver_set_viewport(width, height, true, false);
+
+   menu_disp_batch_width  = width;
+   menu_disp_batch_height = height;
+   menu_disp_batch_enable = width && height
+      && menu_display_batch_supported();
 }
 
 void menu_display_unset_viewport(unsigned width, unsigned height)
 {
+   menu_display_batch_flush();
+   menu_disp_batch_enable = false;
    video_driver_set_viewport(width, height, false, true);
 }
 
@@ -478,6 +748,7 @@ void menu_display_clear_color(menu_display_ctx_clearcolor_t *color)
 {
    if (!menu_disp || !menu_disp->clear_color)
       return;
+   menu_display_batch_flush();
    menu_disp->clear_color(color);
 }
 
@@ -490,6 +761,10 @@ void menu_display_draw(menu_display_ctx_draw_t *draw)
    if (draw->height <= 0)
       draw->height = 1;
 
+   if (menu_display_batch_push(draw))
+      return;
+
+   menu_display_batch_flush();
    menu_disp->draw(draw);
 }
 
@@ -497,6 +772,7 @@ void menu_display_draw_pipeline(menu_display_ctx_draw_t *draw)
 {
    if (!menu_disp || !draw || !menu_disp->draw_pipeline)
       return;
+   menu_display_batch_flush();
    menu_disp->draw_pipeline(draw);
 }
 
@@ -896,6 +1172,9 @@ void menu_display_draw_text(
       params.drop_alpha  = 0.35f;
    }
 
+   if (!menu_display_batch_font_bound(font))
+      menu_display_batch_flush();
+
    video_driver_set_osd_msg(text, &params, (void*)font);
 }
 
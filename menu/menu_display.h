@@ -199,6 +199,7 @@ void menu_display_toggle_set_reason(enum menu_toggle_reason reason);
 
 void menu_display_blend_begin(void);
 void menu_display_blend_end(void);
+void menu_display_batch_flush(void);
 
 void menu_display_font_free(font_data_t *font);
 font_data_t *menu_display_font_main_init(menu_display_ctx_font_t *font);
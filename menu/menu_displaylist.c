@@ -1412,11 +1412,165 @@ static int menu_displaylist_parse_system_info(menu_displaylist_info_t *info)
    return 0;
 }
 
+typedef struct menu_displaylist_playlist_provider
+{
+   playlist_t *playlist;
+   bool is_history;
+   char path_playlist[PATH_MAX_LENGTH];
+} menu_displaylist_playlist_provider_t;
+
+/* Deferred playlist entries look their data up again when
+ * they are materialized, so make sure the playlist they
+ * were built from hasn't been unloaded in the meantime. */
+static bool menu_displaylist_playlist_is_live(playlist_t *playlist)
+{
+   playlist_t *menu_playlist = NULL;
+
+   if (!playlist)
+      return false;
+
+   menu_driver_ctl(RARCH_MENU_CTL_PLAYLIST_GET, &menu_playlist);
+
+   if (playlist == menu_playlist)
+      return true;
+   if (playlist == g_defaults.content_history)
+      return true;
+#ifdef HAVE_IMAGEVIEWER
+   if (playlist == g_defaults.image_history)
+      return true;
+#endif
+#ifdef HAVE_FFMPEG
+   if (playlist == g_defaults.video_history)
+      return true;
+   if (playlist == g_defaults.music_history)
+      return true;
+#endif
+
+   return false;
+}
+
+static void menu_displaylist_playlist_fill_label(char *s, size_t len,
+      const char *path, const char *label, const char *core_name)
+{
+   s[0] = '\0';
+
+   if (core_name)
+      strlcpy(s, core_name, len);
+
+   if (path)
+   {
+      char path_short[PATH_MAX_LENGTH];
+
+      path_short[0] = '\0';
+
+      fill_short_pathname_representation(path_short, path,
+            sizeof(path_short));
+      strlcpy(s,
+            (!string_is_empty(label)) ? label : path_short,
+            len);
+
+      if (!string_is_empty(core_name))
+      {
+         if (!string_is_equal(core_name,
+                  file_path_str(FILE_PATH_DETECT)))
+         {
+            char tmp[PATH_MAX_LENGTH];
+
+            tmp[0] = '\0';
+
+            snprintf(tmp, sizeof(tmp), " (%s)", core_name);
+            strlcat(s, tmp, len);
+         }
+      }
+   }
+}
+
+static void menu_displaylist_playlist_fetch(file_list_t *list,
+      size_t idx, void *data)
+{
+   char fill_buf[PATH_MAX_LENGTH];
+   size_t entry_idx                           = 0;
+   const char *core_name                      = NULL;
+   const char *path                           = NULL;
+   const char *label                          = NULL;
+   const char *entry_path                     = NULL;
+   const char *entry_label                    = NULL;
+   menu_displaylist_playlist_provider_t *prov =
+      (menu_displaylist_playlist_provider_t*)data;
+
+   fill_buf[0] = '\0';
+
+   file_list_get_at_offset(list, idx, NULL, NULL, NULL, &entry_idx);
+
+   if (     menu_displaylist_playlist_is_live(prov->playlist)
+         && entry_idx < playlist_size(prov->playlist))
+      playlist_get_index(prov->playlist, entry_idx,
+            &path, &label, NULL, &core_name, NULL, NULL);
+
+   if (!path || prov->is_history)
+      menu_displaylist_playlist_fill_label(fill_buf, sizeof(fill_buf),
+            path, label, core_name);
+
+   if (!path)
+   {
+      entry_path  = fill_buf;
+      entry_label = prov->path_playlist;
+   }
+   else if (prov->is_history)
+   {
+      entry_path  = fill_buf;
+      entry_label = path;
+   }
+   else
+   {
+      entry_path  = label;
+      entry_label = path;
+   }
+
+   if (entry_path)
+      list->list[idx].path  = strdup(entry_path);
+   list->list[idx].label    = strdup(entry_label);
+
+   menu_entries_init_actiondata(list, idx, MENU_ENUM_LABEL_PLAYLIST_ENTRY);
+}
+
+static const char *menu_displaylist_playlist_fetch_alt(
+      const file_list_t *list, size_t idx, void *data)
+{
+   size_t entry_idx                           = 0;
+   const char *path                           = NULL;
+   const char *label                          = NULL;
+   menu_displaylist_playlist_provider_t *prov =
+      (menu_displaylist_playlist_provider_t*)data;
+
+   file_list_get_at_offset(list, idx, NULL, NULL, NULL, &entry_idx);
+
+   if (     !menu_displaylist_playlist_is_live(prov->playlist)
+         || entry_idx >= playlist_size(prov->playlist))
+      return NULL;
+
+   playlist_get_index(prov->playlist, entry_idx,
+         &path, &label, NULL, NULL, NULL, NULL);
+
+   if (!string_is_empty(label))
+      return label;
+   return path;
+}
+
+/**
+ * menu_displaylist_parse_playlist:
+ *
+ * Playlist entries are appended deferred: only their type
+ * is known up front, their path/label and action callbacks
+ * are built by menu_displaylist_playlist_fetch once they
+ * are about to be displayed.
+ **/
 static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
       playlist_t *playlist, const char *path_playlist, bool is_history)
 {
    unsigned i;
-   size_t list_size = 0;
+   size_t list_size                           = 0;
+   menu_displaylist_playlist_provider_t *prov = NULL;
 
    if (!playlist)
       return -1;
@@ -1433,62 +1587,29 @@ static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
       return 0;
    }
 
-   for (i = 0; i < list_size; i++)
-   {
-      char fill_buf[PATH_MAX_LENGTH];
-      char path_copy[PATH_MAX_LENGTH];
-      const char *core_name           = NULL;
-      const char *path                = NULL;
-      const char *label               = NULL;
-
-      fill_buf[0] = path_copy[0]      = '\0';
+   prov = (menu_displaylist_playlist_provider_t*)calloc(1, sizeof(*prov));
 
-      strlcpy(path_copy, info->path, sizeof(path_copy));
-
-      path = path_copy;
-
-      playlist_get_index(playlist, i,
-            &path, &label, NULL, &core_name, NULL, NULL);
-
-      if (core_name)
-         strlcpy(fill_buf, core_name, sizeof(fill_buf));
-
-      if (path)
-      {
-         char path_short[PATH_MAX_LENGTH];
-
-         path_short[0] = '\0';
+   if (!prov)
+      return -1;
 
-         fill_short_pathname_representation(path_short, path,
-               sizeof(path_short));
-         strlcpy(fill_buf,
-               (!string_is_empty(label)) ? label : path_short,
-               sizeof(fill_buf));
+   prov->playlist   = playlist;
+   prov->is_history = is_history;
+   strlcpy(prov->path_playlist, path_playlist, sizeof(prov->path_playlist));
 
-         if (!string_is_empty(core_name))
-         {
-            if (!string_is_equal(core_name,
-                     file_path_str(FILE_PATH_DETECT)))
-            {
-               char tmp[PATH_MAX_LENGTH];
+   file_list_set_fetch_cb(info->list,
+         menu_displaylist_playlist_fetch,
+         menu_displaylist_playlist_fetch_alt,
+         free, prov);
 
-               tmp[0] = '\0';
+   for (i = 0; i < list_size; i++)
+   {
+      const char *path                = NULL;
 
-               snprintf(tmp, sizeof(tmp), " (%s)", core_name);
-               strlcat(fill_buf, tmp, sizeof(fill_buf));
-            }
-         }
-      }
+      playlist_get_index(playlist, i,
+            &path, NULL, NULL, NULL, NULL, NULL);
 
-      if (!path)
-         menu_entries_append_enum(info->list, fill_buf, path_playlist,
-               MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_PLAYLIST_ENTRY, 0, i);
-      else if (is_history)
-         menu_entries_append_enum(info->list, fill_buf,
-               path, MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_RPL_ENTRY, 0, i);
-      else
-         menu_entries_append_enum(info->list, label,
-               path, MENU_ENUM_LABEL_PLAYLIST_ENTRY, FILE_TYPE_RPL_ENTRY, 0, i);
+      menu_entries_append_deferred(info->list, NULL, NULL,
+            path ? FILE_TYPE_RPL_ENTRY : FILE_TYPE_PLAYLIST_ENTRY, 0, i);
    }
 
    return 0;
@@ -4344,6 +4465,9 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
          ret = menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_PLAYLIST_ENTRY_REMOVE,
                PARSE_ONLY_BOOL, false);			   
+         ret = menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_PLAYLIST_BINARY_FORMAT,
+               PARSE_ONLY_BOOL, false);
 
          menu_displaylist_parse_playlist_associations(info);
          info->need_push    = true;
@@ -4439,6 +4563,9 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_SAVESTATE_THUMBNAIL_ENABLE,
                PARSE_ONLY_BOOL, false);
+         menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION,
+               PARSE_ONLY_BOOL, false);
 
          info->need_refresh = true;
          info->need_push    = true;
@@ -4817,6 +4944,14 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
                   MENU_ENUM_LABEL_NETPLAY_STATELESS_MODE,
                   PARSE_ONLY_BOOL, false) != -1)
                count++;
+            if (menu_displaylist_parse_settings_enum(menu, info,
+                  MENU_ENUM_LABEL_NETPLAY_SPECTATOR_RELAY,
+                  PARSE_ONLY_BOOL, false) != -1)
+               count++;
+            if (menu_displaylist_parse_settings_enum(menu, info,
+                  MENU_ENUM_LABEL_NETPLAY_RELAY_KEYFRAME_INTERVAL,
+                  PARSE_ONLY_UINT, false) != -1)
+               count++;
             if (menu_displaylist_parse_settings_enum(menu, info,
                   MENU_ENUM_LABEL_NETPLAY_CHECK_FRAMES,
                   PARSE_ONLY_INT, false) != -1)
@@ -5156,12 +5291,21 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_VIDEO_FRAME_DELAY,
                PARSE_ONLY_UINT, false);
+         menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_RUN_AHEAD_ENABLED,
+               PARSE_ONLY_BOOL, false);
+         menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,
+               PARSE_ONLY_UINT, false);
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_VIDEO_BLACK_FRAME_INSERTION,
                PARSE_ONLY_BOOL, false);
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_VIDEO_GPU_SCREENSHOT,
                PARSE_ONLY_BOOL, false);
+         menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_SCREENSHOT_COMPRESSION_LEVEL,
+               PARSE_ONLY_UINT, false);
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_VIDEO_CROP_OVERSCAN,
                PARSE_ONLY_BOOL, false);
@@ -5214,6 +5358,9 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_DELTA,
                PARSE_ONLY_FLOAT, false);
+         menu_displaylist_parse_settings_enum(menu, info,
+               MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_ADAPTIVE,
+               PARSE_ONLY_BOOL, false);
          menu_displaylist_parse_settings_enum(menu, info,
                MENU_ENUM_LABEL_AUDIO_MAX_TIMING_SKEW,
                PARSE_ONLY_FLOAT, false);
@@ -5353,7 +5500,8 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
       case DISPLAYLIST_HORIZONTAL:
          ret = menu_displaylist_parse_horizontal_list(info);
 
-         info->need_sort    = true;
+         /* playlist_qsort already ordered the (deferred)
+          * entries by label. */
          info->need_refresh = true;
          info->need_push    = true;
          break;
@@ -5674,9 +5822,10 @@ bool menu_displaylist_ctl(enum menu_displaylist_ctl_state type, void *data)
             ret = menu_displaylist_parse_playlist(info,
                   playlist, path_playlist, false);
 
+            /* playlist_qsort already ordered the (deferred)
+             * entries by label. */
             if (ret == 0)
             {
-               info->need_sort    = true;
                info->need_refresh = true;
                info->need_push    = true;
             }
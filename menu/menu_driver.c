@@ -305,7 +305,10 @@ const char *menu_driver_ident(void)
 void menu_driver_frame(video_frame_info_t *video_info)
 {
    if (menu_driver_alive && menu_driver_ctx->frame)
+   {
       menu_driver_ctx->frame(menu_userdata, video_info);
+      menu_display_batch_flush();
+   }
 }
 
 /**
@@ -361,6 +364,8 @@ bool menu_driver_render(bool is_idle)
 
       if (menu_driver_ctx->render)
          menu_driver_ctx->render(menu_userdata);
+
+      menu_entries_release_deferred();
    }
 
    if (menu_driver_alive && !is_idle)
@@ -31,6 +31,13 @@
 #include "../runloop.h"
 #include "../version.h"
 
+/* Number of entries on each side of the selection that
+ * stay materialized in a deferred list. */
+#define MENU_ENTRIES_DEFERRED_MARGIN 64
+
+/* Selection the deferred window was last released around. */
+static size_t menu_entries_deferred_selection = (size_t)-1;
+
 void menu_entries_get_at_offset(const file_list_t *list, size_t idx,
       const char **path, const char **label, unsigned *file_type,
       size_t *entry_idx, const char **alt)
@@ -71,6 +78,9 @@ static bool menu_entries_clear(file_list_t *list)
 
    menu_driver_ctl(RARCH_MENU_CTL_LIST_CLEAR, list);
 
+   /* The rebuilt list needs its window released again. */
+   menu_entries_deferred_selection = (size_t)-1;
+
    for (i = 0; i < list->size; i++)
       file_list_free_actiondata(list, i);
 
@@ -389,7 +399,6 @@ void menu_entries_append_enum(file_list_t *list, const char *path, const char *l
    menu_ctx_list_t list_info;
    size_t idx;
    const char *menu_path           = NULL;
-   menu_file_list_cbs_t *cbs       = NULL;
    if (!list || !label)
       return;
 
@@ -413,6 +422,70 @@ void menu_entries_append_enum(file_list_t *list, const char *path, const char *l
    if (list_info.fullpath)
       free(list_info.fullpath);
 
+   menu_entries_init_actiondata(list, idx, enum_idx);
+}
+
+/**
+ * menu_entries_append_deferred:
+ * @list                     : File list handle.
+ * @path                     : Path of entry, or NULL if it is fetched.
+ * @label                    : Label of entry, or NULL if it is fetched.
+ *
+ * Like menu_entries_append_enum, but the entry's action
+ * callbacks (and its path/label if both are NULL) are only
+ * set up once the entry is accessed, through the fetch
+ * callback installed on @list with file_list_set_fetch_cb.
+ * The fetch callback is expected to call
+ * menu_entries_init_actiondata.
+ **/
+void menu_entries_append_deferred(file_list_t *list,
+      const char *path, const char *label,
+      unsigned type, size_t directory_ptr, size_t entry_idx)
+{
+   menu_ctx_list_t list_info;
+   const char *menu_path           = NULL;
+   if (!list)
+      return;
+
+   file_list_append_deferred(list, path, label, type,
+         directory_ptr, entry_idx);
+
+   menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
+
+   list_info.fullpath    = NULL;
+
+   if (!string_is_empty(menu_path))
+      list_info.fullpath = strdup(menu_path);
+   list_info.list        = list;
+   list_info.path        = path;
+   list_info.label       = label;
+   list_info.idx         = list->size - 1;
+
+   menu_driver_ctl(RARCH_MENU_CTL_LIST_INSERT, &list_info);
+
+   if (list_info.fullpath)
+      free(list_info.fullpath);
+}
+
+/**
+ * menu_entries_init_actiondata:
+ * @list                     : File list handle.
+ * @idx                      : Index of entry.
+ * @enum_idx                 : Enum label of entry.
+ *
+ * Allocates the action callbacks of entry @idx
+ * based on its current path, label and type.
+ **/
+void menu_entries_init_actiondata(file_list_t *list, size_t idx,
+      enum msg_hash_enums enum_idx)
+{
+   unsigned type                   = 0;
+   const char *path                = NULL;
+   const char *label               = NULL;
+   menu_file_list_cbs_t *cbs       = NULL;
+
+   file_list_get_at_offset(list, idx, &path, &label, &type, NULL);
+
    file_list_free_actiondata(list, idx);
    cbs = (menu_file_list_cbs_t*)
       calloc(1, sizeof(menu_file_list_cbs_t));
@@ -428,6 +501,36 @@ void menu_entries_append_enum(file_list_t *list, const char *path, const char *l
    menu_cbs_init(list, cbs, path, label, type, idx);
 }
 
+/**
+ * menu_entries_release_deferred:
+ *
+ * Drops the fetched data of deferred entries which are
+ * further than MENU_ENTRIES_DEFERRED_MARGIN entries away
+ * from the current selection. Only does work when the
+ * selection has moved since the last call.
+ **/
+void menu_entries_release_deferred(void)
+{
+   size_t selection               = 0;
+   size_t first                   = 0;
+   file_list_t *selection_buf     = menu_entries_get_selection_buf_ptr(0);
+
+   if (!selection_buf || !selection_buf->fetch_cb)
+      return;
+   if (!menu_navigation_ctl(MENU_NAVIGATION_CTL_GET_SELECTION, &selection))
+      return;
+   if (selection == menu_entries_deferred_selection)
+      return;
+
+   menu_entries_deferred_selection = selection;
+
+   if (selection > MENU_ENTRIES_DEFERRED_MARGIN)
+      first = selection - MENU_ENTRIES_DEFERRED_MARGIN;
+
+   file_list_release_deferred(selection_buf, first,
+         selection + MENU_ENTRIES_DEFERRED_MARGIN);
+}
+
 void menu_entries_prepend(file_list_t *list, const char *path, const char *label,
       enum msg_hash_enums enum_idx,
       unsigned type, size_t directory_ptr, size_t entry_idx)
@@ -185,6 +185,15 @@ void menu_entries_append_enum(file_list_t *list, const char *path, const char *l
       enum msg_hash_enums enum_idx,
       unsigned type, size_t directory_ptr, size_t entry_idx);
 
+void menu_entries_append_deferred(file_list_t *list,
+      const char *path, const char *label,
+      unsigned type, size_t directory_ptr, size_t entry_idx);
+
+void menu_entries_init_actiondata(file_list_t *list, size_t idx,
+      enum msg_hash_enums enum_idx);
+
+void menu_entries_release_deferred(void);
+
 bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data);
 
 RETRO_END_DECLS
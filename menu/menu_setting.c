@@ -2923,7 +2923,7 @@ static bool setting_append_list(
       case SETTINGS_LIST_SAVING:
          {
             unsigned i;
-            struct bool_entry bool_entries[7];
+            struct bool_entry bool_entries[8];
 
             START_GROUP(list, list_info, &group_info, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_SAVING_SETTINGS), parent_group);
             parent_group = msg_hash_to_str(MENU_ENUM_LABEL_SAVING_SETTINGS);
@@ -2973,6 +2973,12 @@ static bool setting_append_list(
             bool_entries[6].default_value  = savestate_thumbnail_enable;
             bool_entries[6].flags          = SD_FLAG_ADVANCED;
 
+            bool_entries[7].target         = &settings->savestate_file_compression;
+            bool_entries[7].name_enum_idx  = MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION;
+            bool_entries[7].SHORT_enum_idx = MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_COMPRESSION;
+            bool_entries[7].default_value  = savestate_file_compression;
+            bool_entries[7].flags          = SD_FLAG_ADVANCED;
+
             for (i = 0; i < ARRAY_SIZE(bool_entries); i++)
             {
                CONFIG_BOOL(
@@ -3572,6 +3578,35 @@ static bool setting_append_list(
                general_read_handler);
          menu_settings_list_current_add_range(list, list_info, 0, 15, 1, true, true);
 
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->run_ahead_enabled,
+               MENU_ENUM_LABEL_RUN_AHEAD_ENABLED,
+               MENU_ENUM_LABEL_VALUE_RUN_AHEAD_ENABLED,
+               run_ahead_enabled,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_NONE
+               );
+
+         CONFIG_UINT(
+               list, list_info,
+               &settings->run_ahead_frames,
+               MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,
+               MENU_ENUM_LABEL_VALUE_RUN_AHEAD_FRAMES,
+               run_ahead_frames,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler);
+         menu_settings_list_current_add_range(list, list_info, 1, 6, 1, true, true);
+
 #if !defined(RARCH_MOBILE)
          CONFIG_BOOL(
                list, list_info,
@@ -3615,6 +3650,20 @@ static bool setting_append_list(
                );
          settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+         CONFIG_UINT(
+               list, list_info,
+               &settings->screenshot_compression_level,
+               MENU_ENUM_LABEL_SCREENSHOT_COMPRESSION_LEVEL,
+               MENU_ENUM_LABEL_VALUE_SCREENSHOT_COMPRESSION_LEVEL,
+               screenshot_compression_level,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler);
+         menu_settings_list_current_add_range(list, list_info, 1, 9, 1, true, true);
+         settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
          CONFIG_BOOL(
                list, list_info,
                &settings->video.crop_overscan,
@@ -3786,6 +3835,22 @@ static bool setting_append_list(
                false);
          settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
 
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->audio.rate_control_adaptive,
+               MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_ADAPTIVE,
+               MENU_ENUM_LABEL_VALUE_AUDIO_RATE_CONTROL_ADAPTIVE,
+               rate_control_adaptive,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_ADVANCED
+               );
+
          CONFIG_FLOAT(
                list, list_info,
                &settings->audio.max_timing_skew,
@@ -5456,6 +5521,21 @@ static bool setting_append_list(
                general_write_handler,
                general_read_handler,
                SD_FLAG_NONE);
+
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->playlist_binary_format,
+               MENU_ENUM_LABEL_PLAYLIST_BINARY_FORMAT,
+               MENU_ENUM_LABEL_VALUE_PLAYLIST_BINARY_FORMAT,
+               def_playlist_binary_format,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_ADVANCED);
 		 
          END_SUB_GROUP(list, list_info, parent_group);
 		 
@@ -5676,6 +5756,35 @@ static bool setting_append_list(
                   general_read_handler,
                   SD_FLAG_NONE);
 
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->netplay.spectator_relay,
+                  MENU_ENUM_LABEL_NETPLAY_SPECTATOR_RELAY,
+                  MENU_ENUM_LABEL_VALUE_NETPLAY_SPECTATOR_RELAY,
+                  netplay_spectator_relay,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_NONE);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->netplay.relay_keyframe_interval,
+                  MENU_ENUM_LABEL_NETPLAY_RELAY_KEYFRAME_INTERVAL,
+                  MENU_ENUM_LABEL_VALUE_NETPLAY_RELAY_KEYFRAME_INTERVAL,
+                  netplay_relay_keyframe_interval,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            menu_settings_list_current_add_range(list, list_info, 60, 3600, 60, true, true);
+            settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
+
             CONFIG_INT(
                   list, list_info,
                   &settings->netplay.check_frames,
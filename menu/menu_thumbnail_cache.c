@@ -0,0 +1,243 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <retro_stat.h>
+#include <rhash.h>
+#include <string/stdstring.h>
+
+#include "menu_driver.h"
+#include "menu_thumbnail_cache.h"
+
+#include "../gfx/video_driver.h"
+#include "../tasks/tasks_internal.h"
+
+#define MENU_THUMBNAIL_CACHE_SIZE 32
+
+typedef struct menu_thumbnail
+{
+   char *path;
+   uint32_t hash;
+   uintptr_t texture;
+   unsigned width;
+   unsigned height;
+   unsigned last_used;
+   /* For failed decodes, the file's mtime at the time,
+    * so they are retried once the file changes. */
+   int64_t mtime;
+} menu_thumbnail_t;
+
+static menu_thumbnail_t menu_thumbnails[MENU_THUMBNAIL_CACHE_SIZE];
+static unsigned menu_thumbnails_count        = 0;
+static unsigned menu_thumbnails_clock        = 0;
+static bool menu_thumbnails_busy             = false;
+static unsigned menu_thumbnails_generation   = 0;
+static struct string_list *menu_thumbnails_pending = NULL;
+
+static menu_thumbnail_t *menu_thumbnail_cache_find(const char *path)
+{
+   unsigned i;
+   uint32_t hash = djb2_calculate(path);
+
+   for (i = 0; i < menu_thumbnails_count; i++)
+   {
+      menu_thumbnail_t *thumb = &menu_thumbnails[i];
+
+      if (thumb->hash == hash && string_is_equal(thumb->path, path))
+         return thumb;
+   }
+
+   return NULL;
+}
+
+static void menu_thumbnail_cache_insert(const char *path,
+      struct texture_image *img)
+{
+   unsigned i;
+   menu_thumbnail_t *thumb = menu_thumbnail_cache_find(path);
+
+   if (!thumb)
+   {
+      if (menu_thumbnails_count < MENU_THUMBNAIL_CACHE_SIZE)
+         thumb = &menu_thumbnails[menu_thumbnails_count++];
+      else
+      {
+         /* Evict the least recently used. */
+         thumb = &menu_thumbnails[0];
+         for (i = 1; i < menu_thumbnails_count; i++)
+            if (menu_thumbnails[i].last_used < thumb->last_used)
+               thumb = &menu_thumbnails[i];
+      }
+
+      if (thumb->texture)
+         video_driver_texture_unload(&thumb->texture);
+      if (thumb->path)
+         free(thumb->path);
+
+      thumb->path    = strdup(path);
+      thumb->hash    = djb2_calculate(path);
+      thumb->texture = 0;
+   }
+
+   if (thumb->texture)
+      video_driver_texture_unload(&thumb->texture);
+
+   thumb->width     = 0;
+   thumb->height    = 0;
+   thumb->mtime     = -1;
+   thumb->last_used = ++menu_thumbnails_clock;
+
+   if (img->pixels && img->width && img->height)
+   {
+      thumb->width  = img->width;
+      thumb->height = img->height;
+      video_driver_texture_load(img,
+            TEXTURE_FILTER_MIPMAP_LINEAR, &thumb->texture);
+   }
+   else
+      thumb->mtime  = path_get_mtime(path);
+}
+
+static void menu_thumbnail_cache_push(struct string_list *paths);
+
+static void menu_thumbnail_cache_handle_upload(void *task_data,
+      void *user_data, const char *err)
+{
+   unsigned i;
+   image_batch_t *batch = (image_batch_t*)task_data;
+
+   /* Requested before the cache was last freed; its
+    * textures would outlive the context they're for. */
+   if ((unsigned)(uintptr_t)user_data != menu_thumbnails_generation)
+   {
+      task_image_batch_free(batch);
+      return;
+   }
+
+   menu_thumbnails_busy = false;
+
+   if (batch)
+   {
+      for (i = 0; i < batch->paths->size; i++)
+         menu_thumbnail_cache_insert(batch->paths->elems[i].data,
+               &batch->images[i]);
+      task_image_batch_free(batch);
+   }
+
+   if (menu_thumbnails_pending)
+   {
+      struct string_list *paths = menu_thumbnails_pending;
+      menu_thumbnails_pending   = NULL;
+      menu_thumbnail_cache_push(paths);
+   }
+
+   menu_driver_ctl(RARCH_MENU_CTL_UPDATE_THUMBNAIL_IMAGE, NULL);
+}
+
+static void menu_thumbnail_cache_push(struct string_list *paths)
+{
+   unsigned i;
+   union string_list_elem_attr attr;
+   struct string_list *missing = string_list_new();
+
+   attr.i = 0;
+
+   for (i = 0; missing && i < paths->size; i++)
+   {
+      const char *path        = paths->elems[i].data;
+      menu_thumbnail_t *thumb = NULL;
+
+      if (string_is_empty(path) || string_list_find_elem(missing, path))
+         continue;
+
+      thumb = menu_thumbnail_cache_find(path);
+      if (thumb && (thumb->width || path_get_mtime(path) == thumb->mtime))
+         continue;
+
+      if (path_file_exists(path))
+         string_list_append(missing, path, attr);
+   }
+
+   string_list_free(paths);
+
+   if (!missing || !missing->size)
+   {
+      string_list_free(missing);
+      return;
+   }
+
+   menu_thumbnails_busy = task_push_image_load_batch(missing,
+         menu_thumbnail_cache_handle_upload,
+         (void*)(uintptr_t)menu_thumbnails_generation);
+}
+
+bool menu_thumbnail_cache_get(const char *path, uintptr_t *texture,
+      unsigned *width, unsigned *height)
+{
+   menu_thumbnail_t *thumb = NULL;
+
+   if (string_is_empty(path))
+      return false;
+
+   thumb = menu_thumbnail_cache_find(path);
+   if (!thumb)
+      return false;
+
+   thumb->last_used = ++menu_thumbnails_clock;
+   *texture         = thumb->texture;
+   *width           = thumb->width;
+   *height          = thumb->height;
+   return true;
+}
+
+void menu_thumbnail_cache_request(struct string_list *paths)
+{
+   if (!paths)
+      return;
+
+   if (menu_thumbnails_busy)
+   {
+      string_list_free(menu_thumbnails_pending);
+      menu_thumbnails_pending = paths;
+      return;
+   }
+
+   menu_thumbnail_cache_push(paths);
+}
+
+void menu_thumbnail_cache_free(void)
+{
+   unsigned i;
+
+   for (i = 0; i < menu_thumbnails_count; i++)
+   {
+      if (menu_thumbnails[i].texture)
+         video_driver_texture_unload(&menu_thumbnails[i].texture);
+      free(menu_thumbnails[i].path);
+   }
+
+   memset(menu_thumbnails, 0, sizeof(menu_thumbnails));
+   menu_thumbnails_count = 0;
+
+   /* A batch still being decoded is dropped when it lands. */
+   menu_thumbnails_generation++;
+   menu_thumbnails_busy    = false;
+
+   string_list_free(menu_thumbnails_pending);
+   menu_thumbnails_pending = NULL;
+}
@@ -0,0 +1,65 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MENU_THUMBNAIL_CACHE_H
+#define _MENU_THUMBNAIL_CACHE_H
+
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <lists/string_list.h>
+
+RETRO_BEGIN_DECLS
+
+/**
+ * menu_thumbnail_cache_get:
+ * @path             : path of the thumbnail.
+ * @texture          : set to the texture, 0 if the image failed to decode.
+ * @width            : set to the width of the image.
+ * @height           : set to the height of the image.
+ *
+ * Looks up a decoded thumbnail. The texture belongs to the cache
+ * and stays valid until the next menu_thumbnail_cache_request
+ * callback or menu_thumbnail_cache_free.
+ *
+ * Returns: true if @path has been decoded.
+ **/
+bool menu_thumbnail_cache_get(const char *path, uintptr_t *texture,
+      unsigned *width, unsigned *height);
+
+/**
+ * menu_thumbnail_cache_request:
+ * @paths            : thumbnails to decode, most wanted first.
+ *                     The cache takes ownership.
+ *
+ * Decodes the thumbnails not cached yet in the background. Only one
+ * batch is decoded at a time; a request made meanwhile replaces the
+ * previous one. The menu driver's update_thumbnail_image is called
+ * once a batch is uploaded.
+ **/
+void menu_thumbnail_cache_request(struct string_list *paths);
+
+/**
+ * menu_thumbnail_cache_free:
+ *
+ * Unloads all cached textures, for when the video context goes away.
+ * A batch still being decoded is discarded when it completes.
+ **/
+void menu_thumbnail_cache_free(void);
+
+RETRO_END_DECLS
+
+#endif
@@ -53,6 +53,44 @@ void filebrowser_set_type(enum filebrowser_enums type)
       filebrowser_types = type;
 }
 
+static enum msg_hash_enums filebrowser_type_to_enum(
+      enum msg_file_type file_type)
+{
+   switch (file_type)
+   {
+      case FILE_TYPE_MOVIE:
+         return MENU_ENUM_LABEL_FILE_BROWSER_MOVIE_OPEN;
+      case FILE_TYPE_MUSIC:
+         return MENU_ENUM_LABEL_FILE_BROWSER_MUSIC_OPEN;
+      case FILE_TYPE_IMAGE:
+         return MENU_ENUM_LABEL_FILE_BROWSER_IMAGE;
+      case FILE_TYPE_IMAGEVIEWER:
+         return MENU_ENUM_LABEL_FILE_BROWSER_IMAGE_OPEN_WITH_VIEWER;
+      case FILE_TYPE_DIRECTORY:
+         return MENU_ENUM_LABEL_FILE_BROWSER_DIRECTORY;
+      case FILE_TYPE_PLAIN:
+#if 0
+         return MENU_ENUM_LABEL_FILE_BROWSER_PLAIN_FILE;
+#endif
+      default:
+         break;
+   }
+
+   return MSG_UNKNOWN;
+}
+
+/* Directory entries keep their path/label, only their
+ * action callbacks are set up once they get displayed. */
+static void filebrowser_fetch(file_list_t *list, size_t idx, void *data)
+{
+   unsigned file_type = 0;
+
+   file_list_get_at_offset(list, idx, NULL, NULL, &file_type, NULL);
+
+   menu_entries_init_actiondata(list, idx,
+         filebrowser_type_to_enum((enum msg_file_type)file_type));
+}
+
 void filebrowser_parse(void *data, unsigned type_data)
 {
    size_t i, list_size;
@@ -109,6 +147,8 @@ void filebrowser_parse(void *data, unsigned type_data)
 
    dir_list_sort(str_list, true);
 
+   file_list_set_fetch_cb(info->list, filebrowser_fetch, NULL, NULL, NULL);
+
    list_size = str_list->size;
 
    if (list_size == 0)
@@ -122,7 +162,6 @@ void filebrowser_parse(void *data, unsigned type_data)
       {
          char label[PATH_MAX_LENGTH];
          bool is_dir                   = false;
-         enum msg_hash_enums enum_idx  = MSG_UNKNOWN;
          enum msg_file_type file_type  = FILE_TYPE_NONE;
          const char *path              = str_list->elems[i].data;
 
@@ -214,41 +253,14 @@ void filebrowser_parse(void *data, unsigned type_data)
             }
          }
 
-         switch (file_type)
-         {
-            case FILE_TYPE_PLAIN:
-#if 0
-               enum_idx = MENU_ENUM_LABEL_FILE_BROWSER_PLAIN_FILE;
-#endif
-               files_count++;
-               break;
-            case FILE_TYPE_MOVIE:
-               enum_idx = MENU_ENUM_LABEL_FILE_BROWSER_MOVIE_OPEN;
-               files_count++;
-               break;
-            case FILE_TYPE_MUSIC:
-               enum_idx = MENU_ENUM_LABEL_FILE_BROWSER_MUSIC_OPEN;
-               files_count++;
-               break;
-            case FILE_TYPE_IMAGE:
-               enum_idx = MENU_ENUM_LABEL_FILE_BROWSER_IMAGE;
-               files_count++;
-               break;
-            case FILE_TYPE_IMAGEVIEWER:
-               enum_idx = MENU_ENUM_LABEL_FILE_BROWSER_IMAGE_OPEN_WITH_VIEWER;
-               files_count++;
-               break;
-            case FILE_TYPE_DIRECTORY:
-               enum_idx = MENU_ENUM_LABEL_FILE_BROWSER_DIRECTORY;
-               dirs_count++;
-               break;
-            default:
-               break;
-         }
+         if (file_type == FILE_TYPE_DIRECTORY)
+            dirs_count++;
+         else if (file_type == FILE_TYPE_PLAIN
+               || filebrowser_type_to_enum(file_type) != MSG_UNKNOWN)
+            files_count++;
 
          items_found++;
-         menu_entries_append_enum(info->list, path, label,
-               enum_idx,
+         menu_entries_append_deferred(info->list, path, label,
                file_type, 0, 0);
       }
    }
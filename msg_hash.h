@@ -238,6 +238,10 @@ enum msg_hash_enums
    MSG_COULD_NOT_OPEN_DATA_TRACK,
    MSG_FOUND_FIRST_DATA_TRACK_ON_FILE,
    MSG_FRAMES,
+   MSG_AUDIO_BUFFER_FILL,
+   MSG_AUDIO_UNDERRUNS,
+   MSG_AUDIO_DRIFT,
+   MSG_RUN_AHEAD_DISABLED,
    MSG_FOUND_SHADER,
    MSG_LOADING_HISTORY_FILE,
    MSG_COULD_NOT_READ_STATE_FROM_MOVIE,
@@ -598,8 +602,11 @@ enum msg_hash_enums
    MENU_LABEL(VIDEO_SOFT_FILTER),
    MENU_LABEL(VIDEO_MAX_SWAPCHAIN_IMAGES),
    MENU_LABEL(VIDEO_GPU_SCREENSHOT),
+   MENU_LABEL(SCREENSHOT_COMPRESSION_LEVEL),
    MENU_LABEL(VIDEO_BLACK_FRAME_INSERTION),
    MENU_LABEL(VIDEO_FRAME_DELAY),
+   MENU_LABEL(RUN_AHEAD_ENABLED),
+   MENU_LABEL(RUN_AHEAD_FRAMES),
    MENU_LABEL(VIDEO_VSYNC),
    MENU_LABEL(VIDEO_HARD_SYNC),
    MENU_LABEL(VIDEO_HARD_SYNC_FRAMES),
@@ -705,6 +712,7 @@ enum msg_hash_enums
    MENU_LABEL(HISTORY_LIST_ENABLE),
    MENU_LABEL(CONTENT_HISTORY_SIZE),
    MENU_LABEL(PLAYLIST_ENTRY_REMOVE),
+   MENU_LABEL(PLAYLIST_BINARY_FORMAT),
    MENU_LABEL(MENU_THROTTLE_FRAMERATE),
    MENU_LABEL(NO_ACHIEVEMENTS_TO_DISPLAY),
    MENU_LABEL(NO_ENTRIES_TO_DISPLAY),
@@ -958,6 +966,7 @@ enum msg_hash_enums
    MENU_LABEL(AUDIO_SYNC),
    MENU_LABEL(AUDIO_VOLUME),
    MENU_LABEL(AUDIO_RATE_CONTROL_DELTA),
+   MENU_LABEL(AUDIO_RATE_CONTROL_ADAPTIVE),
    MENU_LABEL(AUDIO_LATENCY),
    MENU_LABEL(SAVE_STATE),
    MENU_LABEL(LOAD_STATE),
@@ -1001,6 +1010,7 @@ enum msg_hash_enums
    MENU_LABEL(SAVESTATE_AUTO_SAVE),
    MENU_LABEL(SAVESTATE_AUTO_LOAD),
    MENU_LABEL(SAVESTATE_THUMBNAIL_ENABLE),
+   MENU_LABEL(SAVESTATE_FILE_COMPRESSION),
 
    MENU_LABEL(SUSPEND_SCREENSAVER_ENABLE),
    MENU_LABEL(DPI_OVERRIDE_ENABLE),
@@ -1020,6 +1030,8 @@ enum msg_hash_enums
    MENU_LABEL(NETPLAY_DELAY_FRAMES),
    MENU_LABEL(NETPLAY_PUBLIC_ANNOUNCE),
    MENU_LABEL(NETPLAY_STATELESS_MODE),
+   MENU_LABEL(NETPLAY_SPECTATOR_RELAY),
+   MENU_LABEL(NETPLAY_RELAY_KEYFRAME_INTERVAL),
    MENU_LABEL(NETPLAY_CHECK_FRAMES),
    MENU_LABEL(NETPLAY_INPUT_LATENCY_FRAMES_MIN),
    MENU_LABEL(NETPLAY_INPUT_LATENCY_FRAMES_RANGE),
@@ -166,6 +166,41 @@ bool netplay_send(struct socket_buffer *sbuf, int sockfd, const void *buf,
    return netplay_send_flush(sbuf, sockfd, false);
 }
 
+/**
+ * netplay_send_queue
+ *
+ * Queue as much of the given data as fits in the buffer, without sending
+ * anything.
+ *
+ * Returns the number of bytes queued.
+ */
+size_t netplay_send_queue(struct socket_buffer *sbuf, const void *buf,
+   size_t len)
+{
+   size_t remaining = buf_remaining(sbuf);
+
+   if (len > remaining)
+      len = remaining;
+   if (len == 0)
+      return 0;
+
+   if (sbuf->bufsz - sbuf->end < len)
+   {
+      size_t chunka = sbuf->bufsz - sbuf->end,
+             chunkb = len - chunka;
+      memcpy(sbuf->data + sbuf->end, buf, chunka);
+      memcpy(sbuf->data, (const unsigned char *) buf + chunka, chunkb);
+      sbuf->end = chunkb;
+   }
+   else
+   {
+      memcpy(sbuf->data + sbuf->end, buf, len);
+      sbuf->end += len;
+   }
+
+   return len;
+}
+
 /**
  * netplay_send_flush
  *
@@ -16,13 +16,17 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include <boolean.h>
 #include <encodings/crc32.h>
+#include <rhash.h>
 
 #include "netplay_private.h"
 
+#include "../../managers/state_manager.h"
+
 /**
  * netplay_delta_frame_ready
  *
@@ -64,3 +68,196 @@ uint32_t netplay_delta_frame_crc(netplay_t *netplay, struct delta_frame *delta)
       return 0;
    return encoding_crc32(0L, (const unsigned char*)delta->state, netplay->state_size);
 }
+
+/**
+ * netplay_delta_frame_hash
+ *
+ * Get the xxHash64 for the serialization of this frame.
+ */
+uint64_t netplay_delta_frame_hash(netplay_t *netplay,
+   struct delta_frame *delta)
+{
+   if (!netplay->state_size)
+      return 0;
+   return xxh64_calculate((const uint8_t*)delta->state, netplay->state_size, 0);
+}
+
+/**
+ * netplay_delta_find_frame
+ *
+ * Find the delta frame holding the given frame, if we still have it.
+ *
+ * Returns: The delta frame, or NULL if it's no longer in the buffer.
+ */
+struct delta_frame *netplay_delta_find_frame(netplay_t *netplay,
+   uint32_t frame)
+{
+   size_t i;
+   for (i = 0; i < netplay->buffer_size; i++)
+   {
+      struct delta_frame *delta = &netplay->buffer[i];
+      if (delta->used && delta->frame == frame && delta->state &&
+          !delta->state_stale)
+         return delta;
+   }
+   return NULL;
+}
+
+/**
+ * netplay_delta_init_patch_buffers
+ *
+ * Allocate the buffers used to encode and decode delta savestates, if they
+ * haven't already been.
+ *
+ * Returns: True if the buffers are ready.
+ */
+bool netplay_delta_init_patch_buffers(netplay_t *netplay)
+{
+   if (netplay->delta_patch)
+      return true;
+   if (!netplay->state_size)
+      return false;
+
+   /* The encoder needs two buffers with differing sentinels at the end */
+   netplay->delta_src        = state_manager_raw_alloc(netplay->state_size, 0);
+   netplay->delta_dst        = state_manager_raw_alloc(netplay->state_size, 1);
+   netplay->delta_patch_size = state_manager_raw_maxsize(netplay->state_size);
+   netplay->delta_patch      = (uint16_t*)malloc(netplay->delta_patch_size);
+
+   if (!netplay->delta_src || !netplay->delta_dst || !netplay->delta_patch)
+   {
+      free(netplay->delta_src);
+      free(netplay->delta_dst);
+      free(netplay->delta_patch);
+      netplay->delta_src        = NULL;
+      netplay->delta_dst        = NULL;
+      netplay->delta_patch      = NULL;
+      netplay->delta_patch_size = 0;
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * netplay_delta_encode_state
+ *
+ * Encode the patch turning the state in base into the state in target, with
+ * its framing in network byte order.
+ *
+ * Returns: The size of the patch in netplay->delta_patch, or 0 on failure.
+ */
+size_t netplay_delta_encode_state(netplay_t *netplay,
+   const void *target, const void *base)
+{
+   uint16_t *patch16, *end16;
+   size_t patch_size;
+
+   if (!netplay_delta_init_patch_buffers(netplay))
+      return 0;
+
+   /* The rewind encoder records the words of its first argument wherever the
+    * two differ, so applying the patch to base yields target */
+   memcpy(netplay->delta_src, target, netplay->state_size);
+   memcpy(netplay->delta_dst, base, netplay->state_size);
+   patch_size = state_manager_raw_compress(netplay->delta_src,
+      netplay->delta_dst, netplay->state_size, netplay->delta_patch);
+
+   /* The changed words are raw state bytes, but the framing is in host
+    * order, so convert it */
+   patch16 = netplay->delta_patch;
+   end16   = patch16 + patch_size / sizeof(uint16_t);
+   while (patch16 < end16)
+   {
+      uint16_t numchanged = patch16[0];
+      patch16[0] = htons(numchanged);
+
+      if (numchanged)
+      {
+         patch16[1] = htons(patch16[1]);
+         patch16 += 2 + numchanged;
+      }
+      else
+      {
+         bool last  = !patch16[1] && !patch16[2];
+         patch16[1] = htons(patch16[1]);
+         patch16[2] = htons(patch16[2]);
+         patch16 += 3;
+         if (last)
+            break;
+      }
+   }
+
+   return patch_size;
+}
+
+/**
+ * netplay_delta_decode_state
+ *
+ * Validate a patch received from the network in netplay->delta_patch and
+ * apply it on top of the state in data.
+ *
+ * Returns: True if the patch was valid and applied.
+ */
+bool netplay_delta_decode_state(netplay_t *netplay, size_t patch_size,
+   void *data)
+{
+   uint16_t *patch16, *end16;
+   size_t state16s, out16 = 0;
+   bool terminated        = false;
+
+   if (!netplay->delta_patch || patch_size > netplay->delta_patch_size)
+      return false;
+
+   patch16  = netplay->delta_patch;
+   end16    = patch16 + patch_size / sizeof(uint16_t);
+   state16s = (netplay->state_size + sizeof(uint16_t) - 1) / sizeof(uint16_t);
+
+   /* Convert the framing back to host order, making sure that no part of the
+    * patch would write outside of the state */
+   while (patch16 < end16)
+   {
+      uint16_t numchanged = ntohs(patch16[0]);
+      patch16[0] = numchanged;
+
+      if (numchanged)
+      {
+         if (end16 - patch16 < 2)
+            break;
+         patch16[1] = ntohs(patch16[1]);
+         out16     += patch16[1] + numchanged;
+         patch16   += 2 + numchanged;
+         if (out16 > state16s || patch16 > end16)
+            break;
+      }
+      else
+      {
+         uint32_t numunchanged;
+         if (end16 - patch16 < 3)
+            break;
+         patch16[1]   = ntohs(patch16[1]);
+         patch16[2]   = ntohs(patch16[2]);
+         numunchanged = patch16[1] | ((uint32_t)patch16[2] << 16);
+         patch16     += 3;
+         if (!numunchanged)
+         {
+            terminated = true;
+            break;
+         }
+         out16 += numunchanged;
+         if (out16 > state16s)
+            break;
+      }
+   }
+
+   if (!terminated)
+      return false;
+
+   /* Apply it in the padded scratch buffer, as the last word may extend past
+    * the end of an odd-sized state */
+   memcpy(netplay->delta_dst, data, netplay->state_size);
+   state_manager_raw_decompress(netplay->delta_patch, patch_size,
+      netplay->delta_dst, netplay->state_size);
+   memcpy(data, netplay->delta_dst, netplay->state_size);
+   return true;
+}
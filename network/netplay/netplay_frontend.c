@@ -155,10 +155,15 @@ static bool get_self_input_state(netplay_t *netplay)
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
-      if (connection->active && connection->mode >= NETPLAY_CONNECTION_CONNECTED)
+      if (connection->active && connection->mode >= NETPLAY_CONNECTION_CONNECTED &&
+          !connection->relayed)
          netplay_send_cur_input(netplay, &netplay->connections[i]);
    }
 
+   /* Relayed spectators all get the same thing */
+   if (netplay->relay)
+      netplay_send_cur_input(netplay, NULL);
+
    return true;
 }
 
@@ -634,9 +639,11 @@ static void netplay_frontend_paused(netplay_t *netplay, bool paused)
                NULL, 0);
 
          /* We're not going to be polled, so we need to flush this command now */
-         netplay_send_flush(&connection->send_packet_buffer, connection->fd, true);
+         if (!connection->relayed)
+            netplay_send_flush(&connection->send_packet_buffer, connection->fd, true);
       }
    }
+   netplay_relay_flush(netplay);
 }
 
 /**
@@ -701,6 +708,15 @@ bool netplay_pre_frame(netplay_t *netplay)
       }
    }
 
+   /* A deep rollback didn't fit in the last frame, so finish it before
+    * running anything new */
+   if (netplay->replay_pending)
+   {
+      netplay_sync_post_frame(netplay, true);
+      netplay_relay_post_frame(netplay);
+      return false;
+   }
+
    sync_stalled = !netplay_sync_pre_frame(netplay);
 
    if (sync_stalled ||
@@ -710,6 +726,7 @@ bool netplay_pre_frame(netplay_t *netplay)
       /* We may have received data even if we're stalled, so run post-frame
        * sync */
       netplay_sync_post_frame(netplay, true);
+      netplay_relay_post_frame(netplay);
       return false;
    }
    return true;
@@ -729,11 +746,12 @@ void netplay_post_frame(netplay_t *netplay)
    retro_assert(netplay);
    netplay_update_unread_ptr(netplay);
    netplay_sync_post_frame(netplay, false);
+   netplay_relay_post_frame(netplay);
 
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
-      if (connection->active &&
+      if (connection->active && !connection->relayed &&
           !netplay_send_flush(&connection->send_packet_buffer, connection->fd,
             false))
          netplay_hangup(netplay, &netplay->connections[0]);
@@ -783,7 +801,9 @@ void netplay_send_savestate(netplay_t *netplay,
       struct netplay_connection *connection = &netplay->connections[i];
       if (!connection->active ||
           connection->mode < NETPLAY_CONNECTION_CONNECTED ||
-          connection->compression_supported != cx) continue;
+          connection->compression_supported != cx ||
+          connection->delta_base_valid ||
+          connection->relayed) continue;
 
       if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
             sizeof(header)) ||
@@ -791,6 +811,76 @@ void netplay_send_savestate(netplay_t *netplay,
             netplay->zbuffer, wn))
          netplay_hangup(netplay, connection);
    }
+
+   /* And once to the spectator relay, which uses a single compression */
+   if (netplay->relay && cx == netplay_relay_compression(netplay))
+   {
+      netplay_relay_queue(netplay, NULL, NULL, header, sizeof(header));
+      netplay_relay_queue(netplay, NULL, NULL, netplay->zbuffer, wn);
+   }
+}
+
+/**
+ * netplay_send_savestate_delta
+ * @netplay              : pointer to netplay object
+ * @serial_info          : the savestate being loaded
+ * @connection           : the connection to send it to
+ *
+ * Send a loaded savestate to a single peer as a delta against the last frame
+ * at which that peer confirmed our states matched.
+ *
+ * Returns: true if the delta was sent, false if the peer needs the full state.
+ */
+static bool netplay_send_savestate_delta(netplay_t *netplay,
+   retro_ctx_serialize_info_t *serial_info,
+   struct netplay_connection *connection)
+{
+   uint32_t header[6];
+   uint32_t rd, wn;
+   size_t patch_size;
+   enum trans_stream_error error;
+   struct delta_frame *base;
+   struct compression_transcoder *z = &netplay->compress_nil;
+
+   if (connection->compression_supported == NETPLAY_COMPRESSION_ZLIB)
+      z = &netplay->compress_zlib;
+
+   if (!z->compression_backend || serial_info->size != netplay->state_size)
+      return false;
+
+   /* Make sure we still have the base frame */
+   base = netplay_delta_find_frame(netplay, connection->delta_base_frame);
+   if (!base || base->frame > netplay->run_frame_count)
+      return false;
+
+   patch_size = netplay_delta_encode_state(netplay, serial_info->data_const,
+      base->state);
+   if (!patch_size)
+      return false;
+
+   /* Compress the patch */
+   z->compression_backend->set_in(z->compression_stream,
+      (const uint8_t*)netplay->delta_patch, patch_size);
+   z->compression_backend->set_out(z->compression_stream,
+      netplay->zbuffer, netplay->zbuffer_size);
+   if (!z->compression_backend->trans(z->compression_stream, true, &rd,
+         &wn, &error) || rd != patch_size)
+      return false;
+
+   header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE_DELTA);
+   header[1] = htonl(wn + 4*sizeof(uint32_t));
+   header[2] = htonl(netplay->run_frame_count);
+   header[3] = htonl(base->frame);
+   header[4] = htonl(netplay_delta_frame_crc(netplay, base));
+   header[5] = htonl(patch_size);
+
+   if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
+         sizeof(header)) ||
+       !netplay_send(&connection->send_packet_buffer, connection->fd,
+         netplay->zbuffer, wn))
+      netplay_hangup(netplay, connection);
+
+   return true;
 }
 
 /**
@@ -806,8 +896,12 @@ void netplay_send_savestate(netplay_t *netplay,
 void netplay_load_savestate(netplay_t *netplay,
       retro_ctx_serialize_info_t *serial_info, bool save)
 {
+   size_t i;
    retro_ctx_serialize_info_t tmp_serial_info;
 
+   /* Whatever replay was in progress is moot now */
+   netplay->replay_pending = false;
+
    /* Wherever we're inputting, that's where we consider our state to be loaded
     * (FIXME: Need to be more careful about saving it?) */
    netplay->run_ptr = netplay->self_ptr;
@@ -878,12 +972,25 @@ void netplay_load_savestate(netplay_t *netplay,
             | NETPLAY_QUIRK_NO_TRANSMISSION))
       return;
 
-   /* Send this to every peer */
+   /* Peers that asked to resync against a frame we agree on only need a
+    * delta. Any we can't do that for get the full state. */
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (connection->active && connection->delta_base_valid &&
+          !netplay_send_savestate_delta(netplay, serial_info, connection))
+         connection->delta_base_valid = false;
+   }
+
+   /* Send this to every other peer */
    if (netplay->compress_nil.compression_backend)
       netplay_send_savestate(netplay, serial_info, 0, &netplay->compress_nil);
    if (netplay->compress_zlib.compression_backend)
       netplay_send_savestate(netplay, serial_info, NETPLAY_COMPRESSION_ZLIB,
          &netplay->compress_zlib);
+
+   for (i = 0; i < netplay->connections_size; i++)
+      netplay->connections[i].delta_base_valid = false;
 }
 
 /**
@@ -1026,6 +1133,8 @@ bool init_netplay(void *direct_host, const char *server, unsigned port)
       quirks |= NETPLAY_QUIRK_ENDIAN_DEPENDENT;
    if (serialization_quirks & NETPLAY_QUIRK_MAP_PLATFORM_DEPENDENT)
       quirks |= NETPLAY_QUIRK_PLATFORM_DEPENDENT;
+   if (serialization_quirks & NETPLAY_QUIRK_MAP_VARIABLE_SIZE)
+      quirks |= NETPLAY_QUIRK_VARIABLE_SIZE;
 
    if (netplay_is_client)
    {
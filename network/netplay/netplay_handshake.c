@@ -374,6 +374,9 @@ bool netplay_handshake_init(netplay_t *netplay,
       }
       connection->compression_supported = 0;
    }
+   connection->delta_supported  = !!(compression & NETPLAY_COMPRESSION_DELTA);
+   connection->hash_xxh64       = !!(compression & NETPLAY_HASH_XXH64);
+   connection->delta_base_valid = false;
    if (!ctrans->decompression_backend)
       ctrans->decompression_backend = ctrans->compression_backend->reverse;
 
@@ -442,8 +445,9 @@ static void netplay_handshake_ready(netplay_t *netplay, struct netplay_connectio
    {
       netplay_log_connection(&connection->addr, connection - netplay->connections, connection->nick);
 
-      /* Send them the savestate */
-      if (!(netplay->quirks & (NETPLAY_QUIRK_NO_SAVESTATES|NETPLAY_QUIRK_NO_TRANSMISSION)))
+      /* Send them the savestate, unless the relay's keyframe does that */
+      if (!connection->relayed &&
+          !(netplay->quirks & (NETPLAY_QUIRK_NO_SAVESTATES|NETPLAY_QUIRK_NO_TRANSMISSION)))
       {
          netplay->force_send_savestate = true;
       }
@@ -517,7 +521,8 @@ bool netplay_handshake_sync(netplay_t *netplay, struct netplay_connection *conne
 {
    /* If we're the server, now we send sync info */
    uint32_t cmd[5];
-   uint32_t connected_players;
+   uint32_t frame, connected_players, flip_frame;
+   bool relay;
    settings_t *settings = config_get_ptr();
    size_t i;
    uint32_t device;
@@ -531,21 +536,27 @@ bool netplay_handshake_sync(netplay_t *netplay, struct netplay_connection *conne
    core_get_memory(&mem_info);
    autosave_unlock();
 
+   /* Spectators on the relay start from its last keyframe */
+   relay = netplay_relay_join_info(netplay, connection, &frame,
+      &connected_players, &flip_frame);
+   if (!relay)
+   {
+      frame = netplay->self_frame_count;
+      connected_players = netplay->connected_players;
+      if (netplay->self_mode == NETPLAY_CONNECTION_PLAYING)
+         connected_players |= 1<<netplay->self_player;
+      if (netplay->local_paused || netplay->remote_paused)
+         connected_players |= NETPLAY_CMD_SYNC_BIT_PAUSED;
+      flip_frame = netplay->flip ? netplay->flip_frame : 0;
+   }
+
    /* Send basic sync info */
    cmd[0] = htonl(NETPLAY_CMD_SYNC);
    cmd[1] = htonl(3*sizeof(uint32_t) + MAX_USERS*sizeof(uint32_t) +
       NETPLAY_NICK_LEN + mem_info.size);
-   cmd[2] = htonl(netplay->self_frame_count);
-   connected_players = netplay->connected_players;
-   if (netplay->self_mode == NETPLAY_CONNECTION_PLAYING)
-      connected_players |= 1<<netplay->self_player;
-   if (netplay->local_paused || netplay->remote_paused)
-      connected_players |= NETPLAY_CMD_SYNC_BIT_PAUSED;
+   cmd[2] = htonl(frame);
    cmd[3] = htonl(connected_players);
-   if (netplay->flip)
-      cmd[4] = htonl(netplay->flip_frame);
-   else
-      cmd[4] = htonl(0);
+   cmd[4] = htonl(flip_frame);
 
    if (!netplay_send(&connection->send_packet_buffer, connection->fd, cmd,
             sizeof(cmd)))
@@ -611,6 +622,8 @@ bool netplay_handshake_sync(netplay_t *netplay, struct netplay_connection *conne
 
    /* Now we're ready! */
    connection->mode = NETPLAY_CONNECTION_SPECTATING;
+   if (relay && !netplay_relay_attach(netplay, connection))
+      return false;
    netplay_handshake_ready(netplay, connection);
 
    return true;
@@ -1060,6 +1073,7 @@ bool netplay_handshake(netplay_t *netplay,
    }
 
    if (connection->mode >= NETPLAY_CONNECTION_CONNECTED &&
+         !connection->relayed &&
          !netplay_send_cur_input(netplay, connection))
       return false;
 
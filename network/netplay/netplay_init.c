@@ -31,6 +31,7 @@
 #include "netplay_discovery.h"
 
 #include "../../autosave.h"
+#include "../../configuration.h"
 #include "../../runloop.h"
 
 #if defined(AF_INET6) && !defined(HAVE_SOCKET_LEGACY)
@@ -240,7 +241,8 @@ static bool netplay_init_socket_buffers(netplay_t *netplay)
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
-      if (connection->active)
+      /* Relayed connections' send buffers belong to the relay */
+      if (connection->active && !connection->relayed)
       {
          if (connection->send_packet_buffer.data)
          {
@@ -413,6 +415,7 @@ netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
    const struct retro_callbacks *cb, bool nat_traversal, const char *nick,
    uint64_t quirks)
 {
+   settings_t *settings = config_get_ptr();
    netplay_t *netplay = (netplay_t*)calloc(1, sizeof(*netplay));
    if (!netplay)
       return NULL;
@@ -459,6 +462,9 @@ netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
       return NULL;
    }
 
+   if (netplay->is_server && settings->netplay.spectator_relay)
+      netplay_relay_init(netplay, settings->netplay.relay_keyframe_interval);
+
    if (!netplay->is_server)
    {
       netplay_handshake_init_send(netplay, &netplay->connections[0]);
@@ -481,6 +487,8 @@ netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
    return netplay;
 
 error:
+   netplay_relay_free(netplay);
+
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
@@ -501,6 +509,21 @@ void netplay_free(netplay_t *netplay)
 {
    size_t i;
 
+   if (netplay->rollback_count)
+   {
+      RARCH_LOG("Netplay rollbacks: %u, depth average: %.2f, max: %u frames.\n",
+            netplay->rollback_count,
+            (double)netplay->rollback_depth_total / netplay->rollback_count,
+            netplay->rollback_depth_max);
+      RARCH_LOG("Netplay replay time max: %u usec, deferred to later frames: %u times, states not saved: %u.\n",
+            (unsigned)netplay->replay_time_max,
+            netplay->replay_deferred_count,
+            netplay->replay_serialize_skipped);
+   }
+
+   /* Stop the relay before closing the sockets it sends on */
+   netplay_relay_free(netplay);
+
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
@@ -533,6 +556,13 @@ void netplay_free(netplay_t *netplay)
    if (netplay->zbuffer)
       free(netplay->zbuffer);
 
+   if (netplay->delta_src)
+      free(netplay->delta_src);
+   if (netplay->delta_dst)
+      free(netplay->delta_dst);
+   if (netplay->delta_patch)
+      free(netplay->delta_patch);
+
    if (netplay->compress_nil.compression_stream)
    {
       netplay->compress_nil.compression_backend->stream_free(netplay->compress_nil.compression_stream);
@@ -113,6 +113,9 @@ void netplay_hangup(netplay_t *netplay, struct netplay_connection *connection)
    RARCH_LOG("%s\n", dmsg);
    runloop_msg_queue_push(dmsg, 1, 180, false);
 
+   if (connection->relayed)
+      netplay_relay_remove(netplay, connection);
+
    socket_close(connection->fd);
    connection->active = false;
    netplay_deinit_socket_buffer(&connection->send_packet_buffer);
@@ -165,7 +168,12 @@ static bool send_input_frame(netplay_t *netplay,
    buffer[5] = htonl(state[1]);
    buffer[6] = htonl(state[2]);
 
-   if (only)
+   if (only && only->relayed)
+   {
+      return netplay_relay_queue_cmd(netplay, only, NULL, NETPLAY_CMD_INPUT,
+         buffer + 2, WORDS_PER_FRAME * sizeof(uint32_t));
+   }
+   else if (only)
    {
       if (!netplay_send(&only->send_packet_buffer, only->fd, buffer, sizeof(buffer)))
       {
@@ -178,7 +186,7 @@ static bool send_input_frame(netplay_t *netplay,
       for (i = 0; i < netplay->connections_size; i++)
       {
          struct netplay_connection *connection = &netplay->connections[i];
-         if (connection == except) continue;
+         if (connection == except || connection->relayed) continue;
          if (connection->active &&
              connection->mode >= NETPLAY_CONNECTION_CONNECTED &&
              (connection->mode != NETPLAY_CONNECTION_PLAYING ||
@@ -189,15 +197,41 @@ static bool send_input_frame(netplay_t *netplay,
                netplay_hangup(netplay, connection);
          }
       }
+
+      /* Spectators on the relay get it once */
+      if (netplay->relay)
+         netplay_relay_queue_cmd(netplay, NULL, except, NETPLAY_CMD_INPUT,
+            buffer + 2, WORDS_PER_FRAME * sizeof(uint32_t));
    }
 
    return true;
 }
 
+/* Send the specified input data to a connection, or to everybody on the
+ * spectator relay if connection is NULL */
+static bool send_cur_input_frame(netplay_t *netplay,
+   struct netplay_connection *connection,
+   uint32_t frame, uint32_t player, uint32_t *state)
+{
+   uint32_t buffer[WORDS_PER_FRAME];
+
+   if (connection)
+      return send_input_frame(netplay, connection, NULL, frame, player, state);
+
+   buffer[0] = htonl(frame);
+   buffer[1] = htonl(player);
+   buffer[2] = htonl(state[0]);
+   buffer[3] = htonl(state[1]);
+   buffer[4] = htonl(state[2]);
+   return netplay_relay_queue_cmd(netplay, NULL, NULL, NETPLAY_CMD_INPUT,
+      buffer, sizeof(buffer));
+}
+
 /**
  * netplay_send_cur_input
  *
- * Send the current input frame to a given connection.
+ * Send the current input frame to a given connection, or to the spectator
+ * relay if connection is NULL.
  *
  * Returns true if successful, false otherwise.
  */
@@ -212,14 +246,15 @@ bool netplay_send_cur_input(netplay_t *netplay,
       /* Send the other players' input data */
       for (player = 0; player < MAX_USERS; player++)
       {
-         if (connection->mode == NETPLAY_CONNECTION_PLAYING &&
+         if (connection &&
+               connection->mode == NETPLAY_CONNECTION_PLAYING &&
                connection->player == player)
             continue;
          if ((netplay->connected_players & (1<<player)))
          {
             if (dframe->have_real[player])
             {
-               if (!send_input_frame(netplay, connection, NULL,
+               if (!send_cur_input_frame(netplay, connection,
                         netplay->self_frame_count, player,
                         dframe->real_input_state[player]))
                   return false;
@@ -231,8 +266,11 @@ bool netplay_send_cur_input(netplay_t *netplay,
       if (netplay->self_mode != NETPLAY_CONNECTION_PLAYING)
       {
          uint32_t payload = htonl(netplay->self_frame_count);
-         if (!netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_NOINPUT,
-               &payload, sizeof(payload)))
+         if (!(connection ?
+               netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_NOINPUT,
+                  &payload, sizeof(payload)) :
+               netplay_relay_queue_cmd(netplay, NULL, NULL,
+                  NETPLAY_CMD_NOINPUT, &payload, sizeof(payload))))
             return false;
       }
 
@@ -241,13 +279,22 @@ bool netplay_send_cur_input(netplay_t *netplay,
    /* Send our own data */
    if (netplay->self_mode == NETPLAY_CONNECTION_PLAYING)
    {
-      if (!send_input_frame(netplay, connection, NULL,
+      if (!send_cur_input_frame(netplay, connection,
             netplay->self_frame_count,
             (netplay->is_server ?  NETPLAY_CMD_INPUT_BIT_SERVER : 0) | netplay->self_player,
             dframe->self_state))
          return false;
    }
 
+   if (!connection)
+   {
+      netplay_relay_flush(netplay);
+      return true;
+   }
+
+   if (connection->relayed)
+      return true;
+
    if (!netplay_send_flush(&connection->send_packet_buffer, connection->fd,
          false))
       return false;
@@ -268,6 +315,10 @@ bool netplay_send_raw_cmd(netplay_t *netplay,
 {
    uint32_t cmdbuf[2];
 
+   if (connection->relayed)
+      return netplay_relay_queue_cmd(netplay, connection, NULL, cmd, data,
+         size);
+
    cmdbuf[0] = htonl(cmd);
    cmdbuf[1] = htonl(size);
 
@@ -296,7 +347,7 @@ void netplay_send_raw_cmd_all(netplay_t *netplay,
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
-      if (connection == except)
+      if (connection == except || connection->relayed)
          continue;
       if (connection->active && connection->mode >= NETPLAY_CONNECTION_CONNECTED)
       {
@@ -304,6 +355,9 @@ void netplay_send_raw_cmd_all(netplay_t *netplay,
             netplay_hangup(netplay, connection);
       }
    }
+
+   if (netplay->relay)
+      netplay_relay_queue_cmd(netplay, NULL, except, cmd, data, size);
 }
 
 static bool netplay_cmd_nak(netplay_t *netplay,
@@ -320,17 +374,40 @@ static bool netplay_cmd_nak(netplay_t *netplay,
  */
 bool netplay_cmd_crc(netplay_t *netplay, struct delta_frame *delta)
 {
-   uint32_t payload[2];
+   uint32_t payload[3];
    bool success = true;
    size_t i;
    payload[0] = htonl(delta->frame);
-   payload[1] = htonl(delta->crc);
    for (i = 0; i < netplay->connections_size; i++)
    {
-      if (netplay->connections[i].active &&
-            netplay->connections[i].mode >= NETPLAY_CONNECTION_CONNECTED)
-         success = netplay_send_raw_cmd(netplay, &netplay->connections[i],
-            NETPLAY_CMD_CRC, payload, sizeof(payload)) && success;
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (!connection->active ||
+            connection->mode < NETPLAY_CONNECTION_CONNECTED ||
+            connection->relayed)
+         continue;
+
+      if (connection->hash_xxh64)
+      {
+         payload[1] = htonl((uint32_t)(delta->hash >> 32));
+         payload[2] = htonl((uint32_t)delta->hash);
+         success = netplay_send_raw_cmd(netplay, connection,
+            NETPLAY_CMD_CRC, payload, 3*sizeof(uint32_t)) && success;
+      }
+      else
+      {
+         payload[1] = htonl(delta->crc);
+         success = netplay_send_raw_cmd(netplay, connection,
+            NETPLAY_CMD_CRC, payload, 2*sizeof(uint32_t)) && success;
+      }
+   }
+
+   /* Everybody on the relay uses xxHash64 */
+   if (netplay->relay)
+   {
+      payload[1] = htonl((uint32_t)(delta->hash >> 32));
+      payload[2] = htonl((uint32_t)delta->hash);
+      success = netplay_relay_queue_cmd(netplay, NULL, NULL,
+         NETPLAY_CMD_CRC, payload, 3*sizeof(uint32_t)) && success;
    }
    return success;
 }
@@ -342,6 +419,8 @@ bool netplay_cmd_crc(netplay_t *netplay, struct delta_frame *delta)
  */
 bool netplay_cmd_request_savestate(netplay_t *netplay)
 {
+   uint32_t base_frame;
+
    if (netplay->connections_size == 0 ||
        !netplay->connections[0].active ||
        netplay->connections[0].mode < NETPLAY_CONNECTION_CONNECTED)
@@ -349,6 +428,17 @@ bool netplay_cmd_request_savestate(netplay_t *netplay)
    if (netplay->savestate_request_outstanding)
       return true;
    netplay->savestate_request_outstanding = true;
+
+   /* If the server can send deltas, tell it the last frame we know we agree
+    * on, so it only has to send what changed since */
+   if (netplay->connections[0].delta_supported && netplay->have_crc_match &&
+       netplay_delta_find_frame(netplay, netplay->crc_match_frame))
+   {
+      base_frame = htonl(netplay->crc_match_frame);
+      return netplay_send_raw_cmd(netplay, &netplay->connections[0],
+         NETPLAY_CMD_REQUEST_SAVESTATE, &base_frame, sizeof(base_frame));
+   }
+
    return netplay_send_raw_cmd(netplay, &netplay->connections[0],
       NETPLAY_CMD_REQUEST_SAVESTATE, NULL, 0);
 }
@@ -670,6 +760,14 @@ static bool netplay_get_cmd(netplay_t *netplay,
             break;
          }
 
+         /* Relayed spectators can only play once they've caught up */
+         if (connection->relayed && !netplay_relay_detach(netplay, connection))
+         {
+            payload[0] = htonl(NETPLAY_CMD_MODE_REFUSED_REASON_OTHER);
+            netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_MODE_REFUSED, payload, sizeof(uint32_t));
+            break;
+         }
+
          if (connection->mode != NETPLAY_CONNECTION_PLAYING)
          {
             /* Mark them as playing */
@@ -953,17 +1051,19 @@ static bool netplay_get_cmd(netplay_t *netplay,
 
       case NETPLAY_CMD_CRC:
          {
-            uint32_t buffer[2];
+            uint32_t buffer[3];
+            uint64_t hash  = 0;
             size_t tmp_ptr = netplay->run_ptr;
             bool found = false;
+            bool is_hash = connection->hash_xxh64;
 
-            if (cmd_size != sizeof(buffer))
+            if (cmd_size != (is_hash ? 3 : 2) * sizeof(uint32_t))
             {
                RARCH_ERR("NETPLAY_CMD_CRC received unexpected payload size.\n");
                return netplay_cmd_nak(netplay, connection);
             }
 
-            RECV(buffer, sizeof(buffer))
+            RECV(buffer, cmd_size)
             {
                RARCH_ERR("NETPLAY_CMD_CRC failed to receive payload.\n");
                return netplay_cmd_nak(netplay, connection);
@@ -971,6 +1071,8 @@ static bool netplay_get_cmd(netplay_t *netplay,
 
             buffer[0] = ntohl(buffer[0]);
             buffer[1] = ntohl(buffer[1]);
+            if (is_hash)
+               hash = ((uint64_t)buffer[1] << 32) | ntohl(buffer[2]);
 
             /* Received a CRC for some frame. If we still have it, check if it
              * matched. This approach could be improved with some quick modular
@@ -980,7 +1082,8 @@ static bool netplay_get_cmd(netplay_t *netplay,
                if (     netplay->buffer[tmp_ptr].used 
                      && netplay->buffer[tmp_ptr].frame == buffer[0])
                {
-                  found = true;
+                  /* If replay skipped saving this state, we can't check it */
+                  found = !netplay->buffer[tmp_ptr].state_stale;
                   break;
                }
 
@@ -997,36 +1100,74 @@ static bool netplay_get_cmd(netplay_t *netplay,
             {
                /* We've already replayed up to this frame, so we can check it
                 * directly */
-               uint32_t local_crc = netplay_delta_frame_crc(
-                     netplay, &netplay->buffer[tmp_ptr]);
+               bool match;
+               if (is_hash)
+                  match = (hash == netplay_delta_frame_hash(
+                        netplay, &netplay->buffer[tmp_ptr]));
+               else
+                  match = (buffer[1] == netplay_delta_frame_crc(
+                        netplay, &netplay->buffer[tmp_ptr]));
 
-               if (buffer[1] != local_crc)
+               if (!match)
                {
                   /* Problem! */
                   netplay_cmd_request_savestate(netplay);
                }
+               else
+               {
+                  netplay->have_crc_match  = true;
+                  netplay->crc_match_frame = buffer[0];
+               }
             }
             else
             {
                /* We'll have to check it when we catch up */
-               netplay->buffer[tmp_ptr].crc = buffer[1];
+               if (is_hash)
+                  netplay->buffer[tmp_ptr].hash = hash;
+               else
+                  netplay->buffer[tmp_ptr].crc  = buffer[1];
             }
 
             break;
          }
 
       case NETPLAY_CMD_REQUEST_SAVESTATE:
+         /* A client that can take deltas may tell us a frame we agree on */
+         if (cmd_size == sizeof(uint32_t) && connection->delta_supported)
+         {
+            uint32_t base_frame;
+            RECV(&base_frame, sizeof(base_frame))
+            {
+               RARCH_ERR("NETPLAY_CMD_REQUEST_SAVESTATE failed to receive base frame.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+            /* The relay only sends full states */
+            connection->delta_base_valid = !connection->relayed;
+            connection->delta_base_frame = ntohl(base_frame);
+         }
+         else if (cmd_size != 0)
+         {
+            RARCH_ERR("NETPLAY_CMD_REQUEST_SAVESTATE received unexpected payload size.\n");
+            return netplay_cmd_nak(netplay, connection);
+         }
+
          /* Delay until next frame so we don't send the savestate after the
           * input */
          netplay->force_send_savestate = true;
          break;
 
       case NETPLAY_CMD_LOAD_SAVESTATE:
+      case NETPLAY_CMD_LOAD_SAVESTATE_DELTA:
          {
             uint32_t frame;
             uint32_t isize;
             uint32_t rd, wn;
             uint32_t player;
+            uint32_t header_size       = 2*sizeof(uint32_t);
+            uint32_t base_frame        = 0;
+            uint32_t base_crc          = 0;
+            struct delta_frame *base   = NULL;
+            bool is_delta              = (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA);
             struct compression_transcoder *ctrans;
 
             /* Make sure we're ready for it */
@@ -1071,12 +1212,24 @@ static bool netplay_get_cmd(netplay_t *netplay,
              * (strangely) force a rewind to the frame we're already on, so it
              * gets loaded. This is just to avoid having reloading implemented in
              * too many places. */
-            if (cmd_size > netplay->zbuffer_size + 2*sizeof(uint32_t))
+            if (is_delta)
+               header_size = 4*sizeof(uint32_t);
+
+            if (cmd_size < header_size ||
+                cmd_size > netplay->zbuffer_size + header_size)
             {
                RARCH_ERR("CMD_LOAD_SAVESTATE received an unexpected payload size.\n");
                return netplay_cmd_nak(netplay, connection);
             }
 
+            /* Only the server sends deltas, and only when asked to */
+            if (is_delta && (netplay->is_server ||
+                  !netplay_delta_init_patch_buffers(netplay)))
+            {
+               RARCH_ERR("CMD_LOAD_SAVESTATE_DELTA received unexpectedly.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
             RECV(&frame, sizeof(frame))
             {
                RARCH_ERR("CMD_LOAD_SAVESTATE failed to receive savestate frame.\n");
@@ -1097,6 +1250,23 @@ static bool netplay_get_cmd(netplay_t *netplay,
                goto shrt;
             }
 
+            if (is_delta)
+            {
+               RECV(&base_frame, sizeof(base_frame))
+               {
+                  RARCH_ERR("CMD_LOAD_SAVESTATE_DELTA failed to receive base frame.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
+               base_frame = ntohl(base_frame);
+
+               RECV(&base_crc, sizeof(base_crc))
+               {
+                  RARCH_ERR("CMD_LOAD_SAVESTATE_DELTA failed to receive base CRC.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
+               base_crc = ntohl(base_crc);
+            }
+
             RECV(&isize, sizeof(isize))
             {
                RARCH_ERR("CMD_LOAD_SAVESTATE failed to receive inflated size.\n");
@@ -1104,13 +1274,14 @@ static bool netplay_get_cmd(netplay_t *netplay,
             }
             isize = ntohl(isize);
 
-            if (isize != netplay->state_size)
+            if ((!is_delta && isize != netplay->state_size) ||
+                (is_delta && isize > netplay->delta_patch_size))
             {
                RARCH_ERR("CMD_LOAD_SAVESTATE received an unexpected save state size.\n");
                return netplay_cmd_nak(netplay, connection);
             }
 
-            RECV(netplay->zbuffer, cmd_size - 2*sizeof(uint32_t))
+            RECV(netplay->zbuffer, cmd_size - header_size)
             {
                RARCH_ERR("CMD_LOAD_SAVESTATE failed to receive savestate.\n");
                return netplay_cmd_nak(netplay, connection);
@@ -1125,13 +1296,53 @@ static bool netplay_get_cmd(netplay_t *netplay,
                default:
                   ctrans = &netplay->compress_nil;
             }
-            ctrans->decompression_backend->set_in(ctrans->decompression_stream,
-               netplay->zbuffer, cmd_size - 2*sizeof(uint32_t));
-            ctrans->decompression_backend->set_out(ctrans->decompression_stream,
-               (uint8_t*)netplay->buffer[netplay->read_ptr[connection->player]].state,
-               netplay->state_size);
-            ctrans->decompression_backend->trans(ctrans->decompression_stream,
-               true, &rd, &wn, NULL);
+            if (is_delta)
+            {
+               struct delta_frame *target =
+                  &netplay->buffer[netplay->read_ptr[connection->player]];
+
+               /* If our base doesn't match the server's after all, we'll have
+                * to ask for the whole thing */
+               base = netplay_delta_find_frame(netplay, base_frame);
+               if (!base || netplay_delta_frame_crc(netplay, base) != base_crc)
+               {
+                  RARCH_WARN("Netplay delta savestate base mismatch, requesting full savestate.\n");
+                  netplay->have_crc_match                = false;
+                  netplay->savestate_request_outstanding = false;
+                  netplay_cmd_request_savestate(netplay);
+                  break;
+               }
+
+               ctrans->decompression_backend->set_in(ctrans->decompression_stream,
+                  netplay->zbuffer, cmd_size - header_size);
+               ctrans->decompression_backend->set_out(ctrans->decompression_stream,
+                  (uint8_t*)netplay->delta_patch, isize);
+               if (!ctrans->decompression_backend->trans(
+                     ctrans->decompression_stream, true, &rd, &wn, NULL) ||
+                   wn != isize)
+               {
+                  RARCH_ERR("CMD_LOAD_SAVESTATE_DELTA failed to decompress delta.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
+
+               if (target != base)
+                  memcpy(target->state, base->state, netplay->state_size);
+               if (!netplay_delta_decode_state(netplay, isize, target->state))
+               {
+                  RARCH_ERR("CMD_LOAD_SAVESTATE_DELTA received an invalid delta.\n");
+                  return netplay_cmd_nak(netplay, connection);
+               }
+            }
+            else
+            {
+               ctrans->decompression_backend->set_in(ctrans->decompression_stream,
+                  netplay->zbuffer, cmd_size - header_size);
+               ctrans->decompression_backend->set_out(ctrans->decompression_stream,
+                  (uint8_t*)netplay->buffer[netplay->read_ptr[connection->player]].state,
+                  netplay->state_size);
+               ctrans->decompression_backend->trans(ctrans->decompression_stream,
+                  true, &rd, &wn, NULL);
+            }
 
             /* Skip ahead if it's past where we are */
             if (frame > netplay->run_frame_count)
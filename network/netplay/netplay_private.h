@@ -50,6 +50,10 @@
 #define NETPLAY_MAX_REQ_STALL_TIME     60
 #define NETPLAY_MAX_REQ_STALL_FREQUENCY 120
 
+/* Portion of a host frame, in percent, that replaying frames after a
+ * misprediction may take before the rest is deferred to the next frame */
+#define NETPLAY_REPLAY_BUDGET_PERCENT  50
+
 #define PREV_PTR(x) ((x) == 0 ? netplay->buffer_size - 1 : (x) - 1)
 #define NEXT_PTR(x) ((x + 1) % netplay->buffer_size)
 
@@ -60,6 +64,7 @@
 #define NETPLAY_QUIRK_INITIALIZATION (1<<2)
 #define NETPLAY_QUIRK_ENDIAN_DEPENDENT (1<<3)
 #define NETPLAY_QUIRK_PLATFORM_DEPENDENT (1<<4)
+#define NETPLAY_QUIRK_VARIABLE_SIZE (1<<5)
 
 /* Mapping of serialization quirks to netplay quirks. */
 #define NETPLAY_QUIRK_MAP_UNDERSTOOD \
@@ -79,13 +84,25 @@
    (RETRO_SERIALIZATION_QUIRK_ENDIAN_DEPENDENT)
 #define NETPLAY_QUIRK_MAP_PLATFORM_DEPENDENT \
    (RETRO_SERIALIZATION_QUIRK_PLATFORM_DEPENDENT)
+#define NETPLAY_QUIRK_MAP_VARIABLE_SIZE \
+   (RETRO_SERIALIZATION_QUIRK_CORE_VARIABLE_SIZE)
 
 /* Compression protocols supported */
 #define NETPLAY_COMPRESSION_ZLIB (1<<0)
+
+/* Savestates may be sent as a delta against a frame both sides agree on */
+#define NETPLAY_COMPRESSION_DELTA (1<<1)
+
+/* Frame hashes may be sent as 64-bit xxHash64 instead of CRC-32. This isn't
+ * compression, but is negotiated in the same header word. */
+#define NETPLAY_HASH_XXH64 (1<<2)
+
 #if HAVE_ZLIB
-#define NETPLAY_COMPRESSION_SUPPORTED NETPLAY_COMPRESSION_ZLIB
+#define NETPLAY_COMPRESSION_SUPPORTED \
+   (NETPLAY_COMPRESSION_ZLIB|NETPLAY_COMPRESSION_DELTA|NETPLAY_HASH_XXH64)
 #else
-#define NETPLAY_COMPRESSION_SUPPORTED 0
+#define NETPLAY_COMPRESSION_SUPPORTED \
+   (NETPLAY_COMPRESSION_DELTA|NETPLAY_HASH_XXH64)
 #endif
 
 enum netplay_cmd
@@ -156,6 +173,10 @@ enum netplay_cmd
    /* Sends over cheats enabled on client (unsupported) */
    NETPLAY_CMD_CHEATS         = 0x0046,
 
+   /* Send a savestate for the client to load, as a delta against an earlier
+    * frame whose CRC the client has confirmed */
+   NETPLAY_CMD_LOAD_SAVESTATE_DELTA = 0x0047,
+
    /* Misc. commands */
 
    /* Swap inputs between player 1 and player 2 */
@@ -225,9 +246,16 @@ struct delta_frame
    /* The serialized state of the core at this frame, before input */
    void *state;
 
+   /* Is the serialized state out of date? Replay doesn't save states it can
+    * never rewind to again. */
+   bool state_stale;
+
    /* The CRC-32 of the serialized state if we've calculated it, else 0 */
    uint32_t crc;
 
+   /* The xxHash64 of the serialized state if we've calculated it, else 0 */
+   uint64_t hash;
+
    /* The real, simulated and local input. If we're playing, self_state is
     * mirrored to the appropriate real_input_state player. */
    netplay_input_state_t real_input_state[MAX_USERS];
@@ -285,6 +313,22 @@ struct netplay_connection
    /* What compression does this peer support? */
    uint32_t compression_supported;
 
+   /* Does this peer support delta savestates? */
+   bool delta_supported;
+
+   /* Does this peer check frames with xxHash64 rather than CRC-32? */
+   bool hash_xxh64;
+
+   /* For the server: The last frame at which this client confirmed that its
+    * state matches ours, if it requested a savestate with one */
+   bool delta_base_valid;
+   uint32_t delta_base_frame;
+
+   /* Is this connection served by the spectator relay (server only)? While
+    * it is, the relay owns its sending. */
+   bool relayed;
+   uint32_t relay_id;
+
    /* Is this player paused? */
    bool paused;
 
@@ -297,6 +341,9 @@ struct netplay_connection
    uint32_t stall_frame;
 };
 
+/* Spectator relay, see netplay_relay.c */
+struct netplay_relay;
+
 /* Compression transcoder */
 struct compression_transcoder
 {
@@ -355,6 +402,15 @@ struct netplay
    uint8_t *zbuffer;
    size_t zbuffer_size;
 
+   /* Spectator relay (server only), or NULL */
+   struct netplay_relay *relay;
+
+   /* Buffers for delta savestates: two scratch states in the format the
+    * rewind encoder expects, and the patch between them */
+   void *delta_src, *delta_dst;
+   uint16_t *delta_patch;
+   size_t delta_patch_size;
+
    /* The size of our packet buffers */
    size_t packet_buffer_size;
 
@@ -397,6 +453,9 @@ struct netplay
    /* Are we replaying old frames? */
    bool is_replay;
 
+   /* Did we run out of time replaying, and have to finish next frame? */
+   bool replay_pending;
+
    /* We don't want to poll several times on a frame. */
    bool can_poll;
 
@@ -463,6 +522,19 @@ struct netplay
 
    /* Are they valid? */
    bool crcs_valid;
+
+   /* For the client: The last frame at which our CRC matched the server's */
+   bool have_crc_match;
+   uint32_t crc_match_frame;
+
+   /* Rollback instrumentation: how far back we've had to rewind, and how long
+    * replaying took per frame */
+   uint32_t rollback_count;
+   uint32_t rollback_depth_last, rollback_depth_max;
+   uint64_t rollback_depth_total;
+   uint32_t replay_deferred_count;
+   uint32_t replay_serialize_skipped;
+   retro_time_t replay_time_last, replay_time_max;
 };
 
 
@@ -499,6 +571,17 @@ void netplay_deinit_socket_buffer(struct socket_buffer *sbuf);
 bool netplay_send(struct socket_buffer *sbuf, int sockfd, const void *buf,
    size_t len);
 
+/**
+ * netplay_send_queue
+ *
+ * Queue as much of the given data as fits in the buffer, without sending
+ * anything.
+ *
+ * Returns the number of bytes queued.
+ */
+size_t netplay_send_queue(struct socket_buffer *sbuf, const void *buf,
+   size_t len);
+
 /**
  * netplay_send_flush
  *
@@ -559,6 +642,56 @@ bool netplay_delta_frame_ready(netplay_t *netplay, struct delta_frame *delta,
  */
 uint32_t netplay_delta_frame_crc(netplay_t *netplay, struct delta_frame *delta);
 
+/**
+ * netplay_delta_frame_hash
+ *
+ * Get the xxHash64 for the serialization of this frame.
+ */
+uint64_t netplay_delta_frame_hash(netplay_t *netplay,
+   struct delta_frame *delta);
+
+/**
+ * netplay_delta_find_frame
+ *
+ * Find the delta frame holding the given frame, if we still have it.
+ *
+ * Returns: The delta frame, or NULL if it's no longer in the buffer.
+ */
+struct delta_frame *netplay_delta_find_frame(netplay_t *netplay,
+   uint32_t frame);
+
+/**
+ * netplay_delta_init_patch_buffers
+ *
+ * Allocate the buffers used to encode and decode delta savestates, if they
+ * haven't already been.
+ *
+ * Returns: True if the buffers are ready.
+ */
+bool netplay_delta_init_patch_buffers(netplay_t *netplay);
+
+/**
+ * netplay_delta_encode_state
+ *
+ * Encode the patch turning the state in base into the state in target, with
+ * its framing in network byte order.
+ *
+ * Returns: The size of the patch in netplay->delta_patch, or 0 on failure.
+ */
+size_t netplay_delta_encode_state(netplay_t *netplay,
+   const void *target, const void *base);
+
+/**
+ * netplay_delta_decode_state
+ *
+ * Validate a patch received from the network in netplay->delta_patch and
+ * apply it on top of the state in data.
+ *
+ * Returns: True if the patch was valid and applied.
+ */
+bool netplay_delta_decode_state(netplay_t *netplay, size_t patch_size,
+   void *data);
+
 
 /***************************************************************
  * NETPLAY-DISCOVERY.C
@@ -774,6 +907,159 @@ void netplay_announce_nat_traversal(netplay_t *netplay);
 void netplay_init_nat_traversal(netplay_t *netplay);
 
 
+/***************************************************************
+ * NETPLAY-RELAY.C
+ **************************************************************/
+
+/**
+ * netplay_relay_init
+ * @netplay              : pointer to netplay object
+ * @keyframe_interval    : frames between keyframes
+ *
+ * Start relaying to spectators.
+ *
+ * Returns true if the relay is running.
+ */
+bool netplay_relay_init(netplay_t *netplay, unsigned keyframe_interval);
+
+/**
+ * netplay_relay_free
+ * @netplay              : pointer to netplay object
+ *
+ * Stop relaying and free the relay. Relayed connections' sockets are left to
+ * the caller.
+ */
+void netplay_relay_free(netplay_t *netplay);
+
+/**
+ * netplay_relay_queue
+ * @netplay              : pointer to netplay object
+ * @only                 : relayed connection to send to, or NULL for all
+ * @except               : connection not to send to, or NULL
+ * @data                 : data
+ * @size                 : size of the data
+ *
+ * Queue raw data for relayed connections. It's sent with the rest of the
+ * frame's commands by netplay_relay_flush.
+ *
+ * Returns false if the data couldn't be queued.
+ */
+bool netplay_relay_queue(netplay_t *netplay,
+      struct netplay_connection *only, struct netplay_connection *except,
+      const void *data, size_t size);
+
+/**
+ * netplay_relay_queue_cmd
+ * @netplay              : pointer to netplay object
+ * @only                 : relayed connection to send to, or NULL for all
+ * @except               : connection not to send to, or NULL
+ * @cmd                  : command
+ * @data                 : payload
+ * @size                 : size of the payload
+ *
+ * Queue a command for relayed connections.
+ *
+ * Returns false if the command couldn't be queued.
+ */
+bool netplay_relay_queue_cmd(netplay_t *netplay,
+      struct netplay_connection *only, struct netplay_connection *except,
+      uint32_t cmd, const void *data, size_t size);
+
+/**
+ * netplay_relay_flush
+ * @netplay              : pointer to netplay object
+ *
+ * Hand the commands queued so far to the I/O thread.
+ */
+void netplay_relay_flush(netplay_t *netplay);
+
+/**
+ * netplay_relay_compression
+ * @netplay              : pointer to netplay object
+ *
+ * The compression relayed connections must use.
+ */
+uint32_t netplay_relay_compression(netplay_t *netplay);
+
+/**
+ * netplay_relay_pre_frame
+ * @netplay              : pointer to netplay object
+ *
+ * Called before the frame's input is sent. If a keyframe is due, remember
+ * where this frame starts in the stream.
+ */
+void netplay_relay_pre_frame(netplay_t *netplay);
+
+/**
+ * netplay_relay_post_frame
+ * @netplay              : pointer to netplay object
+ *
+ * Called after each frame. Sends the frame's commands, moves keyframes along
+ * and hangs up on spectators we failed to send to.
+ */
+void netplay_relay_post_frame(netplay_t *netplay);
+
+/**
+ * netplay_relay_wants_state
+ * @netplay              : pointer to netplay object
+ * @frame                : frame being replayed
+ *
+ * Whether the relay will want the state of this frame for a keyframe.
+ */
+bool netplay_relay_wants_state(netplay_t *netplay, uint32_t frame);
+
+/**
+ * netplay_relay_join_info
+ * @netplay              : pointer to netplay object
+ * @connection           : connection being synchronized
+ * @frame                : set to the frame to sync to
+ * @connected_players    : set to the players connected as of that frame
+ * @flip_frame           : set to the flip frame as of that frame
+ *
+ * Decide whether a new connection should be relayed.
+ *
+ * Returns true if the connection should be relayed.
+ */
+bool netplay_relay_join_info(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t *frame,
+      uint32_t *connected_players, uint32_t *flip_frame);
+
+/**
+ * netplay_relay_attach
+ * @netplay              : pointer to netplay object
+ * @connection           : connection to relay
+ *
+ * Hand a connection over to the relay.
+ *
+ * Returns true if the connection is now relayed.
+ */
+bool netplay_relay_attach(netplay_t *netplay,
+      struct netplay_connection *connection);
+
+/**
+ * netplay_relay_detach
+ * @netplay              : pointer to netplay object
+ * @connection           : relayed connection
+ *
+ * Take a connection back from the relay so it can be sent to directly. Only
+ * spectators that have caught up can be detached.
+ *
+ * Returns true if the connection is no longer relayed.
+ */
+bool netplay_relay_detach(netplay_t *netplay,
+      struct netplay_connection *connection);
+
+/**
+ * netplay_relay_remove
+ * @netplay              : pointer to netplay object
+ * @connection           : relayed connection
+ *
+ * Drop a connection from the relay, discarding whatever wasn't sent.
+ */
+void netplay_relay_remove(netplay_t *netplay,
+      struct netplay_connection *connection);
+
+
 /***************************************************************
  * NETPLAY-SYNC.C
  **************************************************************/
@@ -0,0 +1,1108 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2016-2017 - Gregor Richards
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <boolean.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include "netplay_private.h"
+
+/*
+ * The spectator relay serves spectators from a single stream. Everything the
+ * server would send to each spectator (input, mode changes, CRCs, ...) is
+ * encoded once, batched per frame and appended to the stream, and an I/O
+ * thread writes it out to every relayed connection. Every so often, the
+ * state of a frame whose input is all known is compressed into a keyframe,
+ * so that new spectators can join from it without the players having to send
+ * or load a savestate.
+ */
+
+#ifdef HAVE_THREADS
+
+/* A relay ID meaning every relayed connection */
+#define RELAY_ALL 0
+
+/* How long to wait before retrying spectators whose sockets were full */
+#define RELAY_RETRY_USEC 2000
+
+/* The most that may be pending for a spectator that wants to become a player.
+ * Anything more and they're still catching up. */
+#define RELAY_DETACH_MAX 4096
+
+struct relay_chunk
+{
+   struct relay_chunk *next;
+
+   /* Relay ID of the connection this chunk is for, and of the one it's not
+    * for */
+   uint32_t only, except;
+
+   /* References (keyframes only) */
+   unsigned refs;
+
+   size_t size;
+   uint8_t *data;
+};
+
+/* A point in the stream at which spectators can join, and the sync info to
+ * give them */
+struct relay_join
+{
+   struct relay_chunk *mark;
+   uint32_t frame;
+   uint32_t connected_players;
+   uint32_t flip_frame;
+};
+
+struct relay_client
+{
+   /* Is the I/O thread using this client right now? */
+   bool busy;
+
+   /* Did sending fail? The client gets hung up on the next frame. */
+   bool failed;
+
+   /* Relay ID, index of the connection and its socket */
+   uint32_t id;
+   size_t conn;
+   int fd;
+
+   /* The connection's send buffer, owned by the relay while attached */
+   struct socket_buffer sbuf;
+
+   /* The keyframe the client joined from, until it's been queued */
+   struct relay_chunk *keyframe;
+   size_t keyframe_offset;
+
+   /* The last chunk of the stream queued, and how much of the one after */
+   struct relay_chunk *last;
+   size_t offset;
+};
+
+struct netplay_relay
+{
+   sthread_t *thread;
+   slock_t *lock;
+
+   /* Signaled when there's work for the I/O thread, and when it's let go of a
+    * client */
+   scond_t *cond, *idle_cond;
+   bool work, quit;
+
+   /* The stream. The head is the oldest chunk anybody might still need. Only
+    * the frontend appends, and only the I/O thread frees. */
+   struct relay_chunk *head, *tail;
+
+   /* Commands queued this frame but not yet appended to the stream */
+   uint8_t *batch;
+   size_t batch_size, batch_cap;
+   uint32_t batch_only, batch_except;
+
+   /* Relayed connections, and the ID for the next one. IDs aren't reused, so
+    * a new connection never gets what was meant for an old one in the same
+    * slot. */
+   struct relay_client **clients;
+   size_t clients_size;
+   uint32_t next_id;
+
+   /* Keyframe compression */
+   uint32_t compression;
+   const struct trans_stream_backend *compression_backend;
+   void *compression_stream;
+   unsigned keyframe_interval;
+
+   /* The current keyframe, if any */
+   struct relay_chunk *keyframe;
+   struct relay_join keyframe_join;
+
+   /* A frame whose state we'll make a keyframe once its input is known */
+   bool candidate;
+   struct relay_join candidate_join;
+
+   /* A known-good state handed to the I/O thread for compression */
+   bool raw_pending;
+   uint8_t *raw_state;
+   size_t raw_size;
+   struct relay_join raw_join;
+
+   /* A compressed keyframe handed back to the frontend */
+   struct relay_chunk *compressed;
+   struct relay_join compressed_join;
+
+   /* Statistics */
+   uint64_t bytes_queued;
+   unsigned keyframes;
+};
+
+static struct relay_chunk *relay_chunk_new(size_t size)
+{
+   struct relay_chunk *chunk = (struct relay_chunk*)
+      malloc(sizeof(struct relay_chunk) + size);
+   if (!chunk)
+      return NULL;
+   chunk->next   = NULL;
+   chunk->only   = RELAY_ALL;
+   chunk->except = RELAY_ALL;
+   chunk->refs   = 1;
+   chunk->size   = size;
+   chunk->data   = (uint8_t*)(chunk + 1);
+   return chunk;
+}
+
+/* Must be called with the lock held */
+static void relay_keyframe_release(struct relay_chunk *keyframe)
+{
+   if (keyframe && --keyframe->refs == 0)
+      free(keyframe);
+}
+
+static bool relay_chunk_retained(struct netplay_relay *relay,
+      struct relay_chunk *chunk)
+{
+   size_t i;
+
+   if ((relay->keyframe && relay->keyframe_join.mark == chunk) ||
+       (relay->candidate && relay->candidate_join.mark == chunk) ||
+       (relay->raw_pending && relay->raw_join.mark == chunk) ||
+       (relay->compressed && relay->compressed_join.mark == chunk))
+      return true;
+
+   for (i = 0; i < relay->clients_size; i++)
+   {
+      struct relay_client *client = relay->clients[i];
+      if (client && client->last == chunk)
+         return true;
+   }
+
+   return false;
+}
+
+/* Free the chunks nobody needs anymore. Called by the I/O thread with the
+ * lock held. */
+static void relay_trim(struct netplay_relay *relay)
+{
+   while (relay->head != relay->tail &&
+          !relay_chunk_retained(relay, relay->head))
+   {
+      struct relay_chunk *next = relay->head->next;
+      free(relay->head);
+      relay->head = next;
+   }
+}
+
+/* Queue whatever's pending for this client into its send buffer, as much as
+ * fits */
+static void relay_client_fill(struct netplay_relay *relay,
+      struct relay_client *client, struct relay_chunk *end)
+{
+   size_t queued;
+
+   if (client->keyframe && client->keyframe_offset < client->keyframe->size)
+   {
+      queued = netplay_send_queue(&client->sbuf,
+            client->keyframe->data + client->keyframe_offset,
+            client->keyframe->size - client->keyframe_offset);
+      client->keyframe_offset += queued;
+      relay->bytes_queued     += queued;
+      if (client->keyframe_offset < client->keyframe->size)
+         return;
+   }
+
+   while (client->last != end)
+   {
+      struct relay_chunk *next = client->last->next;
+
+      if ((next->only == RELAY_ALL || next->only == client->id) &&
+          next->except != client->id)
+      {
+         queued = netplay_send_queue(&client->sbuf,
+               next->data + client->offset, next->size - client->offset);
+         client->offset      += queued;
+         relay->bytes_queued += queued;
+         if (client->offset < next->size)
+            return;
+      }
+
+      client->last   = next;
+      client->offset = 0;
+   }
+}
+
+/**
+ * relay_client_send
+ *
+ * Send as much as the socket will take. Called by the I/O thread without the
+ * lock held, with the client marked busy.
+ *
+ * Returns false on socket failure. Sets *blocked if the socket filled up.
+ */
+static bool relay_client_send(struct netplay_relay *relay,
+      struct relay_client *client, struct relay_chunk *end, bool *blocked)
+{
+   *blocked = false;
+
+   for (;;)
+   {
+      relay_client_fill(relay, client, end);
+
+      if (!netplay_send_flush(&client->sbuf, client->fd, false))
+         return false;
+
+      if (client->sbuf.start != client->sbuf.end)
+      {
+         *blocked = true;
+         return true;
+      }
+
+      if (client->last == end &&
+          (!client->keyframe ||
+           client->keyframe_offset == client->keyframe->size))
+         return true;
+   }
+}
+
+/* Compress a keyframe. Called by the I/O thread without the lock held. */
+static struct relay_chunk *relay_compress_keyframe(
+      struct netplay_relay *relay, const uint8_t *state, size_t size,
+      uint32_t frame)
+{
+   uint32_t rd, wn;
+   uint32_t *header;
+   size_t zsize = size * 2 + 64;
+   struct relay_chunk *chunk = relay_chunk_new(4*sizeof(uint32_t) + zsize);
+   if (!chunk)
+      return NULL;
+
+   relay->compression_backend->set_in(relay->compression_stream,
+         state, (uint32_t)size);
+   relay->compression_backend->set_out(relay->compression_stream,
+         chunk->data + 4*sizeof(uint32_t), (uint32_t)zsize);
+   if (!relay->compression_backend->trans(relay->compression_stream, true,
+            &rd, &wn, NULL) || rd != size)
+   {
+      free(chunk);
+      return NULL;
+   }
+
+   header    = (uint32_t*)chunk->data;
+   header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE);
+   header[1] = htonl(wn + 2*sizeof(uint32_t));
+   header[2] = htonl(frame);
+   header[3] = htonl((uint32_t)size);
+   chunk->size = 4*sizeof(uint32_t) + wn;
+
+   return chunk;
+}
+
+static void relay_thread(void *data)
+{
+   struct netplay_relay *relay = (struct netplay_relay*)data;
+
+   slock_lock(relay->lock);
+   while (!relay->quit)
+   {
+      size_t i;
+      bool any_blocked = false;
+
+      relay->work = false;
+
+      /* Compress any new keyframe */
+      if (relay->raw_pending && !relay->compressed)
+      {
+         struct relay_chunk *chunk;
+         slock_unlock(relay->lock);
+         chunk = relay_compress_keyframe(relay, relay->raw_state,
+               relay->raw_size, relay->raw_join.frame);
+         slock_lock(relay->lock);
+         if (chunk)
+         {
+            relay->compressed      = chunk;
+            relay->compressed_join = relay->raw_join;
+         }
+         relay->raw_pending = false;
+      }
+
+      /* Send to everybody */
+      for (i = 0; i < relay->clients_size; i++)
+      {
+         struct relay_client *client = relay->clients[i];
+         struct relay_chunk *end     = relay->tail;
+         bool blocked                = false;
+         bool ok;
+
+         if (!client || client->failed)
+            continue;
+
+         client->busy = true;
+         slock_unlock(relay->lock);
+         ok = relay_client_send(relay, client, end, &blocked);
+         slock_lock(relay->lock);
+         client->busy = false;
+
+         if (!ok)
+            client->failed = true;
+         else if (blocked)
+            any_blocked = true;
+
+         /* Done with the keyframe? */
+         if (client->keyframe &&
+             client->keyframe_offset == client->keyframe->size)
+         {
+            relay_keyframe_release(client->keyframe);
+            client->keyframe = NULL;
+         }
+      }
+      scond_signal(relay->idle_cond);
+
+      relay_trim(relay);
+
+      if (relay->work || relay->quit)
+         continue;
+      if (any_blocked)
+         scond_wait_timeout(relay->cond, relay->lock, RELAY_RETRY_USEC);
+      else
+         scond_wait(relay->cond, relay->lock);
+   }
+   slock_unlock(relay->lock);
+}
+
+/* Must be called with the lock held */
+static void relay_wake(struct netplay_relay *relay)
+{
+   relay->work = true;
+   scond_signal(relay->cond);
+}
+
+/* Relay ID of a connection, if it's relayed */
+static uint32_t relay_id(struct netplay_connection *connection)
+{
+   if (!connection || !connection->relayed)
+      return RELAY_ALL;
+   return connection->relay_id;
+}
+
+static struct relay_client *relay_find_client(struct netplay_relay *relay,
+      uint32_t id, size_t *idx)
+{
+   size_t i;
+   for (i = 0; i < relay->clients_size; i++)
+   {
+      struct relay_client *client = relay->clients[i];
+      if (client && client->id == id)
+      {
+         if (idx)
+            *idx = i;
+         return client;
+      }
+   }
+   return NULL;
+}
+
+/* Append the batch to the stream */
+static bool relay_commit(struct netplay_relay *relay)
+{
+   struct relay_chunk *chunk;
+
+   if (!relay->batch_size)
+      return true;
+
+   chunk = relay_chunk_new(relay->batch_size);
+   if (!chunk)
+      return false;
+   memcpy(chunk->data, relay->batch, relay->batch_size);
+   chunk->only       = relay->batch_only;
+   chunk->except     = relay->batch_except;
+   relay->batch_size = 0;
+
+   slock_lock(relay->lock);
+   relay->tail->next = chunk;
+   relay->tail       = chunk;
+   relay_wake(relay);
+   slock_unlock(relay->lock);
+
+   return true;
+}
+
+/**
+ * netplay_relay_init
+ * @netplay              : pointer to netplay object
+ * @keyframe_interval    : frames between keyframes
+ *
+ * Start relaying to spectators.
+ *
+ * Returns true if the relay is running.
+ */
+bool netplay_relay_init(netplay_t *netplay, unsigned keyframe_interval)
+{
+   struct netplay_relay *relay = (struct netplay_relay*)
+      calloc(1, sizeof(*relay));
+   if (!relay)
+      return false;
+
+   relay->keyframe_interval = keyframe_interval ? keyframe_interval : 1;
+   relay->batch_only        = RELAY_ALL;
+   relay->batch_except      = RELAY_ALL;
+
+   /* Keyframes are compressed the way the server prefers */
+#if HAVE_ZLIB
+   relay->compression_backend = trans_stream_get_zlib_deflate_backend();
+   relay->compression         = NETPLAY_COMPRESSION_ZLIB;
+#endif
+   if (!relay->compression_backend)
+   {
+      relay->compression_backend = trans_stream_get_pipe_backend();
+      relay->compression         = 0;
+   }
+   relay->compression_stream = relay->compression_backend->stream_new();
+
+   /* The stream starts with an empty chunk, so there's always a tail */
+   relay->head = relay->tail = relay_chunk_new(0);
+
+   relay->lock      = slock_new();
+   relay->cond      = scond_new();
+   relay->idle_cond = scond_new();
+
+   if (!relay->compression_stream || !relay->head || !relay->lock ||
+       !relay->cond || !relay->idle_cond)
+      goto error;
+
+   relay->thread = sthread_create(relay_thread, relay);
+   if (!relay->thread)
+      goto error;
+
+   netplay->relay = relay;
+   RARCH_LOG("Netplay spectator relay started, keyframes every %u frames.\n",
+         relay->keyframe_interval);
+   return true;
+
+error:
+   if (relay->compression_stream)
+      relay->compression_backend->stream_free(relay->compression_stream);
+   if (relay->head)
+      free(relay->head);
+   if (relay->lock)
+      slock_free(relay->lock);
+   if (relay->cond)
+      scond_free(relay->cond);
+   if (relay->idle_cond)
+      scond_free(relay->idle_cond);
+   free(relay);
+   RARCH_WARN("Failed to start the netplay spectator relay.\n");
+   return false;
+}
+
+/**
+ * netplay_relay_free
+ * @netplay              : pointer to netplay object
+ *
+ * Stop relaying and free the relay. Relayed connections' sockets are left to
+ * the caller.
+ */
+void netplay_relay_free(netplay_t *netplay)
+{
+   size_t i;
+   struct netplay_relay *relay = netplay->relay;
+
+   if (!relay)
+      return;
+
+   slock_lock(relay->lock);
+   relay->quit = true;
+   relay_wake(relay);
+   slock_unlock(relay->lock);
+   sthread_join(relay->thread);
+
+   RARCH_LOG("Netplay spectator relay: %u keyframes, %llu bytes sent.\n",
+         relay->keyframes, (unsigned long long)relay->bytes_queued);
+
+   for (i = 0; i < relay->clients_size; i++)
+   {
+      struct relay_client *client = relay->clients[i];
+      if (!client)
+         continue;
+      relay_keyframe_release(client->keyframe);
+      netplay_deinit_socket_buffer(&client->sbuf);
+      free(client);
+   }
+   free(relay->clients);
+
+   while (relay->head)
+   {
+      struct relay_chunk *next = relay->head->next;
+      free(relay->head);
+      relay->head = next;
+   }
+   relay_keyframe_release(relay->keyframe);
+   if (relay->compressed)
+      free(relay->compressed);
+
+   free(relay->raw_state);
+   free(relay->batch);
+   relay->compression_backend->stream_free(relay->compression_stream);
+   scond_free(relay->idle_cond);
+   scond_free(relay->cond);
+   slock_free(relay->lock);
+   free(relay);
+   netplay->relay = NULL;
+}
+
+/**
+ * netplay_relay_queue
+ * @netplay              : pointer to netplay object
+ * @only                 : relayed connection to send to, or NULL for all
+ * @except               : connection not to send to, or NULL
+ * @data                 : data
+ * @size                 : size of the data
+ *
+ * Queue raw data for relayed connections. It's sent with the rest of the
+ * frame's commands by netplay_relay_flush.
+ *
+ * Returns false if the data couldn't be queued.
+ */
+bool netplay_relay_queue(netplay_t *netplay,
+      struct netplay_connection *only, struct netplay_connection *except,
+      const void *data, size_t size)
+{
+   struct netplay_relay *relay = netplay->relay;
+   uint32_t only_id            = relay_id(only);
+   uint32_t except_id          = relay_id(except);
+
+   if (!relay)
+      return false;
+
+   /* Data for different recipients goes in different chunks */
+   if (relay->batch_size &&
+       (relay->batch_only != only_id || relay->batch_except != except_id))
+   {
+      if (!relay_commit(relay))
+         return false;
+   }
+   relay->batch_only   = only_id;
+   relay->batch_except = except_id;
+
+   if (relay->batch_size + size > relay->batch_cap)
+   {
+      size_t new_cap = relay->batch_cap ? relay->batch_cap : 256;
+      uint8_t *new_batch;
+      while (relay->batch_size + size > new_cap)
+         new_cap *= 2;
+      new_batch = (uint8_t*)realloc(relay->batch, new_cap);
+      if (!new_batch)
+         return false;
+      relay->batch     = new_batch;
+      relay->batch_cap = new_cap;
+   }
+
+   memcpy(relay->batch + relay->batch_size, data, size);
+   relay->batch_size += size;
+   return true;
+}
+
+/**
+ * netplay_relay_queue_cmd
+ * @netplay              : pointer to netplay object
+ * @only                 : relayed connection to send to, or NULL for all
+ * @except               : connection not to send to, or NULL
+ * @cmd                  : command
+ * @data                 : payload
+ * @size                 : size of the payload
+ *
+ * Queue a command for relayed connections.
+ *
+ * Returns false if the command couldn't be queued.
+ */
+bool netplay_relay_queue_cmd(netplay_t *netplay,
+      struct netplay_connection *only, struct netplay_connection *except,
+      uint32_t cmd, const void *data, size_t size)
+{
+   uint32_t cmdbuf[2];
+
+   cmdbuf[0] = htonl(cmd);
+   cmdbuf[1] = htonl((uint32_t)size);
+
+   if (!netplay_relay_queue(netplay, only, except, cmdbuf, sizeof(cmdbuf)))
+      return false;
+   if (size > 0)
+      return netplay_relay_queue(netplay, only, except, data, size);
+   return true;
+}
+
+/**
+ * netplay_relay_flush
+ * @netplay              : pointer to netplay object
+ *
+ * Hand the commands queued so far to the I/O thread.
+ */
+void netplay_relay_flush(netplay_t *netplay)
+{
+   if (netplay->relay && !relay_commit(netplay->relay))
+      RARCH_ERR("Netplay spectator relay failed to queue data.\n");
+}
+
+/**
+ * netplay_relay_compression
+ * @netplay              : pointer to netplay object
+ *
+ * The compression relayed connections must use.
+ */
+uint32_t netplay_relay_compression(netplay_t *netplay)
+{
+   return netplay->relay ? netplay->relay->compression : 0;
+}
+
+/**
+ * netplay_relay_pre_frame
+ * @netplay              : pointer to netplay object
+ *
+ * Called before the frame's input is sent. If a keyframe is due, remember
+ * where this frame starts in the stream.
+ */
+void netplay_relay_pre_frame(netplay_t *netplay)
+{
+   uint32_t connected_players;
+   struct netplay_relay *relay = netplay->relay;
+
+   if (!relay || relay->candidate ||
+       (netplay->quirks & (NETPLAY_QUIRK_NO_SAVESTATES
+                          |NETPLAY_QUIRK_NO_TRANSMISSION
+                          |NETPLAY_QUIRK_INITIALIZATION)))
+      return;
+
+   if (relay->keyframe &&
+       netplay->self_frame_count <
+         relay->keyframe_join.frame + relay->keyframe_interval)
+      return;
+
+   /* Everything before this frame's input goes before the mark */
+   if (!relay_commit(relay))
+      return;
+
+   connected_players = netplay->connected_players;
+   if (netplay->self_mode == NETPLAY_CONNECTION_PLAYING)
+      connected_players |= 1<<netplay->self_player;
+   if (netplay->local_paused || netplay->remote_paused)
+      connected_players |= NETPLAY_CMD_SYNC_BIT_PAUSED;
+
+   slock_lock(relay->lock);
+   relay->candidate                           = true;
+   relay->candidate_join.mark                 = relay->tail;
+   relay->candidate_join.frame                = netplay->self_frame_count;
+   relay->candidate_join.connected_players    = connected_players;
+   relay->candidate_join.flip_frame           =
+      netplay->flip ? netplay->flip_frame : 0;
+   slock_unlock(relay->lock);
+}
+
+/**
+ * netplay_relay_post_frame
+ * @netplay              : pointer to netplay object
+ *
+ * Called after each frame. Sends the frame's commands, moves keyframes along
+ * and hangs up on spectators we failed to send to.
+ */
+void netplay_relay_post_frame(netplay_t *netplay)
+{
+   size_t i;
+   struct netplay_relay *relay = netplay->relay;
+
+   if (!relay)
+      return;
+
+   netplay_relay_flush(netplay);
+
+   slock_lock(relay->lock);
+
+   /* Publish a freshly compressed keyframe */
+   if (relay->compressed)
+   {
+      relay_keyframe_release(relay->keyframe);
+      relay->keyframe      = relay->compressed;
+      relay->keyframe_join = relay->compressed_join;
+      relay->compressed    = NULL;
+      relay->keyframes++;
+   }
+
+   /* Once the candidate frame's input is all in, its state is good */
+   if (relay->candidate && !relay->raw_pending &&
+       netplay->other_frame_count >= relay->candidate_join.frame &&
+       netplay->run_frame_count > relay->candidate_join.frame)
+   {
+      struct delta_frame *delta = netplay_delta_find_frame(netplay,
+            relay->candidate_join.frame);
+
+      if (delta && relay->raw_size < netplay->state_size)
+      {
+         uint8_t *raw_state = (uint8_t*)realloc(relay->raw_state,
+               netplay->state_size);
+         if (raw_state)
+         {
+            relay->raw_state = raw_state;
+            relay->raw_size  = netplay->state_size;
+         }
+         else
+            delta = NULL;
+      }
+
+      if (delta)
+      {
+         memcpy(relay->raw_state, delta->state, netplay->state_size);
+         relay->raw_size    = netplay->state_size;
+         relay->raw_join    = relay->candidate_join;
+         relay->raw_pending = true;
+         relay_wake(relay);
+      }
+
+      /* If we lost the state, we'll try again on a later frame */
+      relay->candidate = false;
+   }
+
+   /* Hang up on anybody the I/O thread gave up on */
+   for (i = 0; i < relay->clients_size; i++)
+   {
+      struct relay_client *client = relay->clients[i];
+      if (client && client->failed && client->conn < netplay->connections_size)
+      {
+         slock_unlock(relay->lock);
+         netplay_hangup(netplay, &netplay->connections[client->conn]);
+         slock_lock(relay->lock);
+      }
+   }
+
+   slock_unlock(relay->lock);
+}
+
+/**
+ * netplay_relay_wants_state
+ * @netplay              : pointer to netplay object
+ * @frame                : frame being replayed
+ *
+ * Whether the relay will want the state of this frame for a keyframe.
+ */
+bool netplay_relay_wants_state(netplay_t *netplay, uint32_t frame)
+{
+   return netplay->relay && netplay->relay->candidate &&
+      netplay->relay->candidate_join.frame == frame;
+}
+
+/**
+ * netplay_relay_join_info
+ * @netplay              : pointer to netplay object
+ * @connection           : connection being synchronized
+ * @frame                : set to the frame to sync to
+ * @connected_players    : set to the players connected as of that frame
+ * @flip_frame           : set to the flip frame as of that frame
+ *
+ * Decide whether a new connection should be relayed. Connections are relayed
+ * if they'd be spectators anyway, and can take our keyframes and hashes. A
+ * relayed connection is synchronized to the last keyframe, and catches up
+ * from there.
+ *
+ * Returns true if the connection should be relayed.
+ */
+bool netplay_relay_join_info(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t *frame,
+      uint32_t *connected_players, uint32_t *flip_frame)
+{
+   uint32_t player;
+   struct netplay_relay *relay = netplay->relay;
+
+   if (!relay || !relay->keyframe ||
+       !connection->hash_xxh64 ||
+       connection->compression_supported != relay->compression)
+      return false;
+
+   /* Would they be able to play? */
+   if (connection->can_play)
+   {
+      for (player = 0; player <= netplay->player_max; player++)
+      {
+         if (!(netplay->self_mode == NETPLAY_CONNECTION_PLAYING &&
+               netplay->self_player == player) &&
+             !(netplay->connected_players & (1<<player)))
+            return false;
+      }
+   }
+
+   *frame             = relay->keyframe_join.frame;
+   *connected_players = relay->keyframe_join.connected_players;
+   *flip_frame        = relay->keyframe_join.flip_frame;
+   return true;
+}
+
+/**
+ * netplay_relay_attach
+ * @netplay              : pointer to netplay object
+ * @connection           : connection to relay
+ *
+ * Hand a connection over to the relay. It gets the keyframe given by
+ * netplay_relay_join_info, then the stream from there. Must be called in the
+ * same frame as netplay_relay_join_info.
+ *
+ * Returns true if the connection is now relayed.
+ */
+bool netplay_relay_attach(netplay_t *netplay,
+      struct netplay_connection *connection)
+{
+   size_t i;
+   struct netplay_relay *relay = netplay->relay;
+   struct relay_client *client;
+
+   if (!relay || !relay->keyframe)
+      return false;
+
+   client = (struct relay_client*)calloc(1, sizeof(*client));
+   if (!client)
+      return false;
+
+   /* The stream up to here may still be queued for others */
+   if (!relay_commit(relay))
+   {
+      free(client);
+      return false;
+   }
+
+   slock_lock(relay->lock);
+
+   for (i = 0; i < relay->clients_size; i++)
+      if (!relay->clients[i])
+         break;
+   if (i == relay->clients_size)
+   {
+      size_t new_size = relay->clients_size ? relay->clients_size * 2 : 4;
+      struct relay_client **new_clients = (struct relay_client**)
+         realloc(relay->clients, new_size * sizeof(*new_clients));
+      if (!new_clients)
+      {
+         slock_unlock(relay->lock);
+         free(client);
+         return false;
+      }
+      memset(new_clients + relay->clients_size, 0,
+            (new_size - relay->clients_size) * sizeof(*new_clients));
+      relay->clients      = new_clients;
+      relay->clients_size = new_size;
+   }
+
+   if (++relay->next_id == RELAY_ALL)
+      relay->next_id++;
+   client->id       = relay->next_id;
+   client->conn     = connection - netplay->connections;
+   client->fd       = connection->fd;
+   client->sbuf     = connection->send_packet_buffer;
+   client->keyframe = relay->keyframe;
+   client->last     = relay->keyframe_join.mark;
+   relay->keyframe->refs++;
+   relay->clients[i] = client;
+
+   /* From here on, the I/O thread does all our sending */
+   memset(&connection->send_packet_buffer, 0,
+         sizeof(connection->send_packet_buffer));
+   connection->relayed  = true;
+   connection->relay_id = client->id;
+
+   relay_wake(relay);
+   slock_unlock(relay->lock);
+
+   RARCH_LOG("Netplay relaying to connection %u from frame %u.\n",
+         (unsigned)client->conn, relay->keyframe_join.frame);
+   return true;
+}
+
+/**
+ * relay_detach
+ *
+ * Take a client away from the I/O thread. If max_pending is nonzero and no
+ * more than that is still to be sent, it's moved into the connection's own
+ * send buffer. Otherwise, if max_pending is nonzero, the client stays.
+ */
+static bool relay_detach(netplay_t *netplay,
+      struct netplay_connection *connection, size_t max_pending)
+{
+   size_t idx;
+   size_t pending = 0;
+   struct netplay_relay *relay = netplay->relay;
+   struct relay_client *client;
+   struct relay_chunk *chunk;
+
+   if (!relay || !connection->relayed)
+      return true;
+
+   relay_commit(relay);
+
+   slock_lock(relay->lock);
+   client = relay_find_client(relay, connection->relay_id, &idx);
+   if (!client)
+   {
+      slock_unlock(relay->lock);
+      connection->relayed = false;
+      return true;
+   }
+   while (client->busy)
+      scond_wait(relay->idle_cond, relay->lock);
+
+   if (max_pending)
+   {
+      /* How far behind are they? */
+      if (client->keyframe)
+         pending += client->keyframe->size - client->keyframe_offset;
+      for (chunk = client->last; chunk != relay->tail && pending <= max_pending;
+            chunk = chunk->next)
+      {
+         struct relay_chunk *next = chunk->next;
+         if ((next->only == RELAY_ALL || next->only == client->id) &&
+             next->except != client->id)
+            pending += next->size;
+      }
+      if (pending > max_pending)
+      {
+         slock_unlock(relay->lock);
+         return false;
+      }
+   }
+
+   relay->clients[idx] = NULL;
+   connection->send_packet_buffer = client->sbuf;
+   connection->relayed            = false;
+
+   if (max_pending)
+   {
+      /* Everything not yet sent goes to the connection's own buffer */
+      if (client->keyframe)
+         netplay_send(&connection->send_packet_buffer, connection->fd,
+               client->keyframe->data + client->keyframe_offset,
+               client->keyframe->size - client->keyframe_offset);
+      for (chunk = client->last; chunk != relay->tail; chunk = chunk->next)
+      {
+         struct relay_chunk *next = chunk->next;
+         if ((next->only == RELAY_ALL || next->only == client->id) &&
+             next->except != client->id)
+         {
+            netplay_send(&connection->send_packet_buffer, connection->fd,
+                  next->data + client->offset, next->size - client->offset);
+         }
+         client->offset = 0;
+      }
+   }
+
+   relay_keyframe_release(client->keyframe);
+   relay_wake(relay);
+   slock_unlock(relay->lock);
+
+   free(client);
+   return true;
+}
+
+/**
+ * netplay_relay_detach
+ * @netplay              : pointer to netplay object
+ * @connection           : relayed connection
+ *
+ * Take a connection back from the relay so it can be sent to directly, for
+ * instance because it's becoming a player. Only spectators that have caught
+ * up can be detached.
+ *
+ * Returns true if the connection is no longer relayed.
+ */
+bool netplay_relay_detach(netplay_t *netplay,
+      struct netplay_connection *connection)
+{
+   return relay_detach(netplay, connection, RELAY_DETACH_MAX);
+}
+
+/**
+ * netplay_relay_remove
+ * @netplay              : pointer to netplay object
+ * @connection           : relayed connection
+ *
+ * Drop a connection from the relay, discarding whatever wasn't sent, so its
+ * socket can be closed.
+ */
+void netplay_relay_remove(netplay_t *netplay,
+      struct netplay_connection *connection)
+{
+   relay_detach(netplay, connection, 0);
+}
+
+#else
+
+bool netplay_relay_init(netplay_t *netplay, unsigned keyframe_interval)
+{
+   RARCH_WARN("Netplay spectator relay requires threads.\n");
+   return false;
+}
+
+void netplay_relay_free(netplay_t *netplay) { }
+
+bool netplay_relay_queue(netplay_t *netplay,
+      struct netplay_connection *only, struct netplay_connection *except,
+      const void *data, size_t size)
+{
+   return false;
+}
+
+bool netplay_relay_queue_cmd(netplay_t *netplay,
+      struct netplay_connection *only, struct netplay_connection *except,
+      uint32_t cmd, const void *data, size_t size)
+{
+   return false;
+}
+
+void netplay_relay_flush(netplay_t *netplay) { }
+
+uint32_t netplay_relay_compression(netplay_t *netplay)
+{
+   return 0;
+}
+
+void netplay_relay_pre_frame(netplay_t *netplay) { }
+
+void netplay_relay_post_frame(netplay_t *netplay) { }
+
+bool netplay_relay_wants_state(netplay_t *netplay, uint32_t frame)
+{
+   return false;
+}
+
+bool netplay_relay_join_info(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t *frame,
+      uint32_t *connected_players, uint32_t *flip_frame)
+{
+   return false;
+}
+
+bool netplay_relay_attach(netplay_t *netplay,
+      struct netplay_connection *connection)
+{
+   return false;
+}
+
+bool netplay_relay_detach(netplay_t *netplay,
+      struct netplay_connection *connection)
+{
+   return true;
+}
+
+void netplay_relay_remove(netplay_t *netplay,
+      struct netplay_connection *connection) { }
+
+#endif
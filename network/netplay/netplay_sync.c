@@ -24,6 +24,7 @@
 #include "netplay_private.h"
 
 #include "../../autosave.h"
+#include "../../configuration.h"
 #include "../../driver.h"
 #include "../../input/input_driver.h"
 
@@ -139,15 +140,41 @@ static void netplay_handle_frame_hash(netplay_t *netplay, struct delta_frame *de
       if (netplay->check_frames &&
           delta->frame % abs(netplay->check_frames) == 0)
       {
-         delta->crc = netplay_delta_frame_crc(netplay, delta);
+         size_t i;
+         bool need_crc  = false;
+         /* The relay's stream always carries xxHash64 */
+         bool need_hash = (netplay->relay != NULL);
+
+         /* Only compute the kinds of hash our clients understand */
+         for (i = 0; i < netplay->connections_size; i++)
+         {
+            struct netplay_connection *connection = &netplay->connections[i];
+            if (!connection->active ||
+                connection->mode < NETPLAY_CONNECTION_CONNECTED)
+               continue;
+            if (connection->hash_xxh64)
+               need_hash = true;
+            else
+               need_crc  = true;
+         }
+
+         if (need_crc)
+            delta->crc  = netplay_delta_frame_crc(netplay, delta);
+         if (need_hash)
+            delta->hash = netplay_delta_frame_hash(netplay, delta);
          netplay_cmd_crc(netplay, delta);
       }
    }
-   else if (delta->crc && netplay->crcs_valid)
+   else if ((delta->crc || delta->hash) && netplay->crcs_valid)
    {
-      /* We have a remote CRC, so check it */
-      uint32_t local_crc = netplay_delta_frame_crc(netplay, delta);
-      if (local_crc != delta->crc)
+      /* We have a remote hash, so check it */
+      bool match;
+      if (delta->hash)
+         match = (netplay_delta_frame_hash(netplay, delta) == delta->hash);
+      else
+         match = (netplay_delta_frame_crc(netplay, delta) == delta->crc);
+
+      if (!match)
       {
          if (!netplay->crc_validity_checked)
          {
@@ -169,13 +196,48 @@ static void netplay_handle_frame_hash(netplay_t *netplay, struct delta_frame *de
             }
          }
       }
-      else if (!netplay->crc_validity_checked)
+      else
       {
-         netplay->crc_validity_checked = true;
+         if (!netplay->crc_validity_checked)
+            netplay->crc_validity_checked = true;
+
+         /* Remember this as a base for delta savestates */
+         netplay->have_crc_match  = true;
+         netplay->crc_match_frame = delta->frame;
       }
    }
 }
 
+/**
+ * netplay_clear_state
+ * @netplay              : pointer to netplay object
+ * @serial_info          : state buffer about to be serialized into
+ *
+ * Clears whatever part of the state buffer the core won't overwrite, so
+ * stale bytes never reach the frame hashes or deltas. Cores that write
+ * the whole state every time don't pay for a clear at all.
+ */
+static void netplay_clear_state(netplay_t *netplay,
+      retro_ctx_serialize_info_t *serial_info)
+{
+   retro_ctx_size_info_t info;
+
+   if ((netplay->quirks & (NETPLAY_QUIRK_INITIALIZATION
+               | NETPLAY_QUIRK_NO_SAVESTATES
+               | NETPLAY_QUIRK_VARIABLE_SIZE))
+         || netplay->run_frame_count == 0)
+   {
+      memset(serial_info->data, 0, serial_info->size);
+      return;
+   }
+
+   /* The state can shrink without the core declaring it */
+   core_serialize_size(&info);
+   if (info.size < serial_info->size)
+      memset((uint8_t*)serial_info->data + info.size, 0,
+            serial_info->size - info.size);
+}
+
 /**
  * netplay_sync_pre_frame
  * @netplay              : pointer to netplay object
@@ -192,7 +254,8 @@ bool netplay_sync_pre_frame(netplay_t *netplay)
       serial_info.data = netplay->buffer[netplay->run_ptr].state;
       serial_info.size = netplay->state_size;
 
-      memset(serial_info.data, 0, serial_info.size);
+      netplay_clear_state(netplay, &serial_info);
+
       if ((netplay->quirks & NETPLAY_QUIRK_INITIALIZATION) || netplay->run_frame_count == 0)
       {
          /* Don't serialize until it's safe */
@@ -234,6 +297,9 @@ bool netplay_sync_pre_frame(netplay_t *netplay)
          netplay->stall = NETPLAY_STALL_NO_CONNECTION;
    }
 
+   /* Spectators on the relay may join from this frame */
+   netplay_relay_pre_frame(netplay);
+
    if (netplay->is_server)
    {
       fd_set fds;
@@ -354,6 +420,195 @@ process:
    return (netplay->stall != NETPLAY_STALL_NO_CONNECTION);
 }
 
+/**
+ * netplay_replay_budget
+ *
+ * How long replay may take in a single host frame, in microseconds.
+ */
+static retro_time_t netplay_replay_budget(void)
+{
+   settings_t *settings = config_get_ptr();
+   float refresh_rate   = settings->video.refresh_rate;
+
+   if (refresh_rate <= 0.0f)
+      refresh_rate = 60.0f;
+
+   return (retro_time_t)(1000000.0f / refresh_rate)
+      * NETPLAY_REPLAY_BUDGET_PERCENT / 100;
+}
+
+/**
+ * netplay_replay_needs_state
+ * @netplay             : pointer to netplay object
+ * @delta               : frame about to be replayed
+ *
+ * Whether replay needs to save the state of this frame. Frames before
+ * unread_frame_count can never be rewound to again, so their state is only
+ * needed to check hashes.
+ */
+static bool netplay_replay_needs_state(netplay_t *netplay,
+      struct delta_frame *delta)
+{
+   if (netplay->replay_frame_count >= netplay->unread_frame_count)
+      return true;
+
+   /* We know the remote hash, or expect one */
+   if (delta->crc || delta->hash)
+      return true;
+   if (netplay->check_frames &&
+       delta->frame % abs(netplay->check_frames) == 0)
+      return true;
+
+   /* The spectator relay wants it for a keyframe */
+   if (netplay_relay_wants_state(netplay, delta->frame))
+      return true;
+
+   return false;
+}
+
+/**
+ * netplay_sync_replay
+ * @netplay             : pointer to netplay object
+ * @budget              : maximum time to spend replaying in microseconds, or
+ *                        0 for no limit
+ *
+ * Replay from other_ptr up to run_ptr with the real input. If the budget runs
+ * out, the replay is resumed on the next frame.
+ */
+static void netplay_sync_replay(netplay_t *netplay, retro_time_t budget)
+{
+   retro_ctx_serialize_info_t serial_info;
+   retro_time_t replay_start = cpu_features_get_time_usec();
+
+   netplay->is_replay = true;
+
+   if (!netplay->replay_pending)
+   {
+      uint32_t depth;
+
+      /* Replay frames. */
+      netplay->replay_ptr = netplay->other_ptr;
+      netplay->replay_frame_count = netplay->other_frame_count;
+
+      if (netplay->quirks & NETPLAY_QUIRK_INITIALIZATION)
+         /* Make sure we're initialized before we start loading things */
+         netplay_wait_and_init_serialization(netplay);
+
+      serial_info.data       = NULL;
+      serial_info.data_const = netplay->buffer[netplay->replay_ptr].state;
+      serial_info.size       = netplay->state_size;
+
+      if (!core_unserialize(&serial_info))
+      {
+         RARCH_ERR("Netplay savestate loading failed: Prepare for desync!\n");
+      }
+
+      depth = netplay->run_frame_count - netplay->replay_frame_count;
+      netplay->rollback_count++;
+      netplay->rollback_depth_last   = depth;
+      netplay->rollback_depth_total += depth;
+      if (depth > netplay->rollback_depth_max)
+         netplay->rollback_depth_max = depth;
+   }
+
+   while (netplay->replay_frame_count < netplay->run_frame_count)
+   {
+      retro_time_t start, tm;
+
+      struct delta_frame *ptr = &netplay->buffer[netplay->replay_ptr];
+      serial_info.data       = ptr->state;
+      serial_info.size       = netplay->state_size;
+      serial_info.data_const = NULL;
+
+      start = cpu_features_get_time_usec();
+
+      /* Remember the current state */
+      if (netplay_replay_needs_state(netplay, ptr))
+      {
+         netplay_clear_state(netplay, &serial_info);
+         core_serialize(&serial_info);
+         ptr->state_stale = false;
+         if (netplay->replay_frame_count < netplay->unread_frame_count)
+            netplay_handle_frame_hash(netplay, ptr);
+      }
+      else
+      {
+         ptr->state_stale = true;
+         netplay->replay_serialize_skipped++;
+      }
+
+      /* Re-simulate this frame's input */
+      netplay_simulate_input(netplay, netplay->replay_ptr, true);
+
+      autosave_lock();
+      core_run();
+      autosave_unlock();
+      netplay->replay_ptr = NEXT_PTR(netplay->replay_ptr);
+      netplay->replay_frame_count++;
+
+#ifdef DEBUG_NONDETERMINISTIC_CORES
+      if (ptr->have_remote && netplay_delta_frame_ready(netplay, &netplay->buffer[netplay->replay_ptr], netplay->replay_frame_count))
+      {
+         RARCH_LOG("PRE  %u: %X\n", netplay->replay_frame_count-1, netplay_delta_frame_crc(netplay, ptr));
+         if (netplay->is_server)
+            RARCH_LOG("INP  %X %X\n", ptr->real_input_state[0], ptr->self_state[0]);
+         else
+            RARCH_LOG("INP  %X %X\n", ptr->self_state[0], ptr->real_input_state[0]);
+         ptr = &netplay->buffer[netplay->replay_ptr];
+         serial_info.data = ptr->state;
+         memset(serial_info.data, 0, serial_info.size);
+         core_serialize(&serial_info);
+         RARCH_LOG("POST %u: %X\n", netplay->replay_frame_count-1, netplay_delta_frame_crc(netplay, ptr));
+      }
+#endif
+
+      /* Get our time window */
+      tm = cpu_features_get_time_usec() - start;
+      netplay->frame_run_time_sum -= netplay->frame_run_time[netplay->frame_run_time_ptr];
+      netplay->frame_run_time[netplay->frame_run_time_ptr] = tm;
+      netplay->frame_run_time_sum += tm;
+      netplay->frame_run_time_ptr++;
+      if (netplay->frame_run_time_ptr >= NETPLAY_FRAME_RUN_TIME_WINDOW)
+         netplay->frame_run_time_ptr = 0;
+
+      /* Don't let a deep rollback blow through this frame's time */
+      if (budget && start + tm - replay_start >= budget)
+         break;
+   }
+
+   /* Average our time */
+   netplay->frame_run_time_avg = netplay->frame_run_time_sum / NETPLAY_FRAME_RUN_TIME_WINDOW;
+
+   netplay->replay_time_last = cpu_features_get_time_usec() - replay_start;
+   if (netplay->replay_time_last > netplay->replay_time_max)
+      netplay->replay_time_max = netplay->replay_time_last;
+
+   netplay->is_replay    = false;
+   netplay->force_rewind = false;
+
+   if (netplay->replay_frame_count < netplay->run_frame_count)
+   {
+      /* Pick up where we left off next frame */
+      if (!netplay->replay_pending)
+         netplay->replay_deferred_count++;
+      netplay->replay_pending = true;
+      return;
+   }
+
+   netplay->replay_pending = false;
+
+   if (netplay->unread_frame_count < netplay->run_frame_count)
+   {
+      netplay->other_ptr = netplay->unread_ptr;
+      netplay->other_frame_count = netplay->unread_frame_count;
+   }
+   else
+   {
+      netplay->other_ptr = netplay->run_ptr;
+      netplay->other_frame_count = netplay->run_frame_count;
+   }
+}
+
 /**
  * netplay_sync_post_frame
  * @netplay              : pointer to netplay object
@@ -384,6 +639,10 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
    if ((netplay->is_server && !netplay->connected_players) ||
        (netplay->self_mode < NETPLAY_CONNECTION_CONNECTED))
    {
+      /* Nobody to keep up with, so just finish any replay in progress */
+      if (netplay->replay_pending)
+         netplay_sync_replay(netplay, 0);
+
       netplay->other_frame_count = netplay->self_frame_count;
       netplay->other_ptr = netplay->self_ptr;
       /* FIXME: Duplication */
@@ -423,98 +682,10 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
 #endif
 
    /* Now replay the real input if we've gotten ahead of it */
-   if (netplay->force_rewind ||
+   if (netplay->force_rewind || netplay->replay_pending ||
        (netplay->other_frame_count < netplay->unread_frame_count &&
         netplay->other_frame_count < netplay->run_frame_count))
-   {
-      retro_ctx_serialize_info_t serial_info;
-
-      /* Replay frames. */
-      netplay->is_replay = true;
-      netplay->replay_ptr = netplay->other_ptr;
-      netplay->replay_frame_count = netplay->other_frame_count;
-
-      if (netplay->quirks & NETPLAY_QUIRK_INITIALIZATION)
-         /* Make sure we're initialized before we start loading things */
-         netplay_wait_and_init_serialization(netplay);
-
-      serial_info.data       = NULL;
-      serial_info.data_const = netplay->buffer[netplay->replay_ptr].state;
-      serial_info.size       = netplay->state_size;
-
-      if (!core_unserialize(&serial_info))
-      {
-         RARCH_ERR("Netplay savestate loading failed: Prepare for desync!\n");
-      }
-
-      while (netplay->replay_frame_count < netplay->run_frame_count)
-      {
-         retro_time_t start, tm;
-
-         struct delta_frame *ptr = &netplay->buffer[netplay->replay_ptr];
-         serial_info.data       = ptr->state;
-         serial_info.size       = netplay->state_size;
-         serial_info.data_const = NULL;
-
-         start = cpu_features_get_time_usec();
-
-         /* Remember the current state */
-         memset(serial_info.data, 0, serial_info.size);
-         core_serialize(&serial_info);
-         if (netplay->replay_frame_count < netplay->unread_frame_count)
-            netplay_handle_frame_hash(netplay, ptr);
-
-         /* Re-simulate this frame's input */
-         netplay_simulate_input(netplay, netplay->replay_ptr, true);
-
-         autosave_lock();
-         core_run();
-         autosave_unlock();
-         netplay->replay_ptr = NEXT_PTR(netplay->replay_ptr);
-         netplay->replay_frame_count++;
-
-#ifdef DEBUG_NONDETERMINISTIC_CORES
-         if (ptr->have_remote && netplay_delta_frame_ready(netplay, &netplay->buffer[netplay->replay_ptr], netplay->replay_frame_count))
-         {
-            RARCH_LOG("PRE  %u: %X\n", netplay->replay_frame_count-1, netplay_delta_frame_crc(netplay, ptr));
-            if (netplay->is_server)
-               RARCH_LOG("INP  %X %X\n", ptr->real_input_state[0], ptr->self_state[0]);
-            else
-               RARCH_LOG("INP  %X %X\n", ptr->self_state[0], ptr->real_input_state[0]);
-            ptr = &netplay->buffer[netplay->replay_ptr];
-            serial_info.data = ptr->state;
-            memset(serial_info.data, 0, serial_info.size);
-            core_serialize(&serial_info);
-            RARCH_LOG("POST %u: %X\n", netplay->replay_frame_count-1, netplay_delta_frame_crc(netplay, ptr));
-         }
-#endif
-
-         /* Get our time window */
-         tm = cpu_features_get_time_usec() - start;
-         netplay->frame_run_time_sum -= netplay->frame_run_time[netplay->frame_run_time_ptr];
-         netplay->frame_run_time[netplay->frame_run_time_ptr] = tm;
-         netplay->frame_run_time_sum += tm;
-         netplay->frame_run_time_ptr++;
-         if (netplay->frame_run_time_ptr >= NETPLAY_FRAME_RUN_TIME_WINDOW)
-            netplay->frame_run_time_ptr = 0;
-      }
-
-      /* Average our time */
-      netplay->frame_run_time_avg = netplay->frame_run_time_sum / NETPLAY_FRAME_RUN_TIME_WINDOW;
-
-      if (netplay->unread_frame_count < netplay->run_frame_count)
-      {
-         netplay->other_ptr = netplay->unread_ptr;
-         netplay->other_frame_count = netplay->unread_frame_count;
-      }
-      else
-      {
-         netplay->other_ptr = netplay->run_ptr;
-         netplay->other_frame_count = netplay->run_frame_count;
-      }
-      netplay->is_replay = false;
-      netplay->force_rewind = false;
-   }
+      netplay_sync_replay(netplay, netplay_replay_budget());
 
    if (netplay->is_server)
    {
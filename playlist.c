@@ -2,7 +2,7 @@
  *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
  *  Copyright (C) 2011-2016 - Daniel De Matteis
  *  Copyright (C) 2013-2014 - Jason Fetters
- * 
+ *
  *  RetroArch is free software: you can redistribute it and/or modify it under the terms
  *  of the GNU General Public License as published by the Free Software Found-
  *  ation, either version 3 of the License, or (at your option) any later version.
@@ -20,7 +20,11 @@
 #include <string.h>
 
 #include <boolean.h>
+#include <rhash.h>
+#include <retro_miscellaneous.h>
+#include <retro_stat.h>
 #include <compat/posix_string.h>
+#include <compat/strl.h>
 #include <string/stdstring.h>
 #include <streams/file_stream.h>
 #include <file/file_path.h>
@@ -32,10 +36,475 @@
 #define PLAYLIST_ENTRIES 6
 #endif
 
+/* Changes are appended to this file next to the playlist
+ * and folded back into it once the journal holds more
+ * records than the playlist has entries. */
+#define PLAYLIST_JOURNAL_EXTENSION ".lpj"
+
+#ifndef PLAYLIST_JOURNAL_MIN_RECORDS
+#define PLAYLIST_JOURNAL_MIN_RECORDS 64
+#endif
+
+#define PLAYLIST_JOURNAL_PUSH   'P'
+#define PLAYLIST_JOURNAL_DELETE 'D'
+#define PLAYLIST_JOURNAL_UPDATE 'U'
+
+/* Binary playlists start with the magic, a version, the entry
+ * count and the size of the string table, all little-endian
+ * 32-bit. Then follows one row of PLAYLIST_ENTRIES string
+ * offsets per entry and the NUL-terminated strings, with the
+ * empty string at offset 0. */
+#define PLAYLIST_BINARY_MAGIC       "RPLB"
+#define PLAYLIST_BINARY_VERSION     1
+#define PLAYLIST_BINARY_HEADER_SIZE 16
+
 typedef int (playlist_sort_fun_t)(
       const struct playlist_entry *a,
       const struct playlist_entry *b);
 
+struct playlist_index_node
+{
+   size_t pos;
+   /* Node index + 1 of the next entry, 0 ends the chain. */
+   size_t next;
+};
+
+struct playlist_index_slot
+{
+   uint32_t hash;
+   /* Node index + 1 of the first entry, 0 if unused. */
+   size_t head;
+};
+
+/* Maps a string hash to the chain of entries with that
+ * hash, ordered by index. A position is the entry index
+ * plus 'index_base', so pushing to the top of the playlist
+ * only has to decrement the base. */
+struct playlist_index
+{
+   struct playlist_index_slot *slots;
+   size_t cap;
+   size_t used;
+
+   struct playlist_index_node *nodes;
+   size_t nodes_count;
+   size_t nodes_cap;
+};
+
+struct playlist_store
+{
+   struct playlist_index path_index;
+   struct playlist_index crc_index;
+   size_t index_base;
+   bool index_dirty;
+
+   /* Interned core path/name and database name strings,
+    * shared by all entries. */
+   char **strings;
+   size_t strings_cap;
+   size_t strings_count;
+
+   /* Journal records not written out yet. */
+   char *journal;
+   size_t journal_len;
+   size_t journal_cap;
+   unsigned journal_pending;
+   /* Records already in the journal file. */
+   unsigned journal_records;
+   /* The playlist file has to be rewritten as a whole. */
+   bool full_write;
+   bool replaying;
+
+   enum playlist_file_format format;
+
+   /* Loaded binary playlist; entry strings that point into
+    * its string table are not owned by the entries. */
+   RFILE *blob_file;
+   uint8_t *blob_buf;
+   const char *blob_strings;
+   size_t blob_strings_size;
+
+   char journal_path[PATH_MAX_LENGTH];
+};
+
+static const char *playlist_intern(playlist_t *playlist, const char *s)
+{
+   size_t i;
+   uint32_t hash;
+   struct playlist_store *store = playlist->store;
+
+   if (string_is_empty(s))
+      return NULL;
+
+   if ((store->strings_count + 1) * 2 > store->strings_cap)
+   {
+      size_t new_cap    = store->strings_cap ? store->strings_cap * 2 : 16;
+      char **strings    = (char**)calloc(new_cap, sizeof(*strings));
+
+      if (!strings)
+         return NULL;
+
+      for (i = 0; i < store->strings_cap; i++)
+      {
+         size_t j;
+         if (!store->strings[i])
+            continue;
+         j = djb2_calculate(store->strings[i]) & (new_cap - 1);
+         while (strings[j])
+            j = (j + 1) & (new_cap - 1);
+         strings[j] = store->strings[i];
+      }
+
+      free(store->strings);
+      store->strings     = strings;
+      store->strings_cap = new_cap;
+   }
+
+   hash = djb2_calculate(s);
+
+   for (i = hash & (store->strings_cap - 1); store->strings[i];
+         i = (i + 1) & (store->strings_cap - 1))
+      if (string_is_equal(store->strings[i], s))
+         return store->strings[i];
+
+   store->strings[i] = strdup(s);
+   if (store->strings[i])
+      store->strings_count++;
+   return store->strings[i];
+}
+
+static bool playlist_owns_string(playlist_t *playlist, const char *s)
+{
+   struct playlist_store *store = playlist->store;
+   return s >= store->blob_strings
+      && s < store->blob_strings + store->blob_strings_size;
+}
+
+static void playlist_free_string(playlist_t *playlist, char *s)
+{
+   if (!string_is_empty(s) && !playlist_owns_string(playlist, s))
+      free(s);
+}
+
+static char *playlist_copy_string(playlist_t *playlist, char *s)
+{
+   if (!s || !playlist_owns_string(playlist, s))
+      return s;
+   return strdup(s);
+}
+
+/**
+ * playlist_release_blob:
+ * @playlist            : Playlist handle.
+ *
+ * Copies the entry strings out of the loaded binary playlist
+ * and closes it, so that its file can be rewritten.
+ **/
+static void playlist_release_blob(playlist_t *playlist)
+{
+   size_t i;
+   struct playlist_store *store = playlist->store;
+
+   if (!store->blob_strings)
+      return;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      struct playlist_entry *entry = &playlist->entries[i];
+
+      entry->path      = playlist_copy_string(playlist, entry->path);
+      entry->label     = playlist_copy_string(playlist, entry->label);
+      entry->crc32     = playlist_copy_string(playlist, entry->crc32);
+      entry->core_path = (char*)playlist_intern(playlist, entry->core_path);
+      entry->core_name = (char*)playlist_intern(playlist, entry->core_name);
+      entry->db_name   = (char*)playlist_intern(playlist, entry->db_name);
+   }
+
+   if (store->blob_file)
+      filestream_close(store->blob_file);
+   if (store->blob_buf)
+      free(store->blob_buf);
+
+   store->blob_file         = NULL;
+   store->blob_buf          = NULL;
+   store->blob_strings      = NULL;
+   store->blob_strings_size = 0;
+}
+
+static void playlist_index_free(struct playlist_index *index)
+{
+   if (index->slots)
+      free(index->slots);
+   if (index->nodes)
+      free(index->nodes);
+   memset(index, 0, sizeof(*index));
+}
+
+static struct playlist_index_slot *playlist_index_slot(
+      struct playlist_index *index, uint32_t hash)
+{
+   size_t i;
+
+   for (i = hash & (index->cap - 1); index->slots[i].head;
+         i = (i + 1) & (index->cap - 1))
+      if (index->slots[i].hash == hash)
+         break;
+
+   return &index->slots[i];
+}
+
+static bool playlist_index_resize(struct playlist_index *index, size_t cap)
+{
+   size_t i;
+   struct playlist_index old         = *index;
+   struct playlist_index_slot *slots = (struct playlist_index_slot*)
+      calloc(cap, sizeof(*slots));
+
+   if (!slots)
+      return false;
+
+   index->slots = slots;
+   index->cap   = cap;
+
+   for (i = 0; i < old.cap; i++)
+      if (old.slots[i].head)
+         *playlist_index_slot(index, old.slots[i].hash) = old.slots[i];
+
+   if (old.slots)
+      free(old.slots);
+   return true;
+}
+
+/* Adds an entry in front of the chain of its hash; it must
+ * have a lower index than the entries already in there. */
+static void playlist_index_insert(struct playlist_index *index,
+      const char *s, size_t pos)
+{
+   uint32_t hash;
+   struct playlist_index_slot *slot = NULL;
+
+   if (string_is_empty(s))
+      return;
+
+   if ((index->used + 1) * 2 > index->cap)
+      if (!playlist_index_resize(index, index->cap ? index->cap * 2 : 64))
+         return;
+
+   if (index->nodes_count == index->nodes_cap)
+   {
+      size_t new_cap                    = index->nodes_cap
+         ? index->nodes_cap * 2 : 64;
+      struct playlist_index_node *nodes = (struct playlist_index_node*)
+         realloc(index->nodes, new_cap * sizeof(*nodes));
+
+      if (!nodes)
+         return;
+
+      index->nodes     = nodes;
+      index->nodes_cap = new_cap;
+   }
+
+   hash = djb2_calculate(s);
+   slot = playlist_index_slot(index, hash);
+
+   if (!slot->head)
+   {
+      slot->hash = hash;
+      index->used++;
+   }
+
+   index->nodes[index->nodes_count].pos  = pos;
+   index->nodes[index->nodes_count].next = slot->head;
+   slot->head                            = ++index->nodes_count;
+}
+
+static void playlist_index_rebuild(playlist_t *playlist)
+{
+   size_t i;
+   size_t cap                   = 64;
+   struct playlist_store *store = playlist->store;
+
+   while (cap < playlist->size * 2)
+      cap *= 2;
+
+   playlist_index_free(&store->path_index);
+   playlist_index_free(&store->crc_index);
+   playlist_index_resize(&store->path_index, cap);
+   playlist_index_resize(&store->crc_index, cap);
+
+   store->index_base  = 0;
+   store->index_dirty = false;
+
+   for (i = playlist->size; i > 0; i--)
+   {
+      playlist_index_insert(&store->path_index,
+            playlist->entries[i - 1].path, i - 1);
+      playlist_index_insert(&store->crc_index,
+            playlist->entries[i - 1].crc32, i - 1);
+   }
+}
+
+/* Indexes the entry which was just added at the top. */
+static void playlist_index_push(playlist_t *playlist)
+{
+   struct playlist_store *store = playlist->store;
+
+   if (store->index_dirty)
+      return;
+
+   /* Evicted entries leave stale nodes behind, drop them
+    * once they make up most of the index. */
+   if (store->path_index.nodes_count > playlist->size * 2 + 64)
+   {
+      store->index_dirty = true;
+      return;
+   }
+
+   store->index_base--;
+   playlist_index_insert(&store->path_index,
+         playlist->entries[0].path, store->index_base);
+   playlist_index_insert(&store->crc_index,
+         playlist->entries[0].crc32, store->index_base);
+}
+
+/**
+ * playlist_index_find:
+ * @playlist            : Playlist handle.
+ * @crc                 : Look up by CRC instead of path.
+ * @key                 : Path or CRC to look up.
+ * @core_path           : Core path the entry must have, or NULL.
+ * @start               : First index to consider.
+ * @idx                 : Index of found entry.
+ *
+ * Finds the first entry at or after @start matching @key.
+ *
+ * Returns: true (1) if an entry was found, otherwise false (0).
+ **/
+static bool playlist_index_find(playlist_t *playlist, bool crc,
+      const char *key, const char *core_path, size_t start, size_t *idx)
+{
+   size_t node;
+   struct playlist_store *store = playlist->store;
+   struct playlist_index *index = crc ? &store->crc_index : &store->path_index;
+
+   if (string_is_empty(key))
+      return false;
+
+   if (store->index_dirty)
+      playlist_index_rebuild(playlist);
+
+   if (!index->cap)
+      return false;
+
+   for (node = playlist_index_slot(index, djb2_calculate(key))->head;
+         node; node = index->nodes[node - 1].next)
+   {
+      const char *value = NULL;
+      size_t entry_idx  = index->nodes[node - 1].pos - store->index_base;
+
+      /* Entries past the end were evicted. */
+      if (entry_idx >= playlist->size || entry_idx < start)
+         continue;
+
+      value = crc ? playlist->entries[entry_idx].crc32
+         : playlist->entries[entry_idx].path;
+
+      if (!string_is_equal(value, key))
+         continue;
+      if (core_path && !string_is_equal(
+               playlist->entries[entry_idx].core_path, core_path))
+         continue;
+
+      *idx = entry_idx;
+      return true;
+   }
+
+   return false;
+}
+
+/* Finds the first entry with the given path and core path;
+ * entries without a path aren't indexed. */
+static bool playlist_find_entry(playlist_t *playlist,
+      const char *path, const char *core_path, size_t *idx)
+{
+   size_t i;
+
+   if (path)
+      return playlist_index_find(playlist, false, path,
+            core_path ? core_path : "", 0, idx);
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      if (playlist->entries[i].path)
+         continue;
+      if (!string_is_equal(playlist->entries[i].core_path,
+               core_path ? core_path : ""))
+         continue;
+      *idx = i;
+      return true;
+   }
+
+   return false;
+}
+
+static void playlist_journal_append(playlist_t *playlist, const char *s)
+{
+   size_t len                   = strlen(s ? s : "") + 1;
+   struct playlist_store *store = playlist->store;
+
+   if (store->journal_len + len + 1 > store->journal_cap)
+   {
+      size_t new_cap = (store->journal_len + len + 1) * 2;
+      char *journal  = (char*)realloc(store->journal, new_cap);
+
+      if (!journal)
+      {
+         store->full_write = true;
+         return;
+      }
+
+      store->journal     = journal;
+      store->journal_cap = new_cap;
+   }
+
+   memcpy(store->journal + store->journal_len, s ? s : "", len - 1);
+   store->journal_len                  += len;
+   store->journal[store->journal_len - 1] = '\n';
+   store->journal[store->journal_len]     = '\0';
+}
+
+static void playlist_journal_entry(playlist_t *playlist, char op,
+      const struct playlist_entry *key, const struct playlist_entry *entry)
+{
+   char op_str[2];
+
+   if (playlist->store->replaying)
+      return;
+
+   op_str[0] = op;
+   op_str[1] = '\0';
+
+   playlist_journal_append(playlist, op_str);
+
+   if (key)
+   {
+      playlist_journal_append(playlist, key->path);
+      playlist_journal_append(playlist, key->core_path);
+   }
+
+   if (entry)
+   {
+      playlist_journal_append(playlist, entry->path);
+      playlist_journal_append(playlist, entry->label);
+      playlist_journal_append(playlist, entry->core_path);
+      playlist_journal_append(playlist, entry->core_name);
+      playlist_journal_append(playlist, entry->crc32);
+      playlist_journal_append(playlist, entry->db_name);
+   }
+
+   playlist->store->journal_pending++;
+}
+
 /**
  * playlist_get_index:
  * @playlist            : Playlist handle.
@@ -43,8 +512,8 @@ typedef int (playlist_sort_fun_t)(
  * @path                : Path of playlist entry.
  * @core_path           : Core path of playlist entry.
  * @core_name           : Core name of playlist entry.
- * 
- * Gets values of playlist index: 
+ *
+ * Gets values of playlist index:
  **/
 void playlist_get_index(playlist_t *playlist,
       size_t idx,
@@ -70,23 +539,66 @@ void playlist_get_index(playlist_t *playlist,
       *crc32     = playlist->entries[idx].crc32;
 }
 
+/**
+ * playlist_free_entry:
+ * @playlist            : Playlist handle.
+ * @entry               : Playlist entry handle.
+ *
+ * Frees playlist entry. Core path/name and database
+ * name are interned and owned by the playlist, as are
+ * strings read from a binary playlist.
+ **/
+static void playlist_free_entry(playlist_t *playlist,
+      struct playlist_entry *entry)
+{
+   if (!entry)
+      return;
+
+   playlist_free_string(playlist, entry->path);
+   entry->path      = NULL;
+
+   playlist_free_string(playlist, entry->label);
+   entry->label     = NULL;
+
+   playlist_free_string(playlist, entry->crc32);
+   entry->crc32     = NULL;
+
+   entry->core_path = NULL;
+   entry->core_name = NULL;
+   entry->db_name   = NULL;
+}
+
+static void playlist_delete_index_internal(playlist_t *playlist,
+      size_t idx)
+{
+   playlist_journal_entry(playlist, PLAYLIST_JOURNAL_DELETE,
+         &playlist->entries[idx], NULL);
+
+   playlist_free_entry(playlist, &playlist->entries[idx]);
+
+   memmove(playlist->entries + idx, playlist->entries + idx + 1,
+         (playlist->size - idx - 1) * sizeof(struct playlist_entry));
+   memset(&playlist->entries[playlist->size - 1], 0,
+         sizeof(struct playlist_entry));
+
+   playlist->size                = playlist->size - 1;
+   playlist->store->index_dirty  = true;
+}
+
 /**
  * playlist_delete_index:
  * @playlist            : Playlist handle.
  * @idx                 : Index of playlist entry.
- * 
- * Delete the entry at the index: 
+ *
+ * Delete the entry at the index:
  **/
 void playlist_delete_index(playlist_t *playlist,
       size_t idx)
 {
-   if (!playlist)
+   if (!playlist || idx >= playlist->size)
       return;
 
-   memmove(playlist->entries + idx, playlist->entries + idx + 1,
-         (playlist->size - idx) * sizeof(struct playlist_entry));
-
-   playlist->size = playlist->size - 1;
+   playlist_delete_index_internal(playlist, idx);
 
    playlist_write_file(playlist);
 }
@@ -98,130 +610,118 @@ void playlist_get_index_by_path(playlist_t *playlist,
       char **crc32,
       char **db_name)
 {
-   size_t i;
+   size_t i = 0;
    if (!playlist)
       return;
 
-   for (i = 0; i < playlist->size; i++)
-   {
-      if (!string_is_equal(playlist->entries[i].path, search_path))
-         continue;
+   if (!playlist_index_find(playlist, false, search_path, NULL, 0, &i))
+      return;
 
-      if (path)
-         *path      = playlist->entries[i].path;
-      if (label)
-         *label     = playlist->entries[i].label;
-      if (core_path)
-         *core_path = playlist->entries[i].core_path;
-      if (core_name)
-         *core_name = playlist->entries[i].core_name;
-      if (db_name)
-         *db_name   = playlist->entries[i].db_name;
-      if (crc32)
-         *crc32     = playlist->entries[i].crc32;
-      break;
-   }
+   if (path)
+      *path      = playlist->entries[i].path;
+   if (label)
+      *label     = playlist->entries[i].label;
+   if (core_path)
+      *core_path = playlist->entries[i].core_path;
+   if (core_name)
+      *core_name = playlist->entries[i].core_name;
+   if (db_name)
+      *db_name   = playlist->entries[i].db_name;
+   if (crc32)
+      *crc32     = playlist->entries[i].crc32;
+}
+
+/**
+ * playlist_get_index_by_crc32:
+ * @playlist            : Playlist handle.
+ * @crc32               : CRC to look up.
+ * @start               : First index to consider.
+ * @idx                 : Index of found entry.
+ *
+ * Finds the first entry at or after @start with the given CRC.
+ *
+ * Returns: true (1) if an entry was found, otherwise false (0).
+ **/
+bool playlist_get_index_by_crc32(playlist_t *playlist,
+      const char *crc32, size_t start, size_t *idx)
+{
+   if (!playlist || !idx)
+      return false;
+   return playlist_index_find(playlist, true, crc32, NULL, start, idx);
 }
 
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path,
       const char *crc32)
 {
-   size_t i;
+   size_t i = 0;
    if (!playlist)
       return false;
 
-   for (i = 0; i < playlist->size; i++)
-      if (string_is_equal(playlist->entries[i].path, path))
-         return true;
-
-   return false;
+   return playlist_index_find(playlist, false, path, NULL, 0, &i);
 }
 
-/**
- * playlist_free_entry:
- * @entry               : Playlist entry handle.
- *
- * Frees playlist entry.
- **/
-static void playlist_free_entry(struct playlist_entry *entry)
-{
-   if (!entry)
-      return;
-
-   if (!string_is_empty(entry->path))
-      free(entry->path);
-   entry->path      = NULL;
-
-   if (!string_is_empty(entry->label))
-      free(entry->label);
-   entry->label     = NULL;
-
-   if (!string_is_empty(entry->core_path))
-      free(entry->core_path);
-   entry->core_path = NULL;
-
-   if (!string_is_empty(entry->core_name))
-      free(entry->core_name);
-   entry->core_name = NULL;
-
-   if (!string_is_empty(entry->db_name))
-      free(entry->db_name);
-   entry->db_name   = NULL;
-
-   if (!string_is_empty(entry->crc32))
-      free(entry->crc32);
-   entry->crc32     = NULL;
-}
-
-void playlist_update(playlist_t *playlist, size_t idx,
+static void playlist_update_internal(playlist_t *playlist, size_t idx,
       const char *path, const char *label,
       const char *core_path, const char *core_name,
       const char *crc32,
       const char *db_name)
 {
-   struct playlist_entry *entry = NULL;
+   struct playlist_entry key;
+   struct playlist_entry *entry = &playlist->entries[idx];
 
-   if (!playlist || idx > playlist->size)
-      return;
-
-   entry            = &playlist->entries[idx];
+   key.path      = entry->path ? strdup(entry->path) : NULL;
+   key.core_path = entry->core_path;
 
    if (path && (path != entry->path))
    {
-      free(entry->path);
-      entry->path = strdup(path);
+      char *tmp   = strdup(path);
+      playlist_free_string(playlist, entry->path);
+      entry->path = tmp;
+      playlist->store->index_dirty = true;
    }
 
    if (label && (label != entry->label))
    {
-      free(entry->label);
-      entry->label = strdup(label);
+      char *tmp    = strdup(label);
+      playlist_free_string(playlist, entry->label);
+      entry->label = tmp;
    }
 
-   if (core_path && (core_path != entry->core_path))
-   {
-      free(entry->core_path);
-      entry->core_path = strdup(core_path);
-   }
+   if (core_path)
+      entry->core_path = (char*)playlist_intern(playlist, core_path);
 
-   if (core_name && (core_name != entry->core_name))
-   {
-      free(entry->core_name);
-      entry->core_name = strdup(core_name);
-   }
+   if (core_name)
+      entry->core_name = (char*)playlist_intern(playlist, core_name);
 
-   if (db_name && (db_name != entry->db_name))
-   {
-      free(entry->db_name);
-      entry->db_name = strdup(db_name);
-   }
+   if (db_name)
+      entry->db_name   = (char*)playlist_intern(playlist, db_name);
 
    if (crc32 && (crc32 != entry->crc32))
    {
-      free(entry->crc32);
-      entry->crc32 = strdup(crc32);
+      char *tmp    = strdup(crc32);
+      playlist_free_string(playlist, entry->crc32);
+      entry->crc32 = tmp;
+      playlist->store->index_dirty = true;
    }
+
+   playlist_journal_entry(playlist, PLAYLIST_JOURNAL_UPDATE, &key, entry);
+
+   if (key.path)
+      free(key.path);
+}
+
+void playlist_update(playlist_t *playlist, size_t idx,
+      const char *path, const char *label,
+      const char *core_path, const char *core_name,
+      const char *crc32,
+      const char *db_name)
+{
+   if (!playlist || idx >= playlist->size)
+      return;
+
+   playlist_update_internal(playlist, idx, path, label,
+         core_path, core_name, crc32, db_name);
 }
 
 /**
@@ -240,6 +740,7 @@ bool playlist_push(playlist_t *playlist,
       const char *db_name)
 {
    size_t i;
+   struct playlist_entry *entry = NULL;
 
    if (string_is_empty(core_path) || string_is_empty(core_name))
    {
@@ -267,20 +768,11 @@ bool playlist_push(playlist_t *playlist,
    if (!playlist)
       return false;
 
-   for (i = 0; i < playlist->size; i++)
+   /* Core name can have changed while still being the same core.
+    * Differentiate based on the core path only. */
+   if (playlist_find_entry(playlist, path, core_path, &i))
    {
       struct playlist_entry tmp;
-      bool equal_path = (!path && !playlist->entries[i].path) ||
-         (path && playlist->entries[i].path &&
-          string_is_equal(path,playlist->entries[i].path));
-
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (!equal_path)
-         continue;
-
-      if (!string_is_equal(playlist->entries[i].core_path, core_path))
-         continue;
 
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
@@ -293,74 +785,314 @@ bool playlist_push(playlist_t *playlist,
             i * sizeof(struct playlist_entry));
       playlist->entries[0] = tmp;
 
+      playlist->store->index_dirty = true;
+      playlist_journal_entry(playlist, PLAYLIST_JOURNAL_PUSH,
+            NULL, &playlist->entries[0]);
+
       return true;
    }
 
    if (playlist->size == playlist->cap)
    {
-      struct playlist_entry *entry = &playlist->entries[playlist->cap - 1];
-
-      if (entry)
-         playlist_free_entry(entry);
+      playlist_free_entry(playlist, &playlist->entries[playlist->cap - 1]);
       playlist->size--;
    }
 
    memmove(playlist->entries + 1, playlist->entries,
-         (playlist->cap - 1) * sizeof(struct playlist_entry));
-
-   playlist->entries[0].path         = NULL;
-   playlist->entries[0].label        = NULL;
-   playlist->entries[0].core_path    = NULL;
-   playlist->entries[0].core_name    = NULL;
-   playlist->entries[0].db_name      = NULL;
-   playlist->entries[0].crc32        = NULL;
+         playlist->size * sizeof(struct playlist_entry));
+
+   entry            = &playlist->entries[0];
+   entry->path      = NULL;
+   entry->label     = NULL;
+   entry->crc32     = NULL;
    if (!string_is_empty(path))
-      playlist->entries[0].path      = strdup(path);
+      entry->path   = strdup(path);
    if (!string_is_empty(label))
-      playlist->entries[0].label     = strdup(label);
-   if (!string_is_empty(core_path))
-      playlist->entries[0].core_path = strdup(core_path);
-   if (!string_is_empty(core_name))
-      playlist->entries[0].core_name = strdup(core_name);
-   if (!string_is_empty(db_name))
-      playlist->entries[0].db_name   = strdup(db_name);
+      entry->label  = strdup(label);
    if (!string_is_empty(crc32))
-      playlist->entries[0].crc32     = strdup(crc32);
+      entry->crc32  = strdup(crc32);
+   entry->core_path = (char*)playlist_intern(playlist, core_path);
+   entry->core_name = (char*)playlist_intern(playlist, core_name);
+   entry->db_name   = (char*)playlist_intern(playlist, db_name);
 
    playlist->size++;
 
+   playlist_index_push(playlist);
+   playlist_journal_entry(playlist, PLAYLIST_JOURNAL_PUSH, NULL, entry);
+
    return true;
 }
 
-void playlist_write_file(playlist_t *playlist)
+static void playlist_write_le32(uint8_t *data, uint32_t value)
+{
+   data[0] = (uint8_t)(value >>  0);
+   data[1] = (uint8_t)(value >>  8);
+   data[2] = (uint8_t)(value >> 16);
+   data[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t playlist_read_le32(const uint8_t *data)
+{
+   return (uint32_t)data[0]
+      | ((uint32_t)data[1] <<  8)
+      | ((uint32_t)data[2] << 16)
+      | ((uint32_t)data[3] << 24);
+}
+
+struct playlist_string_table
+{
+   char *data;
+   size_t size;
+   size_t cap;
+
+   /* Offsets of the strings added so far, by hash. */
+   uint32_t *slots;
+   size_t slots_cap;
+};
+
+/* Adds a string to the table unless it is already in there,
+ * and returns its offset. */
+static bool playlist_string_table_add(struct playlist_string_table *table,
+      const char *s, uint32_t *offset)
+{
+   size_t i, len;
+
+   *offset = 0;
+
+   if (string_is_empty(s))
+      return true;
+
+   for (i = djb2_calculate(s) & (table->slots_cap - 1); table->slots[i];
+         i = (i + 1) & (table->slots_cap - 1))
+   {
+      if (string_is_equal(table->data + table->slots[i], s))
+      {
+         *offset = table->slots[i];
+         return true;
+      }
+   }
+
+   len = strlen(s) + 1;
+
+   if ((uint64_t)table->size + len > 0xffffffffu)
+      return false;
+
+   if (table->size + len > table->cap)
+   {
+      size_t new_cap = table->cap * 2;
+      char *data     = NULL;
+
+      while (new_cap < table->size + len)
+         new_cap *= 2;
+
+      data = (char*)realloc(table->data, new_cap);
+      if (!data)
+         return false;
+
+      table->data = data;
+      table->cap  = new_cap;
+   }
+
+   memcpy(table->data + table->size, s, len);
+   table->slots[i] = *offset = (uint32_t)table->size;
+   table->size    += len;
+   return true;
+}
+
+/**
+ * playlist_write_file_binary:
+ * @playlist            : Playlist handle.
+ *
+ * Writes the playlist in the binary format. Strings shared
+ * between entries, like core paths, are stored once.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool playlist_write_file_binary(playlist_t *playlist,
+      const char *path)
 {
    size_t i;
-   FILE *file = NULL;
+   struct playlist_string_table table;
+   uint8_t header[PLAYLIST_BINARY_HEADER_SIZE];
+   uint8_t *rows = NULL;
+   FILE *file    = NULL;
+   bool ret      = false;
 
-   if (!playlist)
-      return;
+   memset(&table, 0, sizeof(table));
 
-   file = fopen(playlist->conf_path, "w");
+   table.cap       = 4096;
+   table.slots_cap = 64;
+   while (table.slots_cap < playlist->size * PLAYLIST_ENTRIES * 2)
+      table.slots_cap *= 2;
 
-   RARCH_LOG("Trying to write to playlist file: %s\n", playlist->conf_path);
+   table.data  = (char*)malloc(table.cap);
+   table.slots = (uint32_t*)calloc(table.slots_cap, sizeof(*table.slots));
+   rows        = (uint8_t*)malloc(
+         playlist->size * PLAYLIST_ENTRIES * sizeof(uint32_t) + 1);
 
-   if (!file)
+   if (!table.data || !table.slots || !rows)
+      goto end;
+
+   /* Offset 0 is the empty string. */
+   table.data[0] = '\0';
+   table.size    = 1;
+
+   for (i = 0; i < playlist->size; i++)
    {
-      RARCH_ERR("Failed to write to playlist file: %s\n", playlist->conf_path);
-      return;
+      unsigned j;
+      uint32_t offsets[PLAYLIST_ENTRIES];
+      const struct playlist_entry *entry = &playlist->entries[i];
+      const char *fields[PLAYLIST_ENTRIES];
+
+      fields[0] = entry->path;
+      fields[1] = entry->label;
+      fields[2] = entry->core_path;
+      fields[3] = entry->core_name;
+      fields[4] = entry->crc32;
+      fields[5] = entry->db_name;
+
+      for (j = 0; j < PLAYLIST_ENTRIES; j++)
+      {
+         if (!playlist_string_table_add(&table, fields[j], &offsets[j]))
+            goto end;
+         playlist_write_le32(rows
+               + (i * PLAYLIST_ENTRIES + j) * sizeof(uint32_t), offsets[j]);
+      }
    }
 
+   memcpy(header, PLAYLIST_BINARY_MAGIC, 4);
+   playlist_write_le32(header +  4, PLAYLIST_BINARY_VERSION);
+   playlist_write_le32(header +  8, (uint32_t)playlist->size);
+   playlist_write_le32(header + 12, (uint32_t)table.size);
+
+   file = fopen(path, "wb");
+   if (!file)
+      goto end;
+
+   ret = fwrite(header, 1, sizeof(header), file) == sizeof(header)
+      && fwrite(rows, sizeof(uint32_t) * PLAYLIST_ENTRIES, playlist->size,
+            file) == playlist->size
+      && fwrite(table.data, 1, table.size, file) == table.size;
+
+   if (fclose(file) != 0)
+      ret = false;
+
+end:
+   free(rows);
+   free(table.data);
+   free(table.slots);
+   return ret;
+}
+
+static bool playlist_write_file_text(playlist_t *playlist,
+      const char *path)
+{
+   size_t i;
+   FILE *file = fopen(path, "w");
+
+   if (!file)
+      return false;
+
    for (i = 0; i < playlist->size; i++)
       fprintf(file, "%s\n%s\n%s\n%s\n%s\n%s\n",
             playlist->entries[i].path    ? playlist->entries[i].path    : "",
             playlist->entries[i].label   ? playlist->entries[i].label   : "",
-            playlist->entries[i].core_path,
-            playlist->entries[i].core_name,
+            playlist->entries[i].core_path ? playlist->entries[i].core_path : "",
+            playlist->entries[i].core_name ? playlist->entries[i].core_name : "",
             playlist->entries[i].crc32   ? playlist->entries[i].crc32   : "",
             playlist->entries[i].db_name ? playlist->entries[i].db_name : ""
             );
 
+   return fclose(file) == 0;
+}
+
+static void playlist_write_file_full(playlist_t *playlist)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+   bool ret                     = false;
+   struct playlist_store *store = playlist->store;
+
+   RARCH_LOG("Trying to write to playlist file: %s\n", playlist->conf_path);
+
+   /* Windows won't replace a file that is still mapped. */
+   if (store->blob_file)
+      playlist_release_blob(playlist);
+
+   /* Never rewrite the file in place: other handles may have
+    * it mapped, and would fault on the truncated pages. */
+   strlcpy(tmp_path, playlist->conf_path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+
+   if (store->format == PLAYLIST_FORMAT_BINARY)
+      ret = playlist_write_file_binary(playlist, tmp_path);
+   else
+      ret = playlist_write_file_text(playlist, tmp_path);
+
+   if (ret)
+      ret = path_file_replace(tmp_path, playlist->conf_path);
+
+   if (!ret)
+   {
+      RARCH_ERR("Failed to write to playlist file: %s\n", playlist->conf_path);
+      remove(tmp_path);
+      return;
+   }
+
+   if (path_file_exists(store->journal_path))
+      remove(store->journal_path);
+
+   store->journal_len      = 0;
+   store->journal_pending  = 0;
+   store->journal_records  = 0;
+   store->full_write       = false;
+}
+
+/**
+ * playlist_write_file:
+ * @playlist            : Playlist handle.
+ *
+ * Saves the changes made to the playlist. They are appended
+ * to the playlist's journal, unless the journal has grown
+ * bigger than the playlist itself, in which case the
+ * playlist file is rewritten and the journal removed.
+ **/
+void playlist_write_file(playlist_t *playlist)
+{
+   FILE *file                   = NULL;
+   struct playlist_store *store = NULL;
+
+   if (!playlist)
+      return;
+
+   store = playlist->store;
+
+   if (!store->full_write && !store->journal_pending)
+      return;
+
+   if (     store->full_write
+         || (store->journal_records + store->journal_pending
+            > PLAYLIST_JOURNAL_MIN_RECORDS
+         &&  store->journal_records + store->journal_pending
+            > playlist->size))
+   {
+      playlist_write_file_full(playlist);
+      return;
+   }
+
+   file = fopen(store->journal_path, "a");
+
+   if (!file)
+   {
+      playlist_write_file_full(playlist);
+      return;
+   }
+
+   fwrite(store->journal, 1, store->journal_len, file);
    fclose(file);
+
+   store->journal_records += store->journal_pending;
+   store->journal_pending  = 0;
+   store->journal_len      = 0;
 }
 
 /**
@@ -386,12 +1118,35 @@ void playlist_free(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
 
    free(playlist->entries);
    playlist->entries = NULL;
 
+   if (playlist->store)
+   {
+      struct playlist_store *store = playlist->store;
+
+      playlist_index_free(&store->path_index);
+      playlist_index_free(&store->crc_index);
+
+      if (store->blob_file)
+         filestream_close(store->blob_file);
+      if (store->blob_buf)
+         free(store->blob_buf);
+
+      for (i = 0; i < store->strings_cap; i++)
+         if (store->strings[i])
+            free(store->strings[i]);
+      if (store->strings)
+         free(store->strings);
+      if (store->journal)
+         free(store->journal);
+      free(store);
+   }
+   playlist->store = NULL;
+
    free(playlist);
 }
 
@@ -412,9 +1167,11 @@ void playlist_clear(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
-   playlist->size = 0;
+   playlist->size                = 0;
+   playlist->store->index_dirty  = true;
+   playlist->store->full_write   = true;
 }
 
 /**
@@ -431,14 +1188,181 @@ size_t playlist_size(playlist_t *playlist)
    return playlist->size;
 }
 
+static bool playlist_read_lines(RFILE *file,
+      char (*buf)[1024], unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i < count; i++)
+   {
+      char *last  = NULL;
+      *buf[i]     = '\0';
+
+      if (!filestream_gets(file, buf[i], sizeof(buf[i])))
+         return false;
+
+      /* Read playlist entry and terminate string with NUL character
+       * regardless of Windows or Unix line endings
+       */
+      if((last = strrchr(buf[i], '\r')))
+         *last = '\0';
+      else if((last = strrchr(buf[i], '\n')))
+         *last = '\0';
+   }
+
+   return true;
+}
+
+/**
+ * playlist_load_binary:
+ * @playlist            : Playlist handle.
+ * @data                : Contents of binary playlist file.
+ * @size                : Size of @data.
+ *
+ * Sets up the entries to point into the string table of
+ * @data, which has to stay around as long as they do.
+ **/
+static void playlist_load_binary(playlist_t *playlist,
+      const uint8_t *data, size_t size)
+{
+   size_t i;
+   size_t count                 = 0;
+   size_t strings_size          = 0;
+   const uint8_t *rows          = NULL;
+   const char *strings          = NULL;
+   struct playlist_store *store = playlist->store;
+   const size_t row_size        = PLAYLIST_ENTRIES * sizeof(uint32_t);
+
+   if (playlist_read_le32(data + 4) != PLAYLIST_BINARY_VERSION)
+      goto error;
+
+   count        = playlist_read_le32(data + 8);
+   strings_size = playlist_read_le32(data + 12);
+   size        -= PLAYLIST_BINARY_HEADER_SIZE;
+
+   if (count > size / row_size || strings_size != size - count * row_size)
+      goto error;
+
+   rows    = data + PLAYLIST_BINARY_HEADER_SIZE;
+   strings = (const char*)rows + count * row_size;
+
+   /* Every string, including the last, has to be terminated. */
+   if (!strings_size || strings[0] || strings[strings_size - 1])
+      goto error;
+
+   for (i = 0; i < count && playlist->size < playlist->cap; i++)
+   {
+      unsigned j;
+      uint32_t offsets[PLAYLIST_ENTRIES];
+      struct playlist_entry *entry = &playlist->entries[playlist->size];
+
+      for (j = 0; j < PLAYLIST_ENTRIES; j++)
+      {
+         offsets[j] = playlist_read_le32(rows
+               + (i * PLAYLIST_ENTRIES + j) * sizeof(uint32_t));
+         if (offsets[j] >= strings_size)
+            goto error;
+      }
+
+      /* Entries without a core assigned are kept. */
+      if (!offsets[0] && !offsets[2])
+         continue;
+
+      entry->path      = offsets[0] ? (char*)strings + offsets[0] : NULL;
+      entry->label     = offsets[1] ? (char*)strings + offsets[1] : NULL;
+      entry->core_path = offsets[2] ? (char*)strings + offsets[2] : NULL;
+      entry->core_name = offsets[3] ? (char*)strings + offsets[3] : NULL;
+      entry->crc32     = offsets[4] ? (char*)strings + offsets[4] : NULL;
+      entry->db_name   = offsets[5] ? (char*)strings + offsets[5] : NULL;
+      playlist->size++;
+   }
+
+   store->blob_strings      = strings;
+   store->blob_strings_size = strings_size;
+   return;
+
+error:
+   RARCH_WARN("Ignoring malformed binary playlist: %s\n",
+         playlist->conf_path);
+   memset(playlist->entries, 0, playlist->size * sizeof(*playlist->entries));
+   playlist->size = 0;
+}
+
+/**
+ * playlist_read_file_binary:
+ * @playlist            : Playlist handle.
+ * @path                : Path to playlist file.
+ *
+ * Maps the playlist file if it is in the binary format.
+ * Where files can't be mapped, it is read into memory.
+ *
+ * Returns: true (1) if the file is a binary playlist,
+ * otherwise false (0).
+ **/
+static bool playlist_read_file_binary(
+      playlist_t *playlist, const char *path)
+{
+   size_t size                  = 0;
+   const uint8_t *data          = NULL;
+   struct playlist_store *store = playlist->store;
+   RFILE *file                  = filestream_open(path,
+         RFILE_MODE_READ | RFILE_HINT_MMAP, -1);
+
+   if (!file)
+      return false;
+
+   data = (const uint8_t*)filestream_get_mapped(file, &size);
+
+   if (data)
+   {
+      if (     size < PLAYLIST_BINARY_HEADER_SIZE
+            || memcmp(data, PLAYLIST_BINARY_MAGIC, 4))
+      {
+         filestream_close(file);
+         return false;
+      }
+
+      store->blob_file = file;
+   }
+   else
+   {
+      ssize_t len = 0;
+      char magic[4];
+      bool binary = filestream_read(file, magic, sizeof(magic))
+         == sizeof(magic) && !memcmp(magic, PLAYLIST_BINARY_MAGIC, 4);
+
+      filestream_close(file);
+
+      if (!binary)
+         return false;
+
+      if (!filestream_read_file(path, (void**)&store->blob_buf, &len)
+            || len < PLAYLIST_BINARY_HEADER_SIZE)
+      {
+         RARCH_ERR("Failed to read playlist file: %s\n", path);
+         return true;
+      }
+
+      data = store->blob_buf;
+      size = (size_t)len;
+   }
+
+   store->format = PLAYLIST_FORMAT_BINARY;
+   playlist_load_binary(playlist, data, size);
+   return true;
+}
 
 static bool playlist_read_file(
       playlist_t *playlist, const char *path)
 {
    unsigned i;
    char buf[PLAYLIST_ENTRIES][1024];
-   RFILE *file                      = filestream_open(
-         path, RFILE_MODE_READ_TEXT, -1);
+   RFILE *file                      = NULL;
+
+   if (playlist_read_file_binary(playlist, path))
+      return true;
+
+   file = filestream_open(path, RFILE_MODE_READ_TEXT, -1);
 
    for (i = 0; i < PLAYLIST_ENTRIES; i++)
       buf[i][0] = '\0';
@@ -447,32 +1371,22 @@ static bool playlist_read_file(
     * create an empty playlist instead.
     */
    if (!file)
+   {
+      playlist->store->full_write = true;
       return true;
+   }
 
    for (playlist->size = 0; playlist->size < playlist->cap; )
    {
-      unsigned i;
       struct playlist_entry *entry     = NULL;
-      for (i = 0; i < PLAYLIST_ENTRIES; i++)
-      {
-         char *last  = NULL;
-         *buf[i]     = '\0';
-
-         if (!filestream_gets(file, buf[i], sizeof(buf[i])))
-            goto end;
 
-         /* Read playlist entry and terminate string with NUL character
-          * regardless of Windows or Unix line endings
-          */
-          if((last = strrchr(buf[i], '\r')))
-             *last = '\0';
-          else if((last = strrchr(buf[i], '\n')))
-             *last = '\0';	
-      }
+      if (!playlist_read_lines(file, buf, PLAYLIST_ENTRIES))
+         goto end;
 
       entry = &playlist->entries[playlist->size];
 
-      if (!*buf[2] || !*buf[3])
+      /* Entries without a core assigned are kept. */
+      if (!*buf[0] && !*buf[2])
          continue;
 
       if (*buf[0])
@@ -480,12 +1394,12 @@ static bool playlist_read_file(
       if (*buf[1])
          entry->label     = strdup(buf[1]);
 
-      entry->core_path    = strdup(buf[2]);
-      entry->core_name    = strdup(buf[3]);
+      entry->core_path    = (char*)playlist_intern(playlist, buf[2]);
+      entry->core_name    = (char*)playlist_intern(playlist, buf[3]);
       if (*buf[4])
          entry->crc32     = strdup(buf[4]);
       if (*buf[5])
-         entry->db_name   = strdup(buf[5]);
+         entry->db_name   = (char*)playlist_intern(playlist, buf[5]);
       playlist->size++;
    }
 
@@ -494,6 +1408,89 @@ end:
    return true;
 }
 
+#define PLAYLIST_STR(s) (*(s) ? (s) : NULL)
+
+/**
+ * playlist_read_journal:
+ * @playlist            : Playlist handle.
+ *
+ * Replays the changes recorded in the playlist's journal.
+ **/
+static void playlist_read_journal(playlist_t *playlist)
+{
+   char op[16];
+   char key[2][1024];
+   char buf[PLAYLIST_ENTRIES][1024];
+   struct playlist_store *store = playlist->store;
+   RFILE *file                  = filestream_open(
+         store->journal_path, RFILE_MODE_READ_TEXT, -1);
+
+   if (!file)
+      return;
+
+   store->replaying = true;
+
+   while (filestream_gets(file, op, sizeof(op)))
+   {
+      size_t idx = 0;
+
+      switch (op[0])
+      {
+         case PLAYLIST_JOURNAL_PUSH:
+            if (!playlist_read_lines(file, buf, PLAYLIST_ENTRIES))
+               goto end;
+            playlist_push(playlist, buf[0], buf[1], buf[2], buf[3],
+                  buf[4], buf[5]);
+            break;
+         case PLAYLIST_JOURNAL_DELETE:
+            if (!playlist_read_lines(file, key, 2))
+               goto end;
+            if (playlist_find_entry(playlist, PLAYLIST_STR(key[0]),
+                     key[1], &idx))
+               playlist_delete_index_internal(playlist, idx);
+            break;
+         case PLAYLIST_JOURNAL_UPDATE:
+            if (!playlist_read_lines(file, key, 2))
+               goto end;
+            if (!playlist_read_lines(file, buf, PLAYLIST_ENTRIES))
+               goto end;
+            if (playlist_find_entry(playlist, PLAYLIST_STR(key[0]),
+                     key[1], &idx))
+               playlist_update_internal(playlist, idx,
+                     PLAYLIST_STR(buf[0]), PLAYLIST_STR(buf[1]),
+                     PLAYLIST_STR(buf[2]), PLAYLIST_STR(buf[3]),
+                     PLAYLIST_STR(buf[4]), PLAYLIST_STR(buf[5]));
+            break;
+         default:
+            RARCH_WARN("Ignoring malformed playlist journal: %s\n",
+                  store->journal_path);
+            goto end;
+      }
+
+      store->journal_records++;
+   }
+
+end:
+   store->replaying = false;
+   filestream_close(file);
+}
+
+#undef PLAYLIST_STR
+
+static void playlist_set_path(playlist_t *playlist, const char *path)
+{
+   struct playlist_store *store = playlist->store;
+
+   if (playlist->conf_path)
+      free(playlist->conf_path);
+   playlist->conf_path = strdup(path);
+
+   strlcpy(store->journal_path, path, sizeof(store->journal_path));
+   path_remove_extension(store->journal_path);
+   strlcat(store->journal_path, PLAYLIST_JOURNAL_EXTENSION,
+         sizeof(store->journal_path));
+}
+
 /**
  * playlist_init:
  * @path            	   : Path to playlist contents file.
@@ -517,15 +1514,65 @@ playlist_t *playlist_init(const char *path, size_t size)
       return NULL;
    }
 
+   playlist->store = (struct playlist_store*)
+      calloc(1, sizeof(*playlist->store));
+   if (!playlist->store)
+   {
+      free(entries);
+      free(playlist);
+      return NULL;
+   }
+
    playlist->entries   = entries;
    playlist->cap       = size;
 
+   playlist_set_path(playlist, path);
+
    playlist_read_file(playlist, path);
+   /* Built on the first lookup. */
+   playlist->store->index_dirty = true;
+   playlist_read_journal(playlist);
 
-   playlist->conf_path = strdup(path);
    return playlist;
 }
 
+void playlist_set_format(playlist_t *playlist,
+      enum playlist_file_format format)
+{
+   if (!playlist || playlist->store->format == format)
+      return;
+
+   playlist->store->format     = format;
+   playlist->store->full_write = true;
+}
+
+bool playlist_convert(const char *path, const char *new_path,
+      size_t size, enum playlist_file_format format)
+{
+   bool ret               = false;
+   playlist_t *playlist   = NULL;
+
+   if (string_is_empty(path) || string_is_empty(new_path))
+      return false;
+
+   playlist = playlist_init(path, size);
+   if (!playlist)
+      return false;
+
+   /* The journal of the source playlist has to stay
+    * unless it is rewritten in place. */
+   if (!string_is_equal(path, new_path))
+      playlist_set_path(playlist, new_path);
+
+   playlist->store->format     = format;
+   playlist->store->full_write = true;
+   playlist_write_file_full(playlist);
+   ret = !playlist->store->full_write;
+
+   playlist_free(playlist);
+   return ret;
+}
+
 static int playlist_qsort_func(const struct playlist_entry *a,
       const struct playlist_entry *b)
 {
@@ -543,4 +1590,5 @@ void playlist_qsort(playlist_t *playlist)
    qsort(playlist->entries, playlist->size,
          sizeof(struct playlist_entry),
          (int (*)(const void *, const void *))playlist_qsort_func);
+   playlist->store->index_dirty = true;
 }
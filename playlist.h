@@ -27,6 +27,13 @@ RETRO_BEGIN_DECLS
 
 typedef struct content_playlist       playlist_t;
 
+enum playlist_file_format
+{
+   PLAYLIST_FORMAT_TEXT = 0,
+   /* Entry table and string table, memory-mapped on load. */
+   PLAYLIST_FORMAT_BINARY
+};
+
 struct playlist_entry
 {
    char *path;
@@ -37,6 +44,8 @@ struct playlist_entry
    char *crc32;
 };
 
+struct playlist_store;
+
 struct content_playlist
 {
    struct playlist_entry *entries;
@@ -44,6 +53,9 @@ struct content_playlist
    size_t cap;
 
    char *conf_path;
+
+   /* Lookup index, interned strings and journal state. */
+   struct playlist_store *store;
 };
 
 /**
@@ -134,8 +146,11 @@ void playlist_get_index_by_path(playlist_t *playlist,
       const char *search_path,
       char **path, char **label,
       char **core_path, char **core_name,
-      char **db_name,
-      char **crc32);
+      char **crc32,
+      char **db_name);
+
+bool playlist_get_index_by_crc32(playlist_t *playlist,
+      const char *crc32, size_t start, size_t *idx);
 
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path,
@@ -143,6 +158,32 @@ bool playlist_entry_exists(playlist_t *playlist,
 
 void playlist_write_file(playlist_t *playlist);
 
+/**
+ * playlist_set_format:
+ * @playlist            : Playlist handle.
+ * @format              : File format to save the playlist in.
+ *
+ * Sets the format the playlist file is rewritten in. Playlists
+ * keep the format they were loaded in otherwise.
+ **/
+void playlist_set_format(playlist_t *playlist,
+      enum playlist_file_format format);
+
+/**
+ * playlist_convert:
+ * @path                : Path of playlist to convert.
+ * @new_path            : Path to write the converted playlist to.
+ * @size                : Maximum capacity of playlist size.
+ * @format              : File format of the converted playlist.
+ *
+ * Converts a playlist between the text and binary formats.
+ * @new_path may be the same as @path.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool playlist_convert(const char *path, const char *new_path,
+      size_t size, enum playlist_file_format format);
+
 void playlist_qsort(playlist_t *playlist);
 
 RETRO_END_DECLS
@@ -22,6 +22,8 @@
 #include <compat/msvc.h>
 
 #include <boolean.h>
+#include <retro_miscellaneous.h>
+#include <features/features_cpu.h>
 #include <queues/fifo_queue.h>
 #include <rthreads/rthreads.h>
 #include <gfx/scaler/scaler.h>
@@ -94,13 +96,51 @@ extern "C" {
 #define av_frame_free avcodec_free_frame
 #endif
 
+#define FFMPEG_FRAME_POOL_SIZE   16
+#define FFMPEG_FRAME_QUEUE_SIZE  (FFMPEG_FRAME_POOL_SIZE * 4)
+#define FFMPEG_MAX_SCALE_THREADS 4
+
+struct ffmpeg;
+
+/* A pooled video frame, holding both the packed input pixels and their
+ * scaled and converted counterpart. Frames are handed between threads by
+ * pointer and go back to the pool when their last reference is released. */
+struct ff_frame
+{
+   uint8_t *data;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+
+   AVFrame *conv_frame;
+   uint8_t *conv_frame_buf;
+
+   unsigned refcount;
+   bool converted;
+};
+
+struct ff_scale_worker
+{
+   struct ffmpeg *handle;
+   sthread_t *thread;
+
+   struct scaler_ctx scaler;
+   struct SwsContext *sws;
+};
+
+struct ff_stats
+{
+   unsigned frames;
+   unsigned dropped;
+   unsigned stalls;
+   unsigned max_queue_depth;
+};
+
 struct ff_video_info
 {
    AVCodecContext *codec;
    AVCodec *encoder;
 
-   AVFrame *conv_frame;
-   uint8_t *conv_frame_buf;
    int64_t frame_cnt;
 
    uint8_t *outbuf;
@@ -119,8 +159,8 @@ struct ff_video_info
 
    AVFormatContext *format;
 
+   /* Formats for the scale workers' own scalers. */
    struct scaler_ctx scaler;
-   struct SwsContext *sws;
    bool use_sws;
 };
 
@@ -178,11 +218,15 @@ struct ff_config_param
    char format[64];
    enum PixelFormat out_pix_fmt;
    unsigned threads;
+   unsigned scale_threads;
    unsigned frame_drop_ratio;
    unsigned sample_rate;
    float scale_factor;
 
    bool audio_enable;
+   /* Drop frames instead of stalling when the encoder falls behind.
+    * Their timestamps are skipped, so the previous frame is shown longer. */
+   bool realtime;
    /* Keep same naming conventions as libavcodec. */
    bool audio_qscale;
    int audio_global_quality;
@@ -204,16 +248,39 @@ typedef struct ffmpeg
    
    struct ffemu_params params;
 
-   scond_t *cond;
-   slock_t *cond_lock;
    slock_t *lock;
+   slock_t *mux_lock;
+   scond_t *scale_cond;
+   scond_t *encode_cond;
+   scond_t *audio_cond;
+   scond_t *space_cond;
+
+   struct ff_frame frames[FFMPEG_FRAME_POOL_SIZE];
+   struct ff_frame *free_frames[FFMPEG_FRAME_POOL_SIZE];
+   unsigned free_count;
+
+   /* Frames in presentation order, NULL repeats the previous frame.
+    * Entries from queue_head to queue_scale are being scaled or wait
+    * to be encoded, entries from queue_scale to queue_tail wait to be
+    * scaled. The indices wrap around the queue size. */
+   struct ff_frame *queue[FFMPEG_FRAME_QUEUE_SIZE];
+   /* Frames dropped in realtime mode after each entry,
+    * their timestamps are skipped. */
+   unsigned queue_skip[FFMPEG_FRAME_QUEUE_SIZE];
+   unsigned queue_head;
+   unsigned queue_scale;
+   unsigned queue_tail;
+
    fifo_buffer_t *audio_fifo;
-   fifo_buffer_t *video_fifo;
-   fifo_buffer_t *attr_fifo;
-   sthread_t *thread;
 
-   volatile bool alive;
-   volatile bool can_sleep;
+   struct ff_scale_worker workers[FFMPEG_MAX_SCALE_THREADS];
+   unsigned worker_count;
+   sthread_t *video_thread;
+   sthread_t *audio_thread;
+
+   struct ff_stats stats;
+
+   bool alive;
 } ffmpeg_t;
 
 static bool ffmpeg_codec_has_sample_format(enum AVSampleFormat fmt,
@@ -388,7 +455,6 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
 
 static bool ffmpeg_init_video(ffmpeg_t *handle)
 {
-   size_t size;
    struct ff_config_param *params = &handle->config;
    struct ff_video_info *video    = &handle->video;
    struct ffemu_params *param     = &handle->params;
@@ -510,18 +576,6 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
 
    video->frame_drop_ratio = params->frame_drop_ratio;
 
-   size = avpicture_get_size(video->pix_fmt, param->out_width,
-         param->out_height);
-   video->conv_frame_buf = (uint8_t*)av_malloc(size);
-   video->conv_frame = av_frame_alloc();
-
-   avpicture_fill((AVPicture*)video->conv_frame, video->conv_frame_buf,
-         video->pix_fmt, param->out_width, param->out_height);
-
-   video->conv_frame->width  = param->out_width;
-   video->conv_frame->height = param->out_height;
-   video->conv_frame->format = video->pix_fmt;
-
    return true;
 }
 
@@ -530,12 +584,15 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
 {
    struct config_file_entry entry;
    char pix_fmt[64] = {0};
+   unsigned cores   = cpu_features_get_core_amount();
 
    params->out_pix_fmt = PIX_FMT_NONE;
    params->scale_factor = 1;
-   params->threads = 1;
+   params->scale_threads = MIN(MAX(cores / 2, 1), FFMPEG_MAX_SCALE_THREADS);
+   params->threads = MAX(cores - params->scale_threads, 1);
    params->frame_drop_ratio = 1;
    params->audio_enable = true;
+   params->realtime = false;
 
    if (!config)
       return true;
@@ -556,6 +613,12 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
 
    config_get_uint(params->conf, "threads", &params->threads);
 
+   if (config_get_uint(params->conf, "scale_threads", &params->scale_threads))
+      params->scale_threads = MIN(MAX(params->scale_threads, 1),
+            FFMPEG_MAX_SCALE_THREADS);
+
+   config_get_bool(params->conf, "realtime", &params->realtime);
+
    if (!config_get_uint(params->conf, "frame_drop_ratio",
             &params->frame_drop_ratio) || !params->frame_drop_ratio)
       params->frame_drop_ratio = 1;
@@ -655,69 +718,173 @@ static bool ffmpeg_init_muxer_post(ffmpeg_t *handle)
 
 #define MAX_FRAMES 32
 
-static void ffmpeg_thread(void *data);
+static void ffmpeg_scale_thread(void *data);
+static void ffmpeg_video_thread(void *data);
+static void ffmpeg_audio_thread(void *data);
+
+static bool init_frame_pool(ffmpeg_t *handle)
+{
+   unsigned i;
+   struct ff_video_info *video = &handle->video;
+   /* For some reason, FFmpeg has a tendency to crash
+    * if we don't overallocate a bit. */
+   size_t size      = (handle->params.fb_height + 2) *
+      handle->params.fb_width * video->pix_size;
+   size_t conv_size = avpicture_get_size(video->pix_fmt,
+         handle->params.out_width, handle->params.out_height);
+
+   for (i = 0; i < FFMPEG_FRAME_POOL_SIZE; i++)
+   {
+      struct ff_frame *frame = &handle->frames[i];
+
+      frame->data           = (uint8_t*)av_malloc(size);
+      frame->conv_frame_buf = (uint8_t*)av_malloc(conv_size);
+      frame->conv_frame     = av_frame_alloc();
+
+      if (!frame->data || !frame->conv_frame_buf || !frame->conv_frame)
+         return false;
+
+      avpicture_fill((AVPicture*)frame->conv_frame, frame->conv_frame_buf,
+            video->pix_fmt, handle->params.out_width,
+            handle->params.out_height);
+
+      frame->conv_frame->width  = handle->params.out_width;
+      frame->conv_frame->height = handle->params.out_height;
+      frame->conv_frame->format = video->pix_fmt;
+
+      handle->free_frames[handle->free_count++] = frame;
+   }
+
+   return true;
+}
 
 static bool init_thread(ffmpeg_t *handle)
 {
-   handle->lock = slock_new();
-   handle->cond_lock = slock_new();
-   handle->cond = scond_new();
-   handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
+   unsigned i;
+
+   if (!init_frame_pool(handle))
+   {
+      RARCH_ERR("[FFmpeg]: Failed to allocate frame pool.\n");
+      return false;
+   }
+
+   handle->lock        = slock_new();
+   handle->mux_lock    = slock_new();
+   handle->scale_cond  = scond_new();
+   handle->encode_cond = scond_new();
+   handle->audio_cond  = scond_new();
+   handle->space_cond  = scond_new();
+   handle->audio_fifo  = fifo_new(32000 * sizeof(int16_t) *
          handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
+
+   retro_assert(handle->lock && handle->mux_lock &&
+      handle->scale_cond && handle->encode_cond &&
+      handle->audio_cond && handle->space_cond && handle->audio_fifo);
 
    handle->alive = true;
-   handle->can_sleep = true;
-   handle->thread = sthread_create(ffmpeg_thread, handle);
 
-   retro_assert(handle->lock && handle->cond_lock &&
-      handle->cond && handle->audio_fifo &&
-      handle->attr_fifo && handle->video_fifo && handle->thread);
+   handle->worker_count = handle->config.scale_threads;
+
+   for (i = 0; i < handle->worker_count; i++)
+   {
+      struct ff_scale_worker *worker = &handle->workers[i];
+
+      worker->handle         = handle;
+      worker->scaler.in_fmt  = handle->video.scaler.in_fmt;
+      worker->scaler.out_fmt = handle->video.scaler.out_fmt;
+      worker->thread         = sthread_create(ffmpeg_scale_thread, worker);
+
+      retro_assert(worker->thread);
+   }
+
+   handle->video_thread = sthread_create(ffmpeg_video_thread, handle);
+   retro_assert(handle->video_thread);
+
+   if (handle->config.audio_enable)
+   {
+      handle->audio_thread = sthread_create(ffmpeg_audio_thread, handle);
+      retro_assert(handle->audio_thread);
+   }
+
+   RARCH_LOG("[FFmpeg]: %u scale threads, %u encoder threads, %s.\n",
+         handle->worker_count, handle->config.threads,
+         handle->config.realtime ? "realtime" : "lossless");
 
    return true;
 }
 
 static void deinit_thread(ffmpeg_t *handle)
 {
-   if (!handle->thread)
+   unsigned i;
+
+   if (!handle->lock)
       return;
 
-   slock_lock(handle->cond_lock);
+   /* The threads drain whatever was queued before exiting. */
+   slock_lock(handle->lock);
    handle->alive = false;
-   handle->can_sleep = false;
-   slock_unlock(handle->cond_lock);
+   scond_broadcast(handle->scale_cond);
+   scond_broadcast(handle->encode_cond);
+   scond_broadcast(handle->audio_cond);
+   scond_broadcast(handle->space_cond);
+   slock_unlock(handle->lock);
 
-   scond_signal(handle->cond);
-   sthread_join(handle->thread);
+   for (i = 0; i < handle->worker_count; i++)
+   {
+      struct ff_scale_worker *worker = &handle->workers[i];
 
-   slock_free(handle->lock);
-   slock_free(handle->cond_lock);
-   scond_free(handle->cond);
+      if (worker->thread)
+         sthread_join(worker->thread);
+      worker->thread = NULL;
 
-   handle->thread = NULL;
+      scaler_ctx_gen_reset(&worker->scaler);
+
+      if (worker->sws)
+         sws_freeContext(worker->sws);
+      worker->sws = NULL;
+   }
+
+   if (handle->video_thread)
+      sthread_join(handle->video_thread);
+   if (handle->audio_thread)
+      sthread_join(handle->audio_thread);
+
+   slock_free(handle->lock);
+   slock_free(handle->mux_lock);
+   scond_free(handle->scale_cond);
+   scond_free(handle->encode_cond);
+   scond_free(handle->audio_cond);
+   scond_free(handle->space_cond);
+
+   handle->lock         = NULL;
+   handle->mux_lock     = NULL;
+   handle->video_thread = NULL;
+   handle->audio_thread = NULL;
 }
 
 static void deinit_thread_buf(ffmpeg_t *handle)
 {
+   unsigned i;
+
    if (handle->audio_fifo)
    {
       fifo_free(handle->audio_fifo);
       handle->audio_fifo = NULL;
    }
-   
-   if (handle->attr_fifo)
-   {
-      fifo_free(handle->attr_fifo);
-      handle->attr_fifo = NULL;
-   }
 
-   if (handle->video_fifo)
+   for (i = 0; i < FFMPEG_FRAME_POOL_SIZE; i++)
    {
-      fifo_free(handle->video_fifo);
-      handle->video_fifo = NULL;
+      struct ff_frame *frame = &handle->frames[i];
+
+      av_free(frame->data);
+      av_free(frame->conv_frame_buf);
+      av_frame_free(&frame->conv_frame);
+
+      frame->data           = NULL;
+      frame->conv_frame_buf = NULL;
    }
+
+   handle->free_count = 0;
 }
 
 static void ffmpeg_free(void *data)
@@ -743,14 +910,8 @@ static void ffmpeg_free(void *data)
       av_free(handle->video.codec);
    }
 
-   av_frame_free(&handle->video.conv_frame);
-   av_free(handle->video.conv_frame_buf);
-
    scaler_ctx_gen_reset(&handle->video.scaler);
 
-   if (handle->video.sws)
-      sws_freeContext(handle->video.sws);
-
    if (handle->config.conf)
       config_file_free(handle->config.conf);
    if (handle->config.video_opts)
@@ -809,14 +970,47 @@ error:
    return NULL;
 }
 
+/* Must be called with handle->lock held. */
+static void ffmpeg_queue_frame(ffmpeg_t *handle, struct ff_frame *frame)
+{
+   unsigned depth;
+   unsigned slot = handle->queue_tail++ % FFMPEG_FRAME_QUEUE_SIZE;
+
+   handle->queue[slot]      = frame;
+   handle->queue_skip[slot] = 0;
+
+   depth = handle->queue_tail - handle->queue_head;
+   if (depth > handle->stats.max_queue_depth)
+      handle->stats.max_queue_depth = depth;
+
+   handle->stats.frames++;
+
+   if (frame)
+      scond_signal(handle->scale_cond);
+   else
+      scond_signal(handle->encode_cond);
+}
+
+/* Must be called with handle->lock held. */
+static void ffmpeg_release_frame(ffmpeg_t *handle, struct ff_frame *frame)
+{
+   if (!frame || --frame->refcount)
+      return;
+
+   handle->free_frames[handle->free_count++] = frame;
+   scond_signal(handle->space_cond);
+}
+
 static bool ffmpeg_push_video(void *data,
       const struct ffemu_video_data *vid)
 {
    unsigned y;
    bool drop_frame;
-   struct ffemu_video_data attr_data;
-   ffmpeg_t *handle = (ffmpeg_t*)data;
-   int offset = 0;
+   bool stalled            = false;
+   struct ff_frame *frame  = NULL;
+   ffmpeg_t *handle        = (ffmpeg_t*)data;
+   const uint8_t *src      = NULL;
+   uint8_t *dst            = NULL;
 
    if (!handle || !vid)
       return false;
@@ -829,52 +1023,83 @@ static bool ffmpeg_push_video(void *data,
    if (drop_frame)
       return true;
 
+   /* The pool is sized for the largest frame the core announced. */
+   if (     !vid->is_dupe
+         && (  vid->width  > handle->params.fb_width
+            || vid->height > handle->params.fb_height))
+      return false;
+
+   slock_lock(handle->lock);
+
    for (;;)
    {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->attr_fifo);
-      slock_unlock(handle->lock);
+      bool queue_full = handle->queue_tail - handle->queue_head
+         == FFMPEG_FRAME_QUEUE_SIZE;
 
       if (!handle->alive)
+      {
+         slock_unlock(handle->lock);
          return false;
+      }
 
-      if (avail >= sizeof(*vid))
+      if (!queue_full && (vid->is_dupe || handle->free_count))
          break;
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
+      if (handle->config.realtime)
       {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
+         /* Don't hold the core back, leave a gap in the timestamps
+          * instead. The queue can't be empty here, since every
+          * free frame is released by the time it drains. */
+         handle->stats.dropped++;
+         handle->queue_skip[(handle->queue_tail - 1)
+            % FFMPEG_FRAME_QUEUE_SIZE]++;
+
+         slock_unlock(handle->lock);
+         return true;
       }
-      else
-         scond_signal(handle->cond);
 
-      slock_unlock(handle->cond_lock);
+      if (!stalled)
+         handle->stats.stalls++;
+      stalled = true;
+
+      scond_wait(handle->space_cond, handle->lock);
    }
 
-   slock_lock(handle->lock);
+   if (vid->is_dupe)
+   {
+      unsigned last = (handle->queue_tail - 1) % FFMPEG_FRAME_QUEUE_SIZE;
+
+      /* Repeating a dropped frame is just a longer gap. */
+      if (     handle->queue_tail != handle->queue_head
+            && handle->queue_skip[last])
+         handle->queue_skip[last]++;
+      else
+         ffmpeg_queue_frame(handle, NULL);
+      slock_unlock(handle->lock);
+      return true;
+   }
+
+   frame = handle->free_frames[--handle->free_count];
+   slock_unlock(handle->lock);
 
    /* Tightly pack our frame to conserve memory.
     * libretro tends to use a very large pitch.
     */
-   attr_data = *vid;
-
-   if (attr_data.is_dupe)
-      attr_data.width = attr_data.height = attr_data.pitch = 0;
-   else
-      attr_data.pitch = attr_data.width * handle->video.pix_size;
+   frame->width     = vid->width;
+   frame->height    = vid->height;
+   frame->pitch     = vid->width * handle->video.pix_size;
+   frame->refcount  = 1;
+   frame->converted = false;
 
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   src = (const uint8_t*)vid->data;
+   dst = frame->data;
 
-   for (y = 0; y < attr_data.height; y++, offset += vid->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)vid->data + offset, attr_data.pitch);
+   for (y = 0; y < frame->height; y++, src += vid->pitch, dst += frame->pitch)
+      memcpy(dst, src, frame->pitch);
 
+   slock_lock(handle->lock);
+   ffmpeg_queue_frame(handle, frame);
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
@@ -883,6 +1108,7 @@ static bool ffmpeg_push_audio(void *data,
       const struct ffemu_audio_data *audio_data)
 {
    ffmpeg_t *handle = (ffmpeg_t*)data;
+   size_t size;
 
    if (!handle || !audio_data)
       return false;
@@ -890,38 +1116,27 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
+   size = audio_data->frames * handle->params.channels * sizeof(int16_t);
+
+   slock_lock(handle->lock);
+
    for (;;)
    {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->audio_fifo);
-      slock_unlock(handle->lock);
-
       if (!handle->alive)
+      {
+         slock_unlock(handle->lock);
          return false;
+      }
 
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
+      if (fifo_write_avail(handle->audio_fifo) >= size)
          break;
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
-
-      slock_unlock(handle->cond_lock);
+      scond_wait(handle->space_cond, handle->lock);
    }
 
-   slock_lock(handle->lock);
-   fifo_write(handle->audio_fifo, audio_data->data,
-         audio_data->frames * handle->params.channels * sizeof(int16_t));
+   fifo_write(handle->audio_fifo, audio_data->data, size);
+   scond_signal(handle->audio_cond);
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
@@ -961,61 +1176,73 @@ static bool encode_video(ffmpeg_t *handle, AVPacket *pkt, AVFrame *frame)
    return true;
 }
 
+static bool ffmpeg_write_packet(ffmpeg_t *handle, AVPacket *pkt)
+{
+   bool ret;
+
+   if (!pkt->size)
+      return true;
+
+   /* Audio and video are encoded on different threads. */
+   if (handle->mux_lock)
+      slock_lock(handle->mux_lock);
+
+   ret = av_interleaved_write_frame(handle->muxer.ctx, pkt) >= 0;
+
+   if (handle->mux_lock)
+      slock_unlock(handle->mux_lock);
+
+   return ret;
+}
+
 static void ffmpeg_scale_input(ffmpeg_t *handle,
-      const struct ffemu_video_data *vid)
+      struct ff_scale_worker *worker, struct ff_frame *frame)
 {
    /* Attempt to preserve more information if we scale down. */
-   bool shrunk = handle->params.out_width < vid->width
-      || handle->params.out_height < vid->height;
+   bool shrunk = handle->params.out_width < frame->width
+      || handle->params.out_height < frame->height;
 
    if (handle->video.use_sws)
    {
-      int linesize = vid->pitch;
+      int linesize = frame->pitch;
 
-      handle->video.sws = sws_getCachedContext(handle->video.sws,
-            vid->width, vid->height, handle->video.in_pix_fmt,
+      worker->sws = sws_getCachedContext(worker->sws,
+            frame->width, frame->height, handle->video.in_pix_fmt,
             handle->params.out_width, handle->params.out_height,
             handle->video.pix_fmt,
             shrunk ? SWS_BILINEAR : SWS_POINT, NULL, NULL, NULL);
 
-      sws_scale(handle->video.sws, (const uint8_t* const*)&vid->data,
-            &linesize, 0, vid->height, handle->video.conv_frame->data,
-            handle->video.conv_frame->linesize);
+      sws_scale(worker->sws, (const uint8_t* const*)&frame->data,
+            &linesize, 0, frame->height, frame->conv_frame->data,
+            frame->conv_frame->linesize);
    }
    else
    {
       video_frame_record_scale(
-            &handle->video.scaler,
-            handle->video.conv_frame->data[0],
-            vid->data,
+            &worker->scaler,
+            frame->conv_frame->data[0],
+            frame->data,
             handle->params.out_width,
             handle->params.out_height,
-            handle->video.conv_frame->linesize[0],
-            vid->width,
-            vid->height,
-            vid->pitch,
+            frame->conv_frame->linesize[0],
+            frame->width,
+            frame->height,
+            frame->pitch,
             shrunk);
    }
 }
 
-static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
-      const struct ffemu_video_data *vid)
+static bool ffmpeg_push_video_thread(ffmpeg_t *handle, AVFrame *frame)
 {
    AVPacket pkt;
 
-   if (!vid->is_dupe)
-      ffmpeg_scale_input(handle, vid);
+   frame->pts = handle->video.frame_cnt;
 
-   handle->video.conv_frame->pts = handle->video.frame_cnt;
-
-   if (!encode_video(handle, &pkt, handle->video.conv_frame))
+   if (!encode_video(handle, &pkt, frame))
       return false;
 
-   if (pkt.size)
-   {
-      if (av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
-         return false;
-   }
+   if (!ffmpeg_write_packet(handle, &pkt))
+      return false;
 
    handle->video.frame_cnt++;
    return true;
@@ -1240,11 +1467,8 @@ static bool ffmpeg_push_audio_thread(ffmpeg_t *handle,
       handle->audio.frame_cnt       += handle->audio.frames_in_buffer;
       handle->audio.frames_in_buffer = 0;
 
-      if (pkt.size)
-      {
-         if (av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
-            return false;
-      }
+      if (!ffmpeg_write_packet(handle, &pkt))
+         return false;
    }
 
    return true;
@@ -1271,7 +1495,7 @@ static void ffmpeg_flush_audio(ffmpeg_t *handle, void *audio_buf,
    {
       AVPacket pkt;
       if (!encode_audio(handle, &pkt, true) || !pkt.size ||
-            av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+            !ffmpeg_write_packet(handle, &pkt))
          break;
    }
 }
@@ -1282,69 +1506,29 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
    {
       AVPacket pkt;
       if (!encode_video(handle, &pkt, NULL) || !pkt.size ||
-            av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+            !ffmpeg_write_packet(handle, &pkt))
          break;
    }
 }
 
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
-   bool did_work;
-   void *video_buf = av_malloc(2 * handle->params.fb_width * 
-         handle->params.fb_height * handle->video.pix_size);
-   size_t audio_buf_size = handle->config.audio_enable ? 
-      (handle->audio.codec->frame_size * 
-       handle->params.channels * sizeof(int16_t)) : 0;
-   void *audio_buf = NULL;
-
-   if (audio_buf_size)
-      audio_buf = av_malloc(audio_buf_size);
-   /* Try pushing data in an interleaving pattern to 
-    * ease the work of the muxer a bit. */
-
-   do
+   /* The threads have encoded all the queued video and every
+    * complete audio frame, flush out the last audio. */
+   if (handle->config.audio_enable)
    {
-      struct ffemu_video_data attr_buf;
-
-      did_work = false;
-
-      if (handle->config.audio_enable)
-      {
-         if (fifo_read_avail(handle->audio_fifo) >= audio_buf_size)
-         {
-            struct ffemu_audio_data aud = {0};
-
-            fifo_read(handle->audio_fifo, audio_buf, audio_buf_size);
-
-            aud.frames = handle->audio.codec->frame_size;
-            aud.data = audio_buf;
+      size_t audio_buf_size = handle->audio.codec->frame_size *
+         handle->params.channels * sizeof(int16_t);
+      void *audio_buf       = av_malloc(audio_buf_size);
 
-            ffmpeg_push_audio_thread(handle, &aud, true);
-            did_work = true;
-         }
-      }
-
-      if (fifo_read_avail(handle->attr_fifo) >= sizeof(attr_buf))
-      {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf, 
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
+      if (audio_buf)
+         ffmpeg_flush_audio(handle, audio_buf, audio_buf_size);
 
-         did_work = true;
-      }
-   } while (did_work);
-
-   /* Flush out last audio. */
-   if (handle->config.audio_enable)
-      ffmpeg_flush_audio(handle, audio_buf, audio_buf_size);
+      av_free(audio_buf);
+   }
 
    /* Flush out last video. */
    ffmpeg_flush_video(handle);
-
-   av_free(video_buf);
-   av_free(audio_buf);
 }
 
 static bool ffmpeg_finalize(void *data)
@@ -1364,86 +1548,149 @@ static bool ffmpeg_finalize(void *data)
    /* Write final data. */
    av_write_trailer(handle->muxer.ctx);
 
+   RARCH_LOG("[FFmpeg]: %u frames, %u dropped, %u stalls, "
+         "max queue depth %u.\n",
+         handle->stats.frames, handle->stats.dropped,
+         handle->stats.stalls, handle->stats.max_queue_depth);
+
    return true;
 }
 
-static void ffmpeg_thread(void *data)
+static void ffmpeg_scale_thread(void *data)
 {
-   size_t audio_buf_size;
-   void *audio_buf = NULL;
-   ffmpeg_t *ff    = (ffmpeg_t*)data;
-   /* For some reason, FFmpeg has a tendency to crash 
-    * if we don't overallocate a bit. */
-   void *video_buf = av_malloc(2 * ff->params.fb_width *
-         ff->params.fb_height * ff->video.pix_size);
-
-   retro_assert(video_buf);
+   struct ff_scale_worker *worker = (struct ff_scale_worker*)data;
+   ffmpeg_t *ff                   = worker->handle;
 
-   audio_buf_size = ff->config.audio_enable ? 
-      (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
-   audio_buf      = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
+   slock_lock(ff->lock);
 
-   while (ff->alive)
+   for (;;)
    {
-      struct ffemu_video_data attr_buf;
+      struct ff_frame *frame = NULL;
 
-      bool avail_video = false;
-      bool avail_audio = false;
+      if (ff->queue_scale == ff->queue_tail)
+      {
+         if (!ff->alive)
+            break;
 
-      slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
+         scond_wait(ff->scale_cond, ff->lock);
+         continue;
+      }
+
+      frame = ff->queue[ff->queue_scale++ % FFMPEG_FRAME_QUEUE_SIZE];
+
+      if (!frame)
+         continue;
 
-      if (ff->config.audio_enable)
-         if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
       slock_unlock(ff->lock);
+      ffmpeg_scale_input(ff, worker, frame);
+      slock_lock(ff->lock);
 
-      if (!avail_video && !avail_audio)
+      frame->converted = true;
+      scond_signal(ff->encode_cond);
+   }
+
+   slock_unlock(ff->lock);
+}
+
+static void ffmpeg_video_thread(void *data)
+{
+   ffmpeg_t *ff          = (ffmpeg_t*)data;
+   struct ff_frame *last = NULL;
+
+   slock_lock(ff->lock);
+
+   for (;;)
+   {
+      struct ff_frame *frame = NULL;
+
+      if (ff->queue_head == ff->queue_tail)
       {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
-         {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
-         }
-         else
-            scond_signal(ff->cond);
+         if (!ff->alive)
+            break;
 
-         slock_unlock(ff->cond_lock);
+         scond_wait(ff->encode_cond, ff->lock);
+         continue;
       }
 
-      if (avail_video && video_buf)
+      frame = ff->queue[ff->queue_head % FFMPEG_FRAME_QUEUE_SIZE];
+
+      /* Frames are scaled out of order, but encoded in order. */
+      if (frame && !frame->converted)
       {
-         slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
+         scond_wait(ff->encode_cond, ff->lock);
+         continue;
       }
 
-      if (avail_audio && audio_buf)
+      /* Hold on to the last frame, duplicates encode it again. */
+      if (frame)
       {
-         struct ffemu_audio_data aud = {0};
+         frame->refcount++;
+         ffmpeg_release_frame(ff, last);
+         last = frame;
+      }
+
+      slock_unlock(ff->lock);
+
+      if (last)
+         ffmpeg_push_video_thread(ff, last->conv_frame);
+      else
+         ff->video.frame_cnt++;
+
+      slock_lock(ff->lock);
+
+      /* Don't leave the scale workers behind on duplicates. */
+      if (ff->queue_scale == ff->queue_head)
+         ff->queue_scale++;
+
+      ff->video.frame_cnt += ff->queue_skip[
+         ff->queue_head % FFMPEG_FRAME_QUEUE_SIZE];
+
+      ff->queue_head++;
+      ffmpeg_release_frame(ff, frame);
+      scond_signal(ff->space_cond);
+   }
+
+   ffmpeg_release_frame(ff, last);
+   slock_unlock(ff->lock);
+}
+
+static void ffmpeg_audio_thread(void *data)
+{
+   ffmpeg_t *ff          = (ffmpeg_t*)data;
+   size_t audio_buf_size = ff->audio.codec->frame_size *
+      ff->params.channels * sizeof(int16_t);
+   void *audio_buf       = av_malloc(audio_buf_size);
+
+   retro_assert(audio_buf);
 
-         slock_lock(ff->lock);
-         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
+   slock_lock(ff->lock);
 
-         aud.frames = ff->audio.codec->frame_size;
-         aud.data = audio_buf;
+   for (;;)
+   {
+      struct ffemu_audio_data aud = {0};
+
+      if (fifo_read_avail(ff->audio_fifo) < audio_buf_size)
+      {
+         if (!ff->alive)
+            break;
 
-         ffmpeg_push_audio_thread(ff, &aud, true);
+         scond_wait(ff->audio_cond, ff->lock);
+         continue;
       }
+
+      fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
+      scond_signal(ff->space_cond);
+      slock_unlock(ff->lock);
+
+      aud.frames = ff->audio.codec->frame_size;
+      aud.data   = audio_buf;
+
+      ffmpeg_push_audio_thread(ff, &aud, true);
+
+      slock_lock(ff->lock);
    }
 
-   av_free(video_buf);
+   slock_unlock(ff->lock);
    av_free(audio_buf);
 }
 
@@ -23,6 +23,7 @@
 #include <compat/strl.h>
 #include <retro_assert.h>
 #include <file/file_path.h>
+#include <file/archive_file.h>
 #include <queues/message_queue.h>
 #include <queues/task_queue.h>
 #include <string/stdstring.h>
@@ -510,6 +511,9 @@ bool runloop_ctl(enum runloop_ctl_state state, void *data)
             bool threaded_enable = false;
 #endif
             task_queue_deinit();
+#ifdef HAVE_ZLIB
+            file_archive_index_cache_init();
+#endif
             task_queue_init(threaded_enable, runloop_msg_queue_push);
          }
          break;
@@ -526,6 +530,9 @@ bool runloop_ctl(enum runloop_ctl_state state, void *data)
          break;
       case RUNLOOP_CTL_DATA_DEINIT:
          task_queue_deinit();
+#ifdef HAVE_ZLIB
+         file_archive_index_cache_deinit();
+#endif
          break;
       case RUNLOOP_CTL_IS_CORE_OPTION_UPDATED:
          if (!runloop_core_options)
@@ -1157,7 +1164,20 @@ int runloop_iterate(unsigned *sleep_ms)
    if ((settings->video.frame_delay > 0) && !input_driver_is_nonblock)
       retro_sleep(settings->video.frame_delay);
 
-   core_run();
+   if (settings->run_ahead_enabled)
+   {
+      if (!core_run_ahead(settings->run_ahead_frames))
+      {
+         /* The rollback failed, so the core is now ahead of
+          * the input it was given. core_run_ahead won't try again
+          * for this content; the setting itself is left alone. */
+         RARCH_ERR("%s\n", msg_hash_to_str(MSG_RUN_AHEAD_DISABLED));
+         runloop_msg_queue_push(msg_hash_to_str(MSG_RUN_AHEAD_DISABLED),
+               1, 180, true);
+      }
+   }
+   else
+      core_run();
 
 #ifdef HAVE_CHEEVOS
    if (runloop_check_cheevos())
@@ -156,6 +156,102 @@ static int content_file_read(const char *path, void **buf, ssize_t *length)
    return filestream_read_file(path, buf, length);
 }
 
+/**
+ * content_file_map:
+ * @path             : path to file.
+ * @stream           : set to the stream holding the mapping.
+ * @buf              : set to the mapped, read-only contents of the file.
+ * @length           : set to the size of the file.
+ *
+ * Maps an uncompressed content file instead of reading it, so large
+ * images are paged in as the core copies them rather than loaded twice.
+ * Close @stream to release the mapping.
+ *
+ * Returns: true if the file was mapped.
+ */
+static bool content_file_map(const char *path, RFILE **stream,
+      void **buf, ssize_t *length)
+{
+#ifdef HAVE_MMAP
+   size_t size      = 0;
+   const void *data = NULL;
+   RFILE *file      = NULL;
+
+#ifdef HAVE_COMPRESSION
+   if (path_contains_compressed_file(path))
+      return false;
+#endif
+
+   file = filestream_open(path, RFILE_MODE_READ | RFILE_HINT_MMAP, -1);
+   if (!file)
+      return false;
+
+   data = filestream_get_mapped(file, &size);
+
+   /* Cores may rely on the terminating NUL filestream_read_file
+    * adds. The rest of the mapping's last page reads as zeroes,
+    * so only files ending on a page boundary lack one; those
+    * are read instead. */
+   if (!data || (ssize_t)size <= 0 || !(size & 4095))
+   {
+      filestream_close(file);
+      return false;
+   }
+
+   *stream = file;
+   *buf    = (void*)data;
+   *length = (ssize_t)size;
+   return true;
+#else
+   return false;
+#endif
+}
+
+/**
+ * content_find_playlist_crc:
+ * @path             : path to content file.
+ * @crc              : set to the CRC32 recorded for @path.
+ *
+ * Looks @path up in the playlists that are already loaded, i.e. the
+ * one the menu is showing and the content history, for content that
+ * isn't loaded into memory and so is never checksummed here.
+ *
+ * Returns: true if a playlist knows the CRC32 of @path.
+ */
+static bool content_find_playlist_crc(const char *path, uint32_t *crc)
+{
+   unsigned i;
+   playlist_t *playlists[2];
+
+   playlists[0] = NULL;
+   playlists[1] = g_defaults.content_history;
+
+#ifdef HAVE_MENU
+   menu_driver_ctl(RARCH_MENU_CTL_PLAYLIST_GET, &playlists[0]);
+#endif
+
+   for (i = 0; i < ARRAY_SIZE(playlists); i++)
+   {
+      char *entry_crc = NULL;
+
+      if (!playlists[i])
+         continue;
+
+      playlist_get_index_by_path(playlists[i], path,
+            NULL, NULL, NULL, NULL, &entry_crc, NULL);
+
+      /* Scanned entries look like "0123ABCD|crc" */
+      if (     entry_crc && strlen(entry_crc) == 12
+            && string_is_equal(entry_crc + 8, "|crc"))
+      {
+         *crc = (uint32_t)strtoul(entry_crc, NULL, 16);
+         return true;
+      }
+   }
+
+   return false;
+}
+
 /**
  * content_load_init_wrap:
  * @args                 : Input arguments.
@@ -316,40 +412,63 @@ error:
 static bool load_content_into_memory(
       content_information_ctx_t *content_ctx,
       unsigned i, const char *path, void **buf,
-      ssize_t *length)
+      ssize_t *length, RFILE **stream)
 {
    uint32_t *content_crc_ptr = NULL;
    uint8_t *ret_buf          = NULL;
 
+   *stream                   = NULL;
+
    RARCH_LOG("%s: %s.\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), path);
-   if (!content_file_read(path, (void**) &ret_buf, length))
+   if (     !content_file_map(path, stream, (void**)&ret_buf, length)
+         && !content_file_read(path, (void**) &ret_buf, length))
       return false;
 
    if (*length < 0)
+   {
+      if (*stream)
+         filestream_close(*stream);
+      *stream = NULL;
       return false;
+   }
 
    if (i == 0)
    {
       /* First content file is significant, attempt to do patching,
        * CRC checking, etc. */
+      bool patched = false;
+
+      content_get_crc(&content_crc_ptr);
 
-      /* Attempt to apply a patch. */
+      /* Attempt to apply a patch. The patcher computes the CRC
+       * of its output as it writes it. */
       if (!content_ctx->patch_is_blocked)
       {
          global_t *global = global_get_ptr();
+         uint8_t *source  = ret_buf;
+
          if (global)
-            patch_content(
+            patched = patch_content(
                   global->name.ips,
                   global->name.bps,
                   global->name.ups,
-                  (uint8_t**)&ret_buf,
-                  (void*)length);
-      }
+                  &ret_buf,
+                  length,
+                  content_crc_ptr);
 
-      content_get_crc(&content_crc_ptr);
+         if (patched)
+         {
+            if (*stream)
+               filestream_close(*stream);
+            else
+               free(source);
+            *stream = NULL;
+         }
+      }
 
-      *content_crc_ptr = encoding_crc32(0, ret_buf, *length);
+      if (!patched)
+         *content_crc_ptr = encoding_crc32(0, ret_buf, *length);
 
       RARCH_LOG("CRC32: 0x%x .\n", (unsigned)*content_crc_ptr);
    }
@@ -493,6 +612,7 @@ static bool content_file_init_extract(
  **/
 static bool content_file_load(
       struct retro_game_info *info,
+      RFILE **streams,
       const struct string_list *content,
       content_information_ctx_t *content_ctx,
       char **error_string,
@@ -539,7 +659,7 @@ static bool content_file_load(
 
          if (!load_content_into_memory(
                   content_ctx,
-                  i, path, (void**)&info[i].data, &len))
+                  i, path, (void**)&info[i].data, &len, &streams[i]))
          {
             snprintf(msg, sizeof(msg),
                   "%s \"%s\".\n",
@@ -557,6 +677,19 @@ static bool content_file_load(
                msg_hash_to_str(
                   MSG_CONTENT_LOADING_SKIPPED_IMPLEMENTATION_WILL_DO_IT));
 
+         /* Never read the file just to checksum it; use the CRC the
+          * database scan recorded, if any. */
+         if (i == 0 && !string_is_empty(path))
+         {
+            uint32_t *content_crc_ptr = NULL;
+
+            content_get_crc(&content_crc_ptr);
+
+            if (content_find_playlist_crc(path, content_crc_ptr))
+               RARCH_LOG("CRC32: 0x%x (from playlist).\n",
+                     (unsigned)*content_crc_ptr);
+         }
+
 #ifdef HAVE_COMPRESSION
          if (     !content_ctx->block_extract
                && need_fullpath
@@ -733,6 +866,7 @@ static bool content_file_init(
       char **error_string)
 {
    struct retro_game_info               *info = NULL;
+   RFILE                             **streams = NULL;
    struct string_list *content                = NULL;
    bool ret                                   = path_is_empty(RARCH_PATH_SUBSYSTEM) 
       ? true : false;
@@ -752,19 +886,27 @@ static bool content_file_init(
 
    info                   = (struct retro_game_info*)
       calloc(content->size, sizeof(*info));
+   streams                = (RFILE**)calloc(content->size, sizeof(*streams));
 
-   if (info)
+   if (info && streams)
    {
       unsigned i;
-      ret = content_file_load(info, content, content_ctx, error_string,
-            special);
+      ret = content_file_load(info, streams, content, content_ctx,
+            error_string, special);
 
       for (i = 0; i < content->size; i++)
-         free((void*)info[i].data);
-
-      free(info);
+      {
+         /* Mapped content belongs to its stream */
+         if (streams[i])
+            filestream_close(streams[i]);
+         else
+            free((void*)info[i].data);
+      }
    }
 
+   free(info);
+   free(streams);
+
 error:
    if (content)
       string_list_free(content);
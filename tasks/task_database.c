@@ -26,6 +26,7 @@
 #include <streams/file_stream.h>
 #include "tasks_internal.h"
 
+#include "../configuration.h"
 #include "../database_info.h"
 
 #include "../file_path_special.h"
@@ -57,6 +58,10 @@ typedef struct db_handle
 {
    database_state_handle_t state;
    database_info_handle_t *handle;
+   /* Last playlist matches were added to, kept open
+    * across matches. */
+   playlist_t *playlist;
+   enum playlist_file_format playlist_format;
    unsigned status;
    char playlist_directory[4096];
    char content_database_path[4096];
@@ -90,6 +95,32 @@ static const char *database_info_get_current_element_name(database_info_handle_t
    return handle->list->elems[handle->list_ptr].data;
 }
 
+static void task_database_playlist_close(db_handle_t *_db)
+{
+   if (!_db->playlist)
+      return;
+
+   playlist_write_file(_db->playlist);
+   playlist_free(_db->playlist);
+   _db->playlist = NULL;
+}
+
+/* Scans add their matches to a handful of playlists, so
+ * keep the current one loaded instead of reading it back
+ * for every single match. */
+static playlist_t *task_database_playlist_open(db_handle_t *_db,
+      const char *path)
+{
+   if (_db->playlist && string_is_equal(_db->playlist->conf_path, path))
+      return _db->playlist;
+
+   task_database_playlist_close(_db);
+
+   _db->playlist = playlist_init(path, COLLECTION_SIZE);
+   playlist_set_format(_db->playlist, _db->playlist_format);
+   return _db->playlist;
+}
+
 static int task_database_iterate_start(database_info_handle_t *db,
       const char *name)
 {
@@ -303,7 +334,7 @@ static int database_info_list_iterate_found_match(
    fill_pathname_join(db_playlist_path, _db->playlist_directory,
          db_playlist_base_str, sizeof(db_playlist_path));
 
-   playlist = playlist_init(db_playlist_path, COLLECTION_SIZE);
+   playlist = task_database_playlist_open(_db, db_playlist_path);
 
 
    snprintf(db_crc, sizeof(db_crc), "%08X|crc", db_info_entry->crc32);
@@ -337,7 +368,6 @@ static int database_info_list_iterate_found_match(
    }
 
    playlist_write_file(playlist);
-   playlist_free(playlist);
 
    database_info_list_free(db_state->info);
    free(db_state->info);
@@ -475,7 +505,7 @@ static int task_database_iterate_playlist_lutro(
          file_path_str(FILE_PATH_LUTRO_PLAYLIST),
          sizeof(db_playlist_path));
 
-   playlist = playlist_init(db_playlist_path, COLLECTION_SIZE);
+   playlist = task_database_playlist_open(_db, db_playlist_path);
 
    if(!playlist_entry_exists(playlist, path, file_path_str(FILE_PATH_DETECT)))
    {
@@ -495,7 +525,6 @@ static int task_database_iterate_playlist_lutro(
    }
 
    playlist_write_file(playlist);
-   playlist_free(playlist);
 
    return 0;
 }
@@ -687,6 +716,8 @@ task_finished:
 
    if (db)
    {
+      task_database_playlist_close(db);
+
       if (db->state.buf)
          free(db->state.buf);
 
@@ -707,10 +738,14 @@ bool task_push_dbscan(
 {
    retro_task_t *t      = (retro_task_t*)calloc(1, sizeof(*t));
    db_handle_t *db      = (db_handle_t*)calloc(1, sizeof(db_handle_t));
+   settings_t *settings = config_get_ptr();
 
    if (!t || !db)
       goto error;
 
+   db->playlist_format  = settings->playlist_binary_format
+      ? PLAYLIST_FORMAT_BINARY : PLAYLIST_FORMAT_TEXT;
+
    t->handler        = task_database_handler;
    t->state          = db;
    t->callback       = cb;
@@ -23,6 +23,11 @@
 #include <retro_stat.h>
 #include <compat/strl.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#endif
+
 #include "tasks_internal.h"
 #include "../file_path_special.h"
 #include "../verbosity.h"
@@ -144,6 +149,10 @@ static void task_decompress_handler_finished(retro_task_t *task,
       task_set_data(task, data);
    }
 
+#ifdef HAVE_ZLIB
+   if (dec->index)
+      file_archive_index_close(dec->index);
+#endif
    if (dec->subdir)
       free(dec->subdir);
    if (dec->valid_ext)
@@ -152,6 +161,215 @@ static void task_decompress_handler_finished(retro_task_t *task,
    free(dec);
 }
 
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+#define DECOMPRESS_MAX_THREADS 4
+
+/* Extracts the entries of an indexed archive on several threads.
+ * Entries are independent, so each thread seeks to and inflates
+ * the next unclaimed one on its own. */
+struct decompress_workers
+{
+   sthread_t *threads[DECOMPRESS_MAX_THREADS];
+   unsigned count;
+   slock_t *lock;
+   scond_t *cond;
+   decompress_state_t *dec;
+   size_t next;
+   size_t done;
+   bool cancel;
+};
+
+static bool task_decompress_entry(decompress_state_t *dec,
+      const struct file_archive_entry *entry, char *path, size_t size)
+{
+   char path_dir[PATH_MAX_LENGTH];
+   const char *name = entry->name;
+   size_t len       = strlen(name);
+
+   path_dir[0] = path[0] = '\0';
+
+   /* Ignore directories. */
+   if (!len || name[len - 1] == '/' || name[len - 1] == '\\')
+      return true;
+
+   if (dec->subdir)
+   {
+      if (strstr(name, dec->subdir) != name)
+         return true;
+
+      name += strlen(dec->subdir) + 1;
+   }
+
+   fill_pathname_join(path, dec->target_dir, name, size);
+   fill_pathname_basedir(path_dir, path, sizeof(path_dir));
+
+   /* Make directory. Safe to race, existing directories count
+    * as success. */
+   if (!path_mkdir(path_dir))
+      return false;
+
+   return file_archive_index_read(dec->index, entry, NULL, path) == 0;
+}
+
+static void task_decompress_worker(void *data)
+{
+   char path[PATH_MAX_LENGTH];
+   struct decompress_workers *workers = (struct decompress_workers*)data;
+   decompress_state_t *dec            = workers->dec;
+   size_t total                       = file_archive_index_size(dec->index);
+
+   for (;;)
+   {
+      bool ret;
+      const struct file_archive_entry *entry = NULL;
+
+      slock_lock(workers->lock);
+      if (!workers->cancel && !dec->callback_error && workers->next < total)
+         entry = file_archive_index_get(dec->index, workers->next++);
+      slock_unlock(workers->lock);
+
+      if (!entry)
+         break;
+
+      ret = task_decompress_entry(dec, entry, path, sizeof(path));
+
+      slock_lock(workers->lock);
+      workers->done++;
+      if (!ret && !dec->callback_error)
+      {
+         dec->callback_error = (char*)malloc(PATH_MAX_LENGTH);
+         snprintf(dec->callback_error, PATH_MAX_LENGTH,
+               "Failed to deflate %s.\n", path);
+      }
+      scond_signal(workers->cond);
+      slock_unlock(workers->lock);
+   }
+}
+
+static void task_decompress_workers_free(struct decompress_workers *workers)
+{
+   unsigned i;
+
+   slock_lock(workers->lock);
+   workers->cancel = true;
+   slock_unlock(workers->lock);
+
+   for (i = 0; i < workers->count; i++)
+      sthread_join(workers->threads[i]);
+
+   scond_free(workers->cond);
+   slock_free(workers->lock);
+   free(workers);
+}
+
+static struct decompress_workers *task_decompress_workers_new(
+      decompress_state_t *dec)
+{
+   unsigned i;
+   unsigned count                     = cpu_features_get_core_amount();
+   size_t total                       = file_archive_index_size(dec->index);
+   struct decompress_workers *workers = (struct decompress_workers*)
+      calloc(1, sizeof(*workers));
+
+   if (!workers)
+      return NULL;
+
+   workers->dec  = dec;
+   workers->lock = slock_new();
+   workers->cond = scond_new();
+
+   if (!workers->lock || !workers->cond)
+   {
+      if (workers->lock)
+         slock_free(workers->lock);
+      if (workers->cond)
+         scond_free(workers->cond);
+      free(workers);
+      return NULL;
+   }
+
+   if (count > DECOMPRESS_MAX_THREADS)
+      count = DECOMPRESS_MAX_THREADS;
+   if (count > total)
+      count = (unsigned)total;
+   if (count < 1)
+      count = 1;
+
+   for (i = 0; i < count; i++)
+   {
+      workers->threads[workers->count] = sthread_create(
+            task_decompress_worker, workers);
+
+      if (!workers->threads[workers->count])
+         break;
+
+      workers->count++;
+   }
+
+   if (!workers->count)
+   {
+      task_decompress_workers_free(workers);
+      return NULL;
+   }
+
+   RARCH_LOG("[decompress] Extracting %u entries on %u threads.\n",
+         (unsigned)total, workers->count);
+
+   return workers;
+}
+
+/* Returns false if @dec has to be extracted by walking the archive. */
+static bool task_decompress_handler_parallel(retro_task_t *task,
+      decompress_state_t *dec)
+{
+   size_t done;
+   bool finished;
+   size_t total = 0;
+
+   if (!dec->index)
+      return false;
+
+   if (!dec->workers)
+   {
+      dec->workers = task_decompress_workers_new(dec);
+
+      if (!dec->workers)
+      {
+         file_archive_index_close(dec->index);
+         dec->index = NULL;
+         return false;
+      }
+   }
+
+   total = file_archive_index_size(dec->index);
+
+   slock_lock(dec->workers->lock);
+   if (task_get_cancelled(task))
+      dec->workers->cancel = true;
+   /* The task worker would otherwise spin on this handler
+    * until extraction is done. Wake up whenever an entry
+    * finishes, and now and then to notice cancellation. */
+   else if (!dec->callback_error && dec->workers->done < total)
+      scond_wait_timeout(dec->workers->cond, dec->workers->lock, 10000);
+   done     = dec->workers->done;
+   finished = dec->workers->cancel || dec->callback_error || done == total;
+   slock_unlock(dec->workers->lock);
+
+   task_set_progress(task, total ? (signed)(done * 100 / total) : 100);
+
+   if (!finished)
+      return true;
+
+   task_decompress_workers_free(dec->workers);
+   dec->workers = NULL;
+
+   task_set_error(task, dec->callback_error);
+   task_decompress_handler_finished(task, dec);
+
+   return true;
+}
+#endif
+
 static void task_decompress_handler(retro_task_t *task)
 {
    int ret;
@@ -159,6 +377,11 @@ static void task_decompress_handler(retro_task_t *task)
    struct archive_extract_userdata userdata = {{0}};
    decompress_state_t *dec                  = (decompress_state_t*)task->state;
 
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+   if (task_decompress_handler_parallel(task, dec))
+      return;
+#endif
+
    userdata.dec            = dec;
    strlcpy(userdata.archive_path, dec->source_file, sizeof(userdata.archive_path));
 
@@ -209,6 +432,11 @@ static void task_decompress_handler_subdir(retro_task_t *task)
    decompress_state_t *dec = (decompress_state_t*)task->state;
    struct archive_extract_userdata userdata = {{0}};
 
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+   if (task_decompress_handler_parallel(task, dec))
+      return;
+#endif
+
    userdata.dec            = dec;
    strlcpy(userdata.archive_path, dec->source_file, sizeof(userdata.archive_path));
 
@@ -305,6 +533,13 @@ bool task_push_decompress(
    s->valid_ext   = valid_ext ? strdup(valid_ext) : NULL;
    s->archive.type   = ARCHIVE_TRANSFER_INIT;
 
+#if defined(HAVE_THREADS) && defined(HAVE_ZLIB)
+   /* ZIP entries can be extracted independently of each other. */
+   if (file_archive_get_file_backend(source_file)
+         == file_archive_get_zlib_file_backend())
+      s->index    = file_archive_index_open(source_file);
+#endif
+
    t              = (retro_task_t*)calloc(1, sizeof(*t));
 
    if (!t)
@@ -338,6 +573,12 @@ bool task_push_decompress(
 
 error:
    if (s)
+   {
+#ifdef HAVE_ZLIB
+      if (s->index)
+         file_archive_index_close(s->index);
+#endif
       free(s);
+   }
    return false;
 }
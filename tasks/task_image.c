@@ -25,6 +25,11 @@
 #include <lists/string_list.h>
 #include <rhash.h>
 
+#ifdef HAVE_THREADS
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
+#endif
+
 #include "../gfx/video_driver.h"
 #include "../file_path_special.h"
 #include "../verbosity.h"
@@ -409,3 +414,257 @@ void task_image_load_free(retro_task_t *task)
       free(nbio);
    }
 }
+
+#define IMAGE_BATCH_MAX_THREADS 4
+
+typedef struct
+{
+   image_batch_t *batch;
+   unsigned next;
+   unsigned done;
+#ifdef HAVE_THREADS
+   unsigned thread_count;
+   sthread_t *threads[IMAGE_BATCH_MAX_THREADS];
+   slock_t *lock;
+   scond_t *cond;
+#endif
+} image_batch_state_t;
+
+static void task_image_batch_decode(image_batch_t *batch, unsigned i)
+{
+   if (!image_texture_load(&batch->images[i], batch->paths->elems[i].data))
+      batch->images[i].pixels = NULL;
+}
+
+#ifdef HAVE_THREADS
+static void task_image_batch_thread(void *data)
+{
+   image_batch_state_t *state = (image_batch_state_t*)data;
+
+   for (;;)
+   {
+      unsigned i;
+
+      slock_lock(state->lock);
+      i = state->next++;
+      slock_unlock(state->lock);
+
+      if (i >= state->batch->paths->size)
+         break;
+
+      task_image_batch_decode(state->batch, i);
+
+      slock_lock(state->lock);
+      state->done++;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+   }
+}
+
+/* Stops handing out images and waits for the decoders
+ * to finish the ones they already picked up. */
+static void task_image_batch_join(image_batch_state_t *state)
+{
+   unsigned i;
+
+   if (!state->thread_count)
+      return;
+
+   slock_lock(state->lock);
+   state->next = (unsigned)state->batch->paths->size;
+   slock_unlock(state->lock);
+
+   for (i = 0; i < state->thread_count; i++)
+      sthread_join(state->threads[i]);
+   state->thread_count = 0;
+}
+#endif
+
+static void task_image_batch_handler(retro_task_t *task)
+{
+   unsigned i;
+   image_batch_state_t *state = (image_batch_state_t*)task->state;
+   unsigned size              = (unsigned)state->batch->paths->size;
+   bool finished              = false;
+
+   if (task_get_cancelled(task))
+   {
+#ifdef HAVE_THREADS
+      task_image_batch_join(state);
+#endif
+      task_set_finished(task, true);
+      return;
+   }
+
+#ifdef HAVE_THREADS
+   if (state->lock)
+   {
+      if (!state->thread_count)
+      {
+         unsigned count = MIN(cpu_features_get_core_amount(), size);
+
+         for (i = 0; i < MIN(count, IMAGE_BATCH_MAX_THREADS); i++)
+         {
+            state->threads[i] = sthread_create(
+                  task_image_batch_thread, state);
+            if (!state->threads[i])
+               break;
+            state->thread_count++;
+         }
+      }
+
+      if (state->thread_count)
+      {
+         /* Wait a little, the task worker has nothing else to do
+          * than poll for the decoders. */
+         slock_lock(state->lock);
+         if (state->done < size)
+            scond_wait_timeout(state->cond, state->lock, 1000);
+         finished = state->done == size;
+         slock_unlock(state->lock);
+
+         if (!finished)
+            return;
+
+         task_image_batch_join(state);
+      }
+   }
+#endif
+
+   /* Without threads, one image per iteration. */
+   if (!finished && state->next < size)
+   {
+      task_image_batch_decode(state->batch, state->next++);
+      state->done++;
+   }
+
+   if (state->done < size)
+      return;
+
+   task_set_data(task, state->batch);
+   state->batch = NULL;
+   task_set_finished(task, true);
+}
+
+static void task_image_batch_cleanup(retro_task_t *task)
+{
+   image_batch_state_t *state = task ? (image_batch_state_t*)task->state : NULL;
+
+   if (!state)
+      return;
+
+#ifdef HAVE_THREADS
+   /* The decoders write into the batch until they're joined. */
+   if (state->batch)
+      task_image_batch_join(state);
+#endif
+   task_image_batch_free(state->batch);
+#ifdef HAVE_THREADS
+   if (state->lock)
+      slock_free(state->lock);
+   if (state->cond)
+      scond_free(state->cond);
+#endif
+   free(state);
+   task->state = NULL;
+}
+
+/**
+ * task_push_image_load_batch:
+ * @paths            : images to decode; the task takes ownership.
+ * @cb               : called with an image_batch_t, which is to be
+ *                     freed with task_image_batch_free.
+ * @user_data        : passed on to @cb.
+ *
+ * Decodes a set of images in parallel, up to one per core.
+ * Images that fail to decode are left with NULL pixels.
+ * If the task is cancelled, @cb gets a NULL batch.
+ *
+ * Returns: true if the task was queued.
+ **/
+bool task_push_image_load_batch(struct string_list *paths,
+      retro_task_callback_t cb, void *user_data)
+{
+   unsigned i;
+   bool supports_rgba         = video_driver_supports_rgba();
+   retro_task_t *t            = NULL;
+   image_batch_state_t *state = NULL;
+   image_batch_t *batch       = NULL;
+
+   if (!paths || !paths->size)
+      goto error;
+
+   t     = (retro_task_t*)calloc(1, sizeof(*t));
+   state = (image_batch_state_t*)calloc(1, sizeof(*state));
+   batch = (image_batch_t*)calloc(1, sizeof(*batch));
+
+   if (!t || !state || !batch)
+      goto error;
+
+   batch->paths  = paths;
+   batch->images = (struct texture_image*)
+      calloc(paths->size, sizeof(*batch->images));
+
+   if (!batch->images)
+      goto error;
+
+   for (i = 0; i < paths->size; i++)
+      batch->images[i].supports_rgba = supports_rgba;
+
+   state->batch = batch;
+
+#ifdef HAVE_THREADS
+   /* Falls back to decoding on the task worker. */
+   state->lock  = slock_new();
+   state->cond  = scond_new();
+   if (!state->lock || !state->cond)
+   {
+      if (state->lock)
+         slock_free(state->lock);
+      if (state->cond)
+         scond_free(state->cond);
+      state->lock = NULL;
+      state->cond = NULL;
+   }
+#endif
+
+   t->state     = state;
+   t->handler   = task_image_batch_handler;
+   t->cleanup   = task_image_batch_cleanup;
+   t->callback  = cb;
+   t->user_data = user_data;
+
+   task_queue_ctl(TASK_QUEUE_CTL_PUSH, t);
+
+   return true;
+
+error:
+   /* @paths is ours even when the task couldn't be queued */
+   string_list_free(paths);
+   if (batch)
+   {
+      if (batch->images)
+         free(batch->images);
+      free(batch);
+   }
+   if (state)
+      free(state);
+   if (t)
+      free(t);
+   return false;
+}
+
+void task_image_batch_free(image_batch_t *batch)
+{
+   unsigned i;
+
+   if (!batch)
+      return;
+
+   for (i = 0; i < batch->paths->size; i++)
+      image_texture_free(&batch->images[i]);
+
+   free(batch->images);
+   string_list_free(batch->paths);
+   free(batch);
+}
@@ -129,10 +129,10 @@ static void task_netplay_crc_scan_handler(retro_task_t *task)
 
          playlist = playlist_init(lpl_path, 99999);
 
-         for (j = 0; j < playlist->size; j++)
+         for (j = 0; playlist_get_index_by_crc32(playlist,
+                  state->content_crc, j, &j); j++)
          {
-            if (string_is_equal(playlist->entries[j].crc32, state->content_crc) && 
-               strstr(state->core_extensions, path_get_extension(playlist->entries[j].path)))
+            if (strstr(state->core_extensions, path_get_extension(playlist->entries[j].path)))
             {
                RARCH_LOG("CRC Match %s\n", playlist->entries[j].crc32);
                strlcpy(state->content_path, playlist->entries[j].path, sizeof(state->content_path));
@@ -142,14 +142,14 @@ static void task_netplay_crc_scan_handler(retro_task_t *task)
                task_set_title(task, strdup(msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NETPLAY_COMPAT_CONTENT_FOUND)));
                task_set_finished(task, true);
                string_list_free(state->lpl_list);
-               free(playlist);
+               playlist_free(playlist);
                return;
             }
 
             task_set_progress(task, (int)(j/playlist->size*100.0));
          }
 
-         free(playlist);
+         playlist_free(playlist);
       }
    }
    /* Lobby reports core doesn't need content */
@@ -201,14 +201,14 @@ static void task_netplay_crc_scan_handler(retro_task_t *task)
                task_set_title(task, strdup(msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NETPLAY_COMPAT_CONTENT_FOUND)));
                task_set_finished(task, true);
                string_list_free(state->lpl_list);
-               free(playlist);
+               playlist_free(playlist);
                return;
             }
 
             task_set_progress(task, (int)(j/playlist->size*100.0));
          }
 
-         free(playlist);
+         playlist_free(playlist);
       }
    }
 
@@ -27,6 +27,7 @@
 #include <compat/msvc.h>
 #include <file/file_path.h>
 #include <streams/file_stream.h>
+#include <retro_miscellaneous.h>
 #include <retro_stat.h>
 #include <string/stdstring.h>
 
@@ -81,7 +82,11 @@ struct ups_data
 };
 
 typedef enum patch_error (*patch_func_t)(const uint8_t*, size_t,
-      const uint8_t*, size_t, uint8_t*, size_t*);
+      const uint8_t*, size_t, uint8_t*, size_t*, uint32_t*);
+
+/* Returns the size of the buffer the patch needs for its output,
+ * or 0 if the patch is invalid. */
+typedef size_t (*patch_size_func_t)(const uint8_t*, size_t, size_t);
 
 static uint8_t bps_read(struct bps_data *bps)
 {
@@ -117,10 +122,42 @@ static void bps_write(struct bps_data *bps, uint8_t data)
    bps->target_checksum = ~(encoding_crc32(~bps->target_checksum, &data, 1));
 }
 
+/* Target sizes come straight from the patch header. Refuse ones
+ * far beyond the source, like the old fixed-size buffer did,
+ * so a malformed header can't ask for an arbitrary allocation. */
+static size_t patch_target_size_bound(uint64_t target_size,
+      size_t source_length)
+{
+   if (target_size > (uint64_t)source_length * 4)
+      return 0;
+   return (size_t)target_size;
+}
+
+static size_t bps_target_size(const uint8_t *modify_data,
+      size_t modify_length, size_t source_length)
+{
+   struct bps_data bps = {0};
+
+   if (modify_length < 19)
+      return 0;
+
+   bps.modify_data   = modify_data;
+   bps.modify_length = modify_length;
+
+   if ((bps_read(&bps) != 'B') || (bps_read(&bps) != 'P') ||
+         (bps_read(&bps) != 'S') || (bps_read(&bps) != '1'))
+      return 0;
+
+   /* Source size, then target size */
+   bps_decode(&bps);
+   return patch_target_size_bound(bps_decode(&bps), source_length);
+}
+
 static enum patch_error bps_apply_patch(
       const uint8_t *modify_data, size_t modify_length,
       const uint8_t *source_data, size_t source_length,
-      uint8_t *target_data, size_t *target_length)
+      uint8_t *target_data, size_t *target_length,
+      uint32_t *target_crc)
 {
    size_t i;
    uint32_t checksum;
@@ -231,6 +268,9 @@ static enum patch_error bps_apply_patch(
 
    *target_length = modify_target_size;
 
+   /* Checked against the patch, so it's the CRC of the whole output */
+   *target_crc    = bps.target_checksum;
+
    return PATCH_SUCCESS;
 }
 
@@ -288,10 +328,38 @@ static uint64_t ups_decode(struct ups_data *data)
    return offset;
 }
 
+static size_t ups_target_size(const uint8_t *patchdata,
+      size_t patchlength, size_t sourcelength)
+{
+   unsigned source_read_length;
+   unsigned target_read_length;
+   struct ups_data data = {0};
+
+   data.patch_data      = patchdata;
+   data.patch_length    = patchlength;
+
+   if (data.patch_length < 18)
+      return 0;
+   if (ups_patch_read(&data) != 'U' || ups_patch_read(&data) != 'P'
+         || ups_patch_read(&data) != 'S' || ups_patch_read(&data) != '1')
+      return 0;
+
+   source_read_length = ups_decode(&data);
+   target_read_length = ups_decode(&data);
+
+   /* UPS patches apply both ways */
+   if (sourcelength == source_read_length)
+      return patch_target_size_bound(target_read_length, sourcelength);
+   if (sourcelength == target_read_length)
+      return patch_target_size_bound(source_read_length, sourcelength);
+   return 0;
+}
+
 static enum patch_error ups_apply_patch(
       const uint8_t *patchdata, size_t patchlength,
       const uint8_t *sourcedata, size_t sourcelength,
-      uint8_t *targetdata, size_t *targetlength)
+      uint8_t *targetdata, size_t *targetlength,
+      uint32_t *target_crc)
 {
    size_t i;
    unsigned source_read_length;
@@ -375,7 +443,10 @@ static enum patch_error ups_apply_patch(
    {
       if (data.target_checksum == target_read_checksum
             && data.target_length == target_read_length) 
+      {
+         *target_crc = data.target_checksum;
          return PATCH_SUCCESS;
+      }
       return PATCH_TARGET_INVALID;
    } 
    else if (data.source_checksum == target_read_checksum
@@ -383,17 +454,87 @@ static enum patch_error ups_apply_patch(
    {
       if (data.target_checksum == source_read_checksum
             && data.target_length == source_read_length) 
+      {
+         *target_crc = data.target_checksum;
          return PATCH_SUCCESS;
+      }
       return PATCH_TARGET_INVALID;
    } 
 
    return PATCH_SOURCE_INVALID;
 }
 
+static size_t ips_target_size(const uint8_t *patchdata,
+      size_t patchlen, size_t sourcelength)
+{
+   uint32_t offset = 5;
+   size_t size     = sourcelength;
+
+   if (patchlen < 8 || memcmp(patchdata, "PATCH", 5))
+      return 0;
+
+   /* Same walk as ips_apply_patch, without writing anything */
+   for (;;)
+   {
+      uint32_t address;
+      unsigned length;
+
+      if (offset > patchlen - 3)
+         break;
+
+      address  = patchdata[offset++] << 16;
+      address |= patchdata[offset++] << 8;
+      address |= patchdata[offset++] << 0;
+
+      if (address == 0x454f46) /* EOF */
+      {
+         if (offset == patchlen)
+            return size;
+         else if (offset == patchlen - 3)
+         {
+            uint32_t truncate = patchdata[offset++] << 16;
+            truncate |= patchdata[offset++] << 8;
+            truncate |= patchdata[offset++] << 0;
+            return MAX(size, truncate);
+         }
+      }
+
+      if (offset > patchlen - 2)
+         break;
+
+      length  = patchdata[offset++] << 8;
+      length |= patchdata[offset++] << 0;
+
+      if (length) /* Copy */
+      {
+         if (offset > patchlen - length)
+            break;
+         offset += length;
+      }
+      else /* RLE */
+      {
+         if (offset > patchlen - 3)
+            break;
+
+         length  = patchdata[offset++] << 8;
+         length |= patchdata[offset++] << 0;
+         offset++;
+
+         if (length == 0) /* Illegal */
+            break;
+      }
+
+      size = MAX(size, (size_t)address + length);
+   }
+
+   return 0;
+}
+
 static enum patch_error ips_apply_patch(
       const uint8_t *patchdata, size_t patchlen,
       const uint8_t *sourcedata, size_t sourcelength,
-      uint8_t *targetdata, size_t *targetlength)
+      uint8_t *targetdata, size_t *targetlength,
+      uint32_t *target_crc)
 {
    uint32_t offset = 5;
 
@@ -423,14 +564,19 @@ static enum patch_error ips_apply_patch(
 
       if (address == 0x454f46) /* EOF */
       {
-         if (offset == patchlen)
-            return PATCH_SUCCESS;
-         else if (offset == patchlen - 3)
+         if (offset == patchlen - 3)
          {
             uint32_t size = patchdata[offset++] << 16;
             size |= patchdata[offset++] << 8;
             size |= patchdata[offset++] << 0;
             *targetlength = size;
+         }
+
+         if (offset == patchlen)
+         {
+            /* IPS has no checksums, so this is the only pass over the
+             * output */
+            *target_crc = encoding_crc32(0, targetdata, *targetlength);
             return PATCH_SUCCESS;
          }
       }
@@ -473,18 +619,27 @@ static enum patch_error ips_apply_patch(
    return PATCH_PATCH_INVALID;
 }
 
+/**
+ * apply_patch_content:
+ * @buf          : buffer of the content file. Replaced by a newly
+ *                 allocated buffer if the patch applies; the old one
+ *                 is left for the caller to release.
+ * @size         : size of the content file.
+ * @crc          : set to the CRC32 of the patched content.
+ *
+ * Returns: true if a patch file was found, whether it applied or not.
+ **/
 static bool apply_patch_content(uint8_t **buf,
-      ssize_t *size, const char *patch_desc, const char *patch_path,
-      patch_func_t func)
+      ssize_t *size, uint32_t *crc,
+      const char *patch_desc, const char *patch_path,
+      patch_func_t func, patch_size_func_t size_func)
 {
    size_t target_size;
    ssize_t patch_size;
+   uint32_t target_crc      = 0;
    void *patch_data         = NULL;
    enum patch_error err     = PATCH_UNKNOWN;
-   bool success             = false;
    uint8_t *patched_content = NULL;
-   ssize_t ret_size         = *size;
-   uint8_t *ret_buf         = *buf;
    
    if (!path_is_valid(patch_path))
       return false;
@@ -498,84 +653,79 @@ static bool apply_patch_content(uint8_t **buf,
       return false;
    }
 
-   if (!path_file_exists(patch_path))
-   {
-      free(patch_data);
-      return false;
-   }
-
    RARCH_LOG("Found %s file in \"%s\", attempting to patch ...\n",
          patch_desc, patch_path);
 
-   target_size = ret_size * 4; /* Just to be sure. */
+   /* Allocate exactly what the patch says it'll write */
+   target_size = size_func((const uint8_t*)patch_data, patch_size, *size);
 
-   patched_content = (uint8_t*)malloc(target_size);
-
-   if (!patched_content)
+   if (!target_size)
+      err = PATCH_PATCH_INVALID;
+   else
    {
-      RARCH_ERR("%s\n",
-            msg_hash_to_str(MSG_FAILED_TO_ALLOCATE_MEMORY_FOR_PATCHED_CONTENT));
-      goto error;
-   }
+      /* Keep the terminating NUL filestream_read_file provides. */
+      patched_content = (uint8_t*)malloc(target_size + 1);
 
-   err = func((const uint8_t*)patch_data, patch_size, ret_buf,
-         ret_size, patched_content, &target_size);
+      if (!patched_content)
+      {
+         RARCH_ERR("%s\n",
+               msg_hash_to_str(MSG_FAILED_TO_ALLOCATE_MEMORY_FOR_PATCHED_CONTENT));
+         free(patch_data);
+         return false;
+      }
+
+      err = func((const uint8_t*)patch_data, patch_size, *buf,
+            *size, patched_content, &target_size, &target_crc);
+   }
 
    if (err == PATCH_SUCCESS)
    {
       RARCH_LOG("%s (%s).\n",
             msg_hash_to_str(MSG_FATAL_ERROR_RECEIVED_IN),
             patch_desc);
-      success = true;
+      patched_content[target_size] = '\0';
+      *buf  = patched_content;
+      *size = target_size;
+      *crc  = target_crc;
    }
    else
+   {
       RARCH_ERR("%s %s: %s #%u\n",
             msg_hash_to_str(MSG_FAILED_TO_PATCH),
             patch_desc,
             msg_hash_to_str(MSG_ERROR),
             (unsigned)err);
-
-   if (success)
-   {
-      free(ret_buf);
-      *buf = patched_content;
-      *size = target_size;
+      free(patched_content);
    }
 
    free(patch_data);
    return true;
-
-error:
-   *buf = ret_buf;
-   *size = ret_size;
-   free(patch_data);
-
-   return false;
 }
 
 static bool try_bps_patch(bool allow_bps, const char *name_bps,
-      uint8_t **buf, ssize_t *size)
+      uint8_t **buf, ssize_t *size, uint32_t *crc)
 {
    if (allow_bps && !string_is_empty(name_bps))
-      return apply_patch_content(buf, size, "BPS", name_bps,
-            bps_apply_patch);
+      return apply_patch_content(buf, size, crc, "BPS", name_bps,
+            bps_apply_patch, bps_target_size);
    return false;
 }
 
 static bool try_ups_patch(bool allow_ups, const char *name_ups,
-      uint8_t **buf, ssize_t *size)
+      uint8_t **buf, ssize_t *size, uint32_t *crc)
 {
    if (allow_ups && !string_is_empty(name_ups))
-      return apply_patch_content(buf, size, "UPS", name_ups,
-            ups_apply_patch);
+      return apply_patch_content(buf, size, crc, "UPS", name_ups,
+            ups_apply_patch, ups_target_size);
    return false;
 }
 
 static bool try_ips_patch(bool allow_ips,
-      const char *name_ips, uint8_t **buf, ssize_t *size)
+      const char *name_ips, uint8_t **buf, ssize_t *size, uint32_t *crc)
 {
    if (allow_ips && !string_is_empty(name_ips))
-      return apply_patch_content(buf, size, "IPS", name_ips, ips_apply_patch);
+      return apply_patch_content(buf, size, crc, "IPS", name_ips,
+            ips_apply_patch, ips_target_size);
    return false;
 }
 
@@ -583,18 +733,23 @@ static bool try_ips_patch(bool allow_ips,
  * patch_content:
  * @buf          : buffer of the content file.
  * @size         : size   of the content file.
+ * @crc          : set to the CRC32 of the patched content.
  *
- * Apply patch to the content file in-memory.
+ * Apply patch to the content file in-memory. The content itself is only
+ * read; on success @buf is replaced by a new buffer holding the output,
+ * and the CRC32 comes out of the same pass that wrote it.
  *
+ * Returns: true if @buf was replaced by patched content.
  **/
-static void patch_content(
+static bool patch_content(
       const char *name_ips,
       const char *name_bps,
       const char *name_ups,
       uint8_t **buf,
-      void *data)
+      ssize_t *size,
+      uint32_t *crc)
 {
-   ssize_t *size    = (ssize_t*)data;
+   const uint8_t *source = *buf;
    bool allow_ups   = !rarch_ctl(RARCH_CTL_IS_BPS_PREF, NULL) && !rarch_ctl(RARCH_CTL_IS_IPS_PREF, NULL);
    bool allow_ips   = !rarch_ctl(RARCH_CTL_IS_UPS_PREF, NULL) && !rarch_ctl(RARCH_CTL_IS_BPS_PREF, NULL);
    bool allow_bps   = !rarch_ctl(RARCH_CTL_IS_UPS_PREF, NULL) && !rarch_ctl(RARCH_CTL_IS_IPS_PREF, NULL);
@@ -605,14 +760,16 @@ static void patch_content(
    {
       RARCH_WARN("%s\n",
             msg_hash_to_str(MSG_SEVERAL_PATCHES_ARE_EXPLICITLY_DEFINED));
-      return;
+      return false;
    }
 
-   if (     !try_ips_patch(allow_ips, name_ips, buf, size) 
-         && !try_bps_patch(allow_bps, name_bps, buf, size) 
-         && !try_ups_patch(allow_ups, name_ups, buf, size))
+   if (     !try_ips_patch(allow_ips, name_ips, buf, size, crc) 
+         && !try_bps_patch(allow_bps, name_bps, buf, size, crc) 
+         && !try_ups_patch(allow_ups, name_ups, buf, size, crc))
    {
       RARCH_LOG("%s\n",
             msg_hash_to_str(MSG_DID_NOT_FIND_A_VALID_CONTENT_PATCH));
    }
+
+   return *buf != source;
 }
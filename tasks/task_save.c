@@ -27,13 +27,27 @@
 #endif
 #include <errno.h>
 
+#if defined(HAVE_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#include <fcntl.h>
+#define HAVE_AUTOSAVE_PWRITE
+#endif
+
 #include <compat/strl.h>
 #include <retro_assert.h>
+#include <rhash.h>
 #include <lists/string_list.h>
 #include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <streams/trans_stream.h>
 #include <rthreads/rthreads.h>
 #include <file/file_path.h>
 #include <retro_miscellaneous.h>
+#include <retro_stat.h>
+
+#ifdef HAVE_RPNG
+#include <formats/rpng.h>
+#include <formats/image.h>
+#endif
 
 #ifdef HAVE_CONFIG_H
 #include "../core.h"
@@ -44,16 +58,49 @@
 #endif
 
 #include "../core.h"
+#include "../content.h"
 #include "../file_path_special.h"
 #include "../configuration.h"
 #include "../msg_hash.h"
 #include "../retroarch.h"
 #include "../runloop.h"
 #include "../verbosity.h"
+#include "../gfx/video_driver.h"
 #include "tasks_internal.h"
 
 #define SAVE_STATE_CHUNK 4096
 
+/* SRAM is checked for changes and written back
+ * in blocks of this size. */
+#define AUTOSAVE_BLOCK_SIZE 4096
+
+#ifdef HAVE_ZLIB
+/* Compressed savestates start with a header, followed by
+ * 'thumbnail_size' bytes of PNG thumbnail and 'payload_size'
+ * bytes of deflated state. Fields are little-endian. */
+#define STATE_CONTAINER_MAGIC       "RASTATE1"
+#define STATE_CONTAINER_HEADER_SIZE 120
+#define STATE_CONTAINER_CORE_SIZE   64
+
+#define STATE_CONTAINER_DEFLATE     (1 << 0)
+
+/* Compressed bytes handled per task iteration. */
+#define STATE_CONTAINER_CHUNK       (64 * 1024)
+
+struct state_container_header
+{
+   uint32_t header_size;
+   uint32_t flags;
+   uint32_t content_crc;
+   uint32_t thumbnail_size;
+   uint64_t frame_count;
+   uint64_t timestamp;
+   uint64_t state_size;
+   uint64_t payload_size;
+   char core[STATE_CONTAINER_CORE_SIZE];
+};
+#endif
+
 static struct string_list *task_save_files = NULL;
 
 struct ram_type
@@ -93,6 +140,19 @@ typedef struct
    bool mute;
    int state_slot;
    bool thumbnail_enable;
+#ifdef HAVE_ZLIB
+   /* Saving to or loading from a savestate container. */
+   bool container;
+   struct state_container_header header;
+   const struct trans_stream_backend *backend;
+   void *stream;
+   uint8_t *chunk;
+   uint64_t payload_pos;
+   /* Frame captured for the thumbnail, top-down BGR24. */
+   uint8_t *thumbnail;
+   unsigned thumbnail_width;
+   unsigned thumbnail_height;
+#endif
 } save_task_state_t;
 
 typedef save_task_state_t load_task_data_t;
@@ -124,15 +184,110 @@ struct autosave
    scond_t *cond;
    sthread_t *thread;
 
+   /* Snapshot of SRAM, only copied while holding 'lock'. */
    void *buffer;
    const void *retro_buffer;
    const char *path;
    size_t bufsize;
    unsigned interval;
+
+   /* Hashes of the blocks of SRAM last written out. */
+   uint64_t *hashes;
+   bool *dirty;
+   size_t num_blocks;
+   /* The file holds exactly what 'hashes' describe, so
+    * changed blocks can be written in place. */
+   bool written;
+   /* Last write failed, try again even without changes. */
+   bool failed;
 };
 
 static struct autosave_st autosave_state;
 
+/**
+ * autosave_write_full:
+ * @save            : pointer to autosave object
+ *
+ * Writes the whole snapshot to a temporary file and swaps
+ * it in, so a crash halfway through never leaves a
+ * truncated save behind.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool autosave_write_full(autosave_t *save)
+{
+   char tmp[PATH_MAX_LENGTH];
+   bool failed = false;
+   FILE *file  = NULL;
+
+   strlcpy(tmp, save->path, sizeof(tmp));
+   strlcat(tmp, ".tmp", sizeof(tmp));
+
+   file = fopen(tmp, "wb");
+   if (!file)
+      return false;
+
+   failed |= fwrite(save->buffer, 1, save->bufsize, file)
+      != save->bufsize;
+   failed |= fflush(file) != 0;
+#ifdef HAVE_AUTOSAVE_PWRITE
+   failed |= fsync(fileno(file)) != 0;
+#endif
+   failed |= fclose(file) != 0;
+
+   if (!failed)
+      failed = !path_file_replace(tmp, save->path);
+
+   if (failed)
+      remove(tmp);
+
+   return !failed;
+}
+
+/**
+ * autosave_write_blocks:
+ * @save            : pointer to autosave object
+ *
+ * Writes the changed blocks of the snapshot into the
+ * existing file, in as few writes as possible.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool autosave_write_blocks(autosave_t *save)
+{
+#ifdef HAVE_AUTOSAVE_PWRITE
+   size_t i;
+   bool failed = false;
+   int fd      = open(save->path, O_WRONLY);
+
+   if (fd < 0)
+      return false;
+
+   for (i = 0; i < save->num_blocks && !failed; )
+   {
+      size_t first = i;
+      size_t start, len;
+
+      if (!save->dirty[i++])
+         continue;
+
+      while (i < save->num_blocks && save->dirty[i])
+         i++;
+
+      start = first * AUTOSAVE_BLOCK_SIZE;
+      len   = MIN(i * AUTOSAVE_BLOCK_SIZE, save->bufsize) - start;
+
+      failed = pwrite(fd, (const uint8_t*)save->buffer + start,
+            len, (off_t)start) != (ssize_t)len;
+   }
+
+   failed |= close(fd) != 0;
+   return !failed;
+#else
+   return false;
+#endif
+}
+
 /**
  * autosave_thread:
  * @data            : pointer to autosave object
@@ -146,43 +301,61 @@ static void autosave_thread(void *data)
 
    while (!save->quit)
    {
-      bool differ;
+      size_t i;
+      size_t num_dirty = 0;
 
+      /* Only the copy holds up the runloop, everything
+       * else works on the snapshot. */
       slock_lock(save->lock);
-      differ = memcmp(save->buffer, save->retro_buffer,
-            save->bufsize) != 0;
-      if (differ)
-         memcpy(save->buffer, save->retro_buffer, save->bufsize);
+      memcpy(save->buffer, save->retro_buffer, save->bufsize);
       slock_unlock(save->lock);
 
-      if (differ)
+      for (i = 0; i < save->num_blocks; i++)
       {
-         /* Should probably deal with this more elegantly. */
-         FILE *file = fopen(save->path, "wb");
+         size_t start  = i * AUTOSAVE_BLOCK_SIZE;
+         uint64_t hash = xxh64_calculate(
+               (const uint8_t*)save->buffer + start,
+               MIN(AUTOSAVE_BLOCK_SIZE, save->bufsize - start), 0);
 
-         if (file)
+         save->dirty[i] = hash != save->hashes[i];
+         if (save->dirty[i])
          {
-            bool failed = false;
-
-            /* Avoid spamming down stderr ... */
-            if (first_log)
-            {
-               RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
-                     save->path, save->interval);
-               first_log = false;
-            }
-            else
-               RARCH_LOG("SRAM changed ... autosaving ...\n");
-
-            failed |= fwrite(save->buffer, 1, save->bufsize, file)
-               != save->bufsize;
-            failed |= fflush(file) != 0;
-            failed |= fclose(file) != 0;
-            if (failed)
-               RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+            save->hashes[i] = hash;
+            num_dirty++;
          }
       }
 
+      if (num_dirty || save->failed)
+      {
+         bool ok = false;
+
+         /* Avoid spamming down stderr ... */
+         if (first_log)
+         {
+            RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
+                  save->path, save->interval);
+            first_log = false;
+         }
+         else
+            RARCH_LOG("SRAM changed ... autosaving ...\n");
+
+         /* Write changed blocks in place unless most of
+          * the file changed anyway. */
+         if (      save->written
+               && !save->failed
+               && num_dirty * 2 <= save->num_blocks)
+            ok = autosave_write_blocks(save);
+
+         if (!ok)
+            ok = autosave_write_full(save);
+
+         save->written = ok;
+         save->failed  = !ok;
+
+         if (!ok)
+            RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+      }
+
       slock_lock(save->cond_lock);
 
       if (!save->quit)
@@ -209,6 +382,7 @@ static autosave_t *autosave_new(const char *path,
       const void *data, size_t size,
       unsigned interval)
 {
+   size_t i;
    autosave_t *handle   = (autosave_t*)calloc(1, sizeof(*handle));
    if (!handle)
       goto error;
@@ -218,12 +392,26 @@ static autosave_t *autosave_new(const char *path,
    handle->path         = path;
    handle->buffer       = malloc(size);
    handle->retro_buffer = data;
-
-   if (!handle->buffer)
+   handle->num_blocks   = (size + AUTOSAVE_BLOCK_SIZE - 1)
+      / AUTOSAVE_BLOCK_SIZE;
+   handle->hashes       = (uint64_t*)malloc(
+         handle->num_blocks * sizeof(*handle->hashes));
+   handle->dirty        = (bool*)calloc(handle->num_blocks,
+         sizeof(*handle->dirty));
+
+   if (!handle->buffer || !handle->hashes || !handle->dirty)
       goto error;
 
    memcpy(handle->buffer, handle->retro_buffer, handle->bufsize);
 
+   for (i = 0; i < handle->num_blocks; i++)
+   {
+      size_t start      = i * AUTOSAVE_BLOCK_SIZE;
+      handle->hashes[i] = xxh64_calculate(
+            (const uint8_t*)handle->buffer + start,
+            MIN(AUTOSAVE_BLOCK_SIZE, size - start), 0);
+   }
+
    handle->lock         = slock_new();
    handle->cond_lock    = slock_new();
    handle->cond         = scond_new();
@@ -234,7 +422,12 @@ static autosave_t *autosave_new(const char *path,
 
 error:
    if (handle)
+   {
+      free(handle->buffer);
+      free(handle->hashes);
+      free(handle->dirty);
       free(handle);
+   }
    return NULL;
 }
 
@@ -259,6 +452,11 @@ static void autosave_free(autosave_t *handle)
    if (handle->buffer)
       free(handle->buffer);
    handle->buffer = NULL;
+
+   free(handle->hashes);
+   free(handle->dirty);
+   handle->hashes = NULL;
+   handle->dirty  = NULL;
 }
 
 
@@ -503,6 +701,482 @@ static void undo_save_state_cb(void *task_data,
    }
 }
 
+#ifdef HAVE_ZLIB
+static void state_container_write_le32(uint8_t *data, uint32_t value)
+{
+   data[0] = (uint8_t)(value >>  0);
+   data[1] = (uint8_t)(value >>  8);
+   data[2] = (uint8_t)(value >> 16);
+   data[3] = (uint8_t)(value >> 24);
+}
+
+static void state_container_write_le64(uint8_t *data, uint64_t value)
+{
+   state_container_write_le32(data + 0, (uint32_t)value);
+   state_container_write_le32(data + 4, (uint32_t)(value >> 32));
+}
+
+static uint32_t state_container_read_le32(const uint8_t *data)
+{
+   return (uint32_t)data[0]
+      | ((uint32_t)data[1] <<  8)
+      | ((uint32_t)data[2] << 16)
+      | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t state_container_read_le64(const uint8_t *data)
+{
+   return state_container_read_le32(data)
+      | ((uint64_t)state_container_read_le32(data + 4) << 32);
+}
+
+static void state_container_pack(uint8_t *data,
+      const struct state_container_header *header)
+{
+   memcpy(data, STATE_CONTAINER_MAGIC, 8);
+   state_container_write_le32(data +  8, header->header_size);
+   state_container_write_le32(data + 12, header->flags);
+   state_container_write_le32(data + 16, header->content_crc);
+   state_container_write_le32(data + 20, header->thumbnail_size);
+   state_container_write_le64(data + 24, header->frame_count);
+   state_container_write_le64(data + 32, header->timestamp);
+   state_container_write_le64(data + 40, header->state_size);
+   state_container_write_le64(data + 48, header->payload_size);
+   memcpy(data + 56, header->core, STATE_CONTAINER_CORE_SIZE);
+}
+
+/**
+ * state_container_unpack:
+ * @data             : first STATE_CONTAINER_HEADER_SIZE bytes of a file.
+ * @header           : header to fill in.
+ *
+ * Returns: true if @data is the header of a savestate container.
+ **/
+static bool state_container_unpack(const uint8_t *data,
+      struct state_container_header *header)
+{
+   if (memcmp(data, STATE_CONTAINER_MAGIC, 8))
+      return false;
+
+   header->header_size    = state_container_read_le32(data +  8);
+   header->flags          = state_container_read_le32(data + 12);
+   header->content_crc    = state_container_read_le32(data + 16);
+   header->thumbnail_size = state_container_read_le32(data + 20);
+   header->frame_count    = state_container_read_le64(data + 24);
+   header->timestamp      = state_container_read_le64(data + 32);
+   header->state_size     = state_container_read_le64(data + 40);
+   header->payload_size   = state_container_read_le64(data + 48);
+   memcpy(header->core, data + 56, STATE_CONTAINER_CORE_SIZE);
+   header->core[STATE_CONTAINER_CORE_SIZE - 1] = '\0';
+
+   return header->header_size >= STATE_CONTAINER_HEADER_SIZE;
+}
+
+static void state_container_free(save_task_state_t *state)
+{
+   if (state->stream)
+      state->backend->stream_free(state->stream);
+   if (state->chunk)
+      free(state->chunk);
+   if (state->thumbnail)
+      free(state->thumbnail);
+
+   state->stream    = NULL;
+   state->chunk     = NULL;
+   state->thumbnail = NULL;
+}
+
+/**
+ * task_save_container_init:
+ * @state : the save task state
+ *
+ * Fills in the container header and captures the thumbnail.
+ * Everything else happens on the task.
+ **/
+static void task_save_container_init(save_task_state_t *state)
+{
+   uint32_t *content_crc       = NULL;
+   rarch_system_info_t *system = NULL;
+
+   state->container                 = true;
+   state->header.header_size        = STATE_CONTAINER_HEADER_SIZE;
+   state->header.flags              = STATE_CONTAINER_DEFLATE;
+   state->header.frame_count        = video_driver_get_frame_count();
+   state->header.timestamp          = (uint64_t)time(NULL);
+   state->header.state_size         = (uint64_t)state->size;
+
+   if (content_get_crc(&content_crc) && content_crc)
+      state->header.content_crc     = *content_crc;
+
+   runloop_ctl(RUNLOOP_CTL_SYSTEM_INFO_GET, &system);
+   if (system && system->info.library_name)
+      strlcpy(state->header.core, system->info.library_name,
+            sizeof(state->header.core));
+
+#ifdef HAVE_RPNG
+   if (state->thumbnail_enable)
+      state->thumbnail = take_screenshot_bgr24(
+            &state->thumbnail_width, &state->thumbnail_height);
+#endif
+}
+
+/**
+ * task_save_container_begin:
+ * @state : the save task state
+ *
+ * Writes the header and the thumbnail, and sets up compression.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool task_save_container_begin(save_task_state_t *state)
+{
+   char sidecar[PATH_MAX_LENGTH];
+   uint8_t header[STATE_CONTAINER_HEADER_SIZE];
+   uint8_t *png    = NULL;
+   size_t png_size = 0;
+   bool ret        = false;
+
+#ifdef HAVE_RPNG
+   if (state->thumbnail)
+   {
+      png = rpng_save_image_bgr24_string(state->thumbnail,
+            state->thumbnail_width, state->thumbnail_height,
+            state->thumbnail_width * 3, &png_size);
+      free(state->thumbnail);
+      state->thumbnail = NULL;
+   }
+#endif
+
+   state->header.thumbnail_size = (uint32_t)png_size;
+   state->header.payload_size   = 0;
+   state_container_pack(header, &state->header);
+
+   ret = filestream_write(state->file, header, sizeof(header))
+      == sizeof(header);
+   if (ret && png)
+      ret = filestream_write(state->file, png, png_size)
+         == (ssize_t)png_size;
+
+   if (png)
+      free(png);
+
+   if (!ret)
+      return false;
+
+   /* A thumbnail an uncompressed save left behind would
+    * otherwise be shown for this state. */
+   snprintf(sidecar, sizeof(sidecar), "%s%s", state->path,
+         file_path_str(FILE_PATH_PNG_EXTENSION));
+   if (path_file_exists(sidecar))
+      remove(sidecar);
+
+   state->chunk   = (uint8_t*)malloc(STATE_CONTAINER_CHUNK);
+   state->backend = trans_stream_get_zlib_deflate_backend();
+   state->stream  = state->backend->stream_new();
+
+   if (!state->chunk || !state->stream)
+      return false;
+
+   /* Favour speed, states are saved often and can be large. */
+   state->backend->define(state->stream, "level", 1);
+   state->backend->set_in(state->stream,
+         (const uint8_t*)state->data, (uint32_t)state->size);
+
+   return true;
+}
+
+/**
+ * task_save_container_iterate:
+ * @state : the save task state
+ *
+ * Compresses and writes the next chunk of the state.
+ *
+ * Returns: -1 on error, 1 once the container is complete,
+ * otherwise 0.
+ **/
+static int task_save_container_iterate(save_task_state_t *state)
+{
+   uint8_t header[STATE_CONTAINER_HEADER_SIZE];
+   uint32_t rd                   = 0;
+   uint32_t wn                   = 0;
+   enum trans_stream_error error = TRANS_STREAM_ERROR_NONE;
+
+   state->backend->set_out(state->stream,
+         state->chunk, STATE_CONTAINER_CHUNK);
+
+   if (!state->backend->trans(state->stream, true, &rd, &wn, &error)
+         && error != TRANS_STREAM_ERROR_BUFFER_FULL)
+      return -1;
+
+   if (wn && filestream_write(state->file, state->chunk, wn) != (ssize_t)wn)
+      return -1;
+
+   state->written             += rd;
+   state->header.payload_size += wn;
+
+   if (error != TRANS_STREAM_ERROR_NONE)
+      return 0;
+
+   /* The header goes out last, so an interrupted save
+    * never passes for a complete one. */
+   state_container_pack(header, &state->header);
+
+   if (     filestream_seek(state->file, 0, SEEK_SET) != 0
+         || filestream_write(state->file, header, sizeof(header))
+         != sizeof(header))
+      return -1;
+
+   return 1;
+}
+
+/**
+ * task_load_container_begin:
+ * @state : the load task state
+ *
+ * Sets up decompression if the file is a savestate container,
+ * and leaves the file at the start of the state to read.
+ *
+ * Returns: false if the file is a damaged container.
+ **/
+static bool task_load_container_begin(save_task_state_t *state)
+{
+   uint8_t header[STATE_CONTAINER_HEADER_SIZE];
+   struct state_container_header *info = &state->header;
+   uint64_t file_size                  = (uint64_t)state->size;
+
+   if (file_size < sizeof(header))
+      return true;
+
+   if (filestream_read(state->file, header, sizeof(header))
+         != sizeof(header))
+      return false;
+
+   if (!state_container_unpack(header, info))
+   {
+      filestream_rewind(state->file);
+      return true;
+   }
+
+   if (     !(info->flags & STATE_CONTAINER_DEFLATE)
+         || !info->state_size
+         || info->state_size >= (uint32_t)-1
+         || info->header_size + (uint64_t)info->thumbnail_size
+            + info->payload_size > file_size)
+   {
+      RARCH_ERR("Savestate \"%s\" is damaged or unsupported.\n",
+            state->path);
+      return false;
+   }
+
+   RARCH_LOG("Savestate from core \"%s\", frame %llu.\n",
+         info->core, (unsigned long long)info->frame_count);
+
+   if (filestream_seek(state->file,
+            info->header_size + info->thumbnail_size, SEEK_SET) != 0)
+      return false;
+
+   state->container = true;
+   state->size      = (ssize_t)info->state_size;
+   state->chunk     = (uint8_t*)malloc(STATE_CONTAINER_CHUNK);
+   state->backend   = trans_stream_get_zlib_inflate_backend();
+   state->stream    = state->backend->stream_new();
+
+   return state->chunk && state->stream;
+}
+
+/**
+ * task_load_container_iterate:
+ * @state : the load task state
+ *
+ * Reads and decompresses the next chunk of the state.
+ *
+ * Returns: -1 on error, 1 once the state is complete,
+ * otherwise 0.
+ **/
+static int task_load_container_iterate(save_task_state_t *state)
+{
+   uint32_t rd                   = 0;
+   uint32_t wn                   = 0;
+   enum trans_stream_error error = TRANS_STREAM_ERROR_NONE;
+   size_t len                    = (size_t)MIN(
+         state->header.payload_size - state->payload_pos,
+         STATE_CONTAINER_CHUNK);
+
+   if (!len || filestream_read(state->file, state->chunk, len)
+         != (ssize_t)len)
+      return -1;
+
+   state->payload_pos += len;
+
+   /* One byte of slack, so a payload inflating to more
+    * than the state's size is caught. */
+   state->backend->set_in(state->stream, state->chunk, (uint32_t)len);
+   state->backend->set_out(state->stream,
+         (uint8_t*)state->data + state->bytes_read,
+         (uint32_t)(state->size + 1 - state->bytes_read));
+
+   if (!state->backend->trans(state->stream, false, &rd, &wn, &error))
+      return -1;
+
+   state->bytes_read += wn;
+
+   if (error != TRANS_STREAM_ERROR_NONE)
+      return 0;
+
+   return state->bytes_read == state->size ? 1 : -1;
+}
+#endif
+
+#if defined(HAVE_ZLIB) && defined(HAVE_RPNG)
+struct state_thumbnail_task
+{
+   bool supports_rgba;
+   char path[PATH_MAX_LENGTH];
+};
+
+/**
+ * state_container_read_thumbnail:
+ * @path             : path to the savestate container.
+ * @ti               : texture image to decode into.
+ *
+ * Returns: true if the container has a thumbnail and it was decoded.
+ **/
+static bool state_container_read_thumbnail(const char *path,
+      struct texture_image *ti)
+{
+   struct state_container_header info;
+   uint8_t header[STATE_CONTAINER_HEADER_SIZE];
+   int ret       = IMAGE_PROCESS_ERROR;
+   uint8_t *png  = NULL;
+   void *handle  = NULL;
+   RFILE *file   = filestream_open(path, RFILE_MODE_READ, -1);
+
+   if (!file)
+      return false;
+
+   if (     filestream_read(file, header, sizeof(header)) != sizeof(header)
+         || !state_container_unpack(header, &info)
+         || !info.thumbnail_size
+         || filestream_seek(file, info.header_size, SEEK_SET) != 0)
+      goto end;
+
+   png = (uint8_t*)malloc(info.thumbnail_size);
+   if (     !png
+         || filestream_read(file, png, info.thumbnail_size)
+         != (ssize_t)info.thumbnail_size)
+      goto end;
+
+   handle = image_transfer_new(IMAGE_TYPE_PNG);
+   if (!handle)
+      goto end;
+
+   image_transfer_set_buffer_ptr(handle, IMAGE_TYPE_PNG, png);
+
+   if (!image_transfer_start(handle, IMAGE_TYPE_PNG))
+      goto end;
+
+   while (image_transfer_iterate(handle, IMAGE_TYPE_PNG));
+
+   if (!image_transfer_is_valid(handle, IMAGE_TYPE_PNG))
+      goto end;
+
+   do
+   {
+      ret = image_transfer_process(handle, IMAGE_TYPE_PNG,
+            &ti->pixels, info.thumbnail_size, &ti->width, &ti->height);
+   } while (ret == IMAGE_PROCESS_NEXT);
+
+end:
+   if (handle)
+      image_transfer_free(handle, IMAGE_TYPE_PNG);
+   if (png)
+      free(png);
+   filestream_close(file);
+
+   return ret == IMAGE_PROCESS_END;
+}
+
+static void task_state_thumbnail_handler(retro_task_t *task)
+{
+   struct state_thumbnail_task *state =
+      (struct state_thumbnail_task*)task->state;
+   struct texture_image *ti           =
+      (struct texture_image*)calloc(1, sizeof(*ti));
+
+   if (ti)
+   {
+      ti->supports_rgba = state->supports_rgba;
+
+      if (state_container_read_thumbnail(state->path, ti))
+      {
+         unsigned r_shift, g_shift, b_shift, a_shift;
+
+         image_texture_set_color_shifts(&r_shift, &g_shift, &b_shift,
+               &a_shift, ti);
+         image_texture_color_convert(r_shift, g_shift, b_shift,
+               a_shift, ti);
+
+         task_set_data(task, ti);
+      }
+      else
+      {
+         image_texture_free(ti);
+         free(ti);
+      }
+   }
+
+   free(state);
+   task->state = NULL;
+
+   task_set_finished(task, true);
+}
+
+/**
+ * task_push_state_thumbnail_load:
+ * @path             : path to the savestate.
+ * @cb               : called with the decoded texture image,
+ *                     or NULL if the savestate has no thumbnail.
+ * @user_data        : passed on to @cb.
+ *
+ * Decodes the thumbnail embedded in a savestate container.
+ *
+ * Returns: true if the task was queued.
+ **/
+bool task_push_state_thumbnail_load(const char *path,
+      retro_task_callback_t cb, void *user_data)
+{
+   retro_task_t                *task = NULL;
+   struct state_thumbnail_task *state = NULL;
+
+   if (string_is_empty(path))
+      return false;
+
+   task  = (retro_task_t*)calloc(1, sizeof(*task));
+   state = (struct state_thumbnail_task*)calloc(1, sizeof(*state));
+
+   if (!task || !state)
+   {
+      if (task)
+         free(task);
+      if (state)
+         free(state);
+      return false;
+   }
+
+   state->supports_rgba = video_driver_supports_rgba();
+   strlcpy(state->path, path, sizeof(state->path));
+
+   task->state     = state;
+   task->handler   = task_state_thumbnail_handler;
+   task->callback  = cb;
+   task->user_data = user_data;
+
+   task_queue_ctl(TASK_QUEUE_CTL_PUSH, task);
+
+   return true;
+}
+#endif
+
 /**
  * task_save_handler_finished:
  * @task : the task to finish
@@ -519,6 +1193,10 @@ static void task_save_handler_finished(retro_task_t *task,
 
    filestream_close(state->file);
 
+#ifdef HAVE_ZLIB
+   state_container_free(state);
+#endif
+
    if (!task_get_error(task) && task_get_cancelled(task))
       task_set_error(task, strdup("Task canceled"));
 
@@ -546,8 +1224,8 @@ static void task_save_handler_finished(retro_task_t *task,
  **/
 static void task_save_handler(retro_task_t *task)
 {
-   int written;
-   ssize_t remaining;
+   bool failed              = false;
+   bool finished            = false;
    save_task_state_t *state = (save_task_state_t*)task->state;
 
    if (!state->file)
@@ -556,17 +1234,38 @@ static void task_save_handler(retro_task_t *task)
 
       if (!state->file)
          return;
+
+#ifdef HAVE_ZLIB
+      if (state->container)
+         failed = !task_save_container_begin(state);
+#endif
    }
 
-   remaining       = MIN(state->size - state->written, SAVE_STATE_CHUNK);
-   written         = filestream_write(state->file,
-         (uint8_t*)state->data + state->written, remaining);
+#ifdef HAVE_ZLIB
+   if (state->container)
+   {
+      if (!failed)
+      {
+         int ret  = task_save_container_iterate(state);
+         failed   = ret < 0;
+         finished = ret > 0;
+      }
+   }
+   else
+#endif
+   {
+      ssize_t remaining = MIN(state->size - state->written, SAVE_STATE_CHUNK);
+      int written       = filestream_write(state->file,
+            (uint8_t*)state->data + state->written, remaining);
 
-   state->written += written;
+      state->written   += written;
+      failed            = written != remaining;
+      finished          = state->written == state->size;
+   }
 
    task_set_progress(task, (state->written / (float)state->size) * 100);
 
-   if (task_get_cancelled(task) || written != remaining)
+   if (task_get_cancelled(task) || failed)
    {
       char err[PATH_MAX_LENGTH];
 
@@ -590,7 +1289,7 @@ static void task_save_handler(retro_task_t *task)
       return;
    }
 
-   if (state->written == state->size)
+   if (finished)
    {
       char       *msg      = NULL;
 
@@ -693,6 +1392,10 @@ static void task_load_handler_finished(retro_task_t *task,
    if (state->file)
       filestream_close(state->file);
 
+#ifdef HAVE_ZLIB
+   state_container_free(state);
+#endif
+
    if (!task_get_error(task) && task_get_cancelled(task))
       task_set_error(task, strdup("Task canceled"));
 
@@ -712,7 +1415,8 @@ static void task_load_handler_finished(retro_task_t *task,
  **/
 static void task_load_handler(retro_task_t *task)
 {
-   ssize_t remaining, bytes_read;
+   bool failed              = false;
+   bool finished            = false;
    save_task_state_t *state = (save_task_state_t*)task->state;
 
    if (!state->file)
@@ -732,21 +1436,42 @@ static void task_load_handler(retro_task_t *task)
 
       filestream_rewind(state->file);
 
+#ifdef HAVE_ZLIB
+      /* Backups for undo keep the file as it is. */
+      if (     !state->load_to_backup_buffer
+            && !task_load_container_begin(state))
+         goto error;
+#endif
+
       state->data = malloc(state->size + 1);
 
       if (!state->data)
          goto error;
    }
 
-   remaining          = MIN(state->size - state->bytes_read, SAVE_STATE_CHUNK);
-   bytes_read         = filestream_read(state->file,
-         (uint8_t*)state->data + state->bytes_read, remaining);
-   state->bytes_read += bytes_read;
+#ifdef HAVE_ZLIB
+   if (state->container)
+   {
+      int ret  = task_load_container_iterate(state);
+      failed   = ret < 0;
+      finished = ret > 0;
+   }
+   else
+#endif
+   {
+      ssize_t remaining  = MIN(state->size - state->bytes_read, SAVE_STATE_CHUNK);
+      ssize_t bytes_read = filestream_read(state->file,
+            (uint8_t*)state->data + state->bytes_read, remaining);
+
+      state->bytes_read += bytes_read;
+      failed             = bytes_read != remaining;
+      finished           = state->bytes_read == state->size;
+   }
 
    if (state->size > 0)
       task_set_progress(task, (state->bytes_read / (float)state->size) * 100);
 
-   if (task_get_cancelled(task) || bytes_read != remaining)
+   if (task_get_cancelled(task) || failed)
    {
       if (state->autoload)
       {
@@ -769,7 +1494,7 @@ static void task_load_handler(retro_task_t *task)
       return;
    }
 
-   if (state->bytes_read == state->size)
+   if (finished)
    {
       char msg[1024];
 
@@ -969,7 +1694,12 @@ static void save_state_cb(void *task_data,
    save_task_state_t *state = (save_task_state_t*)task_data;
    char               *path = strdup(state->path);
 
+   /* Containers carry their thumbnail. */
+#ifdef HAVE_ZLIB
+   if (state->thumbnail_enable && !state->container)
+#else
    if (state->thumbnail_enable)
+#endif
       take_screenshot(path, true);
 
    free(path);
@@ -999,6 +1729,11 @@ static void task_push_save_state(const char *path, void *data, size_t size, bool
    state->mute             = autosave; /* don't show OSD messages if we are auto-saving */
    state->thumbnail_enable = settings->savestate_thumbnail_enable;
 
+#ifdef HAVE_ZLIB
+   if (settings->savestate_file_compression)
+      task_save_container_init(state);
+#endif
+
    task->type              = TASK_TYPE_BLOCKING;
    task->state             = state;
    task->handler           = task_save_handler;
@@ -78,6 +78,7 @@ typedef struct
    bool is_paused;
    bool history_list_enable;
    unsigned pixel_format_type;
+   unsigned compression_level;
 } screenshot_task_state_t;
 
 /**
@@ -132,12 +133,13 @@ static void task_screenshot_handler(retro_task_t *task)
 
    scaler_ctx_gen_reset(&state->scaler);
 
-   ret = rpng_save_image_bgr24(
+   ret = rpng_save_image_bgr24_level(
          state->filename,
          state->out_buffer,
          state->width,
          state->height,
-         state->width * 3
+         state->width * 3,
+         state->compression_level
          );
 
    free(state->out_buffer);
@@ -227,6 +229,7 @@ static bool screenshot_dump(
    state->silence             = savestate;
    state->history_list_enable = settings->history_list_enable;
    state->pixel_format_type   = video_driver_get_pixel_format();
+   state->compression_level   = settings->screenshot_compression_level;
 
    if (savestate)
       snprintf(state->filename,
@@ -404,3 +407,126 @@ bool take_screenshot(const char *name_base, bool silence)
 
    return ret;
 }
+
+/**
+ * take_screenshot_bgr24:
+ * @width            : set to the width of the frame.
+ * @height           : set to the height of the frame.
+ *
+ * Grabs the frame the core shows, without the menu, as top-down
+ * BGR24 for savestate thumbnails.
+ *
+ * Returns: pixels to be freed by the caller, or NULL on failure.
+ **/
+uint8_t *take_screenshot_bgr24(unsigned *width, unsigned *height)
+{
+   struct scaler_ctx scaler;
+   size_t pitch;
+   bool is_paused         = false;
+   bool is_idle           = false;
+   bool is_slowmotion     = false;
+   bool is_perfcnt_enable = false;
+   uint8_t *out           = NULL;
+   void *frame_data       = NULL;
+   const void *data       = NULL;
+
+   if (!video_driver_is_active())
+      return NULL;
+
+   runloop_get_status(&is_paused, &is_idle, &is_slowmotion, &is_perfcnt_enable);
+
+#if !defined(VITA)
+   if (video_driver_supports_viewport_read())
+   {
+      unsigned y;
+      struct video_viewport vp;
+
+      memset(&vp, 0, sizeof(vp));
+
+      /* Avoid taking screenshot of GUI overlays. */
+      video_driver_set_texture_enable(false, false);
+      if (!is_idle)
+         video_driver_cached_frame();
+
+      video_driver_get_viewport_info(&vp);
+
+      if (!vp.width || !vp.height)
+         goto end;
+
+      out = (uint8_t*)malloc(vp.width * vp.height * 3);
+      if (!out)
+         goto end;
+
+      if (!video_driver_read_viewport(out, is_idle))
+      {
+         free(out);
+         out = NULL;
+         goto end;
+      }
+
+      /* Viewport reads are bottom-up. */
+      for (y = 0; y < vp.height / 2; y++)
+      {
+         unsigned x;
+         uint8_t *top    = out + y * vp.width * 3;
+         uint8_t *bottom = out + (vp.height - 1 - y) * vp.width * 3;
+
+         for (x = 0; x < vp.width * 3; x++)
+         {
+            uint8_t tmp = top[x];
+            top[x]      = bottom[x];
+            bottom[x]   = tmp;
+         }
+      }
+
+      *width  = vp.width;
+      *height = vp.height;
+      goto end;
+   }
+#endif
+
+   video_driver_cached_frame_get(&data, width, height, &pitch);
+
+   if (video_driver_cached_frame_has_valid_framebuffer())
+   {
+      const void *old_data = data;
+      unsigned old_width   = *width;
+      unsigned old_height  = *height;
+      size_t old_pitch     = pitch;
+
+      if (!video_driver_supports_read_frame_raw())
+         goto end;
+
+      frame_data = video_driver_read_frame_raw(width, height, &pitch);
+
+      video_driver_cached_frame_set(old_data, old_width, old_height,
+            old_pitch);
+
+      data = frame_data;
+   }
+
+   if (!data || !*width || !*height)
+      goto end;
+
+   out = (uint8_t*)malloc(*width * *height * 3);
+   if (!out)
+      goto end;
+
+   memset(&scaler, 0, sizeof(scaler));
+
+   if (video_driver_get_pixel_format() == RETRO_PIXEL_FORMAT_XRGB8888)
+      scaler.in_fmt = SCALER_FMT_ARGB8888;
+   else
+      scaler.in_fmt = SCALER_FMT_RGB565;
+
+   video_frame_convert_to_bgr24(&scaler, out, data,
+         *width, *height, (int)pitch);
+   scaler_ctx_gen_reset(&scaler);
+
+end:
+   if (frame_data)
+      free(frame_data);
+   if (is_paused && !is_idle)
+      video_driver_cached_frame();
+   return out;
+}
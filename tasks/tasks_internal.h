@@ -21,6 +21,7 @@
 #include <boolean.h>
 #include <retro_common_api.h>
 #include <retro_miscellaneous.h>
+#include <lists/string_list.h>
 
 #include <queues/message_queue.h>
 #include <queues/task_queue.h>
@@ -106,6 +107,18 @@ bool task_push_netplay_crc_scan(uint32_t crc, char* name,
 bool task_push_image_load(const char *fullpath,
       retro_task_callback_t cb, void *userdata);
 
+typedef struct image_batch
+{
+   struct string_list *paths;
+   /* One per path, pixels are NULL where decoding failed. */
+   struct texture_image *images;
+} image_batch_t;
+
+bool task_push_image_load_batch(struct string_list *paths,
+      retro_task_callback_t cb, void *user_data);
+
+void task_image_batch_free(image_batch_t *batch);
+
 #ifdef HAVE_LIBRETRODB
 bool task_push_dbscan(
       const char *playlist_directory,
@@ -157,6 +170,13 @@ void task_file_load_handler(retro_task_t *task);
 
 bool take_screenshot(const char *path, bool silence);
 
+uint8_t *take_screenshot_bgr24(unsigned *width, unsigned *height);
+
+#if defined(HAVE_ZLIB) && defined(HAVE_RPNG)
+bool task_push_state_thumbnail_load(const char *path,
+      retro_task_callback_t cb, void *user_data);
+#endif
+
 bool event_load_save_files(void);
 
 bool event_save_files(void);